@@ -78,6 +78,23 @@ stp::InterpType ConfigurationFile::parse_interp_type(const std::string& it)
     return r_it;
 }
 
+stp::HankelMethod ConfigurationFile::parse_hankel_method(const std::string& hm)
+{
+    // Convert string to HankelMethod enum
+    stp::HankelMethod r_hm = stp::HankelMethod::DHT;
+    if (hm == "dht") {
+        r_hm = stp::HankelMethod::DHT;
+    } else if (hm == "dht_batched") {
+        r_hm = stp::HankelMethod::DHT_BATCHED;
+    } else if (hm == "fht") {
+        r_hm = stp::HankelMethod::FHT;
+    } else {
+        assert(0);
+    }
+
+    return r_hm;
+}
+
 stp::MedianMethod ConfigurationFile::parse_median_method(const std::string& medianmethod)
 {
     // Convert string to MedianMethod enum
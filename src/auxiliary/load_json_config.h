@@ -108,9 +108,26 @@ public:
                     s_interp_type = itr->value.GetString();
                     w_proj.interp_type = parse_interp_type(s_interp_type);
                 }
+                itr = secitr->value.FindMember("hankel_method");
+                if (itr != secitr->value.MemberEnd()) {
+                    s_hankel_method = itr->value.GetString();
+                    w_proj.hankel_method = parse_hankel_method(s_hankel_method);
+                }
                 itr = secitr->value.FindMember("wplanes_median");
                 if (itr != secitr->value.MemberEnd())
                     w_proj.wplanes_median = itr->value.GetBool();
+                itr = secitr->value.FindMember("wplanes_max_phase_error");
+                if (itr != secitr->value.MemberEnd())
+                    w_proj.wplanes_max_phase_error = itr->value.GetDouble();
+                itr = secitr->value.FindMember("w_stacking");
+                if (itr != secitr->value.MemberEnd())
+                    w_proj.w_stacking = itr->value.GetBool();
+                itr = secitr->value.FindMember("kernel_cache_dir");
+                if (itr != secitr->value.MemberEnd())
+                    w_proj.kernel_cache_dir = itr->value.GetString();
+                itr = secitr->value.FindMember("kernel_cache_w_tolerance");
+                if (itr != secitr->value.MemberEnd())
+                    w_proj.kernel_cache_w_tolerance = itr->value.GetDouble();
             }
 #endif
 #ifdef APROJECTION
@@ -143,6 +160,12 @@ public:
                 itr = secitr->value.FindMember("aproj_mask_perc");
                 if (itr != secitr->value.MemberEnd())
                     a_proj.aproj_mask_perc = itr->value.GetDouble();
+                itr = secitr->value.FindMember("aproj_pangle_bin_size");
+                if (itr != secitr->value.MemberEnd())
+                    a_proj.pangle_bin_size = itr->value.GetDouble();
+                itr = secitr->value.FindMember("aproj_cache_awkernels");
+                if (itr != secitr->value.MemberEnd())
+                    a_proj.cache_awkernels = itr->value.GetBool();
             }
 #endif
             // Source Find settings
@@ -214,6 +237,7 @@ public:
     std::string s_kernel_function = "PSWF";
     std::string s_fft_routine = "FFTW_ESTIMATE_FFT";
     std::string s_interp_type = "linear";
+    std::string s_hankel_method = "dht";
 
     // Source find settings
     double detection_n_sigma = 0.0;
@@ -260,6 +284,15 @@ private:
      */
     stp::InterpType parse_interp_type(const std::string& it);
 
+    /**
+     * @brief Parse string of Hankel transform method
+     *
+     * @param[in] hm (string): Input Hankel transform method string
+     *
+     * @return (HankelMethod) Enumeration value for the input Hankel transform method
+     */
+    stp::HankelMethod parse_hankel_method(const std::string& hm);
+
     /**
      * @brief Parse string of median method
      *
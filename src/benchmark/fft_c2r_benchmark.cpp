@@ -133,11 +133,7 @@ static void fft_c2r_test_benchmark(benchmark::State& state, stp::FFTRoutine r_ff
 #endif
     }
 
-#ifdef USE_FLOAT
-    fftwf_cleanup_threads();
-#else
-    fftw_cleanup_threads();
-#endif
+    stp::FFTContext::instance().cleanup();
 }
 
 BENCHMARK_CAPTURE(fft_c2r_test_benchmark, FFTW_ESTIMATE_FFT, stp::FFTRoutine::FFTW_ESTIMATE_FFT)
@@ -7,11 +7,13 @@
 #include <load_data.h>
 #include <load_json_config.h>
 #include <stp.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_init.h>
 
 std::string data_path(_PIPELINE_DATAPATH);
 std::string input_npz("simdata_nstep10.npz");
 
-void load_data(arma::mat& uv_in_pixels, arma::cx_mat& residual_vis, arma::mat& snr_weights, int image_size, double cell_size)
+void load_data(arma::mat& uv_in_pixels, arma::cx_mat& residual_vis, arma::mat& snr_weights, arma::vec& w_lambda, int image_size, double cell_size)
 {
     //Load simulated data from input_npz
     arma::mat input_uvw = load_npy_double_array<double>(data_path + input_npz, "uvw_lambda");
@@ -28,8 +30,15 @@ void load_data(arma::mat& uv_in_pixels, arma::cx_mat& residual_vis, arma::mat& s
     // Size of a UV-grid pixel, in multiples of wavelength (lambda):
     double grid_pixel_width_lambda = (1.0 / (arc_sec_to_rad(cell_size) * double(image_size)));
     uv_in_pixels = (input_uvw / grid_pixel_width_lambda);
-    // Remove W column
+    // Remove W column (W-projection uses the W-coordinates in wavelengths)
     uv_in_pixels.shed_col(2);
+    w_lambda = input_uvw.col(2);
+}
+
+void load_data(arma::mat& uv_in_pixels, arma::cx_mat& residual_vis, arma::mat& snr_weights, int image_size, double cell_size)
+{
+    arma::vec w_lambda;
+    load_data(uv_in_pixels, residual_vis, snr_weights, w_lambda, image_size, cell_size);
 }
 
 static void gridder_exact_benchmark(benchmark::State& state)
@@ -52,6 +61,49 @@ static void gridder_exact_benchmark(benchmark::State& state)
         benchmark::DoNotOptimize(stp::convolve_to_grid<true>(kernel_func, state.range(1), image_size, uv_in_pixels, residual_vis, snr_weights, kernel_exact,
             oversampling, shift_uv, halfplane_gridding));
     }
+    state.SetItemsProcessed(state.iterations() * residual_vis.n_elem);
+}
+
+static void gridder_exact_threads_benchmark(benchmark::State& state)
+{
+    int image_size = state.range(0);
+    int kernel_support = state.range(1);
+    int num_threads = state.range(2);
+    double cell_size = 0.5;
+    bool kernel_exact = true;
+    int oversampling = 1;
+    bool shift_uv = true;
+    bool halfplane_gridding = true;
+
+    arma::mat uv_in_pixels;
+    arma::cx_mat residual_vis;
+    arma::mat snr_weights;
+    load_data(uv_in_pixels, residual_vis, snr_weights, image_size, cell_size);
+
+    stp::PSWF kernel_func(kernel_support);
+
+    // Limit the number of worker threads used by the gridder
+    tbb::task_arena arena(num_threads);
+
+    for (auto _ : state) {
+        arena.execute([&] {
+            benchmark::DoNotOptimize(stp::convolve_to_grid<true>(kernel_func, kernel_support, image_size, uv_in_pixels, residual_vis, snr_weights, kernel_exact,
+                oversampling, shift_uv, halfplane_gridding));
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * residual_vis.n_elem);
+}
+
+// Number of threads from 1 up to the number of hardware threads
+static void thread_scaling_args(benchmark::internal::Benchmark* b)
+{
+    int max_threads = tbb::task_scheduler_init::default_num_threads();
+    for (int kernel_support = 3; kernel_support <= 7; kernel_support += 2) {
+        for (int num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+            b->Args({ 1 << 12, kernel_support, num_threads });
+        }
+        b->Args({ 1 << 12, kernel_support, max_threads });
+    }
 }
 
 static void gridder_oversampling_benchmark(benchmark::State& state)
@@ -75,6 +127,7 @@ static void gridder_oversampling_benchmark(benchmark::State& state)
         benchmark::DoNotOptimize(stp::convolve_to_grid<true>(kernel_func, kernel_support, image_size, uv_in_pixels, residual_vis, snr_weights, kernel_exact,
             oversampling, shift_uv, halfplane_gridding));
     }
+    state.SetItemsProcessed(state.iterations() * residual_vis.n_elem);
 }
 
 BENCHMARK(gridder_oversampling_benchmark)
@@ -84,6 +137,57 @@ BENCHMARK(gridder_oversampling_benchmark)
     ->Ranges({ { 1 << 10, 1 << 16 }, { 7, 7 } })
     ->Unit(benchmark::kMillisecond);
 
+#ifdef WPROJECTION
+static void gridder_wprojection_benchmark(benchmark::State& state)
+{
+    int image_size = state.range(0);
+    int wpconv_support = state.range(1);
+    int aa_support = 3;
+    double cell_size = 0.5;
+    bool kernel_exact = false;
+    int oversampling = 8;
+    bool shift_uv = true;
+    bool halfplane_gridding = true;
+
+    arma::mat uv_in_pixels;
+    arma::cx_mat residual_vis;
+    arma::mat snr_weights;
+    arma::vec w_lambda;
+    load_data(uv_in_pixels, residual_vis, snr_weights, w_lambda, image_size, cell_size);
+
+    stp::PSWF kernel_func(aa_support);
+    // No kernel truncation: all W-kernels have the maximum support
+    stp::W_ProjectionPars w_proj(16, wpconv_support);
+
+    stp::GridAccumulator<stp::PSWF, true> accumulator(kernel_func, aa_support, image_size, kernel_exact, oversampling, shift_uv, halfplane_gridding,
+        w_proj, cell_size);
+    stp::GriddingGeometry geometry = accumulator.prepare(uv_in_pixels, snr_weights, w_lambda, arma::mat(), true);
+    // Generate the W-kernels before timing, so that only the gridding loop is measured
+    accumulator.add(geometry, residual_vis);
+
+    for (auto _ : state) {
+        accumulator.add(geometry, residual_vis);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * residual_vis.n_elem);
+}
+
+// W-kernel supports with (1 to 8, 10, 12, 14, 16) and without (9) unrolled gridding kernels
+// (the gridder without W-projection always uses the separable kernel spans)
+BENCHMARK(gridder_wprojection_benchmark)
+    ->Args({ 1 << 12, 3 })
+    ->Args({ 1 << 12, 4 })
+    ->Args({ 1 << 12, 5 })
+    ->Args({ 1 << 12, 6 })
+    ->Args({ 1 << 12, 7 })
+    ->Args({ 1 << 12, 8 })
+    ->Args({ 1 << 12, 9 })
+    ->Args({ 1 << 12, 10 })
+    ->Args({ 1 << 12, 12 })
+    ->Args({ 1 << 12, 16 })
+    ->Unit(benchmark::kMillisecond);
+#endif
+
 BENCHMARK(gridder_exact_benchmark)
     ->RangeMultiplier(2)
     ->Ranges({ { 1 << 10, 1 << 16 }, { 3, 3 } })
@@ -91,4 +195,9 @@ BENCHMARK(gridder_exact_benchmark)
     ->Ranges({ { 1 << 10, 1 << 16 }, { 7, 7 } })
     ->Unit(benchmark::kMillisecond);
 
+BENCHMARK(gridder_exact_threads_benchmark)
+    ->Apply(thread_scaling_args)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
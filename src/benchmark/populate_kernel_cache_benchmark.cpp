@@ -18,6 +18,20 @@ static void populate_kernel_cache_benchmark(benchmark::State& state)
     }
 }
 
+static void populate_kernel_cache_1D_benchmark(benchmark::State& state)
+{
+    bool pad = false;
+    bool normalize = true;
+    stp::GaussianSinc gaussiansinc;
+    int oversampling = state.range(0);
+    int kernel_support = state.range(1);
+
+    for (auto _ : state) {
+        arma::Mat<real_t> cache;
+        cache = stp::populate_kernel_cache_1D(gaussiansinc, kernel_support, oversampling, pad, normalize);
+    }
+}
+
 static void CustomArguments(benchmark::internal::Benchmark* b)
 {
     for (int i = 2; i <= 16; i += 2)
@@ -27,5 +41,7 @@ static void CustomArguments(benchmark::internal::Benchmark* b)
 
 BENCHMARK(populate_kernel_cache_benchmark)
     ->Apply(CustomArguments);
+BENCHMARK(populate_kernel_cache_1D_benchmark)
+    ->Apply(CustomArguments);
 
 BENCHMARK_MAIN();
@@ -0,0 +1,46 @@
+/** @file simd_accumulate_benchmark.cpp
+ *  @brief Test performance of the gridder block-accumulate routines
+ */
+#include <benchmark/benchmark.h>
+#include <stp.h>
+
+// Floating point operations per accumulated element: weighted kernel (2), complex multiply (6) and grid updates (4)
+const double flops_per_elem = 12.0;
+
+auto accumulate_benchmark = [](benchmark::State& state, stp::SimdLevel level) {
+    int kernel_size = state.range(0);
+    int image_size = 1024;
+
+    stp::AccumulateBlockFn<real_t> routine = stp::accumulate_block_routine<real_t>(level);
+    if (routine == nullptr) {
+        state.SkipWithError("Instruction set not supported by the CPU");
+        return;
+    }
+
+    arma::Mat<cx_real_t> vis_grid(image_size, image_size, arma::fill::zeros);
+    arma::Mat<cx_real_t> sampling_grid(image_size, image_size, arma::fill::zeros);
+    arma::Mat<cx_real_t> kernel(kernel_size, kernel_size);
+    kernel.fill(cx_real_t(0.5, 0.25));
+    const cx_real_t vis_val(1.0, -0.5);
+
+    size_t pos = 0;
+    for (auto _ : state) {
+        // Move the kernel position along the grid to avoid measuring a single cache-resident block
+        pos = (pos + 97) % size_t(image_size - kernel_size);
+        routine(vis_grid.colptr(pos) + pos, vis_grid.n_rows, sampling_grid.colptr(pos) + pos, sampling_grid.n_rows, kernel.memptr(), kernel.n_rows,
+            kernel_size, kernel_size, vis_val, real_t(0.5), false);
+        benchmark::ClobberMemory();
+    }
+    state.counters["FLOPS"] = benchmark::Counter(flops_per_elem * kernel_size * kernel_size * state.iterations(), benchmark::Counter::kIsRate);
+};
+
+int main(int argc, char** argv)
+{
+    for (stp::SimdLevel level : { stp::SimdLevel::Scalar, stp::SimdLevel::SSE3, stp::SimdLevel::AVX2, stp::SimdLevel::AVX512 }) {
+        benchmark::RegisterBenchmark((std::string("accumulate_benchmark/") + stp::simd_level_name(level)).c_str(), accumulate_benchmark, level)
+            ->DenseRange(7, 33, 2);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+}
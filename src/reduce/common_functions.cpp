@@ -99,10 +99,19 @@ void log_configuration_imager(const ConfigurationFile& cfg)
         reducelogger->info("W-Projection settings:");
         reducelogger->info(" - num_wplanes={}", cfg.w_proj.num_wplanes);
         reducelogger->info(" - wplanes_median={}", cfg.w_proj.wplanes_median);
+        reducelogger->info(" - wplanes_max_phase_error={}", cfg.w_proj.wplanes_max_phase_error);
+        reducelogger->info(" - w_stacking={}", cfg.w_proj.w_stacking);
         reducelogger->info(" - max_wpconv_support={}", cfg.w_proj.max_wpconv_support);
         reducelogger->info(" - hankel_opt={}", cfg.w_proj.hankel_opt);
+        if (cfg.w_proj.hankel_opt) {
+            reducelogger->info(" - hankel_method={}", cfg.s_hankel_method);
+        }
         reducelogger->info(" - undersampling_opt={}", cfg.w_proj.undersampling_opt);
         reducelogger->info(" - kernel_trunc_perc={}", cfg.w_proj.kernel_trunc_perc);
+        if (!cfg.w_proj.kernel_cache_dir.empty()) {
+            reducelogger->info(" - kernel_cache_dir={}", cfg.w_proj.kernel_cache_dir);
+            reducelogger->info(" - kernel_cache_w_tolerance={}", cfg.w_proj.kernel_cache_w_tolerance);
+        }
         reducelogger->info(" - interp_type={}", cfg.s_interp_type);
     } else
 #endif
@@ -116,6 +125,8 @@ void log_configuration_imager(const ConfigurationFile& cfg)
         reducelogger->info(" - obs_ra={}", cfg.a_proj.obs_ra);
         reducelogger->info(" - aproj_opt={}", cfg.a_proj.aproj_opt);
         reducelogger->info(" - aproj_mask_perc={}", cfg.a_proj.aproj_mask_perc);
+        reducelogger->info(" - aproj_pangle_bin_size={}", cfg.a_proj.pangle_bin_size);
+        reducelogger->info(" - aproj_cache_awkernels={}", cfg.a_proj.cache_awkernels);
         reducelogger->info(" - pbeam_coefs={{{}}}", fmt::join(cfg.a_proj.pbeam_coefs.begin(), cfg.a_proj.pbeam_coefs.end(), ", "));
     } else
 #endif
@@ -54,6 +54,8 @@ static TCLAP::SwitchArg useDiffArg("d", "diff", "Use residual visibilities - dif
 TCLAP::MultiSwitchArg enableLoggerArg("l", "log", "Enable logger to stdout and logfile.txt (-ll for further debug logging of stp library).", false);
 // Print islands
 static TCLAP::SwitchArg disableIslandPrintArg("n", "no-src", "Disable logging of detected islands.", false);
+// Tune FFT plans
+static TCLAP::SwitchArg tuneFFTArg("t", "tune-fft", "Measure the FFTW plans that are missing from the wisdom file and save them to it (the host wisdom cache is used if no wisdom file is configured).", false);
 // Print benchmarks
 static TCLAP::SwitchArg disableBenchPrintArg("b", "no-bench", "Disable logging of function timings.", false);
 
@@ -63,6 +65,7 @@ void createFlags()
     cmd.add(disableBenchPrintArg);
 #endif
     cmd.add(disableIslandPrintArg);
+    cmd.add(tuneFFTArg);
     cmd.add(enableLoggerArg);
     cmd.add(useDiffArg);
     cmd.add(inJsonFileArg);
@@ -95,6 +98,17 @@ int main(int argc, char** argv)
     // Set padded image size
     set_image_sizes(cfg.img_pars);
 
+    // FFT tuning: plans are looked up in the wisdom file, and the missing ones are measured after the pipeline execution
+    if (tuneFFTArg.isSet()) {
+        if (cfg.img_pars.r_fft != stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
+            cfg.img_pars.r_fft = stp::FFTRoutine::FFTW_WISDOM_FFT;
+            cfg.s_fft_routine = "FFTW_WISDOM_FFT";
+        }
+        if (cfg.img_pars.fft_wisdom_filename.empty()) {
+            cfg.img_pars.fft_wisdom_filename = stp::FFTContext::host_wisdom_filename();
+        }
+    }
+
     // Log configuration
     log_configuration_imager(cfg);
     log_configuration_sourcefind(cfg);
@@ -141,6 +155,14 @@ int main(int argc, char** argv)
     TIMESTAMP_MAIN
 
     reducelogger->info("Finished pipeline execution");
+
+    // Measure missing FFTW plans and save them to the wisdom file
+    if (tuneFFTArg.isSet()) {
+        size_t num_tuned = stp::FFTContext::instance().tune_missing_plans();
+        stp::FFTContext::instance().save_wisdom(cfg.img_pars.fft_wisdom_filename);
+        reducelogger->info("Measured {} FFTW plans, saved to wisdom file {}", num_tuned, cfg.img_pars.fft_wisdom_filename);
+    }
+
     if (outJsonFileArg.isSet() || outNpzFileArg.isSet()) {
         reducelogger->info("Saving output data");
     }
@@ -6,6 +6,7 @@
 #include "stp_python.h"
 
 #include <pybind11/stl.h>
+#include <tuple>
 #include <utility>
 
 namespace stp_python {
@@ -14,10 +15,8 @@ namespace stp_python {
 using ptr_complex_double = std::complex<double>*;
 using ptr_double = double*;
 
-pybind11::tuple image_visibilities_wrapper(
-    np_complex_double_array vis,
-    np_double_array snr_weights,
-    np_double_array uvw_lambda,
+// Set imager, W-projection and A-projection parameters from the wrapper arguments
+static std::tuple<stp::ImagerPars, stp::W_ProjectionPars, stp::A_ProjectionPars> make_imager_pars(
     uint image_size,
     double cell_size,
     double padding_factor,
@@ -46,9 +45,6 @@ pybind11::tuple image_visibilities_wrapper(
     np_double_array lha,
     np_double_array pbeam_coefs)
 {
-    assert(vis.request().ndim == 1); // vis is a 1D array
-    assert(uvw_lambda.request().ndim == 2); // uv_pixels is a 2D array
-
     // Set imager parameters
     stp::ImagerPars img_pars(image_size, cell_size, padding_factor, kernel_func, kernel_support, kernel_exact, oversampling,
         generate_beam, gridding_correction, analytic_gcf, r_fft, fft_wisdom_filename);
@@ -66,27 +62,6 @@ pybind11::tuple image_visibilities_wrapper(
         img_pars.padded_image_size++;
     }
 
-    arma::cx_mat vis_arma(
-        static_cast<ptr_complex_double>(vis.request().ptr),
-        vis.request().shape[0], // n_rows
-        1, // vis is a vector (ndim = 1), so there is no shape[1]
-        false, // copy_aux_mem - do not copy memory for better performance (it will not be modified)
-        true); // strict
-
-    arma::mat snr_weights_arma(
-        static_cast<ptr_double>(snr_weights.request().ptr),
-        uvw_lambda.request().shape[0], // n_rows
-        1, // n_cols
-        false,
-        true);
-
-    arma::mat uvw_lambda_arma(
-        static_cast<ptr_double>(uvw_lambda.request().ptr),
-        uvw_lambda.request().shape[0], // n_rows
-        uvw_lambda.request().shape[1], // n_cols
-        false,
-        true);
-
     arma::mat lha_arma(
         static_cast<ptr_double>(lha.request().ptr),
         lha.request().shape[0], // n_rows
@@ -100,10 +75,12 @@ pybind11::tuple image_visibilities_wrapper(
     // Set A-Projection parameters
     stp::A_ProjectionPars aproj_pars(aproj_numtimesteps, obs_dec, obs_ra, aproj_opt, aproj_mask_perc, lha_arma, pbeam_coefs_vec);
 
-    // Run imager
-    stp::ImageVisibilities imager(std::move(vis_arma), std::move(snr_weights_arma),
-        std::move(uvw_lambda_arma), img_pars, wproj_pars, aproj_pars);
+    return std::make_tuple(std::move(img_pars), std::move(wproj_pars), std::move(aproj_pars));
+}
 
+// Convert the image and beam computed by the imager to a tuple of numpy arrays
+static pybind11::tuple imager_result_to_tuple(stp::ImageVisibilities& imager)
+{
     // The function will output a tuple with two np_complex_array
     pybind11::tuple result(2);
 
@@ -139,6 +116,153 @@ pybind11::tuple image_visibilities_wrapper(
     return result;
 }
 
+pybind11::tuple image_visibilities_wrapper(
+    np_complex_double_array vis,
+    np_double_array snr_weights,
+    np_double_array uvw_lambda,
+    uint image_size,
+    double cell_size,
+    double padding_factor,
+    stp::KernelFunction kernel_func,
+    uint kernel_support,
+    bool kernel_exact,
+    uint oversampling,
+    bool generate_beam,
+    bool gridding_correction,
+    bool analytic_gcf,
+    stp::FFTRoutine r_fft,
+    std::string fft_wisdom_filename,
+    uint num_wplanes,
+    bool wplanes_median,
+    uint max_wpconv_support,
+    bool hankel_opt,
+    bool hankel_proj_slice,
+    uint undersampling_opt,
+    double kernel_trunc_perc,
+    stp::InterpType interp_type,
+    uint aproj_numtimesteps,
+    double obs_dec,
+    double obs_ra,
+    bool aproj_opt,
+    double aproj_mask_perc,
+    np_double_array lha,
+    np_double_array pbeam_coefs)
+{
+    assert(vis.request().ndim == 1); // vis is a 1D array
+    assert(uvw_lambda.request().ndim == 2); // uv_pixels is a 2D array
+
+    stp::ImagerPars img_pars;
+    stp::W_ProjectionPars wproj_pars;
+    stp::A_ProjectionPars aproj_pars;
+    std::tie(img_pars, wproj_pars, aproj_pars) = make_imager_pars(image_size, cell_size, padding_factor, kernel_func, kernel_support, kernel_exact, oversampling,
+        generate_beam, gridding_correction, analytic_gcf, r_fft, fft_wisdom_filename, num_wplanes, wplanes_median, max_wpconv_support,
+        hankel_opt, hankel_proj_slice, undersampling_opt, kernel_trunc_perc, interp_type, aproj_numtimesteps, obs_dec, obs_ra, aproj_opt,
+        aproj_mask_perc, lha, pbeam_coefs);
+
+    arma::cx_mat vis_arma(
+        static_cast<ptr_complex_double>(vis.request().ptr),
+        vis.request().shape[0], // n_rows
+        1, // vis is a vector (ndim = 1), so there is no shape[1]
+        false, // copy_aux_mem - do not copy memory for better performance (it will not be modified)
+        true); // strict
+
+    arma::mat snr_weights_arma(
+        static_cast<ptr_double>(snr_weights.request().ptr),
+        uvw_lambda.request().shape[0], // n_rows
+        1, // n_cols
+        false,
+        true);
+
+    arma::mat uvw_lambda_arma(
+        static_cast<ptr_double>(uvw_lambda.request().ptr),
+        uvw_lambda.request().shape[0], // n_rows
+        uvw_lambda.request().shape[1], // n_cols
+        false,
+        true);
+
+    // Run imager
+    stp::ImageVisibilities imager(std::move(vis_arma), std::move(snr_weights_arma),
+        std::move(uvw_lambda_arma), img_pars, wproj_pars, aproj_pars);
+
+    return imager_result_to_tuple(imager);
+}
+
+std::unique_ptr<stp::ImagingPlan> imaging_plan_wrapper(
+    np_double_array snr_weights,
+    np_double_array uvw_lambda,
+    uint image_size,
+    double cell_size,
+    double padding_factor,
+    stp::KernelFunction kernel_func,
+    uint kernel_support,
+    bool kernel_exact,
+    uint oversampling,
+    bool generate_beam,
+    bool gridding_correction,
+    bool analytic_gcf,
+    stp::FFTRoutine r_fft,
+    std::string fft_wisdom_filename,
+    uint num_wplanes,
+    bool wplanes_median,
+    uint max_wpconv_support,
+    bool hankel_opt,
+    bool hankel_proj_slice,
+    uint undersampling_opt,
+    double kernel_trunc_perc,
+    stp::InterpType interp_type,
+    uint aproj_numtimesteps,
+    double obs_dec,
+    double obs_ra,
+    bool aproj_opt,
+    double aproj_mask_perc,
+    np_double_array lha,
+    np_double_array pbeam_coefs)
+{
+    assert(uvw_lambda.request().ndim == 2); // uv_pixels is a 2D array
+
+    stp::ImagerPars img_pars;
+    stp::W_ProjectionPars wproj_pars;
+    stp::A_ProjectionPars aproj_pars;
+    std::tie(img_pars, wproj_pars, aproj_pars) = make_imager_pars(image_size, cell_size, padding_factor, kernel_func, kernel_support, kernel_exact, oversampling,
+        generate_beam, gridding_correction, analytic_gcf, r_fft, fft_wisdom_filename, num_wplanes, wplanes_median, max_wpconv_support,
+        hankel_opt, hankel_proj_slice, undersampling_opt, kernel_trunc_perc, interp_type, aproj_numtimesteps, obs_dec, obs_ra, aproj_opt,
+        aproj_mask_perc, lha, pbeam_coefs);
+
+    arma::mat snr_weights_arma(
+        static_cast<ptr_double>(snr_weights.request().ptr),
+        uvw_lambda.request().shape[0], // n_rows
+        1, // n_cols
+        false,
+        true);
+
+    arma::mat uvw_lambda_arma(
+        static_cast<ptr_double>(uvw_lambda.request().ptr),
+        uvw_lambda.request().shape[0], // n_rows
+        uvw_lambda.request().shape[1], // n_cols
+        false,
+        true);
+
+    // Create imaging plan
+    return stp::ImageVisibilities::make_plan(snr_weights_arma, uvw_lambda_arma, img_pars, wproj_pars, aproj_pars);
+}
+
+pybind11::tuple imaging_plan_image_wrapper(stp::ImagingPlan& plan, np_complex_double_array vis)
+{
+    assert(vis.request().ndim == 1); // vis is a 1D array
+
+    arma::cx_mat vis_arma(
+        static_cast<ptr_complex_double>(vis.request().ptr),
+        vis.request().shape[0], // n_rows
+        1, // vis is a vector (ndim = 1), so there is no shape[1]
+        false, // copy_aux_mem - do not copy memory for better performance (it will not be modified)
+        true); // strict
+
+    // Run imager with the plan
+    stp::ImageVisibilities imager(vis_arma, plan);
+
+    return imager_result_to_tuple(imager);
+}
+
 std::vector<std::tuple<int, double, int, int, int, stp::Gaussian2dParams, stp::Gaussian2dParams, std::string>> source_find_wrapper(
     np_real_array image_data,
     double detection_n_sigma,
@@ -267,6 +391,43 @@ PYBIND11_MODULE(stp_python, m)
         pybind11::arg("lha") = np_double_array(),
         pybind11::arg("pbeam_coefs") = np_double_array());
 
+    // ImagingPlan class binding
+    pybind11::class_<stp::ImagingPlan>(m, "ImagingPlan")
+        .def("image", &imaging_plan_image_wrapper, "Compute image visibilities (gridding + ifft) using the imaging plan.",
+            pybind11::arg("vis"))
+        .def("num_vis", &stp::ImagingPlan::num_vis);
+
+    m.def("imaging_plan_wrapper", &imaging_plan_wrapper, "Create an imaging plan for fixed UVW-coordinates and weights.",
+        pybind11::arg("snr_weights"),
+        pybind11::arg("uvw_lambda"),
+        pybind11::arg("image_size"),
+        pybind11::arg("cell_size"),
+        pybind11::arg("padding_factor") = 1.0,
+        pybind11::arg("kernel_func") = stp::KernelFunction::PSWF,
+        pybind11::arg("kernel_support") = 3,
+        pybind11::arg("kernel_exact") = true,
+        pybind11::arg("kernel_oversampling") = 8,
+        pybind11::arg("generate_beam") = false,
+        pybind11::arg("gridding_correction") = true,
+        pybind11::arg("analytic_gcf") = false,
+        pybind11::arg("r_fft") = stp::FFTRoutine::FFTW_ESTIMATE_FFT,
+        pybind11::arg("fft_wisdom_filename") = std::string(),
+        pybind11::arg("num_wplanes") = 0,
+        pybind11::arg("wplanes_median") = false,
+        pybind11::arg("max_wpconv_support") = 0,
+        pybind11::arg("hankel_opt") = false,
+        pybind11::arg("hankel_proj_slice") = false,
+        pybind11::arg("undersampling_opt") = 1,
+        pybind11::arg("kernel_trunc_perc") = 0.0,
+        pybind11::arg("interp_type") = stp::InterpType::LINEAR,
+        pybind11::arg("aproj_numtimesteps") = 0,
+        pybind11::arg("obs_dec") = 0.0,
+        pybind11::arg("obs_ra") = 0.0,
+        pybind11::arg("aproj_opt") = false,
+        pybind11::arg("aproj_mask_perc") = 0.0,
+        pybind11::arg("lha") = np_double_array(),
+        pybind11::arg("pbeam_coefs") = np_double_array());
+
     m.def("source_find_wrapper", &source_find_wrapper, "Find connected regions which peak above/below a given threshold.",
         pybind11::arg("image_data"),
         pybind11::arg("detection_n_sigma"),
@@ -8,6 +8,7 @@
 
 #include <armadillo>
 #include <complex>
+#include <memory>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <stp.h>
@@ -102,6 +103,64 @@ pybind11::tuple image_visibilities_wrapper(
     np_double_array lha, // numpy.ndarray<np.float_>
     np_double_array pbeam_coefs); // numpy.ndarray<np.float_>
 
+/**
+ * @brief Convenience wrapper over ImageVisibilities::make_plan function.
+ *
+ * Creates an imaging plan for a fixed set of UVW-coordinates and weights (e.g. consecutive snapshots with the same UVW coverage).
+ * The gridding geometry and convolution kernels are computed once, and only the accumulation is performed when imaging new visibilities
+ * (see ImagingPlan.image). This function shall be called from python code.
+ *
+ * @param[in] snr_weights (numpy.ndarray<np.float_>): Visibility weights. 1D array, shape: (n_vis,).
+ * @param[in] uvw_lambda (numpy.ndarray<np.float_>): UVW-coordinates of visibilities. Units are multiples of wavelength.
+ *                                                   2D array, shape: (n_vis, 3). Assumed ordering is u,v,w.
+ *
+ * The remaining parameters are the same as for image_visibilities_wrapper.
+ *
+ * @return (stp::ImagingPlan): Imaging plan.
+ */
+std::unique_ptr<stp::ImagingPlan> imaging_plan_wrapper(
+    np_double_array snr_weights, // numpy.ndarray<np.float_>
+    np_double_array uvw_lambda, // numpy.ndarray<np.float_>
+    uint image_size,
+    double cell_size,
+    double padding_factor,
+    stp::KernelFunction kernel_func, // enum
+    uint kernel_support,
+    bool kernel_exact,
+    uint oversampling,
+    bool generate_beam,
+    bool gridding_correction,
+    bool analytic_gcf,
+    stp::FFTRoutine r_fft, // enum
+    std::string fft_wisdom_filename,
+    uint num_wplanes,
+    bool wplanes_median,
+    uint max_wpconv_support,
+    bool hankel_opt,
+    bool hankel_proj_slice,
+    uint undersampling_opt,
+    double kernel_trunc_perc,
+    stp::InterpType interp_type, // enum
+    uint aproj_numtimesteps,
+    double obs_dec,
+    double obs_ra,
+    bool aproj_opt,
+    double aproj_mask_perc,
+    np_double_array lha, // numpy.ndarray<np.float_>
+    np_double_array pbeam_coefs); // numpy.ndarray<np.float_>
+
+/**
+ * @brief Convenience wrapper over ImagingPlan::image function.
+ *
+ * This function shall be called from python code (as ImagingPlan.image method).
+ *
+ * @param[in] plan (stp::ImagingPlan): Imaging plan.
+ * @param[in] vis (numpy.ndarray<np.complex_>): Complex visibilities, in the order of the plan UVW-coordinates. 1D array, shape: (n_vis,).
+ *
+ * @return (pybind11::tuple): Tuple of numpy.ndarrays representing the image map and beam model (image, beam).
+ */
+pybind11::tuple imaging_plan_image_wrapper(stp::ImagingPlan& plan, np_complex_double_array vis);
+
 /**
  * @brief Convenience wrapper over SourceFindImage function.
  *
@@ -4,223 +4,461 @@
 */
 
 #include "fft.h"
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <fftw3.h>
+#include <fstream>
+#include <memory>
 #include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
 
 #include "../global_macros.h"
 
 namespace stp {
 
-void init_fftw(FFTRoutine r_fft, std::string fft_wisdom_filename)
+namespace {
+
+// FFTW planner flag of the FFT routine
+unsigned int fftw_planner_flag(FFTRoutine r_fft)
 {
-// Init fftw threads
-#ifdef USE_FLOAT
-    if (!fftwf_init_threads()) {
-        throw std::runtime_error("Failed to init FFTW threads");
+    switch (r_fft) {
+    case FFTRoutine::FFTW_ESTIMATE_FFT:
+        return FFTW_ESTIMATE;
+    case FFTRoutine::FFTW_MEASURE_FFT:
+        // Plan generation is slow, but it is only done once per shape (plans are cached)
+        return FFTW_MEASURE;
+    case FFTRoutine::FFTW_PATIENT_FFT:
+        // Plan generation is very slow, but it is only done once per shape (plans are cached)
+        return FFTW_PATIENT;
+    case FFTRoutine::FFTW_WISDOM_FFT:
+    case FFTRoutine::FFTW_WISDOM_INPLACE_FFT:
+        return FFTW_WISDOM_ONLY;
+    default:
         assert(0);
+        return FFTW_ESTIMATE;
     }
-    fftwf_plan_with_nthreads(std::thread::hardware_concurrency());
+}
+
+// Key of the plan of the given arrays
+FFTPlanKey fft_plan_key(FFTPlanKind kind, int n0, int n1, int direction, void* input, void* output, FFTRoutine r_fft, int stride = 1)
+{
+    FFTPlanKey key;
+    key.kind = kind;
+    key.n0 = n0;
+    key.n1 = n1;
+    key.stride = stride;
+    key.direction = direction;
+    key.in_place = (input == output);
+#ifdef USE_FLOAT
+    key.in_alignment = fftwf_alignment_of(static_cast<float*>(input));
+    key.out_alignment = fftwf_alignment_of(static_cast<float*>(output));
 #else
-    if (!fftw_init_threads()) {
-        throw std::runtime_error("Failed to init FFTW threads");
-        assert(0);
+    key.in_alignment = fftw_alignment_of(static_cast<double*>(input));
+    key.out_alignment = fftw_alignment_of(static_cast<double*>(output));
+#endif
+    key.flags = fftw_planner_flag(r_fft);
+    key.precision = sizeof(real_t);
+    return key;
+}
+
+// Creates the FFTW plan of the key for the given arrays
+FFTWPlan create_fftw_plan(const FFTPlanKey& key, void* input, void* output, unsigned int flags)
+{
+    // Dimensions are given in FFTW (row-major) order
+    const int dims[2] = { key.n0, key.n1 };
+
+#ifdef USE_FLOAT
+    float* in_real = static_cast<float*>(input);
+    float* out_real = static_cast<float*>(output);
+    fftwf_complex* in_cx = static_cast<fftwf_complex*>(input);
+    fftwf_complex* out_cx = static_cast<fftwf_complex*>(output);
+    const fftwf_r2r_kind kinds[2] = { FFTW_REDFT00, FFTW_REDFT00 };
+
+    switch (key.kind) {
+    case FFTPlanKind::C2R_2D:
+        return fftwf_plan_dft_c2r_2d(key.n0, key.n1, in_cx, out_real, flags);
+    case FFTPlanKind::R2C_2D:
+        return fftwf_plan_dft_r2c_2d(key.n0, key.n1, in_real, out_cx, flags);
+    case FFTPlanKind::C2C_2D:
+        return fftwf_plan_dft_2d(key.n0, key.n1, in_cx, out_cx, key.direction, flags);
+    case FFTPlanKind::C2C_EVEN_2D:
+        // Two interleaved real transforms (real and imaginary parts)
+        return fftwf_plan_many_r2r(2, dims, 2, in_real, NULL, 2, 1, out_real, NULL, 2, 1, kinds, flags);
+    case FFTPlanKind::R2HC_1D:
+        return fftwf_plan_r2r_1d(key.n0, in_real, out_real, FFTW_R2HC, flags);
+    case FFTPlanKind::C2C_1D:
+        return fftwf_plan_dft_1d(key.n0, in_cx, out_cx, key.direction, flags);
+    case FFTPlanKind::C2C_ROWS_1D:
+        return fftwf_plan_many_dft(1, &key.n0, key.n1, in_cx, NULL, key.stride, 1, out_cx, NULL, key.stride, 1, key.direction, flags);
+    case FFTPlanKind::C2R_COLS_1D:
+        return fftwf_plan_many_dft_c2r(1, &key.n0, key.n1, in_cx, NULL, 1, key.stride, out_real, NULL, 1, 2 * key.stride, flags);
+    }
+#else
+    double* in_real = static_cast<double*>(input);
+    double* out_real = static_cast<double*>(output);
+    fftw_complex* in_cx = static_cast<fftw_complex*>(input);
+    fftw_complex* out_cx = static_cast<fftw_complex*>(output);
+    const fftw_r2r_kind kinds[2] = { FFTW_REDFT00, FFTW_REDFT00 };
+
+    switch (key.kind) {
+    case FFTPlanKind::C2R_2D:
+        return fftw_plan_dft_c2r_2d(key.n0, key.n1, in_cx, out_real, flags);
+    case FFTPlanKind::R2C_2D:
+        return fftw_plan_dft_r2c_2d(key.n0, key.n1, in_real, out_cx, flags);
+    case FFTPlanKind::C2C_2D:
+        return fftw_plan_dft_2d(key.n0, key.n1, in_cx, out_cx, key.direction, flags);
+    case FFTPlanKind::C2C_EVEN_2D:
+        // Two interleaved real transforms (real and imaginary parts)
+        return fftw_plan_many_r2r(2, dims, 2, in_real, NULL, 2, 1, out_real, NULL, 2, 1, kinds, flags);
+    case FFTPlanKind::R2HC_1D:
+        return fftw_plan_r2r_1d(key.n0, in_real, out_real, FFTW_R2HC, flags);
+    case FFTPlanKind::C2C_1D:
+        return fftw_plan_dft_1d(key.n0, in_cx, out_cx, key.direction, flags);
+    case FFTPlanKind::C2C_ROWS_1D:
+        return fftw_plan_many_dft(1, &key.n0, key.n1, in_cx, NULL, key.stride, 1, out_cx, NULL, key.stride, 1, key.direction, flags);
+    case FFTPlanKind::C2R_COLS_1D:
+        return fftw_plan_many_dft_c2r(1, &key.n0, key.n1, in_cx, NULL, 1, key.stride, out_real, NULL, 1, 2 * key.stride, flags);
     }
-    fftw_plan_with_nthreads(std::thread::hardware_concurrency());
 #endif
+    assert(0);
+    return NULL;
+}
+
+void destroy_fftw_plan(FFTWPlan plan)
+{
+#ifdef USE_FLOAT
+    fftwf_destroy_plan(plan);
+#else
+    fftw_destroy_plan(plan);
+#endif
+}
+
+// FFTW aligned buffer with the given alignment offset
+class FFTBuffer {
+public:
+    FFTBuffer(size_t num_bytes, int alignment)
+#ifdef USE_FLOAT
+        : memory(fftwf_malloc(num_bytes + FFT_MAX_ALIGNMENT))
+#else
+        : memory(fftw_malloc(num_bytes + FFT_MAX_ALIGNMENT))
+#endif
+    {
+        if (memory == NULL) {
+            throw std::runtime_error("Failed to allocate FFTW buffer.");
+        }
+        std::fill_n(static_cast<char*>(memory), num_bytes + FFT_MAX_ALIGNMENT, 0);
+        data = static_cast<char*>(memory) + alignment;
+    }
+
+    ~FFTBuffer()
+    {
+#ifdef USE_FLOAT
+        fftwf_free(memory);
+#else
+        fftw_free(memory);
+#endif
+    }
+
+    FFTBuffer(const FFTBuffer&) = delete;
+    FFTBuffer& operator=(const FFTBuffer&) = delete;
+
+    void* memory;
+    void* data;
+};
+}
+
+bool FFTPlanKey::operator<(const FFTPlanKey& other) const
+{
+    return std::tie(kind, n0, n1, stride, direction, in_place, in_alignment, out_alignment, flags, precision)
+        < std::tie(other.kind, other.n0, other.n1, other.stride, other.direction, other.in_place, other.in_alignment, other.out_alignment, other.flags,
+              other.precision);
+}
+
+FFTContext& FFTContext::instance()
+{
+    static FFTContext context;
+    return context;
+}
+
+FFTContext::~FFTContext()
+{
+    destroy_plans();
+}
+
+void FFTContext::init(FFTRoutine r_fft, const std::string& fft_wisdom_filename)
+{
+    std::lock_guard<std::mutex> lock(planner_mutex);
+
+    // Init fftw threads
+    if (!threads_initialized) {
+#ifdef USE_FLOAT
+        if (!fftwf_init_threads()) {
+            throw std::runtime_error("Failed to init FFTW threads");
+            assert(0);
+        }
+        fftwf_plan_with_nthreads(std::thread::hardware_concurrency());
+#else
+        if (!fftw_init_threads()) {
+            throw std::runtime_error("Failed to init FFTW threads");
+            assert(0);
+        }
+        fftw_plan_with_nthreads(std::thread::hardware_concurrency());
+#endif
+        threads_initialized = true;
+    }
 
     // Import Wisdom file
     if ((r_fft == FFTRoutine::FFTW_WISDOM_FFT) || (r_fft == FFTRoutine::FFTW_WISDOM_INPLACE_FFT)) {
+        if (wisdom_files.count(fft_wisdom_filename) == 0) {
+            if (!std::ifstream(fft_wisdom_filename).good()) {
+                // Missing wisdom file: the plans of all shapes are reported as missing wisdom (see tune_missing_plans)
+                STPLIB_DEBUG("stplib", "FFTW wisdom file {} not found. Using FFTW_ESTIMATE plans until wisdom is generated.", fft_wisdom_filename);
 #ifdef USE_FLOAT
-        if (!fftwf_import_wisdom_from_filename(fft_wisdom_filename.c_str())) {
+            } else if (!fftwf_import_wisdom_from_filename(fft_wisdom_filename.c_str())) {
 #else
-        if (!fftw_import_wisdom_from_filename(fft_wisdom_filename.c_str())) {
+            } else if (!fftw_import_wisdom_from_filename(fft_wisdom_filename.c_str())) {
 #endif
-            throw std::runtime_error("Failed to read FFTW wisdom file: " + fft_wisdom_filename);
-            assert(0);
+                throw std::runtime_error("Failed to read FFTW wisdom file: " + fft_wisdom_filename);
+                assert(0);
+            }
+            wisdom_files.insert(fft_wisdom_filename);
         }
     }
 }
 
-void fft_fftw_c2r(arma::Mat<cx_real_t>& input, arma::Mat<real_t>& output, FFTRoutine r_fft)
+FFTWPlan FFTContext::plan(const FFTPlanKey& key, void* input, void* output, size_t input_bytes)
 {
-    size_t n_rows = (input.n_rows % 2 == 0) ? (input.n_rows * 2) : (input.n_rows - 1) * 2;
-    size_t n_cols = input.n_cols;
-
-    if (reinterpret_cast<real_t*>(input.memptr()) != output.memptr()) {
-        output.set_size(n_rows, n_cols);
+    {
+        std::lock_guard<std::mutex> plans_lock(plans_mutex);
+        auto it = plans.find(key);
+        if (it != plans.end()) {
+            return it->second;
+        }
     }
-    unsigned int fftw_flag = FFTW_ESTIMATE;
 
-    switch (r_fft) {
-    case FFTRoutine::FFTW_ESTIMATE_FFT:
-        fftw_flag = FFTW_ESTIMATE;
-        break;
-    case FFTRoutine::FFTW_MEASURE_FFT:
-        // Do not use this mode as the plan generation is very slow
-        fftw_flag = FFTW_MEASURE;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_PATIENT_FFT:
-        // Do not use this mode as the plan generation is extremely slow
-        fftw_flag = FFTW_PATIENT;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_WISDOM_FFT:
-    case FFTRoutine::FFTW_WISDOM_INPLACE_FFT:
-        fftw_flag = FFTW_WISDOM_ONLY;
-        break;
-    default:
-        assert(0);
-        break;
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    {
+        // The plan may have been created by another thread while waiting for the planner
+        std::lock_guard<std::mutex> plans_lock(plans_mutex);
+        auto it = plans.find(key);
+        if (it != plans.end()) {
+            return it->second;
+        }
     }
 
-#ifdef USE_FLOAT
+    // FFTW_MEASURE and FFTW_PATIENT planners overwrite the arrays
+    const bool overwrites_input = !(key.flags & (FFTW_ESTIMATE | FFTW_WISDOM_ONLY));
+    std::vector<char> input_backup;
+    if (overwrites_input) {
+        input_backup.assign(static_cast<char*>(input), static_cast<char*>(input) + input_bytes);
+    }
 
-    fftwf_plan plan = fftwf_plan_dft_c2r_2d(
-        n_cols, // FFTW uses row-major order, requiring the plan
-        n_rows, // to be passed the dimensions in reverse.
-        reinterpret_cast<fftwf_complex*>(input.memptr()),
-        reinterpret_cast<float*>(output.memptr()),
-        fftw_flag);
+    FFTWPlan fft_plan = create_fftw_plan(key, input, output, key.flags);
 
-    assert(plan != NULL);
+    bool no_wisdom = false;
+    if (fft_plan == NULL) {
+        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", key.n0, key.n1);
 
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", n_cols, n_rows);
+        fft_plan = create_fftw_plan(key, input, output, FFTW_ESTIMATE);
+        no_wisdom = (key.flags & FFTW_WISDOM_ONLY) != 0;
+    }
 
-        plan = fftwf_plan_dft_c2r_2d(
-            n_cols, // FFTW uses row-major order, requiring the plan
-            n_rows, // to be passed the dimensions in reverse.
-            reinterpret_cast<fftwf_complex*>(input.memptr()),
-            reinterpret_cast<float*>(output.memptr()),
-            FFTW_ESTIMATE);
+    if (overwrites_input) {
+        std::copy(input_backup.begin(), input_backup.end(), static_cast<char*>(input));
     }
 
-    if (plan == NULL) {
+    if (fft_plan == NULL) {
         throw std::runtime_error("Failed to create FFTW plan.");
     }
 
-    fftwf_execute(plan);
-    fftwf_destroy_plan(plan);
-#else
-    fftw_plan plan = fftw_plan_dft_c2r_2d(
-        n_cols, // FFTW uses row-major order, requiring the plan
-        n_rows, // to be passed the dimensions in reverse.
-        reinterpret_cast<fftw_complex*>(input.memptr()),
-        reinterpret_cast<double*>(output.memptr()),
-        fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", n_cols, n_rows);
-
-        plan = fftw_plan_dft_c2r_2d(
-           n_cols, // FFTW uses row-major order, requiring the plan
-           n_rows, // to be passed the dimensions in reverse.
-           reinterpret_cast<fftw_complex*>(input.memptr()),
-           reinterpret_cast<double*>(output.memptr()),
-           FFTW_ESTIMATE);
+    std::lock_guard<std::mutex> plans_lock(plans_mutex);
+    if (no_wisdom) {
+        missing_wisdom_plans.insert(key);
     }
+    plans.emplace(key, fft_plan);
+    return fft_plan;
+}
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
+size_t FFTContext::num_plans()
+{
+    std::lock_guard<std::mutex> lock(plans_mutex);
+    return plans.size();
+}
+
+std::vector<FFTPlanKey> FFTContext::missing_wisdom()
+{
+    std::lock_guard<std::mutex> lock(plans_mutex);
+    return std::vector<FFTPlanKey>(missing_wisdom_plans.begin(), missing_wisdom_plans.end());
+}
+
+size_t FFTContext::tune_missing_plans(FFTRoutine r_fft)
+{
+    const unsigned int tune_flags = fftw_planner_flag(r_fft);
+    assert(!(tune_flags & (FFTW_ESTIMATE | FFTW_WISDOM_ONLY)));
+
+    size_t num_tuned = 0;
+    for (const FFTPlanKey& key : missing_wisdom()) {
+        // Scratch arrays with the alignment of the key (large enough for any transform kind of the key dimensions)
+        const size_t num_values = std::max(size_t(key.n0) * size_t(key.n1 + 2), size_t(key.stride) * size_t(std::max(key.n0, key.n1)));
+        const size_t num_bytes = num_values * 2 * key.precision;
+        FFTBuffer input(num_bytes, key.in_alignment);
+        std::unique_ptr<FFTBuffer> output;
+        if (!key.in_place) {
+            output = std::make_unique<FFTBuffer>(num_bytes, key.out_alignment);
+        }
+
+        // Measured plans are added to the FFTW wisdom (cached plans are still found meanwhile, as the plan cache is not locked)
+        std::lock_guard<std::mutex> lock(planner_mutex);
+        FFTWPlan fft_plan = create_fftw_plan(key, input.data, key.in_place ? input.data : output->data, tune_flags);
+        if (fft_plan == NULL) {
+            STPLIB_DEBUG("stplib", "Failed to measure FFTW plan for {} x {} size.", key.n0, key.n1);
+            continue;
+        }
+
+        // The FFTW_ESTIMATE plan may be running in other threads, hence it is only destroyed with the context plans
+        std::lock_guard<std::mutex> plans_lock(plans_mutex);
+        auto it = plans.find(key);
+        if (it != plans.end()) {
+            retired_plans.push_back(it->second);
+            it->second = fft_plan;
+        } else {
+            plans.emplace(key, fft_plan);
+        }
+        missing_wisdom_plans.erase(key);
+        num_tuned++;
     }
+    return num_tuned;
+}
 
-    assert(plan != NULL);
-    fftw_execute(plan);
-    fftw_destroy_plan(plan);
-#endif
+std::future<size_t> FFTContext::tune_missing_plans_async(FFTRoutine r_fft)
+{
+    return std::async(std::launch::async, [this, r_fft]() { return tune_missing_plans(r_fft); });
 }
 
-void fft_fftw_r2c(arma::Mat<real_t>& input, arma::Mat<cx_real_t>& output, FFTRoutine r_fft)
+void FFTContext::save_wisdom(const std::string& fft_wisdom_filename)
 {
-    size_t n_rows = input.n_rows / 2 + 1;
-    size_t n_cols = input.n_cols;
-    if (input.memptr() != reinterpret_cast<real_t*>(output.memptr())) {
-        output.set_size(n_rows, n_cols);
+    std::lock_guard<std::mutex> lock(planner_mutex);
+
+    // Merge the wisdom of the file (generated by other runs) with the current wisdom
+    if (std::ifstream(fft_wisdom_filename).good()) {
+#ifdef USE_FLOAT
+        fftwf_import_wisdom_from_filename(fft_wisdom_filename.c_str());
+#else
+        fftw_import_wisdom_from_filename(fft_wisdom_filename.c_str());
+#endif
     }
-    unsigned int fftw_flag = FFTW_ESTIMATE;
 
-    switch (r_fft) {
-    case FFTRoutine::FFTW_ESTIMATE_FFT:
-        fftw_flag = FFTW_ESTIMATE;
-        break;
-    case FFTRoutine::FFTW_MEASURE_FFT:
-        // Do not use this mode as the plan generation is very slow
-        fftw_flag = FFTW_MEASURE;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_PATIENT_FFT:
-        // Do not use this mode as the plan generation is extremely slow
-        fftw_flag = FFTW_PATIENT;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_WISDOM_FFT:
-    case FFTRoutine::FFTW_WISDOM_INPLACE_FFT:
-        fftw_flag = FFTW_WISDOM_ONLY;
-        break;
-    default:
-        assert(0);
-        break;
+#ifdef USE_FLOAT
+    if (!fftwf_export_wisdom_to_filename(fft_wisdom_filename.c_str())) {
+#else
+    if (!fftw_export_wisdom_to_filename(fft_wisdom_filename.c_str())) {
+#endif
+        throw std::runtime_error("Failed to write FFTW wisdom file: " + fft_wisdom_filename);
+    }
+    wisdom_files.insert(fft_wisdom_filename);
+}
+
+std::string FFTContext::host_wisdom_filename(const std::string& directory)
+{
+    char hostname[256] = { 0 };
+    if (gethostname(hostname, sizeof(hostname) - 1) != 0) {
+        std::copy_n("unknown", 8, hostname);
     }
 
+    // FFTW version (e.g. "fftw-3.3.8-sse2-avx"): wisdom is only valid for the library build that generated it
 #ifdef USE_FLOAT
-    fftwf_plan plan = fftwf_plan_dft_r2c_2d(
-        input.n_cols, // FFTW uses row-major order, requiring the plan
-        input.n_rows, // to be passed the dimensions in reverse.
-        reinterpret_cast<float*>(input.memptr()),
-        reinterpret_cast<fftwf_complex*>(output.memptr()),
-        fftw_flag);
+    std::string version(fftwf_version);
+    const std::string precision("float");
+#else
+    std::string version(fftw_version);
+    const std::string precision("double");
+#endif
+    std::replace_if(version.begin(), version.end(), [](char c) { return !(std::isalnum(c) || (c == '.') || (c == '-')); }, '_');
 
-    assert(plan != NULL);
+    std::string prefix = directory.empty() ? std::string() : (directory + "/");
+    return prefix + "WisdomFile_STP_" + std::string(hostname) + "_" + version + "_" + precision + ".fftw";
+}
 
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", input.n_cols, input.n_rows);
+void FFTContext::clear_plans()
+{
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    std::lock_guard<std::mutex> plans_lock(plans_mutex);
+    destroy_plans();
+}
 
-        plan = fftwf_plan_dft_r2c_2d(
-           input.n_cols, // FFTW uses row-major order, requiring the plan
-           input.n_rows, // to be passed the dimensions in reverse.
-           reinterpret_cast<float*>(input.memptr()),
-           reinterpret_cast<fftwf_complex*>(output.memptr()),
-           FFTW_ESTIMATE);
+void FFTContext::cleanup()
+{
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    std::lock_guard<std::mutex> plans_lock(plans_mutex);
+    destroy_plans();
+    if (threads_initialized) {
+#ifdef USE_FLOAT
+        fftwf_cleanup_threads();
+#else
+        fftw_cleanup_threads();
+#endif
+        threads_initialized = false;
     }
+    wisdom_files.clear();
+}
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
+void FFTContext::destroy_plans()
+{
+    for (auto& p : plans) {
+        destroy_fftw_plan(p.second);
+    }
+    for (FFTWPlan p : retired_plans) {
+        destroy_fftw_plan(p);
     }
+    plans.clear();
+    retired_plans.clear();
+    missing_wisdom_plans.clear();
+}
 
-    fftwf_execute(plan);
-    fftwf_destroy_plan(plan);
-#else
-    fftw_plan plan = fftw_plan_dft_r2c_2d(
-        input.n_cols, // FFTW uses row-major order, requiring the plan
-        input.n_rows, // to be passed the dimensions in reverse.
-        reinterpret_cast<double*>(input.memptr()),
-        reinterpret_cast<fftw_complex*>(output.memptr()),
-        fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", input.n_cols, input.n_rows);
+void init_fftw(FFTRoutine r_fft, std::string fft_wisdom_filename)
+{
+    FFTContext::instance().init(r_fft, fft_wisdom_filename);
+}
+
+void fft_fftw_c2r(arma::Mat<cx_real_t>& input, arma::Mat<real_t>& output, FFTRoutine r_fft)
+{
+    size_t n_rows = (input.n_rows % 2 == 0) ? (input.n_rows * 2) : (input.n_rows - 1) * 2;
+    size_t n_cols = input.n_cols;
 
-        plan = fftw_plan_dft_r2c_2d(
-            input.n_cols, // FFTW uses row-major order, requiring the plan
-            input.n_rows, // to be passed the dimensions in reverse.
-            reinterpret_cast<double*>(input.memptr()),
-            reinterpret_cast<fftw_complex*>(output.memptr()),
-            FFTW_ESTIMATE);
+    if (reinterpret_cast<real_t*>(input.memptr()) != output.memptr()) {
+        output.set_size(n_rows, n_cols);
     }
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
+    // FFTW uses row-major order, requiring the plan to be passed the dimensions in reverse.
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::C2R_2D, int(n_cols), int(n_rows), FFTW_BACKWARD, input.memptr(), output.memptr(), r_fft);
+    FFTWPlan plan = FFTContext::instance().plan(key, input.memptr(), output.memptr(), input.n_elem * sizeof(cx_real_t));
+
+#ifdef USE_FLOAT
+    fftwf_execute_dft_c2r(plan, reinterpret_cast<fftwf_complex*>(input.memptr()), reinterpret_cast<float*>(output.memptr()));
+#else
+    fftw_execute_dft_c2r(plan, reinterpret_cast<fftw_complex*>(input.memptr()), reinterpret_cast<double*>(output.memptr()));
+#endif
+}
+
+void fft_fftw_r2c(arma::Mat<real_t>& input, arma::Mat<cx_real_t>& output, FFTRoutine r_fft)
+{
+    size_t n_rows = input.n_rows / 2 + 1;
+    size_t n_cols = input.n_cols;
+    if (input.memptr() != reinterpret_cast<real_t*>(output.memptr())) {
+        output.set_size(n_rows, n_cols);
     }
 
-    assert(plan != NULL);
-    fftw_execute(plan);
-    fftw_destroy_plan(plan);
+    // FFTW uses row-major order, requiring the plan to be passed the dimensions in reverse.
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::R2C_2D, int(input.n_cols), int(input.n_rows), FFTW_FORWARD, input.memptr(), output.memptr(), r_fft);
+    FFTWPlan plan = FFTContext::instance().plan(key, input.memptr(), output.memptr(), input.n_elem * sizeof(real_t));
+
+#ifdef USE_FLOAT
+    fftwf_execute_dft_r2c(plan, reinterpret_cast<float*>(input.memptr()), reinterpret_cast<fftwf_complex*>(output.memptr()));
+#else
+    fftw_execute_dft_r2c(plan, reinterpret_cast<double*>(input.memptr()), reinterpret_cast<fftw_complex*>(output.memptr()));
 #endif
 }
 
@@ -231,274 +469,149 @@ void fft_fftw_c2c(arma::Mat<cx_real_t>& input, arma::Mat<cx_real_t>& output, FFT
     if (input.memptr() != output.memptr()) {
         output.set_size(n_rows, n_cols);
     }
-    unsigned int fftw_flag = FFTW_ESTIMATE;
-
-    switch (r_fft) {
-    case FFTRoutine::FFTW_ESTIMATE_FFT:
-        fftw_flag = FFTW_ESTIMATE;
-        break;
-    case FFTRoutine::FFTW_MEASURE_FFT:
-        // Do not use this mode as the plan generation is very slow
-        fftw_flag = FFTW_MEASURE;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_PATIENT_FFT:
-        // Do not use this mode as the plan generation is extremely slow
-        fftw_flag = FFTW_PATIENT;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_WISDOM_FFT:
-    case FFTRoutine::FFTW_WISDOM_INPLACE_FFT:
-        fftw_flag = FFTW_WISDOM_ONLY;
-        break;
-    default:
-        assert(0);
-        break;
-    }
 
     int direction = FFTW_FORWARD;
     if (!forward) {
         direction = FFTW_BACKWARD;
     }
 
-#ifdef USE_FLOAT
-    fftwf_plan plan = fftwf_plan_dft_2d(
-        n_rows, // FFTW uses row-major order, requiring the plan
-        n_cols, // to be passed the dimensions in reverse.
-        reinterpret_cast<fftwf_complex*>(input.memptr()),
-        reinterpret_cast<fftwf_complex*>(output.memptr()),
-        direction,
-        fftw_flag);
-
-    assert(plan != NULL);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", n_cols, n_rows);
-
-        plan = fftwf_plan_dft_2d(
-            n_rows, // FFTW uses row-major order, requiring the plan
-            n_cols, // to be passed the dimensions in reverse.
-            reinterpret_cast<fftwf_complex*>(input.memptr()),
-            reinterpret_cast<fftwf_complex*>(output.memptr()),
-            direction,
-            FFTW_ESTIMATE);
-    }
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::C2C_2D, int(n_rows), int(n_cols), direction, input.memptr(), output.memptr(), r_fft);
+    FFTWPlan plan = FFTContext::instance().plan(key, input.memptr(), output.memptr(), input.n_elem * sizeof(cx_real_t));
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
-    }
-
-    fftwf_execute(plan);
-    fftwf_destroy_plan(plan);
+#ifdef USE_FLOAT
+    fftwf_execute_dft(plan, reinterpret_cast<fftwf_complex*>(input.memptr()), reinterpret_cast<fftwf_complex*>(output.memptr()));
 #else
-    fftw_plan plan = fftw_plan_dft_2d(
-        n_rows, // FFTW uses row-major order, requiring the plan
-        n_cols, // to be passed the dimensions in reverse.
-        reinterpret_cast<fftw_complex*>(input.memptr()),
-        reinterpret_cast<fftw_complex*>(output.memptr()),
-        direction,
-        fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} x {} size. Trying again with FFTW_ESTIMATE...", n_cols, n_rows);
+    fftw_execute_dft(plan, reinterpret_cast<fftw_complex*>(input.memptr()), reinterpret_cast<fftw_complex*>(output.memptr()));
+#endif
+}
 
-        plan = fftw_plan_dft_2d(
-            n_rows, // FFTW uses row-major order, requiring the plan
-            n_cols, // to be passed the dimensions in reverse.
-            reinterpret_cast<fftw_complex*>(input.memptr()),
-            reinterpret_cast<fftw_complex*>(output.memptr()),
-            direction,
-            FFTW_ESTIMATE);
+void fft_fftw_c2c_even(arma::Mat<cx_real_t>& input, arma::Mat<cx_real_t>& output, FFTRoutine r_fft)
+{
+    size_t n_rows = input.n_rows;
+    size_t n_cols = input.n_cols;
+    assert((n_rows >= 2) && (n_cols >= 2));
+    if (input.memptr() != output.memptr()) {
+        output.set_size(n_rows, n_cols);
     }
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
-    }
+    // Real-even transforms of the real and imaginary parts. FFTW uses row-major order, requiring the dimensions in reverse.
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::C2C_EVEN_2D, int(n_cols), int(n_rows), 0, input.memptr(), output.memptr(), r_fft);
+    FFTWPlan plan = FFTContext::instance().plan(key, input.memptr(), output.memptr(), input.n_elem * sizeof(cx_real_t));
 
-    fftw_execute(plan);
-    fftw_destroy_plan(plan);
+#ifdef USE_FLOAT
+    fftwf_execute_r2r(plan, reinterpret_cast<float*>(input.memptr()), reinterpret_cast<float*>(output.memptr()));
+#else
+    fftw_execute_r2r(plan, reinterpret_cast<double*>(input.memptr()), reinterpret_cast<double*>(output.memptr()));
 #endif
 }
 
 void fft_fftw_dft_r2r_1d(arma::Col<real_t>& input, arma::Col<real_t>& output, FFTRoutine r_fft)
 {
-    size_t n_elems = input.size();
-
     if (input.memptr() != output.memptr()) {
         output.set_size(arma::size(input));
     }
 
-    unsigned int fftw_flag = FFTW_ESTIMATE;
-
-    switch (r_fft) {
-    case FFTRoutine::FFTW_ESTIMATE_FFT:
-        fftw_flag = FFTW_ESTIMATE;
-        break;
-    case FFTRoutine::FFTW_MEASURE_FFT:
-        // Do not use this mode as the plan generation is very slow
-        fftw_flag = FFTW_MEASURE;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_PATIENT_FFT:
-        // Do not use this mode as the plan generation is extremely slow
-        fftw_flag = FFTW_PATIENT;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_WISDOM_FFT:
-    case FFTRoutine::FFTW_WISDOM_INPLACE_FFT:
-        fftw_flag = FFTW_WISDOM_ONLY;
-        break;
-    default:
-        assert(0);
-        break;
-    }
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::R2HC_1D, int(input.size()), 1, FFTW_FORWARD, input.memptr(), output.memptr(), r_fft);
+    FFTWPlan plan = FFTContext::instance().plan(key, input.memptr(), output.memptr(), input.n_elem * sizeof(real_t));
 
 #ifdef USE_FLOAT
-    fftwf_plan plan
-        = fftwf_plan_r2r_1d(
-            n_elems,
-            reinterpret_cast<float*>(input.memptr()),
-            reinterpret_cast<float*>(output.memptr()),
-            FFTW_R2HC,
-            fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} size. Trying again with FFTW_ESTIMATE...", n_elems);
-
-        plan = fftwf_plan_r2r_1d(
-            n_elems,
-            reinterpret_cast<float*>(input.memptr()),
-            reinterpret_cast<float*>(output.memptr()),
-            FFTW_R2HC,
-            FFTW_ESTIMATE);
-    }
-
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
-    }
-
-    fftwf_execute(plan);
-    fftwf_destroy_plan(plan);
+    fftwf_execute_r2r(plan, reinterpret_cast<float*>(input.memptr()), reinterpret_cast<float*>(output.memptr()));
 #else
-    fftw_plan plan = fftw_plan_r2r_1d(
-            n_elems,
-            reinterpret_cast<double*>(input.memptr()),
-            reinterpret_cast<double*>(output.memptr()),
-            FFTW_R2HC,
-            fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} size. Trying again with FFTW_ESTIMATE...", n_elems);
+    fftw_execute_r2r(plan, reinterpret_cast<double*>(input.memptr()), reinterpret_cast<double*>(output.memptr()));
+#endif
+}
 
-        plan = fftw_plan_r2r_1d(
-            n_elems,
-            reinterpret_cast<double*>(input.memptr()),
-            reinterpret_cast<double*>(output.memptr()),
-            FFTW_R2HC,
-            FFTW_ESTIMATE);
+void fft_fftw_dft_c2c_1d(arma::Col<cx_real_t>& input, arma::Col<cx_real_t>& output, FFTRoutine r_fft, bool forward)
+{
+    if (input.memptr() != output.memptr()) {
+        output.set_size(arma::size(input));
     }
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
+    int direction = FFTW_FORWARD;
+    if (!forward) {
+        direction = FFTW_BACKWARD;
     }
 
-    fftw_execute(plan);
-    fftw_destroy_plan(plan);
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::C2C_1D, int(input.size()), 1, direction, input.memptr(), output.memptr(), r_fft);
+    FFTWPlan plan = FFTContext::instance().plan(key, input.memptr(), output.memptr(), input.n_elem * sizeof(cx_real_t));
+
+#ifdef USE_FLOAT
+    fftwf_execute_dft(plan, reinterpret_cast<fftwf_complex*>(input.memptr()), reinterpret_cast<fftwf_complex*>(output.memptr()));
+#else
+    fftw_execute_dft(plan, reinterpret_cast<fftw_complex*>(input.memptr()), reinterpret_cast<fftw_complex*>(output.memptr()));
 #endif
 }
 
-void fft_fftw_dft_c2c_1d(arma::Col<cx_real_t>& input, arma::Col<cx_real_t>& output, FFTRoutine r_fft)
+void fft_fftw_c2c_rows(arma::Mat<cx_real_t>& matrix, size_t num_rows, FFTRoutine r_fft, bool forward)
 {
-    int n_elems = int(input.size());
-
-    if (input.memptr() != output.memptr()) {
-        output.set_size(arma::size(input));
+    assert(num_rows <= matrix.n_rows);
+    if (num_rows == 0) {
+        return;
     }
 
-    unsigned int fftw_flag = FFTW_ESTIMATE;
-
-    switch (r_fft) {
-    case FFTRoutine::FFTW_ESTIMATE_FFT:
-        fftw_flag = FFTW_ESTIMATE;
-        break;
-    case FFTRoutine::FFTW_MEASURE_FFT:
-        // Do not use this mode as the plan generation is very slow
-        fftw_flag = FFTW_MEASURE;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_PATIENT_FFT:
-        // Do not use this mode as the plan generation is extremely slow
-        fftw_flag = FFTW_PATIENT;
-        assert(0);
-        break;
-    case FFTRoutine::FFTW_WISDOM_FFT:
-    case FFTRoutine::FFTW_WISDOM_INPLACE_FFT:
-        fftw_flag = FFTW_WISDOM_ONLY;
-        break;
-    default:
-        assert(0);
-        break;
+    int direction = FFTW_FORWARD;
+    if (!forward) {
+        direction = FFTW_BACKWARD;
     }
 
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::C2C_ROWS_1D, int(matrix.n_cols), int(num_rows), direction, matrix.memptr(), matrix.memptr(), r_fft,
+        int(matrix.n_rows));
+    FFTWPlan plan = FFTContext::instance().plan(key, matrix.memptr(), matrix.memptr(), matrix.n_elem * sizeof(cx_real_t));
+
 #ifdef USE_FLOAT
-    fftwf_plan plan
-        = fftwf_plan_dft_1d(
-            n_elems,
-            reinterpret_cast<fftwf_complex*>(input.memptr()),
-            reinterpret_cast<fftwf_complex*>(output.memptr()),
-            FFTW_FORWARD,
-            fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} size. Trying again with FFTW_ESTIMATE...", n_elems);
+    fftwf_execute_dft(plan, reinterpret_cast<fftwf_complex*>(matrix.memptr()), reinterpret_cast<fftwf_complex*>(matrix.memptr()));
+#else
+    fftw_execute_dft(plan, reinterpret_cast<fftw_complex*>(matrix.memptr()), reinterpret_cast<fftw_complex*>(matrix.memptr()));
+#endif
+}
 
-        plan = fftwf_plan_dft_1d(
-            n_elems,
-            reinterpret_cast<fftwf_complex*>(input.memptr()),
-            reinterpret_cast<fftwf_complex*>(output.memptr()),
-            FFTW_FORWARD,
-            FFTW_ESTIMATE);
+void fft_fftw_c2r_cols(arma::Mat<cx_real_t>& matrix, size_t first_col, size_t num_cols, FFTRoutine r_fft)
+{
+    assert((matrix.n_rows % 2) == 1);
+    assert((first_col + num_cols) <= matrix.n_cols);
+    if (num_cols == 0) {
+        return;
     }
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
-    }
+    cx_real_t* data = matrix.colptr(first_col);
+    FFTPlanKey key = fft_plan_key(FFTPlanKind::C2R_COLS_1D, int((matrix.n_rows - 1) * 2), int(num_cols), FFTW_BACKWARD, data, data, r_fft,
+        int(matrix.n_rows));
+    FFTWPlan plan = FFTContext::instance().plan(key, data, data, num_cols * matrix.n_rows * sizeof(cx_real_t));
 
-    fftwf_execute(plan);
-    fftwf_destroy_plan(plan);
+#ifdef USE_FLOAT
+    fftwf_execute_dft_c2r(plan, reinterpret_cast<fftwf_complex*>(data), reinterpret_cast<float*>(data));
 #else
-    fftw_plan plan
-        = fftw_plan_dft_1d(
-            n_elems,
-            reinterpret_cast<fftw_complex*>(input.memptr()),
-            reinterpret_cast<fftw_complex*>(output.memptr()),
-            FFTW_FORWARD,
-            fftw_flag);
-
-    if (plan == NULL)
-    {
-        STPLIB_DEBUG("stplib", "Failed to use FFTW plan for {} size. Trying again with FFTW_ESTIMATE...", n_elems);
+    fftw_execute_dft_c2r(plan, reinterpret_cast<fftw_complex*>(data), reinterpret_cast<double*>(data));
+#endif
+}
 
-        plan = fftw_plan_dft_1d(
-            n_elems,
-            reinterpret_cast<fftw_complex*>(input.memptr()),
-            reinterpret_cast<fftw_complex*>(output.memptr()),
-            FFTW_FORWARD,
-            FFTW_ESTIMATE);
-    }
+void fft_fftw_c2r_pruned(arma::Mat<cx_real_t>& matrix, size_t image_size, FFTRoutine r_fft)
+{
+    const size_t n_cols = matrix.n_cols;
+    assert(matrix.n_rows == (n_cols / 2 + 1));
+    assert(((image_size % 2) == 0) && (image_size <= n_cols));
 
-    if (plan == NULL) {
-        throw std::runtime_error("Failed to create FFTW plan.");
+    // Rows beyond the last non-zero row of all columns are not transformed (the gridder does not reach the highest u values)
+    std::vector<size_t> col_used_rows(n_cols, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n_cols), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t j = r.begin(); j < r.end(); ++j) {
+            const cx_real_t* col = matrix.colptr(j);
+            size_t i = matrix.n_rows;
+            while ((i > 0) && (std::norm(col[i - 1]) <= real_t(0.0))) {
+                --i;
+            }
+            col_used_rows[j] = i;
+        }
+    });
+    size_t used_rows = *std::max_element(col_used_rows.begin(), col_used_rows.end());
+    if (used_rows > 0) {
+        used_rows = std::min(size_t(matrix.n_rows), ((used_rows + PRUNED_FFT_ROWS_MULTIPLE - 1) / PRUNED_FFT_ROWS_MULTIPLE) * PRUNED_FFT_ROWS_MULTIPLE);
     }
+    fft_fftw_c2c_rows(matrix, used_rows, r_fft, false);
 
-    fftw_execute(plan);
-    fftw_destroy_plan(plan);
-#endif
+    // c2r FFTs of the columns of the cropped image (the first and last image_size / 2 columns)
+    fft_fftw_c2r_cols(matrix, 0, image_size / 2, r_fft);
+    fft_fftw_c2r_cols(matrix, n_cols - image_size / 2, image_size / 2, r_fft);
 }
 
 void generate_hermitian_matrix_from_nonredundant(arma::Mat<cx_real_t>& matrix)
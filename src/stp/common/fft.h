@@ -9,11 +9,189 @@
 #include "../types.h"
 #include "matrix_math.h"
 #include <armadillo>
+#include <fftw3.h>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Maximum alignment offset of FFTW arrays (in bytes), used to reproduce the alignment of a plan in scratch arrays
+#ifndef FFT_MAX_ALIGNMENT
+#define FFT_MAX_ALIGNMENT 64
+#endif
+
+// The number of rows transformed by the pruned c2r FFT is rounded up to a multiple of this value (limits the number of FFTW plans)
+#ifndef PRUNED_FFT_ROWS_MULTIPLE
+#define PRUNED_FFT_ROWS_MULTIPLE 32
+#endif
 
 namespace stp {
 
+#ifdef USE_FLOAT
+using FFTWPlan = fftwf_plan;
+#else
+using FFTWPlan = fftw_plan;
+#endif
+
+/**
+ * @brief Enum of the FFT transforms (types of FFTW plans)
+ */
+enum struct FFTPlanKind {
+    C2R_2D,
+    R2C_2D,
+    C2C_2D,
+    C2C_EVEN_2D,
+    R2HC_1D,
+    C2C_1D,
+    C2C_ROWS_1D,
+    C2R_COLS_1D
+};
+
+/**
+ * @brief The FFTPlanKey struct
+ *
+ * Identifies an FFTW plan: a plan is reused for any arrays with the same shape, placement (in-place or not) and alignment.
+ * For the batched 1D transforms (C2C_ROWS_1D and C2R_COLS_1D), n0 is the transform length, n1 the number of transforms and
+ * stride the number of rows of the matrix.
+ */
+struct FFTPlanKey {
+    FFTPlanKind kind;
+    int n0;
+    int n1;
+    int stride;
+    int direction;
+    bool in_place;
+    int in_alignment;
+    int out_alignment;
+    unsigned int flags;
+    size_t precision;
+
+    bool operator<(const FFTPlanKey& other) const;
+};
+
+/**
+ * @brief The FFTContext class
+ *
+ * Holds the FFTW state of the process: FFTW threads are initialised and wisdom files are imported once, and the FFTW plans are
+ * cached and reused by all FFT calls (imager calls, w-planes, etc.). Plans are executed on the arrays of each call with the
+ * new-array execute functions of FFTW, hence the planning cost (which is large for FFTW_MEASURE and FFTW_PATIENT) is only paid
+ * the first time that a shape is transformed. Plan creation is serialized, plan execution is thread-safe. Cached plans are found
+ * without waiting for plans that are being created or measured.
+ *
+ * Wisdom plans of shapes that are not covered by the wisdom files are recorded, so that they can be measured (in a background
+ * thread or by the reduce --tune-fft option) and saved to the wisdom cache of the host.
+ */
+class FFTContext {
+public:
+    /**
+     * @brief FFT context of the process
+     */
+    static FFTContext& instance();
+
+    /**
+     * @brief Init FFTW threads (only the first time) and import FFTW wisdom file if required (only the first time it is used).
+     *
+     * A missing wisdom file is not an error: its shapes are planned with FFTW_ESTIMATE and recorded as missing wisdom.
+     *
+     * @param[in] r_fft (FFTRoutine enum) : FFT routine to be used: defines the FFTW planner flag
+     * @param[in] fft_wisdom_filename (string): FFTW wisdom filename for FFT execution.
+     */
+    void init(FFTRoutine r_fft, const std::string& fft_wisdom_filename);
+
+    /**
+     * @brief Cached plan of the given key (the plan is created for the given arrays if it is not cached yet)
+     *
+     * Planning with FFTW_MEASURE or FFTW_PATIENT overwrites the arrays, hence the input array is saved and restored. If planning
+     * with the requested flags fails (e.g. no wisdom is available), the plan is created with FFTW_ESTIMATE and, for wisdom plans,
+     * the key is recorded as missing wisdom.
+     *
+     * @param[in] key (FFTPlanKey): Plan key.
+     * @param[in] input (void*): Input array of the transform.
+     * @param[in] output (void*): Output array of the transform.
+     * @param[in] input_bytes (size_t): Size of the input array (in bytes).
+     * @return (FFTWPlan): FFTW plan.
+     */
+    FFTWPlan plan(const FFTPlanKey& key, void* input, void* output, size_t input_bytes);
+
+    /**
+     * @brief Number of cached plans
+     */
+    size_t num_plans();
+
+    /**
+     * @brief Keys of the wisdom plans that were not covered by the FFTW wisdom (these plans use FFTW_ESTIMATE)
+     */
+    std::vector<FFTPlanKey> missing_wisdom();
+
+    /**
+     * @brief Measures the plans of missing wisdom, which adds them to the FFTW wisdom
+     *
+     * Plans are measured on scratch arrays with the same alignment, and replace the FFTW_ESTIMATE plans of the cache. FFTs of other
+     * shapes can run meanwhile (only FFTs that need a new plan wait for each measurement).
+     *
+     * @param[in] r_fft (FFTRoutine enum): Planner rigor (FFTW_MEASURE_FFT or FFTW_PATIENT_FFT).
+     * @return (size_t): Number of measured plans.
+     */
+    size_t tune_missing_plans(FFTRoutine r_fft = FFTRoutine::FFTW_MEASURE_FFT);
+
+    /**
+     * @brief Measures the plans of missing wisdom in a background thread (see tune_missing_plans)
+     *
+     * @param[in] r_fft (FFTRoutine enum): Planner rigor (FFTW_MEASURE_FFT or FFTW_PATIENT_FFT).
+     * @return (std::future<size_t>): Number of measured plans.
+     */
+    std::future<size_t> tune_missing_plans_async(FFTRoutine r_fft = FFTRoutine::FFTW_MEASURE_FFT);
+
+    /**
+     * @brief Saves the FFTW wisdom to a file, merged with the wisdom that the file already contains
+     *
+     * @param[in] fft_wisdom_filename (string): FFTW wisdom filename.
+     */
+    void save_wisdom(const std::string& fft_wisdom_filename);
+
+    /**
+     * @brief Filename of the wisdom cache of this host, versioned by FFTW library version and precision
+     *
+     * @param[in] directory (string): Directory of the wisdom cache.
+     * @return (string): Wisdom filename.
+     */
+    static std::string host_wisdom_filename(const std::string& directory = std::string());
+
+    /**
+     * @brief Destroy all cached plans
+     */
+    void clear_plans();
+
+    /**
+     * @brief Destroy all cached plans and clean up FFTW threads (the context is initialised again by the next init call)
+     */
+    void cleanup();
+
+    FFTContext(const FFTContext&) = delete;
+    FFTContext& operator=(const FFTContext&) = delete;
+
+private:
+    FFTContext() = default;
+    ~FFTContext();
+
+    void destroy_plans();
+
+    // Serializes the FFTW planner (plan creation and destruction, wisdom and threads). It is locked before plans_mutex.
+    std::mutex planner_mutex;
+    // Guards the plan cache, so that cached plans are found without waiting for the planner
+    std::mutex plans_mutex;
+    bool threads_initialized = false;
+    std::set<std::string> wisdom_files;
+    std::map<FFTPlanKey, FFTWPlan> plans;
+    // Plans replaced by measured plans (destroyed with the cache, as they may still be running)
+    std::vector<FFTWPlan> retired_plans;
+    std::set<FFTPlanKey> missing_wisdom_plans;
+};
+
 /**
- * @brief Init FFTW threads and import FFTW wisdom file if required.
+ * @brief Init FFTW threads and import FFTW wisdom file if required (see FFTContext::init).
  *
  * @param[in] r_fft (FFTRoutine enum) : FFT routine to be used: defines the FFTW planner flag
  * @param[in] fft_wisdom_filename (string): FFTW wisdom filename for FFT execution.
@@ -56,6 +234,20 @@ void fft_fftw_r2c(arma::Mat<real_t>& input, arma::Mat<cx_real_t>& output, FFTRou
  */
 void fft_fftw_c2c(arma::Mat<cx_real_t>& input, arma::Mat<cx_real_t>& output, FFTRoutine r_fft, bool forward = true);
 
+/**
+ * @brief Performs the 2D fast fourier transform of a complex matrix that is even along both axes, given its first quadrant
+ *
+ * An N x N matrix m is even along both axes if m(i, j) = m((N - i) % N, j) = m(i, (N - j) % N). Its FFT is also even, hence
+ * it is fully described by the elements [0, N/2] x [0, N/2] of the first quadrant. The FFT is computed with real-even DFTs
+ * (DCT-I, FFTW_REDFT00 transform kind) of the real and imaginary parts of the quadrant, which takes about a quarter of the work
+ * of the full complex FFT. Forward and backward transforms are equal. Input and output may be the same matrix (in-place FFT).
+ *
+ * @param[in] input (arma::Mat) : First quadrant of the input matrix, (N/2 + 1) x (N/2 + 1) elements
+ * @param[out] output (arma::Mat) : First quadrant of the FFT result, (N/2 + 1) x (N/2 + 1) elements
+ * @param[in] r_fft (FFTRoutine enum) : FFT routine to be used: defines the FFTW planner flag
+ */
+void fft_fftw_c2c_even(arma::Mat<cx_real_t>& input, arma::Mat<cx_real_t>& output, FFTRoutine r_fft);
+
 /**
  * @brief Performs the forward fast fourier transform of a real vector (1D) using the FFTW library (real to complex FFT)
  *
@@ -69,7 +261,46 @@ void fft_fftw_c2c(arma::Mat<cx_real_t>& input, arma::Mat<cx_real_t>& output, FFT
  */
 void fft_fftw_dft_r2r_1d(arma::Col<real_t>& input, arma::Col<real_t>& output, FFTRoutine r_fft);
 
-void fft_fftw_dft_c2c_1d(arma::Col<cx_real_t>& input, arma::Col<cx_real_t>& output, FFTRoutine r_fft);
+void fft_fftw_dft_c2c_1d(arma::Col<cx_real_t>& input, arma::Col<cx_real_t>& output, FFTRoutine r_fft, bool forward = true);
+
+/**
+ * @brief Performs the 1D fast fourier transform of the first rows of a complex matrix (in-place)
+ *
+ * Each of the first num_rows rows is transformed along the columns of the matrix (c2c FFT). The other rows are not modified.
+ *
+ * @param[in,out] matrix (arma::Mat) : Complex matrix, the first rows are replaced by their fft
+ * @param[in] num_rows (size_t) : Number of rows to be transformed
+ * @param[in] r_fft (FFTRoutine enum) : FFT routine to be used: defines the FFTW planner flag
+ * @param[in] forward (bool) : Forward FFT if true, backward FFT otherwise
+ */
+void fft_fftw_c2c_rows(arma::Mat<cx_real_t>& matrix, size_t num_rows, FFTRoutine r_fft, bool forward = true);
+
+/**
+ * @brief Performs the 1D backward fast fourier transform of a range of halfplane complex columns (in-place, complex to real FFT)
+ *
+ * The n_rows complex values of each column are replaced by the (n_rows - 1) * 2 real values of its c2r FFT, stored from the start
+ * of the column. The other columns are not modified.
+ *
+ * @param[in,out] matrix (arma::Mat) : Complex matrix with halfplane columns (n_rows must be odd)
+ * @param[in] first_col (size_t) : First column to be transformed
+ * @param[in] num_cols (size_t) : Number of columns to be transformed
+ * @param[in] r_fft (FFTRoutine enum) : FFT routine to be used: defines the FFTW planner flag
+ */
+void fft_fftw_c2r_cols(arma::Mat<cx_real_t>& matrix, size_t first_col, size_t num_cols, FFTRoutine r_fft);
+
+/**
+ * @brief Performs the backward c2r FFT of a halfplane matrix, computing only the columns of the cropped image (in-place)
+ *
+ * Equivalent to fft_fftw_c2r followed by the crop of the (unshifted) image of size image_size, whose quadrants are on the corners
+ * of the padded image. The 1D FFTs along the columns of the matrix are computed for the rows that contain non-zero values (the
+ * others have a zero FFT), and the 1D c2r FFTs along the rows are only computed for the columns of the cropped image.
+ * The real result of column j (for j < image_size / 2 or j >= n_cols - image_size / 2) is stored from the start of the column.
+ *
+ * @param[in,out] matrix (arma::Mat) : Complex halfplane matrix ((n_cols / 2 + 1) x n_cols), replaced by the FFT result
+ * @param[in] image_size (size_t) : Size of the cropped image (multiple of 2, less or equal to n_cols)
+ * @param[in] r_fft (FFTRoutine enum) : FFT routine to be used: defines the FFTW planner flag
+ */
+void fft_fftw_c2r_pruned(arma::Mat<cx_real_t>& matrix, size_t image_size, FFTRoutine r_fft);
 
 /**
  * @brief Generates a hermitian matrix from the non-redundant values
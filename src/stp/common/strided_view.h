@@ -0,0 +1,149 @@
+/**
+* @file strided_view.h
+* @brief Non-owning strided views of visibility data.
+*/
+
+#ifndef STRIDED_VIEW_H
+#define STRIDED_VIEW_H
+
+#include "../types.h"
+#include <armadillo>
+#include <complex>
+
+namespace stp {
+
+/**
+ * @brief The StridedView class
+ *
+ * Non-owning read-only view of an array given by a pointer, a length and a stride (in elements).
+ * The viewed memory must outlive the view.
+ */
+template <typename T>
+class StridedView {
+public:
+    /**
+     * @brief Default constructor (empty view)
+     */
+    StridedView() = default;
+
+    /**
+     * @brief StridedView constructor
+     *
+     * @param[in] _ptr (const T*): Pointer to the first element.
+     * @param[in] _length (size_t): Number of elements.
+     * @param[in] _stride (size_t): Distance between consecutive elements. Default is 1 (contiguous).
+     */
+    StridedView(const T* _ptr, size_t _length, size_t _stride = 1)
+        : ptr(_ptr)
+        , length(_length)
+        , stride(_stride)
+    {
+    }
+
+    /**
+     * @brief StridedView constructor. View of a column of an armadillo matrix.
+     *
+     * @param[in] mat (arma::Mat): Viewed matrix.
+     * @param[in] col (arma::uword): Column index. Default is 0.
+     */
+    explicit StridedView(const arma::Mat<T>& mat, arma::uword col = 0)
+        : ptr(mat.colptr(col))
+        , length(mat.n_rows)
+        , stride(1)
+    {
+    }
+
+    /**
+     * @brief Element access
+     */
+    const T& operator[](size_t i) const
+    {
+        return ptr[i * stride];
+    }
+
+    /**
+     * @brief Number of elements
+     */
+    size_t size() const
+    {
+        return length;
+    }
+
+    /**
+     * @brief Indicates whether the view is empty
+     */
+    bool is_empty() const
+    {
+        return length == 0;
+    }
+
+private:
+    const T* ptr = nullptr;
+    size_t length = 0;
+    size_t stride = 1;
+};
+
+/**
+ * @brief Non-owning views of the visibility data: UVW-coordinates, complex visibilities and weights
+ */
+struct VisibilityView {
+
+    /**
+     * @brief Default constructor
+     */
+    VisibilityView() = default;
+
+    /**
+     * @brief Constructor
+     *
+     * @param[in] _u (StridedView<double>): U-coordinates.
+     * @param[in] _v (StridedView<double>): V-coordinates.
+     * @param[in] _w (StridedView<double>): W-coordinates (may be empty if W-projection is not used).
+     * @param[in] _vis (StridedView<std::complex<double>>): Complex visibilities (may be empty when only the gridding geometry is computed).
+     * @param[in] _weights (StridedView<double>): Visibility weights.
+     */
+    VisibilityView(const StridedView<double>& _u, const StridedView<double>& _v, const StridedView<double>& _w,
+        const StridedView<std::complex<double>>& _vis, const StridedView<double>& _weights)
+        : u(_u)
+        , v(_v)
+        , w(_w)
+        , vis(_vis)
+        , weights(_weights)
+    {
+    }
+
+    /**
+     * @brief Constructor. Views of armadillo matrices.
+     *
+     * @param[in] uvw_lambda (arma::mat): UVW-coordinates (2 or 3 columns). Assumed ordering is u,v,w.
+     * @param[in] _vis (arma::cx_mat): Complex visibilities (1D array, may be empty).
+     * @param[in] _weights (arma::mat): Visibility weights (1D array).
+     */
+    VisibilityView(const arma::mat& uvw_lambda, const arma::cx_mat& _vis, const arma::mat& _weights)
+        : u(uvw_lambda, 0)
+        , v(uvw_lambda, 1)
+        , vis(_vis)
+        , weights(_weights)
+    {
+        if (uvw_lambda.n_cols > 2) {
+            w = StridedView<double>(uvw_lambda, 2);
+        }
+    }
+
+    /**
+     * @brief Number of visibilities
+     */
+    size_t size() const
+    {
+        return u.size();
+    }
+
+    StridedView<double> u;
+    StridedView<double> v;
+    StridedView<double> w;
+    StridedView<std::complex<double>> vis;
+    StridedView<double> weights;
+};
+}
+
+#endif /* STRIDED_VIEW_H */
@@ -4,6 +4,8 @@
  */
 
 #include "conv_func.h"
+#include <cmath>
+#include <limits>
 
 namespace stp {
 
@@ -14,6 +16,11 @@ arma::Col<real_t> Triangle::operator()(const arma::Col<real_t>& radius_in_pix) c
     return arma::max((1.0 - arma::abs(radius_in_pix) / _half_base_width), arma::zeros<arma::Col<real_t>>(arma::size(radius_in_pix)));
 }
 
+real_t Triangle::value(real_t radius_in_pix) const
+{
+    return std::max(real_t(1.0) - std::abs(radius_in_pix) / real_t(_half_base_width), real_t(0.0));
+}
+
 // Triangle grid correction factor
 arma::Col<real_t> Triangle::gcf(const arma::Col<real_t>& radius) const
 {
@@ -33,6 +40,11 @@ arma::Col<real_t> TopHat::operator()(const arma::Col<real_t>& radius_in_pix) con
     return result;
 }
 
+real_t TopHat::value(real_t radius_in_pix) const
+{
+    return (std::abs(radius_in_pix) < real_t(_half_base_width)) ? real_t(1.0) : real_t(0.0);
+}
+
 // TopHat grid correction factor
 arma::Col<real_t> TopHat::gcf(const arma::Col<real_t>& radius) const
 {
@@ -58,6 +70,20 @@ arma::Col<real_t> Sinc::operator()(const arma::Col<real_t>& radius_in_pix) const
     return result;
 }
 
+real_t Sinc::value(real_t radius_in_pix) const
+{
+    if ((_trunc > 0.0) && (std::abs(radius_in_pix) > real_t(_trunc))) {
+        return real_t(0.0);
+    }
+    real_t normalized_radius_in_pix = radius_in_pix * real_t(arma::datum::pi / _width_normalization);
+    // Replace zero radius by 1.0e-20 (to avoid nan values), as in the vectorised function
+    if (std::abs(normalized_radius_in_pix) < std::numeric_limits<real_t>::min()) {
+        normalized_radius_in_pix = real_t(1.0e-20);
+    }
+
+    return std::sin(normalized_radius_in_pix) / normalized_radius_in_pix;
+}
+
 // Sinc grid correction factor
 arma::Col<real_t> Sinc::gcf(const arma::Col<real_t>& radius) const
 {
@@ -81,6 +107,15 @@ arma::Col<real_t> Gaussian::operator()(const arma::Col<real_t>& radius_in_pix) c
     return result;
 }
 
+real_t Gaussian::value(real_t radius_in_pix) const
+{
+    if ((_trunc > 0.0) && (std::abs(radius_in_pix) > real_t(_trunc))) {
+        return real_t(0.0);
+    }
+
+    return std::exp(real_t(-1.0 / (_width_normalization * _width_normalization)) * (radius_in_pix * radius_in_pix));
+}
+
 // Gaussian grid correction factor
 arma::Col<real_t> Gaussian::gcf(const arma::Col<real_t>& radius) const
 {
@@ -102,6 +137,15 @@ arma::Col<real_t> GaussianSinc::operator()(const arma::Col<real_t>& radius_in_pi
     return result;
 }
 
+real_t GaussianSinc::value(real_t radius_in_pix) const
+{
+    if ((_trunc > 0.0) && (std::abs(radius_in_pix) > real_t(_trunc))) {
+        return real_t(0.0);
+    }
+
+    return _gaussian.value(radius_in_pix) * _sinc.value(radius_in_pix);
+}
+
 // GaussianSinc grid correction factor
 arma::Col<real_t> GaussianSinc::gcf(const arma::Col<real_t>& radius) const
 {
@@ -109,7 +153,7 @@ arma::Col<real_t> GaussianSinc::gcf(const arma::Col<real_t>& radius) const
     return arma::conv_to<arma::Col<real_t>>::from(radius);
 }
 
-arma::Col<real_t> __grdsf(arma::Col<real_t> nu)
+real_t __grdsf(real_t nu)
 {
     /* Calculate PSWF using an old SDE routine:
 * Find Spheroidal function with M = 6, alpha = 1 using the rational approximations discussed by Fred Schwab in 'Indirect Imaging'.
@@ -117,65 +161,43 @@ arma::Col<real_t> __grdsf(arma::Col<real_t> nu)
 * The gridding function is (1-NU**2)*GRDSF(NU) where NU is the distance to the edge. The grid correction function is just 1/GRDSF(NU) where NU
 * is now the distance to the edge of the image.
 */
-    arma::Mat<real_t> p = { { 8.203343e-2, -3.644705e-1, 6.278660e-1, -5.335581e-1, 2.312756e-1 },
-        { 4.028559e-3, -3.697768e-2, 1.021332e-1, -1.201436e-1, 6.412774e-2 } };
-    arma::Mat<real_t> q = { { 1.0000000e0, 8.212018e-1, 2.078043e-1 },
-        { 1.0000000e0, 9.599102e-1, 2.918724e-1 } };
-
-    // auxiliary
-    int nu_size = nu.n_elem;
-    int n_p = p.n_cols;
-    int n_q = q.n_cols;
-    arma::Col<real_t> nuend(nu_size);
-    arma::Col<real_t> top(nu_size);
-    arma::Col<real_t> bot(nu_size);
-    arma::uvec part(nu_size);
-
-    // return vec
-    arma::Col<real_t> grdsf(nu_size);
+    static const real_t p[2][5] = { { real_t(8.203343e-2), real_t(-3.644705e-1), real_t(6.278660e-1), real_t(-5.335581e-1), real_t(2.312756e-1) },
+        { real_t(4.028559e-3), real_t(-3.697768e-2), real_t(1.021332e-1), real_t(-1.201436e-1), real_t(6.412774e-2) } };
+    static const real_t q[2][3] = { { real_t(1.0000000e0), real_t(8.212018e-1), real_t(2.078043e-1) },
+        { real_t(1.0000000e0), real_t(9.599102e-1), real_t(2.918724e-1) } };
 
     // module
-    nu = arma::abs(nu);
-
-    for (int i = 0; i < nu_size; i++) {
-        if ((nu[i] >= 0.0) && (nu[i] < 0.75)) {
-            part[i] = 0;
-            top[i] = p.at(0, 0);
-            bot[i] = q.at(0, 0);
-            nuend[i] = 0.75;
-        } else if ((nu[i] >= 0.75) && (nu[i] <= 1.0)) {
-            part[i] = 1;
-            top[i] = p.at(1, 0);
-            bot[i] = q.at(1, 0);
-            nuend[i] = 1.0;
-        } else {
-            part[i] = 0;
-            top[i] = p.at(0, 0);
-            bot[i] = q.at(0, 0);
-            nuend[i] = 0.0;
-        }
+    nu = std::abs(nu);
+
+    int part = 0;
+    real_t nuend = 0.0;
+    if (nu < real_t(0.75)) {
+        nuend = real_t(0.75);
+    } else if (nu <= real_t(1.0)) {
+        part = 1;
+        nuend = real_t(1.0);
     }
 
-    arma::Col<real_t> delnusq(arma::pow(nu, 2) - arma::pow(nuend, 2));
-
-    for (int k = 1; k < n_p; k++)
-        for (int x = 0; x < nu_size; x++) {
-            top[x] += p.at(part[x], k) * std::pow(delnusq[x], k);
-        }
-
-    for (int k = 1; k < n_q; k++)
-        for (int x = 0; x < nu_size; x++) {
-            bot[x] += q.at(part[x], k) * std::pow(delnusq[x], k);
-        }
-
-    for (int i = 0; i < nu_size; i++) {
-        if (bot[i] > 0.0) {
-            grdsf[i] = top[i] / bot[i];
-        } else if (std::abs(nu[i]) > 1.0) {
-            grdsf[i] = 0.0;
-        } else {
-            grdsf[i] = 0.0;
-        }
+    const real_t delnusq = std::pow(nu, real_t(2)) - std::pow(nuend, real_t(2));
+    real_t top = p[part][0];
+    real_t bot = q[part][0];
+
+    for (int k = 1; k < 5; k++) {
+        top += p[part][k] * std::pow(delnusq, k);
+    }
+
+    for (int k = 1; k < 3; k++) {
+        bot += q[part][k] * std::pow(delnusq, k);
+    }
+
+    return (bot > 0.0) ? (top / bot) : real_t(0.0);
+}
+
+arma::Col<real_t> __grdsf(const arma::Col<real_t>& nu)
+{
+    arma::Col<real_t> grdsf(nu.n_elem);
+    for (arma::uword i = 0; i < nu.n_elem; i++) {
+        grdsf[i] = __grdsf(nu[i]);
     }
 
     return grdsf;
@@ -195,6 +217,16 @@ arma::Col<real_t> PSWF::operator()(const arma::Col<real_t>& radius_in_pix) const
     return result;
 }
 
+real_t PSWF::value(real_t radius_in_pix) const
+{
+    if ((_trunc > 0.0) && (std::abs(radius_in_pix) > real_t(_trunc))) {
+        return real_t(0.0);
+    }
+    const real_t nu = radius_in_pix / real_t(_trunc);
+
+    return __grdsf(nu) * (1 - (nu * nu));
+}
+
 // PSWF grid correction factor
 arma::Col<real_t> PSWF::gcf(const arma::Col<real_t>& radius) const
 {
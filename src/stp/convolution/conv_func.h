@@ -38,6 +38,13 @@ public:
      */
     arma::Col<real_t> operator()(const arma::Col<real_t>& radius_in_pix) const;
 
+    /**
+     * @brief Evaluates the kernel at a single point (allocation-free)
+     * @param[in] radius_in_pix (real_t)
+     * @return Kernel value
+     */
+    real_t value(real_t radius_in_pix) const;
+
     /**
      * @brief Generates the 1D grid correction function (gcf)
      * @param[in] radius (arma::Col<real_t>&)
@@ -73,6 +80,13 @@ public:
      */
     arma::Col<real_t> operator()(const arma::Col<real_t>& radius_in_pix) const;
 
+    /**
+     * @brief Evaluates the kernel at a single point (allocation-free)
+     * @param[in] radius_in_pix (real_t)
+     * @return Kernel value
+     */
+    real_t value(real_t radius_in_pix) const;
+
     /**
      * @brief Generates the 1D grid correction function (gcf)
      * @param[in] radius (arma::Col<real_t>&)
@@ -114,6 +128,13 @@ public:
      */
     arma::Col<real_t> operator()(const arma::Col<real_t>& radius_in_pix) const;
 
+    /**
+     * @brief Evaluates the kernel at a single point (allocation-free)
+     * @param[in] radius_in_pix (real_t)
+     * @return Kernel value
+     */
+    real_t value(real_t radius_in_pix) const;
+
     /**
      * @brief Generates the 1D grid correction function (gcf)
      * @param[in] radius (arma::Col<real_t>&)
@@ -158,6 +179,13 @@ public:
      */
     arma::Col<real_t> operator()(const arma::Col<real_t>& radius_in_pix) const;
 
+    /**
+     * @brief Evaluates the kernel at a single point (allocation-free)
+     * @param[in] radius_in_pix (real_t)
+     * @return Kernel value
+     */
+    real_t value(real_t radius_in_pix) const;
+
     /**
      * @brief Generates the 1D grid correction function (gcf)
      * @param[in] radius (arma::Col<real_t>&)
@@ -205,6 +233,13 @@ public:
      */
     arma::Col<real_t> operator()(const arma::Col<real_t>& radius_in_pix) const;
 
+    /**
+     * @brief Evaluates the kernel at a single point (allocation-free)
+     * @param[in] radius_in_pix (real_t)
+     * @return Kernel value
+     */
+    real_t value(real_t radius_in_pix) const;
+
     /**
      * @brief Generates the 1D grid correction function (gcf)
      * @param[in] radius (arma::Col<real_t>&)
@@ -250,6 +285,13 @@ public:
      */
     arma::Col<real_t> operator()(const arma::Col<real_t>& radius_in_pix) const;
 
+    /**
+     * @brief Evaluates the kernel at a single point (allocation-free)
+     * @param[in] radius_in_pix (real_t)
+     * @return Kernel value
+     */
+    real_t value(real_t radius_in_pix) const;
+
     /**
      * @brief Generates the 1D grid correction function (gcf)
      * @param[in] radius (arma::Col<real_t>&)
@@ -336,6 +378,34 @@ arma::Col<real_t> make_1D_kernel(const T& kernel_creator, int support, const dou
     return (normalize == true) ? (result / arma::accu(result)) : result;
 }
 
+/** @brief Fill 1D Kernel Array
+*
+*  Allocation-free counterpart of make_1D_kernel (without oversampling and padding) that evaluates the kernel
+*  into a preallocated buffer. Used by the exact gridder, where the kernel is recalculated for every visibility.
+*
+*  @param[in] kernel_creator: functor used for kernel generation (must provide the 'value' method)
+*  @param[in] support (int): Defines the 'radius' of the bounding box within which convolution takes place.
+*  @param[in] offset (double): subpixel offset from the sampling position of the central pixel to the origin of the kernel function.
+*  @param[out] kernel_coeffs (real_t*): Output buffer with (2 * support + 1) elements.
+*
+*  @return (real_t) Sum of the (non-normalized) kernel coefficients
+*/
+template <typename T>
+inline real_t fill_1D_kernel(const T& kernel_creator, int support, const double offset, real_t* kernel_coeffs)
+{
+    assert(support >= 1);
+    assert(fabs(offset) <= 0.5);
+
+    const int array_size = 2 * support + 1;
+    real_t sum = 0.0;
+    for (int i = 0; i < array_size; i++) {
+        kernel_coeffs[i] = kernel_creator.value(real_t(i - support) - real_t(offset));
+        sum += kernel_coeffs[i];
+    }
+
+    return sum;
+}
+
 /**
  * @brief Computes the image-domain 1D kernel using the forward fast fourier transform or the analytic definition
  *
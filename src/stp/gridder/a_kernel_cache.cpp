@@ -0,0 +1,51 @@
+/**
+ * @file a_kernel_cache.cpp
+ * @brief Implementation of the A-kernel cache functions.
+ */
+
+#include "a_kernel_cache.h"
+#include "../global_macros.h"
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace stp {
+
+AKernelCache::AKernelCache(const A_ProjectionPars& a_proj, double fov, int workarea_size)
+    : beam(a_proj.pbeam_coefs, fov, workarea_size)
+    , bin_size(deg2rad(a_proj.pangle_bin_size))
+{
+    if (bin_size < 0.0) {
+        throw std::runtime_error("Parallactic-angle bin size must be non-negative.");
+    }
+}
+
+real_t quantize_parallactic_angle(real_t pangle, double bin_size)
+{
+    if (bin_size > 0.0) {
+        return real_t(std::round(double(pangle) / bin_size) * bin_size);
+    }
+    return pangle;
+}
+
+real_t AKernelCache::quantize_angle(real_t pangle) const
+{
+    return quantize_parallactic_angle(pangle, bin_size);
+}
+
+const arma::Mat<real_t>& AKernelCache::a_kernel(real_t pangle)
+{
+    assert(!beam.is_empty());
+    const real_t bin_angle = quantize_angle(pangle);
+    auto it = kernels.find(bin_angle);
+    if (it == kernels.end()) {
+        if (bin_size <= 0.0) {
+            // Exact angles are rarely repeated: keep only the last A-kernel
+            kernels.clear();
+        }
+        STPLIB_DEBUG("stplib", "A-Proj: Generate A-kernel of parallactic angle bin {} (cached A-kernels = {})", bin_angle, kernels.size());
+        it = kernels.emplace(bin_angle, beam.a_kernel(bin_angle)).first;
+    }
+    return it->second;
+}
+}
@@ -0,0 +1,91 @@
+/** @file a_kernel_cache.h
+ *  @brief Classes and function prototypes of the A-kernel cache.
+ */
+
+#ifndef A_KERNEL_CACHE_H
+#define A_KERNEL_CACHE_H
+
+#include "../types.h"
+#include "primary_beam.h"
+#include <armadillo>
+#include <map>
+
+namespace stp {
+
+/**
+ * @brief Quantize parallactic angle to the centre of its bin
+ *
+ * @param[in] pangle (real_t): Parallactic angle (in radians).
+ * @param[in] bin_size (double): Bin size (in radians). Zero disables quantization.
+ * @return (real_t): Angle of the bin (or the input angle if the bin size is zero).
+ */
+real_t quantize_parallactic_angle(real_t pangle, double bin_size);
+
+/**
+ * @brief The AKernelCache class
+ *
+ * Stores the A-kernels (inverse of the primary beam rotated by the parallactic angle) of A-projection. Parallactic angles are
+ * quantized to bins and the A-kernel of each bin is generated once, at the bin angle, so that it is shared by all W-planes
+ * (which repeat the same time steps) and by the next calls. The radial factors of the primary beam are tabulated once (see
+ * PrimaryBeam), so each new bin only evaluates the azimuthal factors. Without bins (exact angles), only the last A-kernel is kept,
+ * so that the cache does not grow with the number of distinct angles.
+ */
+class AKernelCache {
+public:
+    /**
+     * @brief Default constructor
+     */
+    AKernelCache() = default;
+
+    /**
+     * @brief AKernelCache constructor
+     *
+     * @param[in] a_proj (A_ProjectionPars): A-projection parameters (primary beam and parallactic-angle bin size).
+     * @param[in] fov (double): Field of view of the A-kernels (in radians).
+     * @param[in] workarea_size (int): Size of the A-kernels.
+     */
+    AKernelCache(const A_ProjectionPars& a_proj, double fov, int workarea_size);
+
+    /**
+     * @brief Quantize parallactic angle to the centre of its bin
+     *
+     * @param[in] pangle (real_t): Parallactic angle (in radians).
+     * @return (real_t): Angle of the bin (or the input angle if the bin size is zero).
+     */
+    real_t quantize_angle(real_t pangle) const;
+
+    /**
+     * @brief A-kernel of the bin of the given parallactic angle (generated if it is not stored yet)
+     *
+     * @param[in] pangle (real_t): Parallactic angle (in radians).
+     * @return (arma::Mat<real_t>): A-kernel (the reference remains valid until the cache is cleared or, without bins, until the
+     *                             A-kernel of another angle is requested).
+     */
+    const arma::Mat<real_t>& a_kernel(real_t pangle);
+
+    /**
+     * @brief Number of stored A-kernels
+     */
+    size_t size() const
+    {
+        return kernels.size();
+    }
+
+    /**
+     * @brief Remove all stored A-kernels
+     */
+    void clear()
+    {
+        kernels.clear();
+    }
+
+private:
+    PrimaryBeam beam;
+    // Bin size in radians
+    double bin_size = 0.0;
+    // A-kernels by bin angle
+    std::map<real_t, arma::Mat<real_t>> kernels;
+};
+}
+
+#endif /* A_KERNEL_CACHE_H */
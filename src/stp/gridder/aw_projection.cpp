@@ -4,8 +4,12 @@
  */
 
 #include <algorithm>
+#include <cblas.h>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <tbb/tbb.h>
+#include <vector>
 
 #include "../common/fft.h"
 #include "../common/spharmonics.h"
@@ -14,6 +18,41 @@
 
 namespace stp {
 
+namespace {
+
+    // Bit pattern of a W value (W values are matched exactly, without float equality)
+    uint64_t w_bit_pattern(real_t w_value)
+    {
+        const double w = double(w_value);
+        uint64_t w_bits;
+        std::memcpy(&w_bits, &w, sizeof(w_bits));
+        return w_bits;
+    }
+
+    // Radial kernels are transformed in real matrices, where the real and imaginary parts of each kernel are consecutive columns
+    void set_radial_kernel(arma::Mat<real_t>& radial_kernels, size_t idx, const arma::Col<cx_real_t>& kernel)
+    {
+        assert(kernel.n_elem == radial_kernels.n_rows);
+        real_t* kernel_real = radial_kernels.colptr(2 * idx);
+        real_t* kernel_imag = radial_kernels.colptr(2 * idx + 1);
+        for (size_t i = 0; i < kernel.n_elem; i++) {
+            kernel_real[i] = kernel[i].real();
+            kernel_imag[i] = kernel[i].imag();
+        }
+    }
+
+    arma::Col<cx_real_t> get_radial_kernel(const arma::Mat<real_t>& radial_kernels, size_t idx)
+    {
+        const real_t* kernel_real = radial_kernels.colptr(2 * idx);
+        const real_t* kernel_imag = radial_kernels.colptr(2 * idx + 1);
+        arma::Col<cx_real_t> kernel(radial_kernels.n_rows);
+        for (size_t i = 0; i < kernel.n_elem; i++) {
+            kernel[i] = cx_real_t(kernel_real[i], kernel_imag[i]);
+        }
+        return kernel;
+    }
+}
+
 // WideFieldImaging class constructor
 
 WideFieldImaging::WideFieldImaging(uint _kernel_size, double _cell_size, uint _oversampling, double _scaling_factor, const W_ProjectionPars& _w_proj, FFTRoutine _r_fft)
@@ -33,8 +72,17 @@ WideFieldImaging::WideFieldImaging(uint _kernel_size, double _cell_size, uint _o
         // create auxiliary arrays/matrices
         max_hankel_kernel_size = (wp.max_wpconv_support * 2 + 1 + 1) * oversampling;
         if (wp.hankel_proj_slice == false) {
-            DHT = dht(array_size / 2);
-            hankel_radius_points = generate_hankel_radius_points(array_size / 2);
+            // The radial kernel is zero beyond half the kernel size, and the kernel interpolation (see RadialInterpolate) only uses
+            // the Hankel transform up to the diagonal of the largest kernel, so only these radius and frequency points are computed
+            const size_t half_arr_size = array_size / 2;
+            const size_t num_radius_points = kernel_size / 2;
+            const size_t num_freq_points = std::min(half_arr_size, size_t(std::ceil(M_SQRT2 * double(max_hankel_kernel_size / 2))) + HANKEL_INTERP_MARGIN);
+            if (wp.hankel_method == HankelMethod::FHT) {
+                fast_hankel = FastHankelTransform(half_arr_size, num_radius_points, num_freq_points, r_fft);
+            } else {
+                DHT = dht(half_arr_size, num_radius_points, num_freq_points);
+            }
+            hankel_radius_points = generate_hankel_radius_points(num_freq_points);
         }
     }
     if (array_size < 4) {
@@ -43,6 +91,10 @@ WideFieldImaging::WideFieldImaging(uint _kernel_size, double _cell_size, uint _o
 
     truncated_wpconv_support = wp.max_wpconv_support;
     current_hankel_kernel_size = wp.max_wpconv_support;
+
+    if (!wp.kernel_cache_dir.empty()) {
+        kernel_store = KernelStore(wp.kernel_cache_dir, wp.kernel_cache_w_tolerance);
+    }
 }
 
 // WideFieldImaging class Members
@@ -68,21 +120,47 @@ void WideFieldImaging::generate_image_domain_convolution_kernel(const real_t inp
     // Calling this function only makes sense when Hankel optimization is not used.
     assert(!wp.hankel_opt);
 
-    w_value = input_w_value;
-    real_t scaled_cell_size = cell_size * scaling_factor;
+    MatStp<cx_real_t> quadrant = generate_image_domain_kernel_quadrant(input_w_value, aa_kernel_img);
     size_t arr_size = array_size;
     uint half_kernel_size = kernel_size / 2;
 
     MatStp<cx_real_t> output(arr_size, arr_size);
 
+    // Unfold the first quadrant (the kernel is even along both axes)
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, half_kernel_size),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t j = r.begin(); j < r.end(); ++j) {
+                const size_t jj = (arr_size - j) % arr_size;
+                for (size_t i = 0; i < half_kernel_size; ++i) {
+                    const size_t ii = (arr_size - i) % arr_size;
+                    const cx_real_t value = quadrant.at(i, j);
+                    output.at(i, j) = value;
+                    output.at(ii, j) = value;
+                    output.at(i, jj) = value;
+                    output.at(ii, jj) = value;
+                }
+            }
+        });
+
+    comb_kernel = std::move(output);
+}
+
+MatStp<cx_real_t> WideFieldImaging::generate_image_domain_kernel_quadrant(const real_t input_w_value, const arma::Col<real_t>& aa_kernel_img)
+{
+    w_value = input_w_value;
+    real_t scaled_cell_size = cell_size * scaling_factor;
+    size_t quadrant_size = array_size / 2 + 1;
+    uint half_kernel_size = kernel_size / 2;
+    assert(half_kernel_size <= quadrant_size);
+
+    MatStp<cx_real_t> output(quadrant_size, quadrant_size);
+
     // calculate lines
     tbb::parallel_for(tbb::blocked_range<size_t>(1, half_kernel_size), [&](const tbb::blocked_range<size_t>& r) {
         for (size_t i = r.begin(); i < r.end(); ++i) {
             cx_real_t value = combine_2d_kernel_value(aa_kernel_img, i, 0, w_value, scaled_cell_size, half_kernel_size);
             output.at(i, 0) = value;
-            output.at(arr_size - i, 0) = value;
             output.at(0, i) = value;
-            output.at(0, arr_size - i) = value;
         }
     });
 
@@ -98,16 +176,12 @@ void WideFieldImaging::generate_image_domain_convolution_kernel(const real_t inp
             size_t j_begin = r.begin(), j_end = r.end();
             for (size_t j = j_begin; j < j_end; ++j) {
                 for (size_t i = 1; i < half_kernel_size; ++i) {
-                    cx_real_t value = combine_2d_kernel_value(aa_kernel_img, i, j, w_value, scaled_cell_size, half_kernel_size);
-                    output.at(i, j) = value;
-                    output.at(arr_size - i, j) = value;
-                    output.at(i, arr_size - j) = value;
-                    output.at(arr_size - i, arr_size - j) = value;
+                    output.at(i, j) = combine_2d_kernel_value(aa_kernel_img, i, j, w_value, scaled_cell_size, half_kernel_size);
                 }
             }
         });
 
-    comb_kernel = std::move(output);
+    return output;
 }
 
 arma::Col<cx_real_t> WideFieldImaging::generate_projected_image_domain_kernel(const real_t input_w_value, const arma::Col<real_t>& aa_kernel_img)
@@ -170,8 +244,81 @@ arma::Col<cx_real_t> WideFieldImaging::generate_projected_image_domain_kernel(co
     return output;
 }
 
+arma::Col<cx_real_t> WideFieldImaging::generate_radial_image_domain_kernel(const real_t input_w_value, const arma::Col<real_t>& aa_kernel_img)
+{
+    real_t scaled_cell_size = cell_size * scaling_factor;
+    size_t half_kernel_size = kernel_size / 2;
+    arma::Col<cx_real_t> output(half_kernel_size);
+
+    for (size_t i = 0; i < half_kernel_size; ++i) {
+        real_t distance_x = real_t(i) * scaled_cell_size;
+        real_t rsquared_radians = distance_x * distance_x;
+        cx_real_t tmp;
+        if (rsquared_radians >= real_t(1.0)) {
+            tmp = 1.0;
+        } else {
+            real_t n = std::sqrt(real_t(1.0) - rsquared_radians);
+            cx_real_t im(0.0, (real_t(-2.0 * M_PI) * input_w_value * (n - real_t(1.0))));
+            tmp = std::exp(im) / n;
+        }
+
+        output(i) = tmp * aa_kernel_img(half_kernel_size + i);
+    }
+
+    return output;
+}
+
+void WideFieldImaging::transform_hankel_batch(const arma::Col<real_t>& w_values, const arma::Col<real_t>& aa_kernel_img)
+{
+    hankel_batch_w.reset();
+    hankel_batch.reset();
+    if (!wp.hankel_opt || wp.hankel_proj_slice || (wp.hankel_method != HankelMethod::DHT_BATCHED) || w_values.is_empty()) {
+        return;
+    }
+
+    // W values are quantized as in generate_convolution_kernel_wproj
+    const size_t num_kernels = w_values.n_elem;
+    hankel_batch_w.set_size(num_kernels);
+    arma::Mat<real_t> radial_kernels(DHT.n_rows, 2 * num_kernels);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_kernels), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t p = r.begin(); p < r.end(); ++p) {
+            hankel_batch_w[p] = kernel_store.quantize_w(w_values[p]);
+            set_radial_kernel(radial_kernels, p, generate_radial_image_domain_kernel(hankel_batch_w[p], aa_kernel_img));
+        }
+    });
+
+    STPLIB_DEBUG("stplib", "W-Proj: Batched DHT of {} W-planes, DHT size = {}x{}", num_kernels, DHT.n_rows, DHT.n_cols);
+    hankel_batch = dht_transform(radial_kernels);
+}
+
+uint64_t WideFieldImaging::kernel_store_key(const arma::Col<real_t>& aa_kernel_img, bool hankel_proj_slice) const
+{
+    KernelStoreKey key;
+    key.add(kernel_size).add(cell_size).add(oversampling).add(scaling_factor);
+    key.add(wp.max_wpconv_support).add(wp.kernel_trunc_perc).add(wp.hankel_opt).add(hankel_proj_slice).add(wp.interp_type);
+    key.add(wp.hankel_method == HankelMethod::FHT);
+    key.add(aa_kernel_img.memptr(), aa_kernel_img.n_elem * sizeof(real_t));
+
+    return key.value();
+}
+
 void WideFieldImaging::generate_convolution_kernel_wproj(real_t input_w_value, const arma::Col<real_t>& aa_kernel_img, bool hankel_proj_slice)
 {
+    store_kernel_cache = false;
+    loaded_kernel_cache = KernelBank();
+    if (kernel_store.is_enabled()) {
+        input_w_value = kernel_store.quantize_w(input_w_value);
+        stored_kernel_key = kernel_store_key(aa_kernel_img, hankel_proj_slice);
+        uint stored_support;
+        if (kernel_store.load(stored_kernel_key, input_w_value, loaded_kernel_cache, stored_support)) {
+            STPLIB_DEBUG("stplib", "W-Proj: Loaded kernel cache of W = {} from disk", input_w_value);
+            w_value = input_w_value;
+            truncated_wpconv_support = stored_support;
+            return;
+        }
+        store_kernel_cache = true;
+    }
+
     // Set w_plane
     w_value = input_w_value;
     real_t trunc_at = 0.0;
@@ -179,19 +326,13 @@ void WideFieldImaging::generate_convolution_kernel_wproj(real_t input_w_value, c
         trunc_at = real_t(wp.kernel_trunc_perc / 100.0);
 
     if (wp.hankel_opt == false) {
-        generate_image_domain_convolution_kernel(w_value, aa_kernel_img);
-
-        STPLIB_DEBUG("stplib", "W-Proj: C2C FFT size = {}", comb_kernel.n_rows);
+        // The image-domain kernel is even along both axes, hence only the first quadrant of the kernel and of its FFT are computed
+        comb_kernel = generate_image_domain_kernel_quadrant(w_value, aa_kernel_img);
 
-        arma::Col<cx_real_t> output = arma::zeros<arma::Col<cx_real_t>>(array_size);
-
-        for (size_t i = 0; i < array_size; ++i) {
-            for (size_t j = 0; j < array_size; ++j) {
-                output(i) += comb_kernel.at(j, i);
-            }
-        }
+        STPLIB_DEBUG("stplib", "W-Proj: Even C2C FFT size = {}", array_size);
 
-        fft_fftw_c2c(comb_kernel, conv_kernel, r_fft);
+        fft_fftw_c2c_even(comb_kernel, conv_kernel, r_fft);
+        conv_kernel_quadrant = true;
         comb_kernel.reset();
 
         // truncate kernel at a certain percentage from maximum
@@ -214,49 +355,32 @@ void WideFieldImaging::generate_convolution_kernel_wproj(real_t input_w_value, c
         // direction to the kernel-centre position:
 
         if (hankel_proj_slice == false) {
-            real_t scaled_cell_size = cell_size * scaling_factor;
-            size_t half_arr_size = array_size / 2;
-            size_t half_kernel_size = kernel_size / 2;
-
-            // Vars
-            arma::Col<cx_real_t> comb_kernel_img_radius = arma::zeros<arma::Col<cx_real_t>>(half_arr_size);
-
             /*********************************************/
-            /*** generate combined kernel radius vector **/
+            /*** generate Hankel transform output array **/
             /*********************************************/
-            for (size_t i = 0; i < half_kernel_size; ++i) {
-                real_t distance_x = real_t(i) * scaled_cell_size;
-                real_t rsquared_radians = distance_x * distance_x;
-                cx_real_t tmp;
-                if (rsquared_radians >= real_t(1.0)) {
-                    tmp = 1.0;
-                } else {
-                    real_t n = std::sqrt(real_t(1.0) - rsquared_radians);
-                    cx_real_t im(0.0, (real_t(-2.0 * M_PI) * w_value * (n - real_t(1.0))));
-                    tmp = std::exp(im) / n;
-                }
-
-                comb_kernel_img_radius(i) = tmp * aa_kernel_img(half_kernel_size + i);
+            arma::Col<cx_real_t> comb_kernel_radius;
+
+            // Use the precomputed transform of this W value, if any (see transform_hankel_batch). The match is meant to be exact:
+            // the batch stores the same (quantized) W values that are given here, so their bit patterns are compared
+            const uint64_t w_bits = w_bit_pattern(w_value);
+            size_t batch_idx = 0;
+            while ((batch_idx < hankel_batch_w.n_elem) && (w_bit_pattern(hankel_batch_w[batch_idx]) != w_bits)) {
+                batch_idx++;
             }
+            if (batch_idx < hankel_batch_w.n_elem) {
+                comb_kernel_radius = get_radial_kernel(hankel_batch, batch_idx);
+            } else {
+                arma::Col<cx_real_t> comb_kernel_img_radius = generate_radial_image_domain_kernel(w_value, aa_kernel_img);
 
-            /*********************************************/
-            /*** generate Hankel transform output array **/
-            /*********************************************/
-            arma::Col<cx_real_t> comb_kernel_radius(half_arr_size);
-
-            STPLIB_DEBUG("stplib", "W-Proj: DHT size = {}", half_arr_size);
-
-            for (size_t i = 0; i < half_arr_size; i++) {
-                real_t acc1 = 0;
-                real_t acc2 = 0;
-                real_t* comb_k = reinterpret_cast<real_t(&)[2]>(comb_kernel_img_radius(0));
-                const size_t n_elem = comb_kernel_img_radius.n_elem;
-                for (size_t j = 0; j < n_elem; j++) {
-                    // Only use double type within the cycle for successful auto-vectorization
-                    acc1 += DHT(j, i) * comb_k[j * 2];
-                    acc2 += DHT(j, i) * comb_k[j * 2 + 1];
+                if (wp.hankel_method == HankelMethod::FHT) {
+                    comb_kernel_radius = fast_hankel.transform(comb_kernel_img_radius);
+                } else {
+                    STPLIB_DEBUG("stplib", "W-Proj: DHT size = {}x{}", DHT.n_rows, DHT.n_cols);
+
+                    arma::Mat<real_t> radial_kernel(DHT.n_rows, 2);
+                    set_radial_kernel(radial_kernel, 0, comb_kernel_img_radius);
+                    comb_kernel_radius = get_radial_kernel(dht_transform(radial_kernel), 0);
                 }
-                comb_kernel_radius(i) = { acc1, acc2 };
             }
 
             /*** generate Hankel transform kernel ***/
@@ -289,6 +413,13 @@ void WideFieldImaging::generate_convolution_kernel_wproj(real_t input_w_value, c
 
 void WideFieldImaging::generate_convolution_kernel_aproj(const arma::Mat<real_t>& a_kernel_img)
 {
+    // A-projection kernels are not symmetric
+    conv_kernel_quadrant = false;
+
+    // A-projection kernels are not stored on disk
+    store_kernel_cache = false;
+    loaded_kernel_cache = KernelBank();
+
     assert(!comb_kernel.empty());
     assert(!wp.hankel_opt);
     if (wp.hankel_opt == true) {
@@ -363,8 +494,12 @@ void WideFieldImaging::generate_convolution_kernel_aproj(const arma::Mat<real_t>
     }
 }
 
-arma::field<arma::Mat<cx_real_t>> WideFieldImaging::generate_kernel_cache()
+KernelBank WideFieldImaging::generate_kernel_cache()
 {
+    if (!loaded_kernel_cache.is_empty()) {
+        return std::move(loaded_kernel_cache);
+    }
+
     const size_t arr_size = array_size;
     const size_t ctr_idx = array_size / 2;
     const size_t oversamp = oversampling;
@@ -372,82 +507,118 @@ arma::field<arma::Mat<cx_real_t>> WideFieldImaging::generate_kernel_cache()
     const size_t oversampled_pixel = (oversamp / 2);
     const size_t cache_size = (oversampled_pixel * 2 + 1);
     const size_t tmp_cache_size = 2 * max_conv_support + 1;
-    arma::field<arma::Mat<cx_real_t>> cache(cache_size, cache_size);
-    arma::Mat<cx_real_t> tmp_cache(tmp_cache_size, tmp_cache_size);
+    KernelBank cache(cache_size, tmp_cache_size, true);
+    const size_t kernel_ld = cache.kernel_ld();
+
+    // Kernels of all oversampled-pixel offsets are extracted in parallel, directly into the kernel bank. The tap indices along each
+    // axis only depend on the offset, so they are computed once (without modulo or folding operations in the extraction loops)
+    const size_t num_kernel_elems = tmp_cache_size * kernel_ld;
+    std::vector<size_t> tap_idx(cache_size * tmp_cache_size);
 
     if (wp.hankel_opt == true) {
         //        const size_t kernel_offset = max_hankel_kernel_size / 2 + 1;
         const size_t kernel_offset = current_hankel_kernel_size / 2;
-        const size_t oversamp_conv_ini = 0 - max_conv_support * oversamp + oversampled_pixel;
-        const size_t oversamp_conv_end = 0 + max_conv_support * oversamp + oversampled_pixel;
+        const int oversamp_conv_ini = int(oversampled_pixel) - int(max_conv_support * oversamp);
 
-        for (uint x = 0; x < cache_size; x++) {
-            for (uint y = 0; y < cache_size; y++) {
+        // Distance of each tap to the kernel centre (in oversampled pixels)
+        for (size_t x = 0; x < cache_size; x++) {
+            for (size_t t = 0; t < tmp_cache_size; t++) {
+                const int c = oversamp_conv_ini - int(x) + int(t * oversamp);
+                tap_idx[x * tmp_cache_size + t] = size_t(std::abs(c));
+            }
+        }
 
-                const int xx_start = int(oversamp_conv_ini - x);
-                const int xx_end = int(oversamp_conv_end - x + 1);
-                const int yy_start = int(oversamp_conv_ini - y);
-                const int yy_end = int(oversamp_conv_end - y + 1);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, cache_size * cache_size), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t offset = r.begin(); offset < r.end(); ++offset) {
+                const size_t x = offset / cache_size;
+                const size_t y = offset % cache_size;
+                const size_t* dcx_idx = &tap_idx[x * tmp_cache_size];
+                const size_t* dcy_idx = &tap_idx[y * tmp_cache_size];
 
+                cx_real_t* kernel = cache.kernel(y, x);
                 real_t kernel_sum = 0;
-                size_t tx = 0, ty = 0, dcx = 0, dcy = 0, vec_idx = 0;
-                for (int cx = xx_start; cx < xx_end; cx += oversamp) {
-                    for (int cy = yy_start; cy < yy_end; cy += oversamp) {
-
-                        dcx = cx > 0 ? size_t(cx) : size_t(-cx);
-                        dcy = cy > 0 ? size_t(cy) : size_t(-cy);
+                for (size_t ty = 0; ty < tmp_cache_size; ty++) {
+                    const size_t dcx = dcx_idx[ty];
+                    for (size_t tx = 0; tx < tmp_cache_size; tx++) {
+                        const size_t dcy = dcy_idx[tx];
+                        size_t vec_idx;
                         if (dcx > dcy) {
                             vec_idx = dcy * kernel_offset - ((dcy * (dcy + 1)) >> 1) + dcx;
                         } else {
                             vec_idx = dcx * kernel_offset - ((dcx * (dcx + 1)) >> 1) + dcy;
                         }
 
-                        tmp_cache.at(tx, ty) = kernel_half_quandrant.at(vec_idx);
-                        kernel_sum += reinterpret_cast<real_t(&)[2]>(kernel_half_quandrant.at(vec_idx))[0];
-                        tx++;
+                        const cx_real_t value = kernel_half_quandrant.at(vec_idx);
+                        kernel[ty * kernel_ld + tx] = value;
+                        kernel_sum += value.real();
                     }
-                    tx = 0;
-                    ty++;
                 }
-                cache(y, x) = tmp_cache / kernel_sum;
+
+                // Normalize the kernel while it is still in cache (padding values are zero)
+                const real_t norm = real_t(1.0) / kernel_sum;
+                real_t* kernel_values = reinterpret_cast<real_t*>(kernel);
+                for (size_t i = 0; i < 2 * num_kernel_elems; i++) {
+                    kernel_values[i] *= norm;
+                }
             }
-        }
+        });
     } else { // kernel from not shifted fft
 
         const size_t kernel_half_size = arr_size / 2;
         const size_t oversamp_conv = ctr_idx - max_conv_support * oversamp + oversampled_pixel;
 
+        // Row/column of conv_kernel of each tap
         for (size_t x = 0; x < cache_size; x++) {
-            for (size_t y = 0; y < cache_size; y++) {
-
-                size_t cx, cy;
-                size_t xx_start = oversamp_conv - x;
-                size_t yy_start = oversamp_conv - y;
-                real_t kernel_sum = 0;
-                for (size_t ty = 0; ty < tmp_cache_size; ty++, xx_start += oversamp) {
+            for (size_t t = 0; t < tmp_cache_size; t++) {
+                size_t c = (oversamp_conv - x + t * oversamp + kernel_half_size) % arr_size;
+                if (conv_kernel_quadrant) {
+                    c = std::min(c, arr_size - c);
+                }
+                tap_idx[x * tmp_cache_size + t] = c;
+            }
+        }
 
-                    cx = (xx_start + kernel_half_size) % arr_size;
-                    for (size_t tx = 0; tx < tmp_cache_size; tx++, yy_start += oversamp) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, cache_size * cache_size), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t offset = r.begin(); offset < r.end(); ++offset) {
+                const size_t x = offset / cache_size;
+                const size_t y = offset % cache_size;
+                const size_t* cx_idx = &tap_idx[x * tmp_cache_size];
+                const size_t* cy_idx = &tap_idx[y * tmp_cache_size];
 
-                        cy = (yy_start + kernel_half_size) % arr_size;
-                        tmp_cache.at(tx, ty) = conv_kernel.at(cx, cy);
-                        kernel_sum += reinterpret_cast<real_t(&)[2]>(conv_kernel.at(cx, cy))[0];
+                cx_real_t* kernel = cache.kernel(y, x);
+                real_t kernel_sum = 0;
+                for (size_t ty = 0; ty < tmp_cache_size; ty++) {
+                    const size_t cx = cx_idx[ty];
+                    for (size_t tx = 0; tx < tmp_cache_size; tx++) {
+                        const cx_real_t value = conv_kernel.at(cx, cy_idx[tx]);
+                        kernel[ty * kernel_ld + tx] = value;
+                        kernel_sum += value.real();
                     }
-
-                    yy_start = oversamp_conv - y;
                 }
 
-                kernel_sum = 1 / kernel_sum;
-                cache(y, x) = tmp_cache * kernel_sum;
+                // Normalize the kernel while it is still in cache (padding values are zero)
+                const real_t norm = real_t(1.0) / kernel_sum;
+                real_t* kernel_values = reinterpret_cast<real_t*>(kernel);
+                for (size_t i = 0; i < 2 * num_kernel_elems; i++) {
+                    kernel_values[i] *= norm;
+                }
             }
-        }
+        });
     }
 
     STPLIB_DEBUG("stplib", "W-Proj: Kernel maximum = {}, minimum = {}, size = {}",
-        std::abs(cache(oversampling / 2, oversampling / 2).at(cache(oversampling / 2, oversampling / 2).n_rows / 2, cache(oversampling / 2, oversampling / 2).n_cols / 2)),
-        std::abs(cache(oversampling / 2, oversampling / 2).at(0, cache(oversampling / 2, oversampling / 2).n_cols / 2)),
+        std::abs(cache.kernel(oversampling / 2, oversampling / 2)[(tmp_cache_size / 2) * kernel_ld + tmp_cache_size / 2]),
+        std::abs(cache.kernel(oversampling / 2, oversampling / 2)[(tmp_cache_size / 2) * kernel_ld]),
         tmp_cache_size);
 
+    // Conjugate kernels are used for visibilities with negative w
+    cache.generate_conjugates();
+
+    if (store_kernel_cache) {
+        kernel_store.store(stored_kernel_key, w_value, cache, truncated_wpconv_support);
+        store_kernel_cache = false;
+    }
+
     return cache;
 }
 
@@ -484,76 +655,39 @@ arma::Col<real_t> WideFieldImaging::generate_hankel_radius_points(size_t arrsize
     return r_points;
 }
 
-/*************************************/
-/* Bessel function kind 1, order 1   */
-/*************************************/
-inline double besselj1(double x)
-{
-    double z, xx, y, res, tmp1, tmp2;
-
-    if (x < 8.0) {
-        xx = x * x;
-        tmp1 = x * (72362614232.0 + xx * (-7895059235.0 + xx * (242396853.1 + xx * (-2972611.439 + xx * (15704.48260 + xx * (-30.16036606))))));
-        tmp2 = 144725228442.0 + xx * (2300535178.0 + xx * (18583304.74 + xx * (99447.43394 + xx * (376.9991397 + xx))));
-        res = tmp1 / tmp2;
-    } else {
-        z = 8.0 / x;
-        xx = z * z;
-        y = x - 2.356194491;
-        tmp1 = 1.0 + xx * (0.183105e-2 + xx * (-0.3516396496e-4 + xx * (0.2457520174e-5 + xx * (-0.240337019e-6))));
-        tmp2 = 0.04687499995 + xx * (-0.2002690873e-3 + xx * (0.8449199096e-5 + xx * (-0.88228987e-6 + xx * 0.105787412e-6)));
-        res = sqrt(0.636619772 / x) * (cos(y) * tmp1 - z * sin(y) * tmp2);
-    }
-    return res;
-}
-
-inline float besselj1(float x)
-{
-    float z, xx, y, res, tmp1, tmp2;
-
-    if (x < 8.0f) {
-        xx = x * x;
-        tmp1 = x * (72362614232.0f + xx * (-7895059235.0f + xx * (242396853.1f + xx * (-2972611.439f + xx * (15704.48260f + xx * (-30.16036606f))))));
-        tmp2 = 144725228442.0f + xx * (2300535178.0f + xx * (18583304.74f + xx * (99447.43394f + xx * (376.9991397f + xx))));
-        res = tmp1 / tmp2;
-    } else {
-        z = 8.0f / x;
-        xx = z * z;
-        y = x - 2.356194491f;
-        tmp1 = 1.0f + xx * (0.183105e-2f + xx * (-0.3516396496e-4f + xx * (0.2457520174e-5f + xx * (-0.240337019e-6f))));
-        tmp2 = 0.04687499995f + xx * (-0.2002690873e-3f + xx * (0.8449199096e-5f + xx * (-0.88228987e-6f + xx * 0.105787412e-6f)));
-        res = std::sqrt(0.636619772f / x) * (std::cos(y) * tmp1 - z * std::sin(y) * tmp2);
-    }
-    return res;
-}
-
 /* Generate Discrete Hankel Transform (DHT) */
 // Note that DHT matrix is generated transposed for faster dot product during Hankel transform
-arma::Mat<real_t> WideFieldImaging::dht(size_t arrsize)
+arma::Mat<real_t> WideFieldImaging::dht(size_t arrsize, size_t num_radius_points, size_t num_freq_points)
 {
+    assert(num_radius_points <= arrsize);
+    assert(num_freq_points <= arrsize);
+
     // aux vars
-    arma::Col<real_t> k(arrsize);
-    arma::Col<real_t> rn(arrsize);
-    arma::Col<real_t> kn(arrsize);
-    arma::Mat<real_t> DHT(arrsize, arrsize);
+    arma::Col<real_t> k(num_freq_points);
+    arma::Col<real_t> rn(num_radius_points);
+    arma::Col<real_t> kn(num_freq_points);
+    arma::Mat<real_t> DHT(num_radius_points, num_freq_points);
 
     real_t kf = real_t(M_PI) / real_t(arrsize);
     kn[0] = 0.0;
     k[0] = 0.0;
-    rn[0] = 0.5;
-    tbb::parallel_for(tbb::blocked_range<size_t>(1, arrsize), [&](const tbb::blocked_range<size_t>& r) {
+    tbb::parallel_for(tbb::blocked_range<size_t>(1, num_freq_points), [&](const tbb::blocked_range<size_t>& r) {
         size_t i_end = r.end();
 
         for (size_t i = r.begin(); i < i_end; ++i) {
             real_t idx = i;
             k[i] = kf * idx;
-            rn[i] = idx + real_t(0.5);
             kn[i] = real_t(2.0 * M_PI) / k[i];
         }
     });
+    for (size_t j = 0; j < num_radius_points; j++) {
+        rn[j] = real_t(j) + real_t(0.5);
+    }
 
     // last rn value is
-    rn.at(arrsize - 1) = arrsize - 1;
+    if (num_radius_points == arrsize) {
+        rn.at(arrsize - 1) = arrsize - 1;
+    }
 
     /* generate Discrete Hankel Transform (DHT) */
     // fill first I value
@@ -564,14 +698,15 @@ arma::Mat<real_t> WideFieldImaging::dht(size_t arrsize)
     real_t cur_value;
 
     // fill first I line
-    for (size_t j = 1; j < arrsize; j++) {
+    for (size_t j = 1; j < num_radius_points; j++) {
         cur_value = real_t(M_PI) * rn[j] * rn[j];
         DHT.at(j, 0) = cur_value - prev_value;
         prev_value = cur_value;
     }
 
     //calculate remaining rows
-    tbb::parallel_for(tbb::blocked_range<size_t>(1, arrsize),
+    const size_t last_row = num_radius_points - 1;
+    tbb::parallel_for(tbb::blocked_range<size_t>(1, num_freq_points),
         [&](const tbb::blocked_range<size_t>& r) {
             size_t col_begin = r.begin(), col_end = r.end();
             if (col_begin == 0)
@@ -581,10 +716,10 @@ arma::Mat<real_t> WideFieldImaging::dht(size_t arrsize)
                 const real_t& kn_i = kn[i];
                 const real_t& k_i = k[i];
 
-                const real_t& rn_j = rn[arrsize - 1];
-                DHT.at(arrsize - 1, i) = kn_i * rn_j * besselj1(k_i * rn_j);
+                const real_t& rn_j = rn[last_row];
+                DHT.at(last_row, i) = kn_i * rn_j * besselj1(k_i * rn_j);
 
-                for (size_t j = arrsize - 1; j > 0; --j) {
+                for (size_t j = last_row; j > 0; --j) {
                     const real_t& rn_j = rn[j - 1];
                     DHT.at(j - 1, i) = kn_i * rn_j * besselj1(k_i * rn_j);
                     DHT.at(j, i) -= DHT.at(j - 1, i);
@@ -595,6 +730,23 @@ arma::Mat<real_t> WideFieldImaging::dht(size_t arrsize)
     return DHT;
 }
 
+arma::Mat<real_t> WideFieldImaging::dht_transform(const arma::Mat<real_t>& radial_kernels) const
+{
+    assert(radial_kernels.n_rows == DHT.n_rows);
+    arma::Mat<real_t> output(DHT.n_cols, radial_kernels.n_cols);
+
+    // The DHT matrix is stored transposed: output = DHT^T * radial_kernels
+#ifdef USE_FLOAT
+    cblas_sgemm(CblasColMajor, CblasTrans, CblasNoTrans, int(DHT.n_cols), int(radial_kernels.n_cols), int(DHT.n_rows),
+        1.0f, DHT.memptr(), int(DHT.n_rows), radial_kernels.memptr(), int(radial_kernels.n_rows), 0.0f, output.memptr(), int(output.n_rows));
+#else
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, int(DHT.n_cols), int(radial_kernels.n_cols), int(DHT.n_rows),
+        1.0, DHT.memptr(), int(DHT.n_rows), radial_kernels.memptr(), int(radial_kernels.n_rows), 0.0, output.memptr(), int(output.n_rows));
+#endif
+
+    return output;
+}
+
 // Local functions
 
 real_t parangle(real_t ha, real_t dec_rad, real_t ra_rad)
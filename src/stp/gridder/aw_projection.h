@@ -9,8 +9,16 @@
 #include "../common/matstp.h"
 #include "../common/spline.h"
 #include "../types.h"
+#include "hankel_transform.h"
+#include "kernel_bank.h"
+#include "kernel_store.h"
 #include <armadillo>
 
+// Number of Hankel transform points beyond the largest radius of the kernel interpolation (keeps the end of the cubic spline away from the kernel)
+#ifndef HANKEL_INTERP_MARGIN
+#define HANKEL_INTERP_MARGIN 32
+#endif
+
 namespace stp {
 
 /**
@@ -61,12 +69,31 @@ public:
     /**
     * @brief Generate convolution kernel at oversampled-pixel offsets for W-Projection.
     *
+    * Without Hankel transform optimization, the image-domain kernel is even along both axes, so only the first quadrant of the
+    * upsampled kernel is computed (see fft_fftw_c2c_even) and stored in conv_kernel.
+    *
+    * When the on-disk kernel cache is enabled (see W_ProjectionPars::kernel_cache_dir), the W value is quantized to the cache tolerance and
+    * the kernel cache is loaded from disk if it was already generated with the same parameters. Otherwise, the kernel cache produced by the
+    * next call to generate_kernel_cache() is stored on disk.
+    *
     * @param[in] input_w_value (real_t): Average W value used to compute W-kernel.
     * @param[in] aa_kernel_img (arma::Col<real_t>&): Sampled image-domain anti-aliasing kernel.
     * @param[in] hankel_proj_slice (bool): Whether to use projection slice theorem for Hankel transform or not
     */
     void generate_convolution_kernel_wproj(real_t input_w_value, const arma::Col<real_t>& aa_kernel_img, bool hankel_proj_slice = false);
 
+    /**
+     * @brief Compute the Hankel transforms of the radial kernels of several W values at once (batched DHT method).
+     *
+     * The radial kernels of all W values are transformed by a single matrix-matrix product with the DHT matrix (BLAS gemm), which
+     * is faster than one matrix-vector product per W value. The next calls of generate_convolution_kernel_wproj() with one of these
+     * W values use the precomputed transforms. This function has no effect unless the batched DHT method is selected.
+     *
+     * @param[in] w_values (arma::Col<real_t>): W values of the W-planes.
+     * @param[in] aa_kernel_img (arma::Col<real_t>&): Sampled image-domain anti-aliasing kernel.
+     */
+    void transform_hankel_batch(const arma::Col<real_t>& w_values, const arma::Col<real_t>& aa_kernel_img);
+
     /**
      * @brief Generate convolution kernel at oversampled-pixel offsets for A-Projection.
      *
@@ -77,9 +104,11 @@ public:
     /**
      * @brief Generate a cache of kernels at oversampled-pixel offsets for A/W-Projection.
      *
-     * @return (arma::field<arma::mat>): Cache of convolution kernels associated to oversampling-pixel offsets.
+     * Returns the memory-mapped kernel cache if it was loaded from disk by generate_convolution_kernel_wproj().
+     *
+     * @return (KernelBank): Cache of convolution kernels associated to oversampling-pixel offsets.
      */
-    arma::field<arma::Mat<cx_real_t>> generate_kernel_cache();
+    KernelBank generate_kernel_cache();
 
     /**
      * @brief Get kernel truncation value in pixels.
@@ -93,8 +122,25 @@ public:
 
     // Upsampled convolution kernel
     arma::Mat<cx_real_t> conv_kernel;
+    // Indicates whether conv_kernel only stores the first quadrant of the (even) upsampled kernel (see generate_convolution_kernel_wproj)
+    bool conv_kernel_quadrant = false;
 
 private:
+    /**
+     * @brief Generate the first quadrant, [0, array_size/2] x [0, array_size/2], of the image-domain convolution kernel (the kernel is even along both axes).
+     */
+    MatStp<cx_real_t> generate_image_domain_kernel_quadrant(const real_t input_w_value, const arma::Col<real_t>& aa_kernel_img);
+
+    /**
+     * @brief Generate the radial image-domain convolution kernel, at pixel distances [0, kernel_size/2) from the kernel centre (used by the Hankel transform).
+     */
+    arma::Col<cx_real_t> generate_radial_image_domain_kernel(const real_t input_w_value, const arma::Col<real_t>& aa_kernel_img);
+
+    /**
+     * @brief Key of the on-disk kernel cache, which identifies every parameter of the W-projection kernel except the W value
+     */
+    uint64_t kernel_store_key(const arma::Col<real_t>& aa_kernel_img, bool hankel_proj_slice) const;
+
     /**
      * @brief Auxiliary function to combine w_kernel and aa_img_domain_kernel values
      */
@@ -111,9 +157,21 @@ private:
     /**
      * @brief Compute Hankel transformation matrix.
      *
+     * Only the rows of the first radius points and the columns of the first frequency points of the arrsize x arrsize matrix are computed.
+     *
      * @param[in] arrsize (size_t): Hankel transform size.
+     * @param[in] num_radius_points (size_t): Number of radius points (rows).
+     * @param[in] num_freq_points (size_t): Number of frequency points (columns).
+     */
+    arma::Mat<real_t> dht(size_t arrsize, size_t num_radius_points, size_t num_freq_points); // Generate DHT Matrix
+
+    /**
+     * @brief Hankel transform of radial kernels using the DHT matrix (BLAS gemm).
+     *
+     * @param[in] radial_kernels (arma::Mat<real_t>): Radial kernels, with the real and imaginary parts of each kernel in consecutive columns.
+     * @return (arma::Mat<real_t>): Hankel transforms, with the same layout.
      */
-    arma::Mat<real_t> dht(size_t arrsize); // Generate DHT Matrix
+    arma::Mat<real_t> dht_transform(const arma::Mat<real_t>& radial_kernels) const;
 
     /**
      * @brief Perform radial kernel interpolation in kernel half quadrant given the radius function values and radius points.
@@ -229,7 +287,17 @@ private:
     MatStp<cx_real_t> comb_kernel;
     arma::Col<cx_real_t> kernel_half_quandrant;
     arma::Mat<real_t> DHT;
+    FastHankelTransform fast_hankel;
     arma::Col<real_t> hankel_radius_points;
+    // Hankel transforms computed by transform_hankel_batch, and their W values
+    arma::Mat<real_t> hankel_batch;
+    arma::Col<real_t> hankel_batch_w;
+
+    // On-disk kernel cache
+    KernelStore kernel_store;
+    uint64_t stored_kernel_key = 0;
+    bool store_kernel_cache = false;
+    KernelBank loaded_kernel_cache;
 };
 
 /**
@@ -0,0 +1,123 @@
+/**
+ * @file grid_tiles.cpp
+ * @brief Implementation of the tile-bucketed gridder functions.
+ */
+
+#include "grid_tiles.h"
+#include <cassert>
+#include <stdexcept>
+
+namespace stp {
+
+GridTiles::GridTiles(int _image_size, int _image_rows, int _tile_size, bool _wrap_negative_rows)
+    : image_size(_image_size)
+    , image_rows(_image_rows)
+    , tile_size(_tile_size)
+    , wrap_negative_rows(_wrap_negative_rows)
+{
+    if (tile_size <= 0)
+        throw std::runtime_error("tile_size must be positive for GridTiles generation.");
+
+    num_tile_rows = (image_rows + tile_size - 1) / tile_size;
+    num_tile_cols = (image_size + tile_size - 1) / tile_size;
+    tile_offsets.assign(num_tiles() + 1, 0);
+}
+
+int GridTiles::footprint_tiles(int first, int kernel_size, int extent, bool wrap_negative, int tile_ranges[3][2]) const
+{
+    TileSpan spans[3];
+    int num_spans = intersect_footprint(first, kernel_size, 0, extent, image_size, wrap_negative, spans);
+
+    // Convert grid spans to tile ranges (sorted by first tile)
+    int num_ranges = 0;
+    for (int s = 0; s < num_spans; ++s) {
+        int lo = (spans[s].kbegin + spans[s].grid_offset) / tile_size;
+        int hi = (spans[s].kend - 1 + spans[s].grid_offset) / tile_size;
+        int r = num_ranges++;
+        while (r > 0 && tile_ranges[r - 1][0] > lo) {
+            tile_ranges[r][0] = tile_ranges[r - 1][0];
+            tile_ranges[r][1] = tile_ranges[r - 1][1];
+            r--;
+        }
+        tile_ranges[r][0] = lo;
+        tile_ranges[r][1] = hi;
+    }
+
+    // Merge overlapping ranges, so that a tile is never visited twice for the same footprint
+    int num_merged = 0;
+    for (int r = 0; r < num_ranges; ++r) {
+        if (num_merged > 0 && tile_ranges[r][0] <= tile_ranges[num_merged - 1][1]) {
+            tile_ranges[num_merged - 1][1] = std::max(tile_ranges[num_merged - 1][1], tile_ranges[r][1]);
+        } else {
+            tile_ranges[num_merged][0] = tile_ranges[r][0];
+            tile_ranges[num_merged][1] = tile_ranges[r][1];
+            num_merged++;
+        }
+    }
+    return num_merged;
+}
+
+template <typename F>
+void GridTiles::for_each_footprint_tile(int gc_x, int gc_y, int support, F&& func) const
+{
+    const int kernel_size = support * 2 + 1;
+    int col_ranges[3][2];
+    int row_ranges[3][2];
+    const int num_col_ranges = footprint_tiles(gc_x - support, kernel_size, image_size, true, col_ranges);
+    const int num_row_ranges = footprint_tiles(gc_y - support, kernel_size, image_rows, wrap_negative_rows, row_ranges);
+
+    for (int c = 0; c < num_col_ranges; ++c) {
+        for (int tile_col = col_ranges[c][0]; tile_col <= col_ranges[c][1]; ++tile_col) {
+            for (int r = 0; r < num_row_ranges; ++r) {
+                for (int tile_row = row_ranges[r][0]; tile_row <= row_ranges[r][1]; ++tile_row) {
+                    func(size_t(tile_col) * size_t(num_tile_rows) + size_t(tile_row));
+                }
+            }
+        }
+    }
+}
+
+void GridTiles::bin(const arma::Mat<int>& kernel_centre_on_grid, const arma::Col<uint>& good_vis, arma::uword vi_begin, arma::uword vi_end, int support,
+    const arma::ivec& vis_group, int group)
+{
+    assert(vi_end <= good_vis.n_elem);
+    assert(kernel_centre_on_grid.n_rows == good_vis.n_elem);
+    const bool use_groups = !vis_group.is_empty();
+
+    // Apply function to the footprint of every visibility (and conjugate visibility) to be gridded
+    auto for_each_entry = [&](auto&& func) {
+        for (arma::uword vi = vi_begin; vi < vi_end; ++vi) {
+            const uint good_vis_val = good_vis[vi];
+            if (good_vis_val == 0)
+                continue;
+            if (use_groups && (vis_group[vi] != group))
+                continue;
+
+            for (uint gv = 0; gv < good_vis_val; ++gv) {
+                int gc_x = kernel_centre_on_grid(vi, 0);
+                int gc_y = kernel_centre_on_grid(vi, 1);
+                if (gv) {
+                    gc_x = -gc_x + image_size;
+                    gc_y = -gc_y + image_size;
+                }
+                const arma::uword entry = (vi << 1) | arma::uword(gv);
+                for_each_footprint_tile(gc_x, gc_y, support, [&](size_t tile) { func(tile, entry); });
+            }
+        }
+    };
+
+    // Counting sort: count entries per tile
+    std::fill(tile_offsets.begin(), tile_offsets.end(), 0);
+    for_each_entry([&](size_t tile, arma::uword) { tile_offsets[tile + 1]++; });
+
+    // Prefix sum gives the first entry of each tile
+    for (size_t t = 0; t < num_tiles(); ++t) {
+        tile_offsets[t + 1] += tile_offsets[t];
+    }
+    entries.resize(tile_offsets.back());
+
+    // Scatter entries, keeping ascending visibility order within each tile
+    std::vector<size_t> fill_pos(tile_offsets.begin(), tile_offsets.end() - 1);
+    for_each_entry([&](size_t tile, arma::uword entry) { entries[fill_pos[tile]++] = entry; });
+}
+}
@@ -0,0 +1,190 @@
+/** @file grid_tiles.h
+ *  @brief Classes and function prototypes of the tile-bucketed gridder.
+ */
+
+#ifndef GRID_TILES_H
+#define GRID_TILES_H
+
+#include "../types.h"
+#include <algorithm>
+#include <armadillo>
+#include <vector>
+
+// Default width (in pixels) of the square grid tiles owned by each gridder task
+#ifndef GRIDDER_TILE_SIZE
+#define GRIDDER_TILE_SIZE 64
+#endif
+
+namespace stp {
+
+/**
+ * @brief Range of kernel indices that overlaps a grid tile along one axis
+ *
+ * Kernel index k in [kbegin, kend) is mapped to the grid position (k + grid_offset).
+ */
+struct TileSpan {
+    int kbegin;
+    int kend;
+    int grid_offset;
+};
+
+/** @brief Intersect a kernel footprint with a range of grid positions along one axis.
+ *
+ *  The kernel footprint starts at (possibly out-of-bounds) grid position 'first'. Positions above the image
+ *  size are wrapped to the beginning of the axis. Negative positions are wrapped to the end of the axis when
+ *  'wrap_negative' is true, otherwise they are discarded (halfplane gridding).
+ *
+ *  @param[in] first (int): Grid position of the first kernel point.
+ *  @param[in] kernel_size (int): Number of kernel points.
+ *  @param[in] range_begin (int): First grid position of the range.
+ *  @param[in] range_end (int): Grid position after the last one of the range.
+ *  @param[in] image_size (int): Image width in pixels (wrapping period).
+ *  @param[in] wrap_negative (bool): Wrap negative grid positions.
+ *  @param[out] spans (TileSpan[3]): Kernel spans that overlap the range.
+ *
+ *  @return (int): Number of valid spans.
+ */
+inline int intersect_footprint(int first, int kernel_size, int range_begin, int range_end, int image_size, bool wrap_negative, TileSpan spans[3])
+{
+    int num_spans = 0;
+    for (int wrap = (wrap_negative ? 1 : 0); wrap >= -1; --wrap) {
+        const int offset = first + wrap * image_size;
+        const int kbegin = std::max(0, range_begin - offset);
+        const int kend = std::min(kernel_size, range_end - offset);
+        if (kbegin < kend) {
+            spans[num_spans++] = { kbegin, kend, offset };
+        }
+    }
+    return num_spans;
+}
+
+/**
+ * @brief The GridTiles class
+ *
+ * Splits the output grid into square tiles and buckets visibilities by the tiles covered by their kernel footprint
+ * (counting sort). Each tile can then be gridded by a separate task that only writes inside its own tile, so no
+ * synchronization is required between tasks. Within each tile, visibilities are kept in ascending order, hence
+ * the accumulation order of every grid cell matches the serial gridder.
+ */
+class GridTiles {
+public:
+    /**
+     * @brief Default constructor
+     */
+    GridTiles() = default;
+
+    /**
+     * @brief GridTiles constructor
+     *
+     * @param[in] image_size (int): Number of grid columns (and wrapping period of both axes).
+     * @param[in] image_rows (int): Number of grid rows (half_image_size + 1 when using halfplane gridding).
+     * @param[in] tile_size (int): Tile width in pixels.
+     * @param[in] wrap_negative_rows (bool): Wrap kernel rows falling on negative grid rows (otherwise they are discarded).
+     */
+    GridTiles(int image_size, int image_rows, int tile_size = GRIDDER_TILE_SIZE, bool wrap_negative_rows = false);
+
+    /**
+     * @brief Bucket visibilities in range [vi_begin, vi_end) by the grid tiles covered by their kernel footprint.
+     *
+     * Conjugate visibilities (good_vis == 2) are placed at the mirrored grid position and are flagged in the entry.
+     *
+     * @param[in] kernel_centre_on_grid (arma::Mat<int>): Kernel centre positions on the grid.
+     * @param[in] good_vis (arma::Col<uint>): Identifies visibilities to be gridded (0 - skip, 1 - grid, 2 - grid also conjugate).
+     * @param[in] vi_begin (arma::uword): First visibility index.
+     * @param[in] vi_end (arma::uword): Last visibility index (not included).
+     * @param[in] support (int): Kernel support.
+     * @param[in] vis_group (arma::ivec): Optional group index of each visibility (e.g. A-projection timestep).
+     * @param[in] group (int): Only bucket visibilities whose group index matches this value (if vis_group is not empty).
+     */
+    void bin(const arma::Mat<int>& kernel_centre_on_grid, const arma::Col<uint>& good_vis, arma::uword vi_begin, arma::uword vi_end, int support,
+        const arma::ivec& vis_group = arma::ivec(), int group = 0);
+
+    /**
+     * @brief Number of tiles
+     */
+    size_t num_tiles() const
+    {
+        return size_t(num_tile_rows) * size_t(num_tile_cols);
+    }
+
+    /**
+     * @brief Grid range covered by a tile
+     *
+     * @param[in] tile (size_t): Tile index.
+     * @param[out] row_begin (int): First row.
+     * @param[out] row_end (int): Row after the last one.
+     * @param[out] col_begin (int): First column.
+     * @param[out] col_end (int): Column after the last one.
+     */
+    void tile_range(size_t tile, int& row_begin, int& row_end, int& col_begin, int& col_end) const
+    {
+        const int tile_row = int(tile % size_t(num_tile_rows));
+        const int tile_col = int(tile / size_t(num_tile_rows));
+        row_begin = tile_row * tile_size;
+        row_end = std::min(row_begin + tile_size, image_rows);
+        col_begin = tile_col * tile_size;
+        col_end = std::min(col_begin + tile_size, image_size);
+    }
+
+    /**
+     * @brief Index of the first entry of a tile in the entries vector
+     */
+    size_t tile_begin(size_t tile) const
+    {
+        return tile_offsets[tile];
+    }
+
+    /**
+     * @brief Index after the last entry of a tile in the entries vector
+     */
+    size_t tile_end(size_t tile) const
+    {
+        return tile_offsets[tile + 1];
+    }
+
+    /**
+     * @brief Visibility index of an entry
+     */
+    static arma::uword entry_vis(arma::uword entry)
+    {
+        return entry >> 1;
+    }
+
+    /**
+     * @brief Indicates whether an entry represents the conjugate visibility
+     */
+    static bool entry_conj(arma::uword entry)
+    {
+        return (entry & 1) != 0;
+    }
+
+    /**
+     * Bucketed entries (visibility index shifted left by one bit, lowest bit indicates the conjugate visibility)
+     */
+    std::vector<arma::uword> entries;
+
+private:
+    /**
+     * @brief Get the inclusive ranges of tile indices covered by a kernel footprint along one axis.
+     *
+     * @return (int): Number of disjoint tile ranges (at most 3).
+     */
+    int footprint_tiles(int first, int kernel_size, int extent, bool wrap_negative, int tile_ranges[3][2]) const;
+
+    /**
+     * @brief Apply function to every tile covered by the kernel footprint centred at (gc_x, gc_y).
+     */
+    template <typename F>
+    void for_each_footprint_tile(int gc_x, int gc_y, int support, F&& func) const;
+
+    int image_size = 0;
+    int image_rows = 0;
+    int tile_size = GRIDDER_TILE_SIZE;
+    bool wrap_negative_rows = false;
+    int num_tile_rows = 0;
+    int num_tile_cols = 0;
+    std::vector<size_t> tile_offsets;
+};
+}
+
+#endif /* GRID_TILES_H */
@@ -4,7 +4,7 @@
  */
 
 #include "gridder.h"
-#include "../common/spharmonics.h"
+#include "primary_beam.h"
 
 namespace stp {
 
@@ -145,6 +145,78 @@ void average_w_planes(arma::mat w_lambda, const arma::Col<uint>& good_vis, uint
     }
 }
 
+uint adaptive_w_planes(const arma::vec& w_lambda, const arma::Col<uint>& good_vis, double max_w_error, uint max_num_wplanes,
+    arma::Col<real_t>& w_avg_values, arma::uvec& w_planes_firstidx, double& achieved_w_error)
+{
+    assert(max_w_error > 0.0);
+    assert(max_num_wplanes > 0);
+    assert(w_lambda.n_elem == good_vis.n_elem);
+
+    // Each plane covers the range [w_first, w_first + 2 * w_error] of its first (smallest) w value
+    auto count_planes = [&](double w_error) {
+        uint num_planes = 0;
+        double plane_end = 0.0;
+        for (arma::uword k = 0; k < good_vis.n_elem; k++) {
+            if (good_vis[k] != 0) {
+                if ((num_planes == 0) || (w_lambda[k] > plane_end)) {
+                    num_planes++;
+                    plane_end = w_lambda[k] + 2.0 * w_error;
+                }
+            }
+        }
+        return num_planes;
+    };
+
+    // Relax the error bound until the planes fit in the maximum number of planes
+    double w_error = max_w_error;
+    uint num_wplanes = count_planes(w_error);
+    while (num_wplanes > max_num_wplanes) {
+        w_error *= 1.25;
+        num_wplanes = count_planes(w_error);
+    }
+    num_wplanes = std::max(num_wplanes, 1u);
+
+    w_avg_values.zeros(num_wplanes);
+    w_planes_firstidx.zeros(num_wplanes);
+
+    // The W value of each plane is the centre of the w range of its visibilities
+    achieved_w_error = 0.0;
+    int plane = -1;
+    double plane_first_w = 0.0;
+    double plane_last_w = 0.0;
+    for (arma::uword k = 0; k < good_vis.n_elem; k++) {
+        if (good_vis[k] != 0) {
+            if ((plane < 0) || (w_lambda[k] > plane_first_w + 2.0 * w_error)) {
+                if (plane >= 0) {
+                    w_avg_values[plane] = real_t((plane_first_w + plane_last_w) / 2.0);
+                    w_planes_firstidx[plane + 1] = k;
+                    achieved_w_error = std::max(achieved_w_error, (plane_last_w - plane_first_w) / 2.0);
+                }
+                plane++;
+                plane_first_w = w_lambda[k];
+            }
+            plane_last_w = w_lambda[k];
+        }
+    }
+    if (plane >= 0) {
+        w_avg_values[plane] = real_t((plane_first_w + plane_last_w) / 2.0);
+        achieved_w_error = std::max(achieved_w_error, (plane_last_w - plane_first_w) / 2.0);
+    }
+    assert(uint(plane + 1) == ((plane < 0) ? 0 : num_wplanes));
+
+    return num_wplanes;
+}
+
+double max_w_plane_error(double max_phase_error, double cell_size, int image_size)
+{
+    // The largest w-term of the image, |n - 1| with n = sqrt(1 - l^2 - m^2), is found at the image corners
+    const double l_max = arc_sec_to_rad(cell_size) * double(image_size / 2);
+    const double r2 = 2.0 * l_max * l_max;
+    const double n_term = (r2 < 1.0) ? (1.0 - std::sqrt(1.0 - r2)) : 1.0;
+
+    return max_phase_error / (2.0 * M_PI * n_term);
+}
+
 void average_lha_planes(const arma::vec& lha, const arma::Col<uint>& good_vis, uint num_timesteps, arma::Col<real_t>& lha_planes, arma::ivec& vis_timesteps)
 {
     // Find maximum and minimum lha values
@@ -204,12 +276,7 @@ void bounds_check_kernel_centre_locations(arma::Col<uint>& good_vis, const arma:
     // Check bounds
     uint col = 0;
     kernel_centre_on_grid.each_row([&](const arma::Mat<int>& r) {
-        const auto& kc_x = r[0];
-        const auto& kc_y = r[1];
-
-        // Note that in-bound kernels that touch the left and top margins are also considered as being out-of-bounds (see comparison: <= 0).
-        // This is to fix the non-symmetric issue on the complex gridded matrix caused by the even matrix size.
-        if ((kc_x - support) <= 0 || (kc_y - support) <= 0 || (kc_x + support) >= image_size || (kc_y + support) >= image_size) {
+        if (!kernel_centre_in_bounds(r[0], r[1], image_size, support)) {
             good_vis[col] = 0;
         }
         col++;
@@ -222,19 +289,8 @@ arma::Mat<int> calculate_oversampled_kernel_indices(arma::mat& subpixel_coord, u
 
     arma::Mat<int> oversampled_coord(arma::size(subpixel_coord));
 
-    int range_max = oversampling / 2;
-    int range_min = -1 * range_max;
-
     for (arma::uword i = 0; i < subpixel_coord.n_elem; i++) {
-        int val = int(rint(subpixel_coord.at(i) * oversampling));
-        if (val > range_max) {
-            val = range_max;
-        } else {
-            if (val < range_min) {
-                val = range_min;
-            }
-        }
-        oversampled_coord.at(i) = val;
+        oversampled_coord.at(i) = oversampled_kernel_index(subpixel_coord.at(i), oversampling);
     }
 
     return oversampled_coord;
@@ -242,35 +298,6 @@ arma::Mat<int> calculate_oversampled_kernel_indices(arma::mat& subpixel_coord, u
 
 arma::Mat<real_t> generate_a_kernel(const A_ProjectionPars& a_proj, const double fov, const int workarea_size, double rot_angle)
 {
-    arma::Mat<real_t> Akernel((size_t)workarea_size, (size_t)workarea_size);
-    int degree = int((a_proj.pbeam_coefs.size() - 1) / 2);
-    int workarea_centre = workarea_size / 2;
-
-    tbb::parallel_for(tbb::blocked_range<int>(-workarea_centre, workarea_centre),
-        [&](const tbb::blocked_range<int>& r) {
-            int j_begin = r.begin(), j_end = r.end();
-            for (int j = j_begin; j < j_end; ++j) {
-                for (int i = -workarea_centre; i < workarea_centre; ++i) {
-                    // Compute phi and theta
-                    double j_rad = double(j) * fov / double(workarea_size);
-                    double i_rad = double(i) * fov / double(workarea_size);
-                    double theta = std::sqrt(j_rad * j_rad + i_rad * i_rad); // Polar angle
-                    double phi = M_PI / 2.0;                                 // Azimuth angle
-                    if (j != 0) {
-                        phi = std::atan(i_rad / j_rad);
-                    }
-                    // Init Akernel
-                    Akernel(size_t(j + workarea_centre), size_t(i + workarea_centre)) = 0;
-                    // Compute each spherical harmonic, get abs and sum
-                    for (int m = -degree; m <= degree; m++) { // SH order range
-                        Akernel(size_t(j + workarea_centre), size_t(i + workarea_centre)) += real_t(std::abs(sh::EvalSH(degree, m, phi + rot_angle, theta) * a_proj.pbeam_coefs[degree + m]));
-                    }
-                    // Invert Akernel value
-                    Akernel(size_t(j + workarea_centre), size_t(i + workarea_centre)) = 1.0 / Akernel(size_t(j + workarea_centre), size_t(i + workarea_centre));
-                }
-            }
-        });
-
-    return Akernel;
+    return PrimaryBeam(a_proj.pbeam_coefs, fov, workarea_size).a_kernel(rot_angle);
 }
 }
@@ -7,18 +7,31 @@
 
 #include <cassert>
 #include <cfloat>
+#include <limits>
 #include <map>
 #include <tbb/tbb.h>
+#include <vector>
 
 #include "../common/fft.h"
 #include "../common/matstp.h"
+#include "../common/strided_view.h"
 #include "../convolution/conv_func.h"
 #include "../global_macros.h"
 #include "../types.h"
+#include "a_kernel_cache.h"
 #include "aw_projection.h"
+#include "grid_tiles.h"
+#include "kernel_bank.h"
+#include "simd_accumulate.h"
+#include "visibility_block.h"
 
 #define arc_sec_to_rad(value) ((value / 3600.0) * (M_PI / 180.0))
 
+// Largest kernel size gridded with unrolled loops when the explicitly vectorized gridder (SIMD_GRIDDER) is enabled
+#ifndef SIMD_GRIDDER_MAX_UNROLLED_KERNEL_SIZE
+#define SIMD_GRIDDER_MAX_UNROLLED_KERNEL_SIZE 13
+#endif
+
 namespace stp {
 
 /**
@@ -104,6 +117,43 @@ arma::field<arma::Mat<cx_real_t>> populate_kernel_cache(const T& kernel_creator,
     return cache;
 }
 
+/** @brief populate_kernel_cache_1D function
+ *
+ *  Generate a cache of normalised 1D kernels at oversampled-pixel offsets. The 2D kernel at offsets (cp_y, cp_x)
+ *  is the outer product of columns cp_y and cp_x, hence this separable cache replaces the one generated by
+ *  populate_kernel_cache (of size (oversampling+1)^2 * kernel_size^2) for non-w-projection kernels.
+ *
+ *  @param[in] T& kernel_creator : the kernel creator functor.
+ *  @param[in] support (int): See kernel generation routine.
+ *  @param[in] oversampling (int): Oversampling ratio value.
+ *  @param[in] pad (bool) :  Whether to pad the array by an extra pixel-width.
+ *             This is used when generating an oversampled kernel that will be used for interpolation. Default is false.
+ *  @param[in] normalize (bool): Whether to normalize generated kernel functions. Default is true.
+ *
+ *  @return (arma::Mat<real_t>): Matrix with one normalised 1D kernel per column (one column per oversampling-pixel offset).
+ */
+template <typename T>
+arma::Mat<real_t> populate_kernel_cache_1D(const T& kernel_creator, const uint support, const uint oversampling, const bool pad = false, const bool normalize = true)
+{
+    uint oversampled_pixel = (oversampling / 2);
+    uint cache_size = (oversampled_pixel * 2 + 1);
+
+    arma::mat oversampled_pixel_offsets = (arma::linspace(0, cache_size - 1, cache_size) - oversampled_pixel) / oversampling;
+    arma::Mat<real_t> cache;
+
+    for (uint i = 0; i < cache_size; i++) {
+        arma::Col<real_t> kernel1D = make_1D_kernel(kernel_creator, support, oversampled_pixel_offsets[i], 1, pad, normalize);
+        if (i == 0) {
+            cache.set_size(kernel1D.n_elem, cache_size);
+        }
+        for (size_t k = 0; k < kernel1D.n_elem; k++) {
+            cache.at(k, i) = kernel1D.at(k);
+        }
+    }
+
+    return cache;
+}
+
 /**
  * @brief Convert visibilities for half-plane gridding and mark the ones that need to be duplicated (includes W-lambda array).
  *
@@ -139,6 +189,37 @@ void convert_to_halfplane_visibilities(arma::mat& uv_lambda, arma::cx_mat& vis,
  */
 void average_w_planes(arma::mat w_lambda, const arma::Col<uint>& good_vis, uint num_wplanes, arma::Col<real_t>& w_avg_values, arma::uvec& w_planes_idx, bool median = false);
 
+/**
+ * @brief Divides the list of w-lambda values into planes whose W value differs from the w of their visibilities by at most a given error.
+ *
+ * Plane boundaries follow the distribution of w: every plane covers a w range of width 2 * max_w_error, starting at the smallest w
+ * not yet assigned to a plane, so planes are only created where there are visibilities. The W value of each plane is the centre of
+ * the w range of its visibilities. If more than max_num_wplanes planes are needed, the error bound is relaxed (by factors of 1.25)
+ * until they fit, hence max_w_error is a target: the achieved error is returned in achieved_w_error.
+ *
+ * @param[in] w_lambda (arma::vec): W-lambda values, sorted in ascending order.
+ * @param[in] good_vis (arma::Col<uint>): Indicates which visibilities are valid.
+ * @param[in] max_w_error (double): Maximum difference between the W value of a plane and the w of its visibilities.
+ * @param[in] max_num_wplanes (uint): Maximum number of planes.
+ * @param[out] w_avg_values (arma::Col): W-value of each plane.
+ * @param[out] w_planes_idx (arma::uvec): List of indexes corresponding to the first visibility associated to each plane.
+ * @param[out] achieved_w_error (double): Largest difference between the W value of a plane and the w of its visibilities
+ *                                        (larger than max_w_error when the error bound was relaxed).
+ * @return (uint): Number of planes.
+ */
+uint adaptive_w_planes(const arma::vec& w_lambda, const arma::Col<uint>& good_vis, double max_w_error, uint max_num_wplanes,
+    arma::Col<real_t>& w_avg_values, arma::uvec& w_planes_idx, double& achieved_w_error);
+
+/**
+ * @brief Maximum w error of a w-plane that keeps the phase error of the w-term below the given bound over the whole image.
+ *
+ * @param[in] max_phase_error (double): Maximum phase error of the w-term (in radians).
+ * @param[in] cell_size (double): Angular-width of a synthesized pixel in the image to be created (arcsecond).
+ * @param[in] image_size (int): Width of the image in pixels.
+ * @return (double): Maximum w error (in wavelengths).
+ */
+double max_w_plane_error(double max_phase_error, double cell_size, int image_size);
+
 /**
  * @brief Divides the list of local hour-angle values into N planes, averaging each plane.
  *
@@ -162,6 +243,44 @@ void average_lha_planes(const arma::vec& lha, const arma::Col<uint>& good_vis, u
  */
 void bounds_check_kernel_centre_locations(arma::Col<uint>& good_vis, const arma::Mat<int>& kernel_centre_on_grid, int image_size, int support);
 
+/** @brief kernel_centre_in_bounds function
+ *
+ *  Bounds check of a single kernel centre location (see bounds_check_kernel_centre_locations).
+ *
+ *  @param[in] kc_x (int): Kernel centre column.
+ *  @param[in] kc_y (int): Kernel centre row.
+ *  @param[in] image_size (int): Image width in pixels.
+ *  @param[in] support (int): Kernel support size in regular pixels.
+ *
+ *  @return (bool): True if the kernel lies inside the grid.
+ */
+inline bool kernel_centre_in_bounds(int kc_x, int kc_y, int image_size, int support)
+{
+    // Note that in-bound kernels that touch the left and top margins are also considered as being out-of-bounds (see comparison: <= 0).
+    // This is to fix the non-symmetric issue on the complex gridded matrix caused by the even matrix size.
+    return !((kc_x - support) <= 0 || (kc_y - support) <= 0 || (kc_x + support) >= image_size || (kc_y + support) >= image_size);
+}
+
+/** @brief oversampled_kernel_index function
+ *
+ *  Find the nearest oversampled gridpoint for a given sub-pixel offset (see calculate_oversampled_kernel_indices).
+ *
+ *  @param[in] subpixel_coord (double): Subpixel offset from nearest pixel on the regular grid.
+ *  @param[in] oversampling (uint). How many oversampled pixels to one regular pixel.
+ *
+ *  @return (int): Corresponding oversampled pixel index
+ */
+inline int oversampled_kernel_index(double subpixel_coord, uint oversampling)
+{
+    assert(std::abs(subpixel_coord) <= 0.5);
+
+    const int range_max = oversampling / 2;
+    const int range_min = -1 * range_max;
+    const int val = int(rint(subpixel_coord * oversampling));
+
+    return (val > range_max) ? range_max : ((val < range_min) ? range_min : val);
+}
+
 /** @brief calculate_oversampled_kernel_indices function
  *
  *  Find the nearest oversampled gridpoint for given sub-pixel offset.
@@ -187,97 +306,493 @@ arma::Mat<int> calculate_oversampled_kernel_indices(arma::mat& subpixel_coord, u
  */
 arma::Mat<real_t> generate_a_kernel(const A_ProjectionPars& a_proj, const double fov, const int workarea_size, double rot_angle = 0.0);
 
-/** @brief Grid visibilities using convolutional gridding.
+/** @brief grid_kernel_spans function
  *
- *  Returns the **un-normalized** weighted visibilities; the
- *  weights-renormalization factor can be calculated by summing the sample grid.
+ *  Accumulate the weighted convolution kernel of a visibility on the grid positions given by the column and row spans
+ *  (see intersect_footprint function).
  *
- *  If 'exact == True' then exact gridding is used, i.e. the kernel is
- *  recalculated for each visibility, with precise sub-pixel offset according to
- *  that visibility's UV co-ordinates. Otherwise, instead of recalculating the
- *  kernel for each sub-pixel location, we pre-generate an oversampled kernel
- *  ahead of time - so e.g. for an oversampling of 5, the kernel is
- *  pre-generated at 0.2 pixel-width offsets. We then pick the pre-generated
- *  kernel corresponding to the sub-pixel offset nearest to that of the
- *  visibility.
- *  Kernel pre-generation results in improved performance, particularly with
- *  large numbers of visibilities and complex kernel functions, at the cost of
- *  introducing minor aliasing effects due to the 'step-like' nature of the
- *  oversampled kernel. This in turn can be minimised (at the cost of longer
- *  start-up times and larger memory usage) by pre-generating kernels with a
- *  larger oversampling ratio, to give finer interpolation.
- *  This function also performs W-projection and A-projection when these
- *  parameters are provided.
+ *  @param[in,out] vis_grid (MatStp<cx_real_t>): Visibility grid.
+ *  @param[in,out] sampling_grid (MatStp<cx_real_t>): Sampling grid (only used when generateBeam is true).
+ *  @param[in] conv_kernel (cx_real_t*): Convolution kernel (column-major, see KernelBank).
+ *  @param[in] kernel_ld (size_t): Leading dimension of the convolution kernel.
+ *  @param[in] col_spans (TileSpan*): Kernel column spans.
+ *  @param[in] num_col_spans (int): Number of column spans.
+ *  @param[in] row_spans (TileSpan*): Kernel row spans.
+ *  @param[in] num_row_spans (int): Number of row spans.
+ *  @param[in] vis_val (cx_real_t): Visibility value.
+ *  @param[in] vis_weight (real_t): Visibility weight.
+ */
+template <bool generateBeam>
+inline void grid_kernel_spans(MatStp<cx_real_t>& vis_grid, MatStp<cx_real_t>& sampling_grid, const cx_real_t* conv_kernel, const size_t kernel_ld,
+    const TileSpan* col_spans, int num_col_spans, const TileSpan* row_spans, int num_row_spans, const cx_real_t vis_val, const real_t vis_weight)
+{
+#ifdef SIMD_GRIDDER
+    // Explicitly vectorized complex multiply-accumulate (selected at runtime according to the CPU)
+    for (int cs = 0; cs < num_col_spans; ++cs) {
+        const int col_begin = col_spans[cs].kbegin;
+        const int num_cols = col_spans[cs].kend - col_begin;
+        const int grid_col = col_begin + col_spans[cs].grid_offset;
+        for (int rs = 0; rs < num_row_spans; ++rs) {
+            const int row_begin = row_spans[rs].kbegin;
+            const int num_rows = row_spans[rs].kend - row_begin;
+            const int grid_row = row_begin + row_spans[rs].grid_offset;
+            accumulate_block(&vis_grid.at(uint(grid_row), uint(grid_col)), vis_grid.n_rows,
+                generateBeam ? &sampling_grid.at(uint(grid_row), uint(grid_col)) : nullptr, sampling_grid.n_rows,
+                conv_kernel + size_t(col_begin) * kernel_ld + size_t(row_begin), kernel_ld, num_rows, num_cols, vis_val, vis_weight, false);
+        }
+    }
+#else
+    for (int cs = 0; cs < num_col_spans; ++cs) {
+        for (int j = col_spans[cs].kbegin; j < col_spans[cs].kend; ++j) {
+            // Use pointers here for faster access
+            const cx_real_t* conv_kernel_col = conv_kernel + size_t(j) * kernel_ld;
+            cx_real_t* vis_grid_col = vis_grid.colptr(uint(j + col_spans[cs].grid_offset));
+            cx_real_t* sampling_grid_col = nullptr;
+            if (generateBeam) {
+                sampling_grid_col = sampling_grid.colptr(uint(j + col_spans[cs].grid_offset));
+            }
+
+            for (int rs = 0; rs < num_row_spans; ++rs) {
+                const int row_offset = row_spans[rs].grid_offset;
+                for (int i = row_spans[rs].kbegin; i < row_spans[rs].kend; ++i) {
+                    const cx_real_t kernel_val = conv_kernel_col[i] * vis_weight;
+                    vis_grid_col[i + row_offset] += vis_val * kernel_val;
+                    if (generateBeam) {
+                        sampling_grid_col[i + row_offset] += kernel_val;
+                    }
+                }
+            }
+        }
+    }
+#endif
+}
+
+/** @brief grid_separable_kernel_spans function
  *
- *  @param[in] T& kernel_creator : the kernel creator functor.
- *  @param[in] support (uint) : Defines the 'radius' of the bounding box within
- *              which convolution takes place. `Box width in pixels = 2*support+1`.
- *              (The central pixel is the one nearest to the UV co-ordinates.)
- *              (This is sometimes known as the 'half-support')
- *  @param[in] image_size (int) : Width of the image in pixels. NB we assume
- *              the pixel `[image_size//2,image_size//2]` corresponds to the origin
- *              in UV-space.
- *  @param[in] uv_lambda (arma::mat) : UV-coordinates of input visibilities.
- *  @param[in] vis (arma::cx_mat) : Complex visibilities. 1d array, shape: (n_vis).
- *  @param[in] vis_weights (arma::mat) : Visibility weights. 1d array, shape: (n_vis).
- *  @param[in] kernel_exact (bool) : Calculate exact kernel-values for every UV-sample.
- *  @param[in] oversampling (uint) : Controls kernel-generation if ``exact==False``.
-                Larger values give a finer-sampled set of pre-cached kernels.
- *  @param[in] shift_uv (bool) : Shift uv-coordinates before gridding (required when fftshift function is
- *              skipped before fft). Default is true.
- *  @param[in] halfplane_gridding (bool) : Grid only halfplane matrix. Used when halfplane c2r fft will be applied.
- *              Default is true.
- *  @param[in] w_proj (W_ProjectionPars) : W-projection configuration parameters.
- *  @param[in] w_lambda (arma::vec) : W-coordinate of input visibilities.
- *  @param[in] cell_size (double) : Angular-width of a synthesized pixel in the image to be created (arcsecond).
- *  @param[in] analytic_gcf (bool): Compute approximation of image-domain kernel from analytic expression. Default is true.
- *  @param[in] r_fft (FFTRoutine): Selects FFT routine. Default is FFTW_ESTIMATE_FFT.
- *  @param[in] a_proj (A_ProjectionPars) : A-projection configuration parameters.
+ *  Accumulate a weighted separable convolution kernel on the grid positions given by the column and row spans
+ *  (see intersect_footprint function). Each kernel value is formed on the fly as y_kernel[i] * x_kernel[j].
  *
- *  @return (GridderRes): stores vis_grid and sampling_grid, representing the visibility grid and the
- *                         sampling grid matrices. Includes also value with the total sampling grid sum.
+ *  @param[in,out] vis_grid (MatStp<cx_real_t>): Visibility grid.
+ *  @param[in,out] sampling_grid (MatStp<cx_real_t>): Sampling grid (only used when generateBeam is true).
+ *  @param[in] x_kernel (real_t*): 1D kernel along the columns (kernel_size values).
+ *  @param[in] y_kernel (real_t*): 1D kernel along the rows (kernel_size values).
+ *  @param[in] col_spans (TileSpan*): Kernel column spans.
+ *  @param[in] num_col_spans (int): Number of column spans.
+ *  @param[in] row_spans (TileSpan*): Kernel row spans.
+ *  @param[in] num_row_spans (int): Number of row spans.
+ *  @param[in] vis_val (cx_real_t): Visibility value.
+ *  @param[in] x_scale (real_t): Scale factor applied to the x kernel (visibility weight and kernel normalization).
  */
-template <bool generateBeam = true, typename T>
-GridderOutput convolve_to_grid(
-    const T& kernel_creator,
-    const uint support,
-    int image_size,
-    arma::mat uv_lambda,
-    arma::cx_mat vis,
-    arma::mat vis_weights,
-    bool kernel_exact = true,
-    uint oversampling = 1,
-    bool shift_uv = true,
-    bool halfplane_gridding = true,
-    const W_ProjectionPars& w_proj = W_ProjectionPars(),
-    arma::vec w_lambda = arma::vec(),
-    double cell_size = 0.0,
-    bool analytic_gcf = true,
-    FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT,
-    const A_ProjectionPars& a_proj = A_ProjectionPars())
+template <bool generateBeam>
+inline void grid_separable_kernel_spans(MatStp<cx_real_t>& vis_grid, MatStp<cx_real_t>& sampling_grid, const real_t* x_kernel, const real_t* y_kernel,
+    const TileSpan* col_spans, int num_col_spans, const TileSpan* row_spans, int num_row_spans, const cx_real_t vis_val, const real_t x_scale)
 {
-    bool use_wproj = w_proj.isEnabled();
-    bool use_aproj = a_proj.isEnabled();
-    real_t obsdec_rad = real_t(deg2rad(a_proj.obs_dec));
-    real_t obsra_rad = real_t(deg2rad(a_proj.obs_ra));
+    for (int cs = 0; cs < num_col_spans; ++cs) {
+        for (int j = col_spans[cs].kbegin; j < col_spans[cs].kend; ++j) {
+            const real_t x_kernel_val = x_kernel[j] * x_scale;
+            cx_real_t* vis_grid_col = vis_grid.colptr(uint(j + col_spans[cs].grid_offset));
+            cx_real_t* sampling_grid_col = nullptr;
+            if (generateBeam) {
+                sampling_grid_col = sampling_grid.colptr(uint(j + col_spans[cs].grid_offset));
+            }
 
-    // Half image size
-    const int half_image_size = int(image_size / 2);
-    // Set convolution kernel support for gridding
-    int conv_support = int(support);
+            for (int rs = 0; rs < num_row_spans; ++rs) {
+                const int row_offset = row_spans[rs].grid_offset;
+                for (int i = row_spans[rs].kbegin; i < row_spans[rs].kend; ++i) {
+                    const real_t kernel_val = y_kernel[i] * x_kernel_val;
+                    vis_grid_col[i + row_offset] += vis_val * kernel_val;
+                    if (generateBeam) {
+                        sampling_grid_col[i + row_offset] += kernel_val;
+                    }
+                }
+            }
+        }
+    }
+}
 
-    /* Some checks ***/
-    assert(uv_lambda.n_cols == 2);
-    assert(uv_lambda.n_rows == vis.n_rows);
+/** @brief grid_kernel_fixed function
+ *
+ *  Accumulate the weighted convolution kernel of a visibility whose footprint lies entirely inside the grid (no
+ *  wrapping nor clipping). The kernel size is a compile-time constant, so the loops are fully unrolled and branch-free.
+ *
+ *  @param[in,out] vis_grid (MatStp<cx_real_t>): Visibility grid.
+ *  @param[in,out] sampling_grid (MatStp<cx_real_t>): Sampling grid (only used when generateBeam is true).
+ *  @param[in] conv_kernel (cx_real_t*): Convolution kernel (KernelSize x KernelSize, column-major, see KernelBank).
+ *  @param[in] kernel_ld (size_t): Leading dimension of the convolution kernel.
+ *  @param[in] grid_col (int): Grid column of the first kernel column.
+ *  @param[in] grid_row (int): Grid row of the first kernel row.
+ *  @param[in] vis_val (cx_real_t): Visibility value.
+ *  @param[in] vis_weight (real_t): Visibility weight.
+ */
+template <int KernelSize, bool generateBeam>
+inline void grid_kernel_fixed(MatStp<cx_real_t>& vis_grid, MatStp<cx_real_t>& sampling_grid, const cx_real_t* conv_kernel, const size_t kernel_ld,
+    int grid_col, int grid_row, const cx_real_t vis_val, const real_t vis_weight)
+{
+    for (int j = 0; j < KernelSize; ++j) {
+        const cx_real_t* conv_kernel_col = conv_kernel + size_t(j) * kernel_ld;
+        cx_real_t* vis_grid_col = vis_grid.colptr(uint(grid_col + j)) + grid_row;
+        cx_real_t* sampling_grid_col = nullptr;
+        if (generateBeam) {
+            sampling_grid_col = sampling_grid.colptr(uint(grid_col + j)) + grid_row;
+        }
+
+        for (int i = 0; i < KernelSize; ++i) {
+            const cx_real_t kernel_val = conv_kernel_col[i] * vis_weight;
+            vis_grid_col[i] += vis_val * kernel_val;
+            if (generateBeam) {
+                sampling_grid_col[i] += kernel_val;
+            }
+        }
+    }
+}
+
+/** @brief grid_kernel_interior function
+ *
+ *  Dispatch an interior kernel footprint to the grid_kernel_fixed specialization of the given kernel size.
+ *  Specializations exist for the common kernel supports (1 to 8, 10, 12, 14 and 16). When SIMD_GRIDDER is defined,
+ *  only kernels up to SIMD_GRIDDER_MAX_UNROLLED_KERNEL_SIZE use the unrolled loops.
+ *
+ *  @return (bool): False if there is no specialization for this kernel size (the generic path must be used).
+ */
+template <bool generateBeam>
+inline bool grid_kernel_interior(int kernel_size, MatStp<cx_real_t>& vis_grid, MatStp<cx_real_t>& sampling_grid, const cx_real_t* conv_kernel, const size_t kernel_ld,
+    int grid_col, int grid_row, const cx_real_t vis_val, const real_t vis_weight)
+{
+#ifdef SIMD_GRIDDER
+    // Larger kernels are faster with the explicitly vectorized accumulate routines (see grid_kernel_spans)
+    if (kernel_size > SIMD_GRIDDER_MAX_UNROLLED_KERNEL_SIZE)
+        return false;
+#endif
+    switch (kernel_size) {
+    case 3:
+        grid_kernel_fixed<3, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 5:
+        grid_kernel_fixed<5, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 7:
+        grid_kernel_fixed<7, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 9:
+        grid_kernel_fixed<9, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 11:
+        grid_kernel_fixed<11, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 13:
+        grid_kernel_fixed<13, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 15:
+        grid_kernel_fixed<15, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 17:
+        grid_kernel_fixed<17, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 21:
+        grid_kernel_fixed<21, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 25:
+        grid_kernel_fixed<25, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 29:
+        grid_kernel_fixed<29, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    case 33:
+        grid_kernel_fixed<33, generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, grid_col, grid_row, vis_val, vis_weight);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief The GriddingGeometry class
+ *
+ * Stores the placement of a set of visibilities on the grid, which only depends on their UVW-coordinates and weights
+ * (see GridAccumulator::prepare): the visibility block (gridding order, half-plane conjugation flags, kernel centre
+ * positions, oversampled kernel offsets and weights of the visibilities inside the grid), W-planes and A-projection
+ * timesteps. Optionally, it also stores the AW-kernels generated for each W-plane and A-projection timestep, so that they are
+ * generated only once (W-kernels are stored by the GridAccumulator, as they only depend on its W-plane layout).
+ */
+class GriddingGeometry {
+public:
+    /**
+     * Number of input visibilities
+     */
+    arma::uword num_vis = 0;
+    /**
+     * Visibilities to be gridded (compacted, in gridding order)
+     */
+    VisibilityBlock vis_block;
+    /**
+     * Coalesced visibilities (empty if visibilities are not coalesced, see COALESCED_GRIDDER)
+     */
+    VisibilityGroups vis_groups;
+    /**
+     * Total sampling grid sum of the visibilities
+     */
+    double sample_grid_total = 0.0;
+    /**
+     * W-planes: average w value and index of the first visibility of each plane
+     */
+    uint num_wplanes = 1;
+    arma::Col<real_t> w_avg_values;
+    arma::uvec w_planes_firstidx;
+    /**
+     * A-projection timesteps: average local hour-angle of each timestep and timestep of each visibility
+     */
+    uint num_timesteps = 1;
+    arma::Col<real_t> lha_planes;
+    arma::ivec vis_timesteps;
+    /**
+     * Store the convolution kernels generated for each W-plane (and A-projection timestep) to be reused.
+     * Only AW-kernels are stored in the geometry, W-kernels are stored by the GridAccumulator.
+     */
+    bool cache_kernels = false;
+    std::vector<KernelBank> kernel_banks;
+    std::vector<int> kernel_supports;
+};
+
+/**
+ * @brief The GridAccumulator class
+ *
+ * Persistent visibility accumulator for streaming (chunked) gridding. It owns the visibility and sampling grids, as well
+ * as the kernel caches that do not depend on the visibilities (separable kernel cache, image-domain AA-kernel and
+ * W-kernel work area), so that chunks of visibilities of any size can be gridded incrementally. Peak memory is bounded
+ * by the grid size plus the chunk size. The W-plane layout is fixed by the first chunk (the first prepare call) and
+ * the W-kernels of the planes are kept by the accumulator, so all chunks are gridded with the same W-planes and kernels.
+ * A-projection timesteps are computed for each chunk.
+ * Adding all visibilities in a single chunk is equivalent to calling convolve_to_grid. Chunks give the same grids as a
+ * single call if the W-plane layout is first fixed by calling prepare with the coordinates of all visibilities.
+ */
+template <typename T, bool generateBeam = true>
+class GridAccumulator {
+public:
+    /**
+     * @brief GridAccumulator constructor. Allocates the grids and generates the kernel caches.
+     *
+     * See convolve_to_grid for the description of the parameters.
+     */
+    GridAccumulator(const T& kernel_creator, uint support, int image_size, bool kernel_exact = true, uint oversampling = 1, bool shift_uv = true,
+        bool halfplane_gridding = true, const W_ProjectionPars& w_proj = W_ProjectionPars(), double cell_size = 0.0, bool analytic_gcf = true,
+        FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT, const A_ProjectionPars& a_proj = A_ProjectionPars());
+
+    /**
+     * @brief Grid a chunk of visibilities.
+     *
+     * @param[in] uv_lambda (arma::mat) : UV-coordinates of the visibilities.
+     * @param[in] vis (arma::cx_mat) : Complex visibilities. 1d array, shape: (n_vis).
+     * @param[in] vis_weights (arma::mat) : Visibility weights. 1d array, shape: (n_vis).
+     * @param[in] w_lambda (arma::vec) : W-coordinate of the visibilities (used by W-projection).
+     * @param[in] lha (arma::mat) : Local hour-angle of the visibilities (used by A-projection).
+     */
+    void add(const arma::mat& uv_lambda, const arma::cx_mat& vis, const arma::mat& vis_weights, const arma::vec& w_lambda = arma::vec(),
+        const arma::mat& lha = arma::mat());
+
+    /**
+     * @brief Grid a chunk of visibilities given by non-owning views (no copies of the visibility data are made).
+     *
+     * @param[in] vis_data (VisibilityView) : Views of the UVW-coordinates, visibilities and weights.
+     * @param[in] uv_scale (double) : Scale factor that converts UV-coordinates to grid pixels. Default is 1.0.
+     * @param[in] lha (arma::mat) : Local hour-angle of the visibilities (used by A-projection).
+     */
+    void add(const VisibilityView& vis_data, double uv_scale = 1.0, const arma::mat& lha = arma::mat());
+
+    /**
+     * @brief Compute the gridding geometry of a chunk of visibilities (everything that does not depend on the visibility values).
+     *
+     * The first call fixes the W-plane layout (W value of each plane and w range of its visibilities), which is used by all
+     * later calls.
+     *
+     * @param[in] uv_lambda (arma::mat) : UV-coordinates of the visibilities.
+     * @param[in] vis_weights (arma::mat) : Visibility weights. 1d array, shape: (n_vis).
+     * @param[in] w_lambda (arma::vec) : W-coordinate of the visibilities (used by W-projection).
+     * @param[in] lha (arma::mat) : Local hour-angle of the visibilities (used by A-projection).
+     * @param[in] cache_kernels (bool) : Keep the W-kernels (or the AW-kernels in the geometry) when they are first generated.
+     *
+     * @return (GriddingGeometry): Gridding geometry of the visibilities.
+     */
+    GriddingGeometry prepare(const arma::mat& uv_lambda, const arma::mat& vis_weights, const arma::vec& w_lambda = arma::vec(),
+        const arma::mat& lha = arma::mat(), bool cache_kernels = false);
+
+    /**
+     * @brief Compute the gridding geometry of a chunk of visibilities given by non-owning views.
+     *
+     * The w-sort is computed as a permutation of the visibilities, and the input data is read through it (not copied).
+     * The placement of the visibilities is computed by a single parallel pass that fills the visibility block,
+     * from which visibilities that fall outside the grid are compacted away.
+     *
+     * @param[in] vis_data (VisibilityView) : Views of the UVW-coordinates and weights (visibilities are not used).
+     * @param[in] uv_scale (double) : Scale factor that converts UV-coordinates to grid pixels.
+     * @param[in] lha (arma::mat) : Local hour-angle of the visibilities (used by A-projection).
+     * @param[in] cache_kernels (bool) : Keep the W-kernels (or the AW-kernels in the geometry) when they are first generated.
+     *
+     * @return (GriddingGeometry): Gridding geometry of the visibilities.
+     */
+    GriddingGeometry prepare(const VisibilityView& vis_data, double uv_scale, const arma::mat& lha = arma::mat(), bool cache_kernels = false);
+
+    /**
+     * @brief Grid a chunk of visibilities whose geometry was computed by prepare.
+     *
+     * @param[in,out] geometry (GriddingGeometry) : Gridding geometry of the visibilities (stores the W-kernels if kernel caching is enabled).
+     * @param[in] vis (arma::cx_mat) : Complex visibilities, in the order given to prepare. 1d array, shape: (n_vis).
+     */
+    void add(GriddingGeometry& geometry, const arma::cx_mat& vis);
+
+    /**
+     * @brief Grid a chunk of visibilities (given by a non-owning view) whose geometry was computed by prepare.
+     *
+     * @param[in,out] geometry (GriddingGeometry) : Gridding geometry of the visibilities (stores the W-kernels if kernel caching is enabled).
+     * @param[in] vis (StridedView<std::complex<double>>) : Complex visibilities, in the order given to prepare.
+     */
+    void add(GriddingGeometry& geometry, const StridedView<std::complex<double>>& vis);
+
+    /**
+     * @brief Gather a chunk of visibilities whose geometry was computed by prepare into the geometry, in gridding order (see add_wplane).
+     *
+     * @param[in,out] geometry (GriddingGeometry) : Gridding geometry of the visibilities.
+     * @param[in] vis (StridedView<std::complex<double>>) : Complex visibilities, in the order given to prepare.
+     */
+    void load_visibilities(GriddingGeometry& geometry, const StridedView<std::complex<double>>& vis) const;
+
+    /**
+     * @brief Grid the visibilities of a single W-plane (W-stacking), which must have been loaded by load_visibilities.
+     *
+     * The visibility grid is cleared before gridding the W-plane, while the sampling grid accumulates all W-planes.
+     * The total sampling grid sum is not updated (it is given by the geometry).
+     *
+     * @param[in,out] geometry (GriddingGeometry) : Gridding geometry of the visibilities.
+     * @param[in] plane (uint) : Index of the W-plane.
+     *
+     * @return (arma::uword): Number of gridded entries (the visibility grid is empty if zero).
+     */
+    arma::uword add_wplane(GriddingGeometry& geometry, uint plane);
+
+    /**
+     * @brief Get the visibility grid (e.g. the grid of the last W-plane, see add_wplane). It may be transformed in place.
+     *
+     * @return (MatStp<cx_real_t>&): Visibility grid.
+     */
+    MatStp<cx_real_t>& get_vis_grid()
+    {
+        return vis_grid;
+    }
+
+    /**
+     * @brief Clear the grids (allocating new ones if they were handed off by finalize).
+     */
+    void reset();
+
+    /**
+     * @brief Hand off the accumulated grids (e.g. to the FFT stage). The accumulator cannot be used afterwards.
+     *
+     * @return (GridderOutput): stores vis_grid and sampling_grid, as well as the total sampling grid sum.
+     */
+    GridderOutput finalize();
+
+    /**
+     * @brief Get total sampling grid sum of the visibilities added so far.
+     *
+     * @return (double): Total sampling grid sum.
+     */
+    double get_sample_grid_total() const
+    {
+        return sample_grid_total;
+    }
+
+private:
+    /**
+     * @brief Grid the loaded visibilities of a range of W-planes.
+     *
+     * @param[in,out] geometry (GriddingGeometry) : Gridding geometry of the visibilities (stores the W-kernels if kernel caching is enabled).
+     * @param[in] plane_begin (uint) : Index of the first W-plane.
+     * @param[in] plane_end (uint) : Index of the last W-plane (not included).
+     */
+    void grid_wplanes(GriddingGeometry& geometry, uint plane_begin, uint plane_end);
+
+    T kernel_creator;
+    uint support;
+    int image_size;
+    int half_image_size;
+    int image_rows;
+    bool kernel_exact;
+    uint oversampling;
+    bool shift_uv;
+    bool halfplane_gridding;
+    W_ProjectionPars w_proj;
+    double cell_size;
+    bool analytic_gcf;
+    FFTRoutine r_fft;
+    A_ProjectionPars a_proj;
+    bool use_wproj;
+    bool use_wstack;
+    bool use_aproj;
+    real_t obsdec_rad;
+    real_t obsra_rad;
+    // Convolution kernel support for gridding (before W-kernel truncation)
+    int max_conv_support;
+
+    // Gridded images
+    MatStp<cx_real_t> vis_grid;
+    MatStp<cx_real_t> sampling_grid;
+    double sample_grid_total = 0.0;
+
+    // Separable kernel cache (one 1D kernel per oversampled offset), used when w-projection is disabled
+    arma::Mat<real_t> kernel1D_cache;
+    // Image-domain AA-kernel
+    arma::Col<real_t> aa_kernel_img;
 #ifdef WPROJECTION
-    if (use_wproj)
-        assert(w_lambda.n_rows == vis.n_rows);
-    else
-        w_lambda = arma::zeros<arma::vec>(vis.n_rows);
+    int workarea_size = 0;
+    WideFieldImaging wide_imaging;
+    // W-plane layout fixed by the first prepare call: W value of each plane and smallest |w| of the visibilities of each plane
+    bool wplanes_fixed = false;
+    uint fixed_num_wplanes = 1;
+    arma::Col<real_t> wplanes_w_values;
+    arma::vec wplanes_first_w;
+    // W-kernel banks and supports of each W-plane (shared by all chunks), used when kernel caching is enabled
+    std::vector<KernelBank> wkernel_banks;
+    std::vector<int> wkernel_supports;
+#endif
+#ifdef APROJECTION
+    arma::Mat<real_t> Akernel;
+    // A-kernels of the parallactic-angle bins, shared by all W-planes and calls (not used with the A-projection optimisation)
+    AKernelCache akernel_cache;
+    // AW-kernel banks and supports of each (W value, parallactic-angle bin), used when A_ProjectionPars::cache_awkernels is set
+    // and the parallactic angles are binned
+    std::map<std::pair<real_t, real_t>, std::pair<KernelBank, int>> awkernel_banks;
 #endif
+};
+
+template <typename T, bool generateBeam>
+GridAccumulator<T, generateBeam>::GridAccumulator(const T& _kernel_creator, uint _support, int _image_size, bool _kernel_exact, uint _oversampling,
+    bool _shift_uv, bool _halfplane_gridding, const W_ProjectionPars& _w_proj, double _cell_size, bool _analytic_gcf, FFTRoutine _r_fft,
+    const A_ProjectionPars& _a_proj)
+    : kernel_creator(_kernel_creator)
+    , support(_support)
+    , image_size(_image_size)
+    , half_image_size(_image_size / 2)
+    , kernel_exact(_kernel_exact)
+    , oversampling(_oversampling)
+    , shift_uv(_shift_uv)
+    , halfplane_gridding(_halfplane_gridding)
+    , w_proj(_w_proj)
+    , cell_size(_cell_size)
+    , analytic_gcf(_analytic_gcf)
+    , r_fft(_r_fft)
+    , a_proj(_a_proj)
+    , use_wproj(_w_proj.isEnabled() && !_w_proj.w_stacking)
+    , use_wstack(_w_proj.isEnabled() && _w_proj.w_stacking)
+    , use_aproj(_a_proj.isEnabled())
+    , obsdec_rad(real_t(deg2rad(_a_proj.obs_dec)))
+    , obsra_rad(real_t(deg2rad(_a_proj.obs_ra)))
+    , max_conv_support(int(_support))
+{
+    // Local hour-angles are given with each chunk of visibilities
+    a_proj.lha.reset();
+
+    /* Some checks ***/
     assert(kernel_exact || (oversampling >= 1));
     assert((image_size % 2) == 0);
-    assert(vis.n_elem == vis_weights.n_elem);
     if (use_aproj) {
         assert(!kernel_exact);
         assert(use_wproj);
@@ -288,11 +803,16 @@ GridderOutput convolve_to_grid(
 #ifdef WPROJECTION
     if (use_wproj || use_aproj) {
         use_wproj = true;
-        conv_support = int(w_proj.max_wpconv_support); // Set convolution kernel support for gridding
+        max_conv_support = int(w_proj.max_wpconv_support); // Set convolution kernel support for gridding
+        kernel_exact = false; // kernel exact must be false in this case
+    }
+    if (use_wstack) {
+        // W-stacking grids each w-plane on the full grid using the AA-kernel (the w-term is applied in the image domain)
+        assert(!halfplane_gridding);
         kernel_exact = false; // kernel exact must be false in this case
     }
 #endif
-    assert(conv_support > 0);
+    assert(max_conv_support > 0);
 
     if (kernel_exact == true) {
         oversampling = 1;
@@ -302,237 +822,520 @@ GridderOutput convolve_to_grid(
             oversampling = 1;
     }
 
-    arma::Col<uint> good_vis(arma::size(vis));
-    good_vis.ones(); // Init good_vis with ones
-    arma::Mat<int> kernel_centre_on_grid(arma::size(uv_lambda));
-    arma::mat uv_frac(arma::size(uv_lambda));
-    arma::vec slha;
+    // Number of rows of the output images. This changes if halfplane gridding is used
+    image_rows = int(image_size);
+    if (halfplane_gridding) {
+        image_rows = half_image_size + 1;
+    }
+
+    // Create matrices for output gridded images
+    reset();
 
+    if (kernel_exact == false) {
 #ifdef WPROJECTION
-    if (use_wproj) {
-        /** calculate wplanes and sort w coordinate
-         * by absolute value
-         */
-        // create auxiliary vector to keep track of original lambda data
-        // Abs w
-        arma::mat uv_aux(arma::size(uv_lambda));
-        arma::mat w_aux(arma::size(w_lambda));
-        arma::cx_mat vis_aux(arma::size(vis));
-        arma::mat vis_weights_aux(arma::size(vis_weights));
+        // aux vars
+        double scaling_factor = 1.0;
+        workarea_size = image_size;
+        STPLIB_DEBUG("stplib", "Gridder: Maximum workarea size (before undersampling opt) = {}", workarea_size);
 
-        /***** Sort by the module of w coordinate **/
-        arma::uvec sorted_idxs = arma::sort_index(arma::abs(w_lambda), "ascend");
+        if (use_wproj) {
+            const int kernel_size = max_conv_support * 2 + 1;
 
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted_idxs.n_elem), [&](const tbb::blocked_range<size_t>& r) {
-            size_t e = r.end();
-            for (size_t i = r.begin(); i < e; ++i) {
-                uv_aux.at(i, 0) = uv_lambda.at(sorted_idxs[i], 0);
-                uv_aux.at(i, 1) = uv_lambda.at(sorted_idxs[i], 1);
-            }
-        });
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted_idxs.n_elem), [&](const tbb::blocked_range<size_t>& r) {
-            size_t e = r.end();
-            for (size_t i = r.begin(); i < e; ++i) {
-                w_aux[i] = w_lambda[sorted_idxs[i]];
-            }
-        });
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted_idxs.n_elem), [&](const tbb::blocked_range<size_t>& r) {
-            size_t e = r.end();
-            for (size_t i = r.begin(); i < e; ++i) {
-                vis_aux[i] = vis[sorted_idxs[i]];
+            /*** Calculate kernel working area size */
+            int undersampling_opt = w_proj.undersampling_opt > 0 ? int(std::pow(2, w_proj.undersampling_opt - 1)) : 0;
+            if (undersampling_opt > 0) {
+                workarea_size = 2;
+                while ((workarea_size / undersampling_opt) < kernel_size) {
+                    workarea_size *= 2;
+                }
             }
-        });
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted_idxs.n_elem), [&](const tbb::blocked_range<size_t>& r) {
-            size_t e = r.end();
-            for (size_t i = r.begin(); i < e; ++i) {
-                vis_weights_aux[i] = vis_weights[sorted_idxs[i]];
+            else
+            {
+                // Undersampling optimisation is 0, set workarea size to the power of 2 above image_size
+                workarea_size = 2;
+                while (workarea_size < image_size) {
+                    workarea_size *= 2;
+                }
             }
-        });
+            // We need to use scaling factor for w-kernel computation, because the workarea size is different than the image size
+            scaling_factor = double(image_size) / double(workarea_size);
 
-        if (use_aproj) {
-            slha.set_size(arma::size(a_proj.lha));
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted_idxs.n_elem), [&](const tbb::blocked_range<size_t>& r) {
-                size_t e = r.end();
-                for (size_t i = r.begin(); i < e; ++i) {
-                    slha[i] = a_proj.lha[sorted_idxs[i]];
-                }
-            });
-        }
+            // Determine image-domain AA-kernel
+            aa_kernel_img = ImgDomKernel(kernel_creator, workarea_size, false, analytic_gcf, r_fft);
 
-        uv_lambda = std::move(uv_aux);
-        w_lambda = std::move(w_aux);
-        vis = std::move(vis_aux);
-        vis_weights = std::move(vis_weights_aux);
-    }
+            // Create W-kernel object
+            wide_imaging = WideFieldImaging(uint(workarea_size), arc_sec_to_rad(cell_size), oversampling, scaling_factor, w_proj, r_fft);
+
+            STPLIB_DEBUG("stplib", "Gridder: Workarea size = {}", workarea_size);
+        } else
 #endif
+        {
+            kernel1D_cache = populate_kernel_cache_1D(kernel_creator, support, oversampling, /*pad*/ false, /*normalize*/ true);
+        }
 
-    // If a visibility point is located in the top half-plane, move it to the bottom half-plane to a symmetric position with respect to the matrix centre (0,0)
-    if (halfplane_gridding) {
-        if (use_wproj)
-            convert_to_halfplane_visibilities(uv_lambda, w_lambda, vis, conv_support, good_vis);
-        else
-            convert_to_halfplane_visibilities(uv_lambda, vis, conv_support, good_vis);
+#ifdef APROJECTION
+        if (use_aproj) {
+            double fov = arc_sec_to_rad(cell_size) * double(image_size);
+            if (a_proj.aproj_opt) {
+                // The convolution kernel is rotated instead of the A-kernel, so the A-kernel cache is not used
+                Akernel = generate_a_kernel(a_proj, fov, workarea_size);
+            } else {
+                akernel_cache = AKernelCache(a_proj, fov, workarea_size);
+            }
+        }
+#endif
     }
+}
 
-    // get visibilities to be processed and uv_frac
-    for (size_t idx = 0; idx < kernel_centre_on_grid.n_rows; ++idx) {
-        int val = int(rint(uv_lambda.at(idx, 0)));
-        uv_frac(idx, 0) = uv_lambda.at(idx, 0) - val;
-        kernel_centre_on_grid(idx, 0) = val + half_image_size;
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::add(const arma::mat& uv_lambda, const arma::cx_mat& vis, const arma::mat& vis_weights, const arma::vec& w_lambda, const arma::mat& lha)
+{
+    assert(uv_lambda.n_cols == 2);
+    assert(vis.n_elem == vis_weights.n_elem);
 
-        val = int(rint(uv_lambda.at(idx, 1)));
-        uv_frac(idx, 1) = uv_lambda.at(idx, 1) - val;
-        kernel_centre_on_grid(idx, 1) = val + half_image_size;
-    }
-    bounds_check_kernel_centre_locations(good_vis, kernel_centre_on_grid, image_size, conv_support);
+    VisibilityView vis_data(StridedView<double>(uv_lambda, 0), StridedView<double>(uv_lambda, 1), StridedView<double>(w_lambda),
+        StridedView<std::complex<double>>(vis), StridedView<double>(vis_weights));
+    add(vis_data, 1.0, lha);
+}
 
-    STPLIB_DEBUG("stplib", "Gridder: Total # of vis = {}", vis.n_elem);
-    STPLIB_DEBUG("stplib", "Gridder: Total # of good vis = {}", arma::accu(good_vis != 0));
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::add(const VisibilityView& vis_data, double uv_scale, const arma::mat& lha)
+{
+    assert(vis_data.vis.size() == vis_data.size());
 
-    // Number of rows of the output images. This changes if halfplane gridding is used
-    int image_rows = int(image_size);
-    if (halfplane_gridding) {
-        image_rows = half_image_size + 1;
+    // The W-kernels are kept for the next chunks
+    GriddingGeometry geometry = prepare(vis_data, uv_scale, lha, true);
+    add(geometry, vis_data.vis);
+}
+
+template <typename T, bool generateBeam>
+GriddingGeometry GridAccumulator<T, generateBeam>::prepare(const arma::mat& uv_lambda, const arma::mat& vis_weights, const arma::vec& w_lambda,
+    const arma::mat& lha, bool cache_kernels)
+{
+    assert(uv_lambda.n_cols == 2);
+
+    VisibilityView vis_data(StridedView<double>(uv_lambda, 0), StridedView<double>(uv_lambda, 1), StridedView<double>(w_lambda),
+        StridedView<std::complex<double>>(), StridedView<double>(vis_weights));
+
+    return prepare(vis_data, 1.0, lha, cache_kernels);
+}
+
+template <typename T, bool generateBeam>
+GriddingGeometry GridAccumulator<T, generateBeam>::prepare(const VisibilityView& vis_data, double uv_scale, const arma::mat& lha, bool cache_kernels)
+{
+    // Set convolution kernel support for gridding
+    const int conv_support = max_conv_support;
+    const arma::uword n_vis = vis_data.size();
+
+    /* Some checks ***/
+    assert(vis_data.v.size() == n_vis);
+    assert(vis_data.weights.size() == n_vis);
+#ifdef WPROJECTION
+    if (use_wproj || use_wstack)
+        assert(vis_data.w.size() == n_vis);
+#endif
+
+    GriddingGeometry geometry;
+    geometry.cache_kernels = cache_kernels;
+    geometry.num_vis = n_vis;
+
+    // Gridding order of the visibilities (empty if visibilities are not reordered)
+    arma::uvec vis_order;
+#ifdef WPROJECTION
+    if (use_wproj || use_wstack) {
+        /***** Sort by the module of w coordinate **/
+        // Only the permutation is computed: the visibility data is read through it rather than being copied in sorted order
+        vis_order.set_size(n_vis);
+        for (arma::uword i = 0; i < n_vis; i++) {
+            vis_order[i] = i;
+        }
+        const StridedView<double>& w_view = vis_data.w;
+        tbb::parallel_sort(vis_order.memptr(), vis_order.memptr() + n_vis, [&](arma::uword a, arma::uword b) {
+            const double wa = std::abs(w_view[a]);
+            const double wb = std::abs(w_view[b]);
+            return (wa < wb) || (!(wb < wa) && (a < b));
+        });
     }
+#endif
 
-    // Shift positions of the visibilities (to avoid call to fftshift function)
-    if (shift_uv) {
-        int shift_offset = half_image_size;
-        kernel_centre_on_grid.each_row([&](arma::Mat<int>& r) {
-            if (r[0] < shift_offset) {
-                r[0] += shift_offset;
+    // Placement of a visibility on the grid
+    struct Placement {
+        int kc_x, kc_y;
+        double frac_x, frac_y;
+        double w;
+        bool conj;
+    };
+    // Compute the placement of input visibility idx: uv scaling, half-plane conversion, kernel centre and sub-pixel offset,
+    // bounds check and uv shift. Returns good_vis value (0 - skip, 1 - grid, 2 - grid also conjugate).
+    const int shift_offset = half_image_size;
+    auto place_vis = [&](arma::uword idx, Placement& p) -> uint {
+        // convert u,v to pixel
+        double u = vis_data.u[idx] * uv_scale;
+        double v = vis_data.v[idx] * uv_scale;
+        p.w = vis_data.w.is_empty() ? 0.0 : vis_data.w[idx];
+        p.conj = false;
+        uint good_vis_val = 1;
+
+        // If a visibility point is located in the top half-plane, move it to the bottom half-plane to a symmetric position with respect to the matrix centre (0,0)
+        // (see convert_to_halfplane_visibilities). The visibility is conjugated when gridded.
+        if (halfplane_gridding) {
+            if (v < 0.0) {
+                // If the visibity point is close to the 0-frequency (within kernel_support distance)
+                // also keep the visibility point in the top half-plane
+                if (v > -(conv_support + 1)) {
+                    good_vis_val = 2;
+                }
+                u *= (-1);
+                v *= (-1);
+                p.w *= (-1);
+                p.conj = true;
             } else {
-                r[0] -= shift_offset;
+                // If the visibity point in the bottom halfplane is close to the 0-frequency (within kernel_support distance)
+                // add the conjugate visibility point to the top half-plane
+                if (v < (conv_support + 1)) {
+                    good_vis_val = 2;
+                }
             }
-            if (r[1] < shift_offset) {
-                r[1] += shift_offset;
-            } else {
-                r[1] -= shift_offset;
+        }
+        // W-stacking: a visibility with negative w is moved to the symmetric position (-u,-v,-w) and conjugated,
+        // which leaves the real image unchanged, so that every w-plane has a single (non-negative) w value
+        if (use_wstack && (p.w < 0.0)) {
+            u *= (-1);
+            v *= (-1);
+            p.w *= (-1);
+            p.conj = true;
+        }
+
+        // get kernel centre and uv_frac
+        const int val_x = int(rint(u));
+        const int val_y = int(rint(v));
+        p.frac_x = u - val_x;
+        p.frac_y = v - val_y;
+        p.kc_x = val_x + half_image_size;
+        p.kc_y = val_y + half_image_size;
+        if (!kernel_centre_in_bounds(p.kc_x, p.kc_y, image_size, conv_support)) {
+            return 0;
+        }
+
+        // Shift positions of the visibilities (to avoid call to fftshift function)
+        if (shift_uv) {
+            p.kc_x += (p.kc_x < shift_offset) ? shift_offset : -shift_offset;
+            p.kc_y += (p.kc_y < shift_offset) ? shift_offset : -shift_offset;
+        }
+        return good_vis_val;
+    };
+
+    // Visibilities are processed in fixed-size chunks by two parallel passes: the first one counts the visibilities
+    // inside the grid, the second one writes them (compacted) into the visibility block at the offset of their chunk.
+    const arma::uword chunk_size = VISIBILITY_BLOCK_CHUNK_SIZE;
+    const size_t num_chunks = size_t((n_vis + chunk_size - 1) / chunk_size);
+    std::vector<arma::uword> chunk_offsets(num_chunks + 1, 0);
+    std::vector<double> chunk_weights(num_chunks, 0.0);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_chunks), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t c = r.begin(); c < r.end(); ++c) {
+            const arma::uword i_end = std::min(n_vis, arma::uword(c + 1) * chunk_size);
+            arma::uword count = 0;
+            Placement p;
+            for (arma::uword i = c * chunk_size; i < i_end; ++i) {
+                if (place_vis(vis_order.is_empty() ? i : vis_order[i], p) != 0)
+                    count++;
             }
-        });
+            chunk_offsets[c + 1] = count;
+        }
+    });
+    for (size_t c = 0; c < num_chunks; ++c) {
+        chunk_offsets[c + 1] += chunk_offsets[c];
     }
 
-    // Compute total sampling grid
+    VisibilityBlock& vis_block = geometry.vis_block;
+    vis_block = VisibilityBlock(chunk_offsets[num_chunks], kernel_exact, use_wproj || use_wstack, halfplane_gridding || use_wstack);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_chunks), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t c = r.begin(); c < r.end(); ++c) {
+            const arma::uword i_end = std::min(n_vis, arma::uword(c + 1) * chunk_size);
+            arma::uword k = chunk_offsets[c];
+            double weights_sum = 0.0;
+            Placement p;
+            for (arma::uword i = c * chunk_size; i < i_end; ++i) {
+                const arma::uword idx = vis_order.is_empty() ? i : vis_order[i];
+                const uint good_vis_val = place_vis(idx, p);
+                if (good_vis_val == 0)
+                    continue;
+
+                vis_block.source_idx[k] = idx;
+                vis_block.good_vis[k] = good_vis_val;
+                if (halfplane_gridding || use_wstack) {
+                    vis_block.vis_conj[k] = p.conj ? 1 : 0;
+                }
+                vis_block.kernel_centre_on_grid.at(k, 0) = p.kc_x;
+                vis_block.kernel_centre_on_grid.at(k, 1) = p.kc_y;
+                if (kernel_exact) {
+                    // The exact gridder evaluates the kernels at the sub-pixel offsets
+                    vis_block.uv_frac.at(k, 0) = p.frac_x;
+                    vis_block.uv_frac.at(k, 1) = p.frac_y;
+                } else {
+                    // get oversampled kernel indexes
+                    vis_block.oversampled_offset.at(k, 0) = oversampled_kernel_index(p.frac_x, oversampling) + int(oversampling / 2);
+                    vis_block.oversampled_offset.at(k, 1) = oversampled_kernel_index(p.frac_y, oversampling) + int(oversampling / 2);
+                }
+                if (use_wproj || use_wstack) {
+                    vis_block.w_lambda[k] = p.w;
+                }
+                const double weight = vis_data.weights[idx];
+                vis_block.vis_weights[k] = weight;
+                weights_sum += weight;
+                k++;
+            }
+            assert(k == chunk_offsets[c + 1]);
+            chunk_weights[c] = weights_sum;
+        }
+    });
+
+    STPLIB_DEBUG("stplib", "Gridder: Total # of vis = {}", n_vis);
+    STPLIB_DEBUG("stplib", "Gridder: Total # of good vis = {}", vis_block.size());
+
+    // Compute total sampling grid (sum of the chunk sums, in chunk order)
     // Used to renormalize the visibilities by the sampled weights total
     double sample_grid_total = 0;
-    for (arma::uword vi = 0; vi < good_vis.n_elem; vi++) {
-        if (good_vis[vi] != 0)
-            sample_grid_total += vis_weights[vi];
+    for (size_t c = 0; c < num_chunks; ++c) {
+        sample_grid_total += chunk_weights[c];
     }
     // Total sampling grid value must be doubled because we are using half gridder image
-    sample_grid_total *= 2.0;
-
-    // Create matrices for output gridded images
-    // Use MatStp class because these images shall be efficiently initialized with zeros
-    MatStp<cx_real_t> vis_grid((size_t(image_rows)), size_t(image_size));
-    int sampl_image_size = 0;
-    int sampl_image_rows = 0;
-    if (generateBeam) {
-        sampl_image_size = image_size;
-        sampl_image_rows = image_rows;
-    }
-
-    MatStp<cx_real_t> sampling_grid((size_t(sampl_image_rows)), size_t(sampl_image_size));
-    int kernel_size = conv_support * 2 + 1;
+    geometry.sample_grid_total = sample_grid_total * 2.0;
 
     if (kernel_exact == false) {
-        // kernel caches declaration
-        arma::field<arma::Mat<cx_real_t>> kernel_cache;
-        // kernel fft
-        arma::Col<real_t> aa_kernel_img;
-
 #ifdef WPROJECTION
-        // aux vars
-        double scaling_factor = 1.0;
-        int workarea_size = image_size;
-        STPLIB_DEBUG("stplib", "Gridder: Maximum workarea size (before undersampling opt) = {}", workarea_size);
-
-        // local data
-        arma::Col<real_t> w_avg_values; // vector of w_planes
-        arma::uvec w_planes_firstidx; // wplanes index tracking
-
-        // Compute W-Planes and convolution kernels for W-Projection
-        uint num_wplanes = 1;
-        if (use_wproj) {
-            num_wplanes = w_proj.num_wplanes;
+        // Compute W-Planes for W-Projection (or W-stacking)
+        if ((use_wproj || use_wstack) && wplanes_fixed) {
+            // The W-plane layout is fixed by the first chunk: each visibility goes to the plane whose w range contains its w
+            geometry.num_wplanes = fixed_num_wplanes;
+            geometry.w_avg_values = wplanes_w_values;
+            geometry.w_planes_firstidx.set_size(fixed_num_wplanes);
+            arma::uword k = 0;
+            for (uint pi = 0; pi < fixed_num_wplanes; pi++) {
+                while ((pi > 0) && (k < vis_block.size()) && (std::abs(vis_block.w_lambda[k]) < wplanes_first_w[pi])) {
+                    k++;
+                }
+                geometry.w_planes_firstidx(pi) = k;
+            }
+        } else if ((use_wproj || use_wstack) && (w_proj.wplanes_max_phase_error > 0.0)) {
+            // Error-driven planes: the fewest planes (up to num_wplanes) that keep the phase error of the w-term below the bound
+            const double max_w_error = max_w_plane_error(w_proj.wplanes_max_phase_error, cell_size, image_size);
+            double achieved_w_error = 0.0;
+            geometry.num_wplanes = adaptive_w_planes(arma::abs(vis_block.w_lambda), vis_block.good_vis, max_w_error, w_proj.num_wplanes,
+                geometry.w_avg_values, geometry.w_planes_firstidx, achieved_w_error);
+            // The phase error is proportional to the w error (the bound is relaxed when the planes do not fit in num_wplanes)
+            STPLIB_DEBUG("stplib", "Gridder: Number of adaptive W-planes = {}, max w error = {} (target {}), max phase error = {} rad (target {} rad)",
+                geometry.num_wplanes, achieved_w_error, max_w_error, w_proj.wplanes_max_phase_error * achieved_w_error / max_w_error,
+                w_proj.wplanes_max_phase_error);
+        } else if (use_wproj || use_wstack) {
+            geometry.num_wplanes = w_proj.num_wplanes;
 
             // create w plane array and idx tracker
-            w_avg_values.set_size(num_wplanes);
-            w_planes_firstidx.set_size(num_wplanes);
+            geometry.w_avg_values.set_size(geometry.num_wplanes);
+            geometry.w_planes_firstidx.set_size(geometry.num_wplanes);
 
             // calculate w_planes_avg
-            average_w_planes(arma::abs(w_lambda), good_vis, num_wplanes, w_avg_values, w_planes_firstidx, w_proj.wplanes_median);
+            average_w_planes(arma::abs(vis_block.w_lambda), vis_block.good_vis, geometry.num_wplanes, geometry.w_avg_values, geometry.w_planes_firstidx, w_proj.wplanes_median);
+        } else {
+            // Set some variables when w-projection is not used
+            geometry.num_wplanes = 1;
+            geometry.w_planes_firstidx.set_size(1);
+            geometry.w_planes_firstidx(0) = 0;
+        }
 
-            /*** Calculate kernel working area size */
-            int undersampling_opt = w_proj.undersampling_opt > 0 ? int(std::pow(2, w_proj.undersampling_opt - 1)) : 0;
-            if (undersampling_opt > 0) {
-                workarea_size = 2;
-                while ((workarea_size / undersampling_opt) < kernel_size) {
-                    workarea_size *= 2;
-                }
+        // Fix the W-plane layout of the first (non-empty) chunk for the next chunks
+        if ((use_wproj || use_wstack) && !wplanes_fixed && (vis_block.size() > 0)) {
+            fixed_num_wplanes = geometry.num_wplanes;
+            wplanes_w_values = geometry.w_avg_values;
+            wplanes_first_w.set_size(fixed_num_wplanes);
+            for (uint pi = 0; pi < fixed_num_wplanes; pi++) {
+                const arma::uword first = geometry.w_planes_firstidx(pi);
+                wplanes_first_w[pi] = (first < vis_block.size()) ? std::abs(vis_block.w_lambda[first]) : std::numeric_limits<double>::infinity();
             }
-            else
-            {
-                // Undersampling optimisation is 0, set workarea size to the power of 2 above image_size
-                workarea_size = 2;
-                while (workarea_size < image_size) {
-                    workarea_size *= 2;
-                }
+            wplanes_fixed = true;
+        }
+#endif
+
+#ifdef APROJECTION
+        geometry.vis_timesteps.set_size(vis_block.size());
+        if (use_aproj) {
+            // Local hour-angles in gridding order
+            arma::vec slha(vis_block.size());
+            for (arma::uword i = 0; i < vis_block.size(); i++) {
+                slha[i] = lha[vis_block.source_idx[i]];
             }
-            // We need to use scaling factor for w-kernel computation, because the workarea size is different than the image size
-            scaling_factor = double(image_size) / double(workarea_size);
+            geometry.num_timesteps = a_proj.num_timesteps;
+            average_lha_planes(slha, vis_block.good_vis, geometry.num_timesteps, geometry.lha_planes, geometry.vis_timesteps);
+        }
+#else
+        (void)lha; // Local hour-angles are only used by A-projection
+#endif
 
-            // Determine image-domain AA-kernel
-            aa_kernel_img = ImgDomKernel(kernel_creator, workarea_size, false, analytic_gcf, r_fft);
-        } else {
-            // Set some variables when w-projection is not used
-            num_wplanes = 1;
-            w_planes_firstidx.set_size(1);
-            w_planes_firstidx(0) = 0;
+#ifdef COALESCED_GRIDDER
+        // Group the visibilities that receive an identical convolution kernel, so that each group is gridded once
+        geometry.vis_groups = VisibilityGroups(vis_block, geometry.w_planes_firstidx, use_aproj ? geometry.vis_timesteps : arma::ivec());
+        STPLIB_DEBUG("stplib", "Gridder: Total # of coalesced vis = {}", geometry.vis_groups.block.size());
 #endif
-            kernel_cache = populate_kernel_cache(kernel_creator, support, oversampling, /*pad*/ false, /*normalize*/ true);
-#ifdef WPROJECTION
-        }
 
-        // Create W-kernel object
-        WideFieldImaging wide_imaging(uint(workarea_size), arc_sec_to_rad(cell_size), oversampling, scaling_factor, w_proj, r_fft);
+        TIMESTAMP_IMAGER
+    }
+
+    return geometry;
+}
+
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::add(GriddingGeometry& geometry, const arma::cx_mat& vis)
+{
+    add(geometry, StridedView<std::complex<double>>(vis));
+}
+
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::add(GriddingGeometry& geometry, const StridedView<std::complex<double>>& vis)
+{
+    load_visibilities(geometry, vis);
+    sample_grid_total += geometry.sample_grid_total;
+    grid_wplanes(geometry, 0, geometry.num_wplanes);
+}
+
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::load_visibilities(GriddingGeometry& geometry, const StridedView<std::complex<double>>& vis) const
+{
+    assert(vis.size() == geometry.num_vis);
+
+    // Gather the visibilities in gridding order (conjugated when moved to the bottom half-plane), so that the gridding loops read them contiguously
+    geometry.vis_block.load_visibilities(vis);
 
-        STPLIB_DEBUG("stplib", "Gridder: Workarea size = {}", workarea_size);
+    // When visibilities are coalesced, the gridding loops grid one entry per group of visibilities
+    if (!geometry.vis_groups.is_empty()) {
+        geometry.vis_groups.load_visibilities(geometry.vis_block);
+    }
+}
+
+template <typename T, bool generateBeam>
+arma::uword GridAccumulator<T, generateBeam>::add_wplane(GriddingGeometry& geometry, uint plane)
+{
+    assert(use_wstack);
+    assert(plane < geometry.num_wplanes);
+
+    // Only the visibility grid is cleared, the sampling grid accumulates all W-planes
+    vis_grid.zeros();
+
+    const bool coalesced = !geometry.vis_groups.is_empty();
+    const arma::uvec& w_planes_firstidx = coalesced ? geometry.vis_groups.plane_firstidx : geometry.w_planes_firstidx;
+    const arma::uword plane_end = (plane + 1 < geometry.num_wplanes) ? w_planes_firstidx(plane + 1) : (coalesced ? geometry.vis_groups.block.size() : geometry.vis_block.size());
+    const arma::uword plane_size = plane_end - w_planes_firstidx(plane);
+    if (plane_size > 0) {
+        grid_wplanes(geometry, plane, plane + 1);
+    }
+
+    return plane_size;
+}
+
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::grid_wplanes(GriddingGeometry& geometry, uint plane_begin, uint plane_end)
+{
+    // When visibilities are coalesced, the gridding loops grid one entry per group of visibilities
+    const bool coalesced = !geometry.vis_groups.is_empty();
+
+    // Geometry of the visibilities (see prepare)
+    const VisibilityBlock& grid_block = coalesced ? geometry.vis_groups.block : geometry.vis_block;
+    const arma::Col<uint>& good_vis = grid_block.good_vis;
+    const arma::Mat<int>& kernel_centre_on_grid = grid_block.kernel_centre_on_grid;
+    const arma::mat& uv_frac = grid_block.uv_frac;
+    const arma::vec& vis_weights = grid_block.vis_weights;
+#ifdef WPROJECTION
+    const arma::vec& w_lambda = grid_block.w_lambda;
+#else
+    // Without W-projection, all visibilities are gridded in a single plane
+    (void)plane_begin;
+    (void)plane_end;
 #endif
+    const arma::Col<cx_real_t>& sorted_vis = grid_block.vis;
 
-        // get oversampled kernel indexes
-        arma::Mat<int> oversampled_offset = calculate_oversampled_kernel_indices(uv_frac, oversampling) + (oversampling / 2);
+    // Set convolution kernel support for gridding
+    int conv_support = max_conv_support;
 
-#ifdef APROJECTION
-        arma::ivec vis_timesteps(arma::size(vis));
-        arma::Col<real_t> lha_planes;
-        arma::Mat<real_t> Akernel;
-        uint num_timesteps = 1;
-        if (use_aproj) {
-            num_timesteps = a_proj.num_timesteps;
-            average_lha_planes(slha, good_vis, num_timesteps, lha_planes, vis_timesteps);
+    int kernel_size = conv_support * 2 + 1;
 
-            if (a_proj.aproj_opt) {
-                double fov = arc_sec_to_rad(cell_size) * double(image_size);
-                Akernel = generate_a_kernel(a_proj, fov, workarea_size);
-            }
+    if (kernel_exact == false) {
+        // Kernel cache of the current W-plane
+        KernelBank kernel_cache;
+        const KernelBank* kernel_bank = &kernel_cache;
+        // Non-w-projection kernels are separable (see kernel1D_cache)
+        bool separable_kernel = true;
+
+        const arma::Mat<int>& oversampled_offset = grid_block.oversampled_offset;
+
+#ifdef WPROJECTION
+        // W-Planes for W-Projection
+        const arma::Col<real_t>& w_avg_values = geometry.w_avg_values;
+        const arma::uvec& w_planes_firstidx = coalesced ? geometry.vis_groups.plane_firstidx : geometry.w_planes_firstidx;
+        const uint num_wplanes = geometry.num_wplanes;
+        if (use_wproj) {
+            separable_kernel = false;
         }
 #endif
 
-        TIMESTAMP_IMAGER
+#ifdef APROJECTION
+        const arma::ivec& vis_timesteps = coalesced ? geometry.vis_groups.vis_timesteps : geometry.vis_timesteps;
+        const arma::Col<real_t>& lha_planes = geometry.lha_planes;
+        const uint num_timesteps = geometry.num_timesteps;
+#endif
+
+#ifdef WPROJECTION
+        // Convolution kernels of each W-plane (and A-projection timestep) are stored when kernel caching is enabled, and are
+        // reused (instead of being regenerated) by the next calls. W-kernels only depend on the W-plane layout, which is fixed
+        // by the first chunk, so they are stored by the accumulator. AW-kernels also depend on the timesteps of the geometry.
+        std::vector<KernelBank>& kernel_banks = use_aproj ? geometry.kernel_banks : wkernel_banks;
+        std::vector<int>& kernel_supports = use_aproj ? geometry.kernel_supports : wkernel_supports;
+        size_t num_kernels = num_wplanes;
+        bool cache_kernels = geometry.cache_kernels;
+#ifdef APROJECTION
+        num_kernels *= num_timesteps;
+        // AW-kernels kept by (W value, parallactic-angle bin) in awkernel_banks are not stored in the geometry. They are only kept
+        // when the angles are binned (the number of bins is bounded, while exact angles would grow awkernel_banks without bound)
+        const bool cache_awkernels = use_aproj && a_proj.cache_awkernels && !a_proj.aproj_opt && (a_proj.pangle_bin_size > 0.0);
+        cache_kernels = cache_kernels && !cache_awkernels;
+#endif
+        const bool kernels_cached = use_wproj && (kernel_banks.size() == num_kernels);
+        if (use_wproj && cache_kernels && !kernels_cached) {
+            kernel_banks.clear();
+            kernel_banks.resize(num_kernels);
+            kernel_supports.assign(num_kernels, 0);
+        }
+#endif
 
         // Init conv kernel generation time
         std::chrono::duration<double> convkernelgentimes(0);
 
+#ifdef WPROJECTION
+        if (use_wproj && !kernels_cached) {
+            // Start timestamp
+            auto start = std::chrono::high_resolution_clock::now();
+
+            // With the batched DHT method, the Hankel transforms of all W-planes are computed at once
+            arma::Col<real_t> batch_w_values(plane_end - plane_begin);
+            for (uint pi = plane_begin; pi < plane_end; pi++) {
+                batch_w_values(pi - plane_begin) = w_avg_values(pi);
+            }
+            wide_imaging.transform_hankel_batch(batch_w_values, aa_kernel_img);
+
+            // End timestamp
+            auto end = std::chrono::high_resolution_clock::now();
+            convkernelgentimes += (end-start);
+        }
+#endif
+
 #ifdef SERIAL_GRIDDER
 // Single-threaded implementation of oversampled gridder
 #ifdef WPROJECTION
-        for (int pi = 0; pi < num_wplanes; pi++) {
-            arma::field<arma::Mat<cx_real_t>> kernel_cache_conj;
+        for (int pi = int(plane_begin); pi < int(plane_end); pi++) {
             arma::uword vi_begin = w_planes_firstidx(pi);
             arma::uword vi_end = (pi == (num_wplanes - 1)) ? good_vis.n_elem : w_planes_firstidx(pi + 1);
 
-            if (use_wproj) {
+            if (use_wproj && !kernels_cached) {
                 // Start timestamp
                 auto start = std::chrono::high_resolution_clock::now();
 #ifdef APROJECTION
@@ -555,19 +1358,25 @@ GridderOutput convolve_to_grid(
 #endif
 #ifdef APROJECTION
             for (int ts = 0; ts < num_timesteps; ts++) {
-                if (use_aproj) {
+                // AW-kernel bank of this W-plane and parallactic-angle bin generated by a previous W-plane, time step or call
+                const std::pair<KernelBank, int>* aw_kernel = nullptr;
+                real_t pangle = 0.0;
+                if (use_aproj && !kernels_cached) {
                     // Start timestamp
                     auto start = std::chrono::high_resolution_clock::now();
 
                     // Generate the AW - kernels
-                    real_t pangle = parangle(lha_planes.at(ts), obsdec_rad, obsra_rad);
+                    pangle = quantize_parallactic_angle(parangle(lha_planes.at(ts), obsdec_rad, obsra_rad), deg2rad(a_proj.pangle_bin_size));
 
                     STPLIB_DEBUG("stplib", "Generate conv. kernel with parallatic angle: {} lha: {}", pangle, lha_planes.at(ts));
 
-                    double fov = arc_sec_to_rad(cell_size) * double(image_size);
-                    Akernel = generate_a_kernel(a_proj, fov, workarea_size, pangle);
-                    // Generate new convolution kernel for A-projection
-                    wide_imaging.generate_convolution_kernel_aproj(Akernel);
+                    auto aw_it = awkernel_banks.find(std::make_pair(w_avg_values(pi), pangle));
+                    if (aw_it != awkernel_banks.end()) {
+                        aw_kernel = &aw_it->second;
+                    } else {
+                        // Generate new convolution kernel for A-projection (the A-kernel of each angle bin is shared by all W-planes)
+                        wide_imaging.generate_convolution_kernel_aproj(akernel_cache.a_kernel(pangle));
+                    }
 
                     // End timestamp
                     auto end = std::chrono::high_resolution_clock::now();
@@ -579,15 +1388,41 @@ GridderOutput convolve_to_grid(
                     // Start timestamp
                     auto start = std::chrono::high_resolution_clock::now();
 
-                    kernel_cache = wide_imaging.generate_kernel_cache();
-                    conv_support = int(wide_imaging.get_trunc_conv_support());
+                    size_t kernel_idx = pi;
+#ifdef APROJECTION
+                    kernel_idx = pi * num_timesteps + ts;
+#endif
+                    if (kernels_cached) {
+                        kernel_bank = &kernel_banks[kernel_idx];
+                        conv_support = kernel_supports[kernel_idx];
+                    } else {
+#ifdef APROJECTION
+                        if (cache_awkernels && (aw_kernel == nullptr)) {
+                            KernelBank aw_bank = wide_imaging.generate_kernel_cache();
+                            const int aw_support = int(wide_imaging.get_trunc_conv_support());
+                            aw_kernel = &(awkernel_banks[std::make_pair(w_avg_values(pi), pangle)] = std::make_pair(std::move(aw_bank), aw_support));
+                        }
+                        if (aw_kernel != nullptr) {
+                            // The bank is kept in awkernel_banks
+                            kernel_bank = &aw_kernel->first;
+                            conv_support = aw_kernel->second;
+                        } else
+#endif
+                        {
+                            kernel_cache = wide_imaging.generate_kernel_cache();
+                            conv_support = int(wide_imaging.get_trunc_conv_support());
+                            kernel_bank = &kernel_cache;
+                            if (cache_kernels) {
+                                kernel_banks[kernel_idx] = std::move(kernel_cache);
+                                kernel_supports[kernel_idx] = conv_support;
+                                kernel_bank = &kernel_banks[kernel_idx];
+                            }
+                        }
+                    }
                     assert(conv_support > 0);
                     kernel_size = conv_support * 2 + 1;
                     STPLIB_DEBUG("stplib", "Gridder: W-plane {} = {}, Plane size = {}, Conv kernel support = {}, Conv kernel size = {}", pi, w_avg_values(pi), vi_end - vi_begin, conv_support, kernel_size);
 
-                    kernel_cache_conj.reset();
-                    kernel_cache_conj.set_size(arma::size(kernel_cache));
-
                     // End timestamp
                     auto end = std::chrono::high_resolution_clock::now();
                     convkernelgentimes += (end-start);
@@ -602,17 +1437,15 @@ GridderOutput convolve_to_grid(
                         if (vis_timesteps[vi] != ts)
                             continue;
 #endif
-                    if (good_vis_val == 0)
-                        continue;
 
                     int gc_x = kernel_centre_on_grid(vi, 0);
                     int gc_y = kernel_centre_on_grid(vi, 1);
                     int cp_x = oversampled_offset.at(vi, 0);
                     int cp_y = oversampled_offset.at(vi, 1);
-                    cx_real_t vis_val = cx_real_t(vis[vi]);
+                    cx_real_t vis_val = sorted_vis[vi];
                     const real_t vis_weight = vis_weights[vi];
 #ifdef WPROJECTION
-                    double w_lambda_val = w_lambda.at(vi);
+                    double w_lambda_val = use_wproj ? w_lambda.at(vi) : 0.0;
 #endif
 
                     // If good_vis[vi] is 2, add also conjugate visibility
@@ -631,49 +1464,32 @@ GridderOutput convolve_to_grid(
 #endif
                         }
 
-                        arma::Mat<cx_real_t>* conv_kernel_array = &(kernel_cache(cp_y, cp_x));
-#ifdef WPROJECTION
-                        if (use_wproj) {
-                            if (w_lambda_val < 0.0) {
-                                if (kernel_cache_conj(cp_y, cp_x).is_empty()) {
-                                    kernel_cache_conj(cp_y, cp_x) = std::move(arma::conj(kernel_cache(cp_y, cp_x)));
-                                }
-                                conv_kernel_array = &(kernel_cache_conj(cp_y, cp_x));
-                            }
-                        }
-#endif
-                        for (int j = 0; j < kernel_size; j++) {
-                            int grid_col = gc_x - conv_support + j;
-                            if (grid_col < 0) // left/right split of the kernel
-                                grid_col += image_size;
-                            if (grid_col >= image_size) // left/right split of the kernel
-                                grid_col -= image_size;
-
-                            // Use pointers here for faster access
-                            cx_real_t* conv_kernel_col = conv_kernel_array->colptr(j);
-                            cx_real_t* vis_grid_col = vis_grid.colptr(grid_col);
-                            cx_real_t* sampling_grid_col = NULL;
-                            if (generateBeam) {
-                                sampling_grid_col = sampling_grid.colptr(grid_col);
-                            }
+                        // Clip kernel footprint to the grid. Halfplane gridding: kernel points in the negative halfplane are excluded
+                        TileSpan col_spans[3];
+                        TileSpan row_spans[3];
+                        const int num_col_spans = intersect_footprint(gc_x - conv_support, kernel_size, 0, image_size, image_size, true, col_spans);
+                        const int num_row_spans = intersect_footprint(gc_y - conv_support, kernel_size, 0, image_rows, image_size, !halfplane_gridding, row_spans);
 
-                            int grid_row = gc_y - conv_support;
-                            for (int i = 0; i < kernel_size; ++i, ++grid_row) {
-                                if (grid_row < 0) // top/bottom split of the kernel. Halfplane gridding: kernel points in the negative halfplane are excluded
-                                    continue;
-                                if (grid_row >= image_size) // top/bottom split of the kernel. Halfplane gridding: kernel points touching the positive halfplane are used
-                                    grid_row -= image_size;
-                                // The following condition is needed for the case of halfplane gridding, because only the top halfplane visibilities are convolved
-                                if (grid_row < image_rows) {
-                                    cx_real_t kernel_val = conv_kernel_col[i] * vis_weight;
-                                    assert(arma::is_finite(kernel_val));
-                                    vis_grid_col[grid_row] += vis_val * kernel_val;
-                                    if (generateBeam) {
-                                        sampling_grid_col[grid_row] += kernel_val;
-                                    }
-                                }
-                            }
+                        if (separable_kernel) {
+                            // Separable kernel: 2D kernel values are formed on the fly from the 1D kernels of the nearest oversampled offsets
+                            grid_separable_kernel_spans<generateBeam>(vis_grid, sampling_grid, kernel1D_cache.colptr(uint(cp_x)), kernel1D_cache.colptr(uint(cp_y)),
+                                col_spans, num_col_spans, row_spans, num_row_spans, vis_val, vis_weight);
+                            continue;
                         }
+
+                        // Visibilities with negative w use the conjugate kernels of the bank
+#ifdef WPROJECTION
+                        const bool conj_kernel = use_wproj && (w_lambda_val < 0.0);
+#else
+                        const bool conj_kernel = false;
+#endif
+                        const cx_real_t* conv_kernel = kernel_bank->kernel(size_t(cp_y), size_t(cp_x), conj_kernel);
+                        const size_t kernel_ld = kernel_bank->kernel_ld();
+                        // Footprints lying entirely inside the grid use the unrolled kernels (if available for this kernel size)
+                        const bool interior = (num_col_spans == 1) && (num_row_spans == 1) && (col_spans[0].kend - col_spans[0].kbegin == kernel_size)
+                            && (row_spans[0].kend - row_spans[0].kbegin == kernel_size);
+                        if (!interior || !grid_kernel_interior<generateBeam>(kernel_size, vis_grid, sampling_grid, conv_kernel, kernel_ld, col_spans[0].grid_offset, row_spans[0].grid_offset, vis_val, vis_weight))
+                            grid_kernel_spans<generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, col_spans, num_col_spans, row_spans, num_row_spans, vis_val, vis_weight);
                     }
                 }
 #ifdef APROJECTION
@@ -684,119 +1500,188 @@ GridderOutput convolve_to_grid(
         times_gridder.push_back(convkernelgentimes);
 #endif
 #else
-        // Multi-threaded implementation of oversampled gridder (20-25% faster)
+        // Multi-threaded implementation of oversampled gridder: the grid is split into tiles and each task grids one tile
+        // Kernel points on negative rows are wrapped only when the full grid is used
+        GridTiles grid_tiles(image_size, image_rows, GRIDDER_TILE_SIZE, !halfplane_gridding);
 #ifdef WPROJECTION
-        for (uint pi = 0; pi < num_wplanes; pi++) {
-            arma::uword vi_begin = w_planes_firstidx(pi);
-            arma::uword vi_end = (pi == (num_wplanes - 1)) ? good_vis.n_elem : w_planes_firstidx(pi + 1);
-
-            if (use_wproj) {
-                // Start timestamp
-                auto start = std::chrono::high_resolution_clock::now();
+        // Convolution kernels are generated by a two-stage pipeline: the kernel of the next W-plane (and A-projection timestep)
+        // is generated by a separate task while the current one is gridded. Kernels are generated in order (the generation
+        // updates the state of wide_imaging) into two kernel buffers, which are used alternately.
+        uint num_ts = 1;
+#ifdef APROJECTION
+        num_ts = num_timesteps;
+#endif
+        const size_t num_items = size_t(plane_end - plane_begin) * num_ts;
+        KernelBank kernel_buffers[2];
+        const KernelBank* item_kernel_bank[2] = { &kernel_buffers[0], &kernel_buffers[1] };
+        int item_conv_support[2] = { conv_support, conv_support };
+
+        // W-plane of the image-domain kernel (or convolution kernel) currently held by wide_imaging
+        uint kernel_plane = plane_end;
+        auto generate_kernel = [&](size_t item) {
+            if (!use_wproj)
+                return;
+
+            const uint pi = plane_begin + uint(item / num_ts);
+            const size_t slot = item % 2;
+            // Start timestamp
+            auto start = std::chrono::high_resolution_clock::now();
+
+            size_t kernel_idx = pi;
+#ifdef APROJECTION
+            const uint ts = uint(item % num_ts);
+            kernel_idx = pi * num_timesteps + ts;
+#endif
+            if (kernels_cached) {
+                item_kernel_bank[slot] = &kernel_banks[kernel_idx];
+                item_conv_support[slot] = kernel_supports[kernel_idx];
+            } else {
+                // AW-kernel bank of this W-plane and parallactic-angle bin generated by a previous W-plane, time step or call
+                const std::pair<KernelBank, int>* aw_kernel = nullptr;
 #ifdef APROJECTION
+                real_t pangle = 0.0;
                 if (use_aproj) {
-                    // Generate new AA/W-kernel for A-projection
-                    if (a_proj.aproj_opt) {
-                        wide_imaging.generate_image_domain_convolution_kernel(w_avg_values(pi), aa_kernel_img);
-                        // Generate convolution kernel for A-projection (it will be rotated afterwards)
-                        wide_imaging.generate_convolution_kernel_aproj(Akernel);
-                    } else {
-                        wide_imaging.generate_image_domain_convolution_kernel(w_avg_values(pi), aa_kernel_img);
+                    pangle = quantize_parallactic_angle(parangle(lha_planes.at(ts), obsdec_rad, obsra_rad), deg2rad(a_proj.pangle_bin_size));
+                    if (cache_awkernels) {
+                        auto aw_it = awkernel_banks.find(std::make_pair(w_avg_values(pi), pangle));
+                        if (aw_it != awkernel_banks.end()) {
+                            aw_kernel = &aw_it->second;
+                        }
+                    }
+                }
+#endif
+                if (aw_kernel == nullptr) {
+                    // The image-domain kernel is generated once per W-plane (and only when a kernel of the plane is generated)
+                    if (kernel_plane != pi) {
+#ifdef APROJECTION
+                        if (use_aproj) {
+                            // Generate new AA/W-kernel for A-projection
+                            if (a_proj.aproj_opt) {
+                                wide_imaging.generate_image_domain_convolution_kernel(w_avg_values(pi), aa_kernel_img);
+                                // Generate convolution kernel for A-projection (it will be rotated afterwards)
+                                wide_imaging.generate_convolution_kernel_aproj(Akernel);
+                            } else {
+                                wide_imaging.generate_image_domain_convolution_kernel(w_avg_values(pi), aa_kernel_img);
+                            }
+                        } else
+#endif
+                        {
+                            // Generate new convolution kernel for W-projection
+                            wide_imaging.generate_convolution_kernel_wproj(w_avg_values(pi), aa_kernel_img, w_proj.hankel_proj_slice);
+                        }
+                        kernel_plane = pi;
+                    }
+
+#ifdef APROJECTION
+                    if (use_aproj) {
+                        // Generate the AW - kernels
+                        STPLIB_DEBUG("stplib", "Generate conv. kernel with parallatic angle: {} lha: {}", pangle, lha_planes.at(ts));
+
+                        if (a_proj.aproj_opt) {
+                            // TODO: remove shifts and review rotate_matrix function
+                            fftshift(wide_imaging.conv_kernel);
+                            cx_real_t pbmin = wide_imaging.conv_kernel(0, 0);
+                            wide_imaging.conv_kernel = rotate_matrix(wide_imaging.conv_kernel, pangle, pbmin, wide_imaging.conv_kernel.n_cols);
+                            fftshift(wide_imaging.conv_kernel);
+                        } else {
+                            // Generate new convolution kernel for A-projection (the A-kernel of each angle bin is shared by all W-planes)
+                            wide_imaging.generate_convolution_kernel_aproj(akernel_cache.a_kernel(pangle));
+                        }
+                    }
+#endif
+                    kernel_buffers[slot] = wide_imaging.generate_kernel_cache();
+                    item_kernel_bank[slot] = &kernel_buffers[slot];
+                    item_conv_support[slot] = int(wide_imaging.get_trunc_conv_support());
+#ifdef APROJECTION
+                    if (cache_awkernels) {
+                        aw_kernel = &(awkernel_banks[std::make_pair(w_avg_values(pi), pangle)] = std::make_pair(std::move(kernel_buffers[slot]), item_conv_support[slot]));
                     }
-                } else
 #endif
-                {
-                    // Generate new convolution kernel for W-projection
-                    wide_imaging.generate_convolution_kernel_wproj(w_avg_values(pi), aa_kernel_img, w_proj.hankel_proj_slice);
                 }
 
-                // End timestamp
-                auto end = std::chrono::high_resolution_clock::now();
-                convkernelgentimes += (end-start);
+                if (aw_kernel != nullptr) {
+                    // The bank is kept in awkernel_banks
+                    item_kernel_bank[slot] = &aw_kernel->first;
+                    item_conv_support[slot] = aw_kernel->second;
+                } else if (cache_kernels) {
+                    kernel_banks[kernel_idx] = std::move(kernel_buffers[slot]);
+                    kernel_supports[kernel_idx] = item_conv_support[slot];
+                    item_kernel_bank[slot] = &kernel_banks[kernel_idx];
+                }
             }
+            assert(item_conv_support[slot] > 0);
+            STPLIB_DEBUG("stplib", "Gridder: W-plane {} = {}, Conv kernel support = {}, Conv kernel size = {}", pi, w_avg_values(pi), item_conv_support[slot], item_conv_support[slot] * 2 + 1);
+
+            // End timestamp
+            auto end = std::chrono::high_resolution_clock::now();
+            convkernelgentimes += (end-start);
+        };
+
+        tbb::task_group kernel_generation;
+        if (num_items > 0) {
+            generate_kernel(0);
+        }
+
+        for (uint pi = plane_begin; pi < plane_end; pi++) {
+            arma::uword vi_begin = w_planes_firstidx(pi);
+            arma::uword vi_end = (pi == (num_wplanes - 1)) ? good_vis.n_elem : w_planes_firstidx(pi + 1);
 #else
         arma::uword vi_begin = 0;
         arma::uword vi_end = good_vis.n_elem;
 #endif
 #ifdef APROJECTION
             for (uint ts = 0; ts < num_timesteps; ts++) {
-                if (use_aproj) {
-                    // Start timestamp
-                    auto start = std::chrono::high_resolution_clock::now();
-
-                    // Generate the AW - kernels
-                    real_t pangle = parangle(lha_planes.at(ts), obsdec_rad, obsra_rad);
-
-                    STPLIB_DEBUG("stplib", "Generate conv. kernel with parallatic angle: {} lha: {}", pangle, lha_planes.at(ts));
-
-                    if (a_proj.aproj_opt) {
-                        // TODO: remove shifts and review rotate_matrix function
-                        fftshift(wide_imaging.conv_kernel);
-                        cx_real_t pbmin = wide_imaging.conv_kernel(0, 0);
-                        wide_imaging.conv_kernel = rotate_matrix(wide_imaging.conv_kernel, pangle, pbmin, wide_imaging.conv_kernel.n_cols);
-                        fftshift(wide_imaging.conv_kernel);
-                    } else {
-                        double fov = arc_sec_to_rad(cell_size) * double(image_size);
-                        Akernel = generate_a_kernel(a_proj, fov, workarea_size, pangle);
-                        // Generate new convolution kernel for A-projection
-                        wide_imaging.generate_convolution_kernel_aproj(Akernel);
-                    }
-
-                    // End timestamp
-                    auto end = std::chrono::high_resolution_clock::now();
-                    convkernelgentimes += (end-start);
-                }
 #endif
 #ifdef WPROJECTION
+                // Wait for the kernel of this W-plane (and timestep), then start the generation of the next one
+                size_t item = size_t(pi - plane_begin) * num_ts;
+#ifdef APROJECTION
+                item += ts;
+#endif
+                kernel_generation.wait();
+                if (item + 1 < num_items) {
+                    kernel_generation.run([&generate_kernel, item] { generate_kernel(item + 1); });
+                }
                 if (use_wproj) {
-                    // Start timestamp
-                    auto start = std::chrono::high_resolution_clock::now();
-
-                    kernel_cache = wide_imaging.generate_kernel_cache();
-                    conv_support = int(wide_imaging.get_trunc_conv_support());
-                    assert(conv_support > 0);
+                    kernel_bank = item_kernel_bank[item % 2];
+                    conv_support = item_conv_support[item % 2];
                     kernel_size = conv_support * 2 + 1;
-                    STPLIB_DEBUG("stplib", "Gridder: W-plane {} = {}, Plane size = {}, Conv kernel support = {}, Conv kernel size = {}", pi, w_avg_values(pi), vi_end - vi_begin, conv_support, kernel_size);
-
-                    // End timestamp
-                    auto end = std::chrono::high_resolution_clock::now();
-                    convkernelgentimes += (end-start);
                 }
 #endif
 
-                tbb::parallel_for(tbb::blocked_range<int>(0, kernel_size, 1), [&](const tbb::blocked_range<int>& r) {
-                    for (arma::uword vi = vi_begin; vi < vi_end; vi++) {
-                        const uint good_vis_val = good_vis[vi];
-
+                // Bucket visibilities by grid tile, so that each task owns a tile and accumulates on it without contention
 #ifdef APROJECTION
-                        // Skip this visibility if using A-projection and it does not belong to the time interval
-                        if (use_aproj)
-                            if (vis_timesteps[vi] != ts)
-                                continue;
+                if (use_aproj)
+                    grid_tiles.bin(kernel_centre_on_grid, good_vis, vi_begin, vi_end, conv_support, vis_timesteps, int(ts));
+                else
 #endif
-                        if (good_vis_val == 0) {
-                            continue;
-                        }
-
-                        int gc_x = kernel_centre_on_grid(vi, 0);
-                        int gc_y = kernel_centre_on_grid(vi, 1);
-                        int cp_x = oversampled_offset.at(vi, 0);
-                        int cp_y = oversampled_offset.at(vi, 1);
-                        cx_real_t vis_val = cx_real_t(vis[vi]);
-                        const real_t vis_weight = real_t(vis_weights[vi]);
+                    grid_tiles.bin(kernel_centre_on_grid, good_vis, vi_begin, vi_end, conv_support);
+
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, grid_tiles.num_tiles()), [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t tile = r.begin(); tile != r.end(); ++tile) {
+                        int row_begin, row_end, col_begin, col_end;
+                        grid_tiles.tile_range(tile, row_begin, row_end, col_begin, col_end);
+
+                        for (size_t e = grid_tiles.tile_begin(tile); e < grid_tiles.tile_end(tile); ++e) {
+                            const arma::uword entry = grid_tiles.entries[e];
+                            const arma::uword vi = GridTiles::entry_vis(entry);
+
+                            int gc_x = kernel_centre_on_grid(vi, 0);
+                            int gc_y = kernel_centre_on_grid(vi, 1);
+                            int cp_x = oversampled_offset.at(vi, 0);
+                            int cp_y = oversampled_offset.at(vi, 1);
+                            cx_real_t vis_val = sorted_vis[vi];
+                            const real_t vis_weight = real_t(vis_weights[vi]);
 #ifdef WPROJECTION
-                        double w_lambda_val = w_lambda.at(vi);
+                            double w_lambda_val = use_wproj ? w_lambda.at(vi) : 0.0;
 #endif
-
-                        // If good_vis[vi] is 2, add also conjugate visibility
-                        for (uint gv = 0; gv < good_vis_val; gv++) {
-
-                            if (gv) {
-                                gc_x = -kernel_centre_on_grid(vi, 0) + image_size;
-                                gc_y = -kernel_centre_on_grid(vi, 1) + image_size;
+                            // Conjugate visibility (only added when good_vis[vi] is 2)
+                            if (GridTiles::entry_conj(entry)) {
+                                gc_x = -gc_x + image_size;
+                                gc_y = -gc_y + image_size;
                                 if (oversampling > 1) {
-                                    cp_x = -oversampled_offset.at(vi, 0) + int(oversampling);
-                                    cp_y = -oversampled_offset.at(vi, 1) + int(oversampling);
+                                    cp_x = -cp_x + int(oversampling);
+                                    cp_y = -cp_y + int(oversampling);
                                 }
                                 vis_val = std::conj(vis_val);
 #ifdef WPROJECTION
@@ -804,134 +1689,55 @@ GridderOutput convolve_to_grid(
 #endif
                             }
 
-                            int rbegin = r.begin();
-                            int conv_col = ((gc_x - rbegin + kernel_size) % kernel_size);
-                            if (conv_col > conv_support)
-                                conv_col -= kernel_size;
-                            int grid_col = (gc_x - conv_col);
-
-                            if ((grid_col < image_size) && (grid_col >= 0)) {
-
-                                assert(std::abs(conv_col) <= conv_support);
-                                assert(arma::uword(grid_col % kernel_size) == rbegin);
+                            // Clip kernel footprint to the tile. Halfplane gridding: kernel points in the negative halfplane are excluded
+                            TileSpan col_spans[3];
+                            TileSpan row_spans[3];
+                            const int num_col_spans = intersect_footprint(gc_x - conv_support, kernel_size, col_begin, col_end, image_size, true, col_spans);
+                            const int num_row_spans = intersect_footprint(gc_y - conv_support, kernel_size, row_begin, row_end, image_size, !halfplane_gridding, row_spans);
 
-                                // Use pointer image_rows here for faster access
-                                cx_real_t* conv_kernel_array = kernel_cache(size_t(cp_y), size_t(cp_x)).colptr(uint(conv_support - conv_col));
-                                cx_real_t* vis_grid_col = vis_grid.colptr(uint(grid_col));
-                                cx_real_t* sampling_grid_col = nullptr;
-                                if (generateBeam) {
-                                    sampling_grid_col = sampling_grid.colptr(uint(grid_col));
-                                }
-
-#ifdef WPROJECTION
-                                if (use_wproj && (w_lambda_val < 0.0)) {
-                                    // Pick the pre-generated kernel corresponding to the sub-pixel offset nearest to that of the visibility.
-                                    int grid_row = gc_y - conv_support;
-                                    for (int i = 0; i < kernel_size; ++i, ++grid_row) {
-                                        if (grid_row < 0)
-                                            continue;
-                                        if (grid_row >= image_size)
-                                            grid_row -= image_size;
-                                        if (grid_row < image_rows) {
-                                            const cx_real_t kernel_val = std::conj(conv_kernel_array[i]) * vis_weight;
-                                            vis_grid_col[grid_row] += vis_val * kernel_val;
-                                            if (generateBeam) {
-                                                sampling_grid_col[grid_row] += kernel_val;
-                                            }
-                                        }
-                                    }
-                                } else
-#endif
-                                {
-                                    // Pick the pre-generated kernel corresponding to the sub-pixel offset nearest to that of the visibility.
-                                    int grid_row = gc_y - conv_support;
-                                    for (int i = 0; i < kernel_size; ++i, ++grid_row) {
-                                        if (grid_row < 0)
-                                            continue;
-                                        if (grid_row >= image_size)
-                                            grid_row -= image_size;
-                                        if (grid_row < image_rows) {
-                                            const cx_real_t kernel_val = conv_kernel_array[i] * vis_weight;
-                                            vis_grid_col[grid_row] += vis_val * kernel_val;
-                                            if (generateBeam) {
-                                                sampling_grid_col[grid_row] += kernel_val;
-                                            }
-                                        }
-                                    }
-                                }
+                            // Separable kernel: 2D kernel values are formed on the fly from the 1D kernels of the nearest oversampled offsets
+                            if (separable_kernel) {
+                                grid_separable_kernel_spans<generateBeam>(vis_grid, sampling_grid, kernel1D_cache.colptr(uint(cp_x)), kernel1D_cache.colptr(uint(cp_y)),
+                                    col_spans, num_col_spans, row_spans, num_row_spans, vis_val, vis_weight);
+                                continue;
                             }
 
-                            // This is for the cases when the kernel is split between the left and right margins
-                            if ((gc_x >= (image_size - conv_support)) || (gc_x < conv_support)) {
-                                if (gc_x >= (image_size - conv_support)) {
-                                    gc_x -= image_size;
-                                    conv_col = ((gc_x - rbegin + kernel_size * 2) % kernel_size);
-                                    if (conv_col > conv_support)
-                                        conv_col -= kernel_size;
-                                    grid_col = (gc_x - conv_col);
-                                    assert(std::abs(conv_col) <= conv_support);
-                                } else {
-                                    assert(gc_x < conv_support);
-                                    gc_x += image_size;
-                                    conv_col = ((gc_x - rbegin + kernel_size) % kernel_size);
-                                    if (conv_col > conv_support)
-                                        conv_col -= kernel_size;
-                                    grid_col = (gc_x - conv_col);
-                                    assert(std::abs(conv_col) <= conv_support);
-                                }
-
-                                if ((grid_col < image_size) && (grid_col >= 0)) {
-
-                                    // Use pointers here for faster access
-                                    cx_real_t* conv_kernel_array = kernel_cache(size_t(cp_y), size_t(cp_x)).colptr(uint(conv_support - conv_col));
-                                    cx_real_t* vis_grid_col = vis_grid.colptr(uint(grid_col));
-                                    cx_real_t* sampling_grid_col = nullptr;
-                                    if (generateBeam) {
-                                        sampling_grid_col = sampling_grid.colptr(uint(grid_col));
-                                    }
-
+                            // Pick the pre-generated kernel corresponding to the sub-pixel offset nearest to that of the visibility
+                            // (visibilities with negative w use the conjugate kernels of the bank).
 #ifdef WPROJECTION
-                                    if (use_wproj && (w_lambda_val < 0.0)) {
-                                        // Pick the pre-generated kernel corresponding to the sub-pixel offset nearest to that of the visibility.
-                                        int grid_row = gc_y - conv_support;
-                                        for (int i = 0; i < kernel_size; ++i, ++grid_row) {
-                                            if (grid_row < 0)
-                                                continue;
-                                            if (grid_row >= image_size)
-                                                grid_row -= image_size;
-                                            if (grid_row < image_rows) {
-                                                const cx_real_t kernel_val = std::conj(conv_kernel_array[i]) * vis_weight;
-                                                vis_grid_col[grid_row] += vis_val * kernel_val;
-                                                if (generateBeam) {
-                                                    sampling_grid_col[grid_row] += kernel_val;
-                                                }
-                                            }
-                                        }
-                                    } else
-#endif
-                                    {
-                                        // Pick the pre-generated kernel corresponding to the sub-pixel offset nearest to that of the visibility.
-                                        int grid_row = gc_y - conv_support;
-                                        for (int i = 0; i < kernel_size; ++i, ++grid_row) {
-                                            if (grid_row < 0)
-                                                continue;
-                                            if (grid_row >= image_size)
-                                                grid_row -= image_size;
-                                            if (grid_row < image_rows) {
-                                                const cx_real_t kernel_val = conv_kernel_array[i] * vis_weight;
-                                                vis_grid_col[grid_row] += vis_val * kernel_val;
-                                                if (generateBeam) {
-                                                    sampling_grid_col[grid_row] += kernel_val;
-                                                }
-                                            }
-                                        }
-                                    }
+                            const bool conj_kernel = use_wproj && (w_lambda_val < 0.0);
+#else
+                            const bool conj_kernel = false;
+#endif
+                            const cx_real_t* conv_kernel = kernel_bank->kernel(size_t(cp_y), size_t(cp_x), conj_kernel);
+                            const size_t kernel_ld = kernel_bank->kernel_ld();
+
+                            // Prefetch the kernel of the next visibility of this tile while the current one is accumulated
+                            if (e + 1 < grid_tiles.tile_end(tile)) {
+                                const arma::uword next_entry = grid_tiles.entries[e + 1];
+                                const arma::uword next_vi = GridTiles::entry_vis(next_entry);
+                                int next_cp_x = oversampled_offset.at(next_vi, 0);
+                                int next_cp_y = oversampled_offset.at(next_vi, 1);
+                                if (GridTiles::entry_conj(next_entry) && (oversampling > 1)) {
+                                    next_cp_x = -next_cp_x + int(oversampling);
+                                    next_cp_y = -next_cp_y + int(oversampling);
                                 }
+#ifdef WPROJECTION
+                                const bool next_conj_kernel = use_wproj && ((GridTiles::entry_conj(next_entry) ? -w_lambda.at(next_vi) : w_lambda.at(next_vi)) < 0.0);
+#else
+                                const bool next_conj_kernel = false;
+#endif
+                                kernel_bank->prefetch(size_t(next_cp_y), size_t(next_cp_x), next_conj_kernel);
                             }
+
+                            // Footprints lying entirely inside the tile use the unrolled kernels, the remaining ones are clipped
+                            const bool interior = (num_col_spans == 1) && (num_row_spans == 1) && (col_spans[0].kend - col_spans[0].kbegin == kernel_size)
+                                && (row_spans[0].kend - row_spans[0].kbegin == kernel_size);
+                            if (!interior || !grid_kernel_interior<generateBeam>(kernel_size, vis_grid, sampling_grid, conv_kernel, kernel_ld, col_spans[0].grid_offset, row_spans[0].grid_offset, vis_val, vis_weight))
+                                grid_kernel_spans<generateBeam>(vis_grid, sampling_grid, conv_kernel, kernel_ld, col_spans, num_col_spans, row_spans, num_row_spans, vis_val, vis_weight);
                         }
                     }
-                },
-                    tbb::simple_partitioner());
+                });
 #ifdef APROJECTION
             }
 #endif
@@ -942,14 +1748,12 @@ GridderOutput convolve_to_grid(
 #endif
     } else {
         // Exact gridder (slower but with more accuracy)
+#ifdef SERIAL_GRIDDER
         for (arma::uword vi = 0; vi < good_vis.n_elem; vi++) {
-            if (good_vis[vi] == 0) {
-                continue;
-            }
             int gc_x = kernel_centre_on_grid(vi, 0);
             int gc_y = kernel_centre_on_grid(vi, 1);
             arma::mat frac = uv_frac.row(vi);
-            cx_real_t vis_val = cx_real_t(vis[vi]);
+            cx_real_t vis_val = sorted_vis[vi];
             const real_t vis_weight = real_t(vis_weights[vi]);
 
             // If good_vis[vi] is 2, add also conjugate visibility
@@ -991,10 +1795,288 @@ GridderOutput convolve_to_grid(
                 }
             }
         }
+#else
+        // Multi-threaded implementation of exact gridder
+        // Visibilities are bucketed by grid tile (as in the oversampled gridder). Kernel points on negative rows are wrapped.
+        GridTiles grid_tiles(image_size, image_rows, GRIDDER_TILE_SIZE, true);
+        grid_tiles.bin(kernel_centre_on_grid, good_vis, 0, good_vis.n_elem, conv_support);
+
+        // The exact kernel is separable: the x and y 1D kernels are evaluated into thread-local buffers (no allocation per visibility)
+        tbb::enumerable_thread_specific<arma::Col<real_t>> kernel_coeffs_tls(arma::Col<real_t>(size_t(2 * kernel_size)));
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, grid_tiles.num_tiles()), [&](const tbb::blocked_range<size_t>& r) {
+            real_t* x_kernel_coeffs = kernel_coeffs_tls.local().memptr();
+            real_t* y_kernel_coeffs = x_kernel_coeffs + kernel_size;
+
+            for (size_t tile = r.begin(); tile != r.end(); ++tile) {
+                int row_begin, row_end, col_begin, col_end;
+                grid_tiles.tile_range(tile, row_begin, row_end, col_begin, col_end);
+
+                for (size_t e = grid_tiles.tile_begin(tile); e < grid_tiles.tile_end(tile); ++e) {
+                    const arma::uword entry = grid_tiles.entries[e];
+                    const arma::uword vi = GridTiles::entry_vis(entry);
+
+                    int gc_x = kernel_centre_on_grid(vi, 0);
+                    int gc_y = kernel_centre_on_grid(vi, 1);
+                    double frac_x = uv_frac.at(vi, 0);
+                    double frac_y = uv_frac.at(vi, 1);
+                    cx_real_t vis_val = sorted_vis[vi];
+
+                    // Conjugate visibility (only added when good_vis[vi] is 2)
+                    if (GridTiles::entry_conj(entry)) {
+                        gc_x = -gc_x + image_size;
+                        gc_y = -gc_y + image_size;
+                        frac_x *= (-1);
+                        frac_y *= (-1);
+                        vis_val = std::conj(vis_val);
+                    }
+
+                    // Exact gridding is used, i.e. the kernel is recalculated for each visibility, with
+                    // precise sub-pixel offset according to that visibility's UV co-ordinates.
+                    const real_t x_sum = fill_1D_kernel(kernel_creator, conv_support, frac_x, x_kernel_coeffs);
+                    const real_t y_sum = fill_1D_kernel(kernel_creator, conv_support, frac_y, y_kernel_coeffs);
+                    // Kernel normalization and visibility weight are applied to the x coefficients
+                    const real_t col_scale = real_t(vis_weights[vi]) / (x_sum * y_sum);
+
+                    // Clip kernel footprint to the tile
+                    TileSpan col_spans[3];
+                    TileSpan row_spans[3];
+                    const int num_col_spans = intersect_footprint(gc_x - conv_support, kernel_size, col_begin, col_end, image_size, true, col_spans);
+                    const int num_row_spans = intersect_footprint(gc_y - conv_support, kernel_size, row_begin, row_end, image_size, true, row_spans);
+
+                    grid_separable_kernel_spans<generateBeam>(vis_grid, sampling_grid, x_kernel_coeffs, y_kernel_coeffs, col_spans, num_col_spans, row_spans, num_row_spans, vis_val, col_scale);
+                }
+            }
+        });
+#endif
     }
 
+}
+
+template <typename T, bool generateBeam>
+void GridAccumulator<T, generateBeam>::reset()
+{
+    // Use MatStp class because these images shall be efficiently initialized with zeros
+    vis_grid = MatStp<cx_real_t>((size_t(image_rows)), size_t(image_size));
+    int sampl_image_size = 0;
+    int sampl_image_rows = 0;
+    if (generateBeam) {
+        sampl_image_size = image_size;
+        sampl_image_rows = image_rows;
+    }
+    sampling_grid = MatStp<cx_real_t>((size_t(sampl_image_rows)), size_t(sampl_image_size));
+    sample_grid_total = 0.0;
+}
+
+template <typename T, bool generateBeam>
+GridderOutput GridAccumulator<T, generateBeam>::finalize()
+{
     return GridderOutput(vis_grid, sampling_grid, sample_grid_total);
 }
+
+/**
+ * @brief The GriddingPlan class
+ *
+ * Gridding plan for a fixed set of visibility positions (UVW-coordinates) and weights, e.g. consecutive snapshots
+ * that share the same UVW coverage. The geometry of the visibilities (uv scaling, w-sort, half-plane conversion,
+ * kernel positions and oversampled offsets, W-planes and A-projection timesteps) and the convolution kernels of all
+ * W-planes are computed once, so that gridding a new set of visibility values only performs the accumulation.
+ */
+template <typename T, bool generateBeam = true>
+class GriddingPlan {
+public:
+    /**
+     * @brief GriddingPlan constructor. Computes the gridding geometry.
+     *
+     * See convolve_to_grid for the description of the parameters.
+     *
+     * @param[in] cache_kernels (bool) : Store the W-kernels when they are first generated, rather than regenerating them for every call.
+     */
+    GriddingPlan(const T& kernel_creator, uint support, int image_size, const arma::mat& uv_lambda, const arma::mat& vis_weights,
+        bool kernel_exact = true, uint oversampling = 1, bool shift_uv = true, bool halfplane_gridding = true,
+        const W_ProjectionPars& w_proj = W_ProjectionPars(), const arma::vec& w_lambda = arma::vec(), double cell_size = 0.0,
+        bool analytic_gcf = true, FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT, const A_ProjectionPars& a_proj = A_ProjectionPars(),
+        bool cache_kernels = true)
+        : accumulator(kernel_creator, support, image_size, kernel_exact, oversampling, shift_uv, halfplane_gridding, w_proj, cell_size, analytic_gcf, r_fft, a_proj)
+        , geometry(accumulator.prepare(uv_lambda, vis_weights, w_lambda, a_proj.lha, cache_kernels))
+    {
+    }
+
+    /**
+     * @brief GriddingPlan constructor. Computes the gridding geometry from non-owning views of the UVW-coordinates and weights.
+     *
+     * See convolve_to_grid for the description of the parameters.
+     *
+     * @param[in] cache_kernels (bool) : Store the W-kernels when they are first generated, rather than regenerating them for every call.
+     */
+    GriddingPlan(const T& kernel_creator, uint support, int image_size, const VisibilityView& vis_data, double uv_scale,
+        bool kernel_exact = true, uint oversampling = 1, bool shift_uv = true, bool halfplane_gridding = true,
+        const W_ProjectionPars& w_proj = W_ProjectionPars(), double cell_size = 0.0, bool analytic_gcf = true,
+        FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT, const A_ProjectionPars& a_proj = A_ProjectionPars(), bool cache_kernels = true)
+        : accumulator(kernel_creator, support, image_size, kernel_exact, oversampling, shift_uv, halfplane_gridding, w_proj, cell_size, analytic_gcf, r_fft, a_proj)
+        , geometry(accumulator.prepare(vis_data, uv_scale, a_proj.lha, cache_kernels))
+    {
+    }
+
+    /**
+     * @brief Grid visibilities using the plan.
+     *
+     * @param[in] vis (arma::cx_mat) : Complex visibilities, in the same order as the plan coordinates. 1d array, shape: (n_vis).
+     *
+     * @return (GridderOutput): stores vis_grid and sampling_grid, as well as the total sampling grid sum.
+     */
+    GridderOutput grid(const arma::cx_mat& vis)
+    {
+        accumulator.reset();
+        accumulator.add(geometry, vis);
+        return accumulator.finalize();
+    }
+
+    /**
+     * @brief Grid visibilities (given by a non-owning view) using the plan.
+     *
+     * @param[in] vis (StridedView<std::complex<double>>) : Complex visibilities, in the same order as the plan coordinates.
+     *
+     * @return (GridderOutput): stores vis_grid and sampling_grid, as well as the total sampling grid sum.
+     */
+    GridderOutput grid(const StridedView<std::complex<double>>& vis)
+    {
+        accumulator.reset();
+        accumulator.add(geometry, vis);
+        return accumulator.finalize();
+    }
+
+    /**
+     * @brief Number of visibilities of the plan
+     */
+    size_t num_vis() const
+    {
+        return geometry.num_vis;
+    }
+
+private:
+    GridAccumulator<T, generateBeam> accumulator;
+    GriddingGeometry geometry;
+};
+
+/** @brief Grid visibilities using convolutional gridding.
+ *
+ *  Returns the **un-normalized** weighted visibilities; the
+ *  weights-renormalization factor can be calculated by summing the sample grid.
+ *
+ *  If 'exact == True' then exact gridding is used, i.e. the kernel is
+ *  recalculated for each visibility, with precise sub-pixel offset according to
+ *  that visibility's UV co-ordinates. Otherwise, instead of recalculating the
+ *  kernel for each sub-pixel location, we pre-generate an oversampled kernel
+ *  ahead of time - so e.g. for an oversampling of 5, the kernel is
+ *  pre-generated at 0.2 pixel-width offsets. We then pick the pre-generated
+ *  kernel corresponding to the sub-pixel offset nearest to that of the
+ *  visibility.
+ *  Kernel pre-generation results in improved performance, particularly with
+ *  large numbers of visibilities and complex kernel functions, at the cost of
+ *  introducing minor aliasing effects due to the 'step-like' nature of the
+ *  oversampled kernel. This in turn can be minimised (at the cost of longer
+ *  start-up times and larger memory usage) by pre-generating kernels with a
+ *  larger oversampling ratio, to give finer interpolation.
+ *  This function also performs W-projection and A-projection when these
+ *  parameters are provided.
+ *
+ *  @param[in] T& kernel_creator : the kernel creator functor.
+ *  @param[in] support (uint) : Defines the 'radius' of the bounding box within
+ *              which convolution takes place. `Box width in pixels = 2*support+1`.
+ *              (The central pixel is the one nearest to the UV co-ordinates.)
+ *              (This is sometimes known as the 'half-support')
+ *  @param[in] image_size (int) : Width of the image in pixels. NB we assume
+ *              the pixel `[image_size//2,image_size//2]` corresponds to the origin
+ *              in UV-space.
+ *  @param[in] uv_lambda (arma::mat) : UV-coordinates of input visibilities.
+ *  @param[in] vis (arma::cx_mat) : Complex visibilities. 1d array, shape: (n_vis).
+ *  @param[in] vis_weights (arma::mat) : Visibility weights. 1d array, shape: (n_vis).
+ *  @param[in] kernel_exact (bool) : Calculate exact kernel-values for every UV-sample.
+ *  @param[in] oversampling (uint) : Controls kernel-generation if ``exact==False``.
+                Larger values give a finer-sampled set of pre-cached kernels.
+ *  @param[in] shift_uv (bool) : Shift uv-coordinates before gridding (required when fftshift function is
+ *              skipped before fft). Default is true.
+ *  @param[in] halfplane_gridding (bool) : Grid only halfplane matrix. Used when halfplane c2r fft will be applied.
+ *              Default is true.
+ *  @param[in] w_proj (W_ProjectionPars) : W-projection configuration parameters.
+ *  @param[in] w_lambda (arma::vec) : W-coordinate of input visibilities.
+ *  @param[in] cell_size (double) : Angular-width of a synthesized pixel in the image to be created (arcsecond).
+ *  @param[in] analytic_gcf (bool): Compute approximation of image-domain kernel from analytic expression. Default is true.
+ *  @param[in] r_fft (FFTRoutine): Selects FFT routine. Default is FFTW_ESTIMATE_FFT.
+ *  @param[in] a_proj (A_ProjectionPars) : A-projection configuration parameters.
+ *
+ *  @return (GridderRes): stores vis_grid and sampling_grid, representing the visibility grid and the
+ *                         sampling grid matrices. Includes also value with the total sampling grid sum.
+ */
+template <bool generateBeam = true, typename T>
+GridderOutput convolve_to_grid(
+    const T& kernel_creator,
+    const uint support,
+    int image_size,
+    const arma::mat& uv_lambda,
+    const arma::cx_mat& vis,
+    const arma::mat& vis_weights,
+    bool kernel_exact = true,
+    uint oversampling = 1,
+    bool shift_uv = true,
+    bool halfplane_gridding = true,
+    const W_ProjectionPars& w_proj = W_ProjectionPars(),
+    const arma::vec& w_lambda = arma::vec(),
+    double cell_size = 0.0,
+    bool analytic_gcf = true,
+    FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT,
+    const A_ProjectionPars& a_proj = A_ProjectionPars())
+{
+    GridAccumulator<T, generateBeam> accumulator(kernel_creator, support, image_size, kernel_exact, oversampling, shift_uv, halfplane_gridding,
+        w_proj, cell_size, analytic_gcf, r_fft, a_proj);
+    // Single chunk: the W-kernels are not kept
+    GriddingGeometry geometry = accumulator.prepare(uv_lambda, vis_weights, w_lambda, a_proj.lha);
+    accumulator.add(geometry, vis);
+
+    return accumulator.finalize();
+}
+
+/** @brief Grid visibilities using convolutional gridding (non-owning views of the visibility data).
+ *
+ *  Same as convolve_to_grid, but the UVW-coordinates, visibilities and weights are given by non-owning strided views,
+ *  so that no copies of the input data are made (the w-sort is applied as a permutation during gridding).
+ *
+ *  @param[in] T& kernel_creator : the kernel creator functor.
+ *  @param[in] support (uint) : Kernel support.
+ *  @param[in] image_size (int) : Width of the image in pixels.
+ *  @param[in] vis_data (VisibilityView) : Views of the UVW-coordinates, visibilities and weights.
+ *  @param[in] uv_scale (double) : Scale factor that converts UV-coordinates to grid pixels.
+ *
+ *  See convolve_to_grid for the description of the remaining parameters.
+ *
+ *  @return (GridderOutput): stores vis_grid and sampling_grid, as well as the total sampling grid sum.
+ */
+template <bool generateBeam = true, typename T>
+GridderOutput convolve_to_grid(
+    const T& kernel_creator,
+    const uint support,
+    int image_size,
+    const VisibilityView& vis_data,
+    double uv_scale,
+    bool kernel_exact = true,
+    uint oversampling = 1,
+    bool shift_uv = true,
+    bool halfplane_gridding = true,
+    const W_ProjectionPars& w_proj = W_ProjectionPars(),
+    double cell_size = 0.0,
+    bool analytic_gcf = true,
+    FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT,
+    const A_ProjectionPars& a_proj = A_ProjectionPars())
+{
+    GridAccumulator<T, generateBeam> accumulator(kernel_creator, support, image_size, kernel_exact, oversampling, shift_uv, halfplane_gridding,
+        w_proj, cell_size, analytic_gcf, r_fft, a_proj);
+    // Single chunk: the W-kernels are not kept
+    GriddingGeometry geometry = accumulator.prepare(vis_data, uv_scale, a_proj.lha);
+    accumulator.add(geometry, vis_data.vis);
+
+    return accumulator.finalize();
+}
 }
 
 #endif /* GRIDDER_H */
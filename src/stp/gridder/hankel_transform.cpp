@@ -0,0 +1,145 @@
+/**
+ * @file hankel_transform.cpp
+ * @brief Implementation of the fast Hankel transform functions.
+ */
+
+#include "hankel_transform.h"
+#include "../common/fft.h"
+#include <algorithm>
+#include <cassert>
+
+namespace stp {
+
+namespace {
+
+    // Cubic Lagrange interpolation weights of the grid points (n - 1, n, n + 1, n + 2) at position n + t
+    void lagrange_weights(double t, real_t* weights)
+    {
+        weights[0] = real_t(-t * (t - 1.0) * (t - 2.0) / 6.0);
+        weights[1] = real_t((t + 1.0) * (t - 1.0) * (t - 2.0) / 2.0);
+        weights[2] = real_t(-(t + 1.0) * t * (t - 2.0) / 2.0);
+        weights[3] = real_t((t + 1.0) * t * (t - 1.0) / 6.0);
+    }
+
+    // Grid point n (of a logarithmic grid with num_points points) and interpolation position t of a value at log position pos
+    size_t log_grid_point(double pos, size_t num_points, double& t)
+    {
+        const double n = std::min(std::max(std::floor(pos), 1.0), double(num_points - 3));
+        t = pos - n;
+        return size_t(n);
+    }
+}
+
+FastHankelTransform::FastHankelTransform(size_t arrsize, size_t num_radius_points, size_t num_freq_points, FFTRoutine _r_fft)
+    : num_radius(num_radius_points)
+    , num_freq(num_freq_points)
+    , r_fft(_r_fft)
+{
+    assert((num_radius > 0) && (num_radius <= arrsize));
+    assert((num_freq > 1) && (num_freq <= arrsize));
+
+    // Ring edges, as in the DHT matrix (the last edge is at arrsize - 1)
+    arma::vec rn(num_radius);
+    edge_area.set_size(num_radius);
+    for (size_t j = 0; j < num_radius; j++) {
+        rn[j] = double(j) + 0.5;
+        if (j == (arrsize - 1)) {
+            rn[j] = double(arrsize - 1);
+        }
+        edge_area[j] = real_t(M_PI * rn[j] * rn[j]);
+    }
+
+    const double k_step = M_PI / double(arrsize);
+    const double max_radius = rn[num_radius - 1];
+    const double max_freq = k_step * double(num_freq - 1);
+
+    // Logarithmic grid spacing: FHT_SAMPLES_PER_PERIOD samples per period of u(k * r) at the largest radius and frequency
+    // (also used to interpolate the output, which oscillates with the same period)
+    const double alpha = std::min(2.0 * M_PI / (double(FHT_SAMPLES_PER_PERIOD) * max_freq * max_radius), 1.0 / double(FHT_SAMPLES_PER_PERIOD));
+
+    // The logarithmic grids start one point before the first edge and frequency, and end two points after the last ones (plus one
+    // point to absorb rounding errors), so that every interpolation has its 4 grid points
+    const double r0 = rn[0] * std::exp(-alpha);
+    const double k0 = k_step * std::exp(-alpha);
+    num_log_radius = size_t(std::floor(std::log(max_radius / r0) / alpha)) + 4;
+    num_log_freq = size_t(std::floor(std::log(max_freq / k0) / alpha)) + 4;
+
+    // FFT size of the correlation (large enough to avoid wrap-around of the linear correlation)
+    const size_t num_kernel_points = num_log_radius + num_log_freq - 1;
+    fft_size = 1;
+    while (fft_size < num_kernel_points) {
+        fft_size <<= 1;
+    }
+
+    // Interpolation of the ring edges on the logarithmic radius grid
+    radius_idx.set_size(num_radius);
+    radius_weights.set_size(4, num_radius);
+    for (size_t j = 0; j < num_radius; j++) {
+        double t;
+        const size_t n = log_grid_point(std::log(rn[j] / r0) / alpha, num_log_radius, t);
+        radius_idx[j] = n - 1;
+        lagrange_weights(t, radius_weights.colptr(j));
+    }
+
+    // Interpolation of the output frequencies on the logarithmic frequency grid (the zero frequency is computed directly)
+    freq_idx.zeros(num_freq);
+    freq_weights.zeros(4, num_freq);
+    for (size_t i = 1; i < num_freq; i++) {
+        double t;
+        const size_t n = log_grid_point(std::log(k_step * double(i) / k0) / alpha, num_log_freq, t);
+        freq_idx[i] = n - 1;
+        real_t* weights = freq_weights.colptr(i);
+        lagrange_weights(t, weights);
+        for (size_t q = 0; q < 4; q++) {
+            const double k = k0 * std::exp(alpha * double(n - 1 + q));
+            weights[q] *= real_t(2.0 * M_PI / (k * k * double(fft_size)));
+        }
+    }
+
+    // Correlation kernel
+    arma::Col<cx_real_t> kernel = arma::zeros<arma::Col<cx_real_t>>(fft_size);
+    for (size_t s = 0; s < num_kernel_points; s++) {
+        const double x = r0 * k0 * std::exp(alpha * double(s));
+        kernel[s] = real_t(x * besselj1(x));
+    }
+    fft_fftw_dft_c2c_1d(kernel, kernel_fft, r_fft);
+}
+
+arma::Col<cx_real_t> FastHankelTransform::transform(const arma::Col<cx_real_t>& radius_values) const
+{
+    assert(!is_empty());
+    assert(radius_values.n_elem == num_radius);
+
+    // Resample ring edges on the logarithmic radius grid. The grid is reversed, so that the correlation with the kernel is
+    // computed as a circular convolution
+    arma::Col<cx_real_t> edges = arma::zeros<arma::Col<cx_real_t>>(fft_size);
+    cx_real_t zero_freq = 0;
+    for (size_t j = 0; j < num_radius; j++) {
+        const cx_real_t next_value = ((j + 1) < num_radius) ? radius_values[j + 1] : cx_real_t(0);
+        const cx_real_t edge_value = radius_values[j] - next_value;
+        zero_freq += edge_value * edge_area[j];
+        const real_t* weights = radius_weights.colptr(j);
+        for (size_t q = 0; q < 4; q++) {
+            const size_t n = radius_idx[j] + q;
+            edges[(fft_size - n) % fft_size] += edge_value * weights[q];
+        }
+    }
+
+    fft_fftw_dft_c2c_1d(edges, edges, r_fft);
+    for (size_t i = 0; i < fft_size; i++) {
+        edges[i] *= kernel_fft[i];
+    }
+    fft_fftw_dft_c2c_1d(edges, edges, r_fft, false);
+
+    // Interpolate output frequencies
+    arma::Col<cx_real_t> output(num_freq);
+    output[0] = zero_freq;
+    for (size_t i = 1; i < num_freq; i++) {
+        const real_t* weights = freq_weights.colptr(i);
+        const cx_real_t* correlation = &edges[freq_idx[i]];
+        output[i] = correlation[0] * weights[0] + correlation[1] * weights[1] + correlation[2] * weights[2] + correlation[3] * weights[3];
+    }
+
+    return output;
+}
+}
@@ -0,0 +1,131 @@
+/** @file hankel_transform.h
+ *  @brief Classes and function prototypes of the fast Hankel transform.
+ */
+
+#ifndef HANKEL_TRANSFORM_H
+#define HANKEL_TRANSFORM_H
+
+#include "../types.h"
+#include <armadillo>
+#include <cmath>
+
+// Number of samples of the logarithmic grids per period of the fastest oscillation of the fast Hankel transform
+#ifndef FHT_SAMPLES_PER_PERIOD
+#define FHT_SAMPLES_PER_PERIOD 16
+#endif
+
+namespace stp {
+
+/*************************************/
+/* Bessel function kind 1, order 1   */
+/*************************************/
+inline double besselj1(double x)
+{
+    double z, xx, y, res, tmp1, tmp2;
+
+    if (x < 8.0) {
+        xx = x * x;
+        tmp1 = x * (72362614232.0 + xx * (-7895059235.0 + xx * (242396853.1 + xx * (-2972611.439 + xx * (15704.48260 + xx * (-30.16036606))))));
+        tmp2 = 144725228442.0 + xx * (2300535178.0 + xx * (18583304.74 + xx * (99447.43394 + xx * (376.9991397 + xx))));
+        res = tmp1 / tmp2;
+    } else {
+        z = 8.0 / x;
+        xx = z * z;
+        y = x - 2.356194491;
+        tmp1 = 1.0 + xx * (0.183105e-2 + xx * (-0.3516396496e-4 + xx * (0.2457520174e-5 + xx * (-0.240337019e-6))));
+        tmp2 = 0.04687499995 + xx * (-0.2002690873e-3 + xx * (0.8449199096e-5 + xx * (-0.88228987e-6 + xx * 0.105787412e-6)));
+        res = sqrt(0.636619772 / x) * (cos(y) * tmp1 - z * sin(y) * tmp2);
+    }
+    return res;
+}
+
+inline float besselj1(float x)
+{
+    float z, xx, y, res, tmp1, tmp2;
+
+    if (x < 8.0f) {
+        xx = x * x;
+        tmp1 = x * (72362614232.0f + xx * (-7895059235.0f + xx * (242396853.1f + xx * (-2972611.439f + xx * (15704.48260f + xx * (-30.16036606f))))));
+        tmp2 = 144725228442.0f + xx * (2300535178.0f + xx * (18583304.74f + xx * (99447.43394f + xx * (376.9991397f + xx))));
+        res = tmp1 / tmp2;
+    } else {
+        z = 8.0f / x;
+        xx = z * z;
+        y = x - 2.356194491f;
+        tmp1 = 1.0f + xx * (0.183105e-2f + xx * (-0.3516396496e-4f + xx * (0.2457520174e-5f + xx * (-0.240337019e-6f))));
+        tmp2 = 0.04687499995f + xx * (-0.2002690873e-3f + xx * (0.8449199096e-5f + xx * (-0.88228987e-6f + xx * 0.105787412e-6f)));
+        res = std::sqrt(0.636619772f / x) * (std::cos(y) * tmp1 - z * std::sin(y) * tmp2);
+    }
+    return res;
+}
+
+/**
+ * @brief The FastHankelTransform class
+ *
+ * Computes the same (order zero) Hankel transform as the DHT matrix of WideFieldImaging: the input value at radius j is constant
+ * in the ring between radii rn(j-1) and rn(j), with rn(j) = j + 0.5, and the output is sampled at frequencies pi * i / arrsize.
+ *
+ * Summing by parts, the transform is a sum over the ring edges: F(k) = 2pi / k^2 * sum_j (f(j) - f(j+1)) * u(k * rn(j)), where
+ * u(x) = x * J1(x). The edges are resampled (by cubic Lagrange interpolation) on a logarithmic radius grid r0 * exp(alpha * n),
+ * so that, on a logarithmic frequency grid k0 * exp(alpha * m), the sum becomes a correlation with u(r0 * k0 * exp(alpha * (n + m))),
+ * which is computed with FFTs (Siegman's method). The output frequencies are interpolated from the logarithmic frequency grid.
+ *
+ * The grid spacing (alpha) is set by the largest radius and frequency, hence the cost is O(M log M), with M of the order of
+ * num_freq_points * log(num_radius_points), instead of the O(num_radius_points * num_freq_points) of the DHT matrix.
+ */
+class FastHankelTransform {
+public:
+    /**
+     * @brief Default constructor
+     */
+    FastHankelTransform() = default;
+
+    /**
+     * @brief FastHankelTransform constructor
+     *
+     * @param[in] arrsize (size_t): Hankel transform size (the DHT matrix is arrsize x arrsize).
+     * @param[in] num_radius_points (size_t): Number of input radius points (the input is zero beyond them).
+     * @param[in] num_freq_points (size_t): Number of output frequency points.
+     * @param[in] r_fft (FFTRoutine): Selects FFT routine.
+     */
+    FastHankelTransform(size_t arrsize, size_t num_radius_points, size_t num_freq_points, FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT);
+
+    /**
+     * @brief Hankel transform of a radial function
+     *
+     * @param[in] radius_values (arma::Col<cx_real_t>): Values at the num_radius_points radius points.
+     * @return (arma::Col<cx_real_t>): Values at the num_freq_points frequency points.
+     */
+    arma::Col<cx_real_t> transform(const arma::Col<cx_real_t>& radius_values) const;
+
+    /**
+     * @brief Indicates whether the transform is initialized or not
+     */
+    bool is_empty() const
+    {
+        return fft_size == 0;
+    }
+
+private:
+    size_t num_radius = 0;
+    size_t num_freq = 0;
+    size_t num_log_radius = 0;
+    size_t num_log_freq = 0;
+    size_t fft_size = 0;
+    FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT;
+
+    // Interpolation of the ring edges on the logarithmic radius grid (first grid point and 4 weights of each edge)
+    arma::uvec radius_idx;
+    arma::Mat<real_t> radius_weights;
+    // Area of the disk within each ring edge (pi * rn^2), used for the zero frequency
+    arma::Col<real_t> edge_area;
+    // Interpolation of the output frequencies on the logarithmic frequency grid (first grid point and 4 weights of each frequency,
+    // scaled by 2pi / k^2 and by the FFT normalization)
+    arma::uvec freq_idx;
+    arma::Mat<real_t> freq_weights;
+    // FFT of the correlation kernel u(r0 * k0 * exp(alpha * s))
+    arma::Col<cx_real_t> kernel_fft;
+};
+}
+
+#endif /* HANKEL_TRANSFORM_H */
@@ -0,0 +1,63 @@
+/**
+ * @file kernel_bank.cpp
+ * @brief Implementation of the oversampled kernel bank functions.
+ */
+
+#include "kernel_bank.h"
+#include <cassert>
+#include <cstdint>
+
+namespace stp {
+
+KernelBank::KernelBank(size_t num_offsets, size_t kernel_size, bool with_conjugates)
+    : n_offsets(num_offsets)
+    , k_size(kernel_size)
+    , k_ld(padded_kernel_ld(kernel_size))
+    , conjugates(with_conjugates)
+{
+    bank = MatStp<cx_real_t>(k_ld * k_size, n_offsets * n_offsets * (conjugates ? 2 : 1));
+}
+
+KernelBank::KernelBank(size_t num_offsets, size_t kernel_size, std::shared_ptr<void> storage, cx_real_t* data, bool with_conjugates)
+    : n_offsets(num_offsets)
+    , k_size(kernel_size)
+    , k_ld(padded_kernel_ld(kernel_size))
+    , conjugates(with_conjugates)
+    , ext_storage(std::move(storage))
+    , ext_data(data)
+{
+    assert(ext_storage);
+    assert((reinterpret_cast<uintptr_t>(ext_data) % CACHE_LINE_SIZE) == 0);
+}
+
+size_t KernelBank::padded_kernel_ld(size_t kernel_size)
+{
+    // Pad kernel columns to a multiple of the cache line size
+    const size_t elems_per_line = CACHE_LINE_SIZE / sizeof(cx_real_t);
+    return ((kernel_size + elems_per_line - 1) / elems_per_line) * elems_per_line;
+}
+
+void KernelBank::generate_conjugates()
+{
+    assert(conjugates);
+    const size_t num_kernel_elems = n_offsets * n_offsets * kernel_elems();
+    cx_real_t* kernels = data();
+    cx_real_t* conj_kernels = kernels + num_kernel_elems;
+    for (size_t i = 0; i < num_kernel_elems; i++) {
+        conj_kernels[i] = std::conj(kernels[i]);
+    }
+}
+
+arma::Mat<cx_real_t> KernelBank::kernel_mat(size_t cp_y, size_t cp_x, bool conjugate) const
+{
+    arma::Mat<cx_real_t> result(k_size, k_size);
+    const cx_real_t* kernel_ptr = kernel(cp_y, cp_x, conjugate);
+    for (size_t j = 0; j < k_size; j++) {
+        for (size_t i = 0; i < k_size; i++) {
+            result.at(i, j) = kernel_ptr[j * k_ld + i];
+        }
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,202 @@
+/** @file kernel_bank.h
+ *  @brief Classes and function prototypes of the oversampled kernel bank.
+ */
+
+#ifndef KERNEL_BANK_H
+#define KERNEL_BANK_H
+
+#include "../common/matstp.h"
+#include "../types.h"
+#include <algorithm>
+#include <cassert>
+#include <armadillo>
+#include <memory>
+
+// Number of cache lines of a kernel prefetched by KernelBank::prefetch
+#ifndef KERNEL_BANK_PREFETCH_LINES
+#define KERNEL_BANK_PREFETCH_LINES 4
+#endif
+
+namespace stp {
+
+/**
+ * @brief The KernelBank class
+ *
+ * Stores the convolution kernels of all oversampled-pixel offsets in a single contiguous, cache-line-aligned buffer.
+ * Kernels are column-major and each kernel column is padded (with zeros) to a multiple of the cache line size, so that
+ * every kernel column starts at an aligned address (which is also aligned to the widest SIMD register).
+ * The kernel of offsets (cp_y, cp_x) is found by a stride computation, which avoids a pointer indirection per visibility.
+ * The kernels are either stored in an owned buffer or in external storage with the same layout (e.g. a memory-mapped kernel file).
+ *
+ * The bank may also store the complex conjugates of all kernels after the regular ones (used to grid visibilities with negative w),
+ * so that the kernel of either sign is picked by an offset computation instead of branching or conjugating each kernel value.
+ */
+class KernelBank {
+public:
+    /**
+     * @brief Default constructor
+     */
+    KernelBank() = default;
+
+    /**
+     * @brief KernelBank constructor (kernel values are initialized with zeros)
+     *
+     * @param[in] num_offsets (size_t): Number of oversampled-pixel offsets along each axis (oversampling + 1).
+     * @param[in] kernel_size (size_t): Width of the kernels (2 * support + 1).
+     * @param[in] with_conjugates (bool): Allocate space for the conjugate kernels (see generate_conjugates).
+     */
+    KernelBank(size_t num_offsets, size_t kernel_size, bool with_conjugates = false);
+
+    /**
+     * @brief KernelBank constructor using external storage, which is kept alive while the bank exists
+     *
+     * @param[in] num_offsets (size_t): Number of oversampled-pixel offsets along each axis (oversampling + 1).
+     * @param[in] kernel_size (size_t): Width of the kernels (2 * support + 1).
+     * @param[in] storage (std::shared_ptr<void>): Owner of the external storage (released when the last bank using it is destroyed).
+     * @param[in] data (cx_real_t*): Kernel values, with the padded layout of the bank and aligned to the cache line size.
+     * @param[in] with_conjugates (bool): The storage also holds the conjugate kernels.
+     */
+    KernelBank(size_t num_offsets, size_t kernel_size, std::shared_ptr<void> storage, cx_real_t* data, bool with_conjugates = false);
+
+    /**
+     * @brief Pointer to the first element of the kernel associated to the oversampled-pixel offsets (cp_y, cp_x)
+     */
+    cx_real_t* kernel(size_t cp_y, size_t cp_x)
+    {
+        return data() + (cp_x * n_offsets + cp_y) * kernel_elems();
+    }
+
+    /**
+     * @brief Pointer to the first element of the kernel associated to the oversampled-pixel offsets (cp_y, cp_x)
+     */
+    const cx_real_t* kernel(size_t cp_y, size_t cp_x) const
+    {
+        return data() + (cp_x * n_offsets + cp_y) * kernel_elems();
+    }
+
+    /**
+     * @brief Pointer to the first element of the kernel associated to the oversampled-pixel offsets (cp_y, cp_x), or of its conjugate
+     *
+     * The bank must store the conjugate kernels when conjugate is true.
+     */
+    const cx_real_t* kernel(size_t cp_y, size_t cp_x, bool conjugate) const
+    {
+        assert(!conjugate || conjugates);
+        return kernel(cp_y, cp_x) + size_t(conjugate) * (n_offsets * n_offsets * kernel_elems());
+    }
+
+    /**
+     * @brief Compute the conjugates of all kernels (the bank must have been created with space for them)
+     */
+    void generate_conjugates();
+
+    /**
+     * @brief Indicates whether the bank stores the conjugate kernels
+     */
+    bool has_conjugates() const
+    {
+        return conjugates;
+    }
+
+    /**
+     * @brief Pointer to the first element of the bank (all kernels are stored contiguously)
+     */
+    cx_real_t* data()
+    {
+        return ext_storage ? ext_data : bank.memptr();
+    }
+
+    /**
+     * @brief Pointer to the first element of the bank (all kernels are stored contiguously)
+     */
+    const cx_real_t* data() const
+    {
+        return ext_storage ? ext_data : bank.memptr();
+    }
+
+    /**
+     * @brief Number of elements of each padded kernel
+     */
+    size_t kernel_elems() const
+    {
+        return k_ld * k_size;
+    }
+
+    /**
+     * @brief Number of elements of the bank (including the conjugate kernels)
+     */
+    size_t num_elems() const
+    {
+        return kernel_elems() * n_offsets * n_offsets * (conjugates ? 2 : 1);
+    }
+
+    /**
+     * @brief Copy of the kernel associated to the oversampled-pixel offsets (cp_y, cp_x) (or of its conjugate), without padding
+     */
+    arma::Mat<cx_real_t> kernel_mat(size_t cp_y, size_t cp_x, bool conjugate = false) const;
+
+    /**
+     * @brief Prefetch the first cache lines of the kernel associated to the oversampled-pixel offsets (cp_y, cp_x)
+     *
+     * Only the beginning of the kernel is prefetched (the hardware prefetcher follows the remaining contiguous lines).
+     */
+    void prefetch(size_t cp_y, size_t cp_x, bool conjugate = false) const
+    {
+        const char* ptr = reinterpret_cast<const char*>(kernel(cp_y, cp_x, conjugate));
+        const size_t num_bytes = std::min(kernel_elems() * sizeof(cx_real_t), size_t(KERNEL_BANK_PREFETCH_LINES * CACHE_LINE_SIZE));
+        for (size_t b = 0; b < num_bytes; b += CACHE_LINE_SIZE) {
+            __builtin_prefetch(ptr + b);
+        }
+    }
+
+    /**
+     * @brief Number of oversampled-pixel offsets along each axis
+     */
+    size_t num_offsets() const
+    {
+        return n_offsets;
+    }
+
+    /**
+     * @brief Width of the kernels
+     */
+    size_t kernel_size() const
+    {
+        return k_size;
+    }
+
+    /**
+     * @brief Leading dimension of the kernels (distance between consecutive kernel columns)
+     */
+    size_t kernel_ld() const
+    {
+        return k_ld;
+    }
+
+    /**
+     * @brief Indicates whether the kernel bank is empty
+     */
+    bool is_empty() const
+    {
+        return ext_storage ? (num_elems() == 0) : bank.is_empty();
+    }
+
+    /**
+     * @brief Leading dimension of the padded kernels of the given width
+     */
+    static size_t padded_kernel_ld(size_t kernel_size);
+
+private:
+    size_t n_offsets = 0;
+    size_t k_size = 0;
+    size_t k_ld = 0;
+    bool conjugates = false;
+    // Each column of this matrix stores one padded kernel
+    MatStp<cx_real_t> bank;
+    // External storage (used instead of the owned matrix when set)
+    std::shared_ptr<void> ext_storage;
+    cx_real_t* ext_data = nullptr;
+};
+}
+
+#endif /* KERNEL_BANK_H */
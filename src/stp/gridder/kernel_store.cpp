@@ -0,0 +1,178 @@
+/**
+ * @file kernel_store.cpp
+ * @brief Implementation of the on-disk W-kernel store functions.
+ */
+
+#include "kernel_store.h"
+#include "../global_macros.h"
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stp {
+
+namespace {
+
+    const char kernel_file_magic[8] = { 'S', 'T', 'P', 'W', 'K', 'E', 'R', 'N' };
+
+    // Header of the kernel files (its size keeps the kernel values aligned to the cache line size)
+    struct KernelFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t value_size;
+        uint64_t key;
+        double w_value;
+        uint64_t num_offsets;
+        uint64_t kernel_size;
+        uint64_t kernel_ld;
+        uint32_t support;
+        uint32_t conjugates;
+    };
+    static_assert(sizeof(KernelFileHeader) == CACHE_LINE_SIZE, "Kernel file header must fill one cache line");
+}
+
+KernelStoreKey& KernelStoreKey::add(const void* data, size_t num_bytes)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < num_bytes; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return *this;
+}
+
+KernelStore::KernelStore(const std::string& directory, double w_tolerance)
+    : dir(directory)
+    , w_tol(w_tolerance)
+{
+    assert(!dir.empty());
+    assert(w_tol >= 0.0);
+    if (w_tol < 0.0) {
+        throw std::runtime_error("W tolerance of the kernel store must be non-negative.");
+    }
+    if ((mkdir(dir.c_str(), 0755) != 0) && (errno != EEXIST)) {
+        throw std::runtime_error("Unable to create kernel store directory: " + dir);
+    }
+}
+
+real_t KernelStore::quantize_w(real_t w_value) const
+{
+    if (w_tol > 0.0) {
+        return real_t(std::round(double(w_value) / w_tol) * w_tol);
+    }
+    return w_value;
+}
+
+std::string KernelStore::kernel_filename(uint64_t key, real_t w_value) const
+{
+    // The W value is identified by its bit pattern
+    const double w = double(w_value);
+    uint64_t w_bits;
+    std::memcpy(&w_bits, &w, sizeof(w_bits));
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "wkernel_%016llx_%016llx.bin", (unsigned long long)key, (unsigned long long)w_bits);
+    return dir + "/" + name;
+}
+
+bool KernelStore::load(uint64_t key, real_t w_value, KernelBank& bank, uint& support) const
+{
+    assert(is_enabled());
+    const std::string filename = kernel_filename(key, w_value);
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || (size_t(file_stat.st_size) < sizeof(KernelFileHeader))) {
+        close(fd);
+        return false;
+    }
+    const size_t file_size = size_t(file_stat.st_size);
+
+    // Private writable mapping: the bank may be modified without changing the file (copy-on-write)
+    void* addr = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    std::shared_ptr<void> mapping(addr, [file_size](void* ptr) { munmap(ptr, file_size); });
+
+    const KernelFileHeader* header = static_cast<const KernelFileHeader*>(addr);
+    // The W value must match exactly, so its bit pattern is compared (as in kernel_filename)
+    const double w = double(w_value);
+    uint64_t w_bits, header_w_bits;
+    std::memcpy(&w_bits, &w, sizeof(w_bits));
+    std::memcpy(&header_w_bits, &header->w_value, sizeof(header_w_bits));
+    const bool valid_header = (std::memcmp(header->magic, kernel_file_magic, sizeof(kernel_file_magic)) == 0)
+        && (header->version == KERNEL_STORE_VERSION)
+        && (header->value_size == sizeof(cx_real_t))
+        && (header->key == key)
+        && (header_w_bits == w_bits)
+        && (header->kernel_size == (2 * header->support + 1))
+        && (header->kernel_ld == KernelBank::padded_kernel_ld(header->kernel_size));
+    if (!valid_header) {
+        STPLIB_DEBUG("stplib", "Kernel store: ignoring invalid kernel file {}", filename);
+        return false;
+    }
+    const size_t num_elems = header->kernel_ld * header->kernel_size * header->num_offsets * header->num_offsets * (header->conjugates ? 2 : 1);
+    if (file_size != (sizeof(KernelFileHeader) + num_elems * sizeof(cx_real_t))) {
+        STPLIB_DEBUG("stplib", "Kernel store: ignoring truncated kernel file {}", filename);
+        return false;
+    }
+
+    cx_real_t* data = reinterpret_cast<cx_real_t*>(static_cast<char*>(addr) + sizeof(KernelFileHeader));
+    bank = KernelBank(header->num_offsets, header->kernel_size, std::move(mapping), data, header->conjugates != 0);
+    support = uint(header->support);
+
+    return true;
+}
+
+bool KernelStore::store(uint64_t key, real_t w_value, const KernelBank& bank, uint support) const
+{
+    assert(is_enabled());
+    assert(bank.kernel_size() == (2 * support + 1));
+
+    KernelFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kernel_file_magic, sizeof(kernel_file_magic));
+    header.version = KERNEL_STORE_VERSION;
+    header.value_size = sizeof(cx_real_t);
+    header.key = key;
+    header.w_value = double(w_value);
+    header.num_offsets = bank.num_offsets();
+    header.kernel_size = bank.kernel_size();
+    header.kernel_ld = bank.kernel_ld();
+    header.support = support;
+    header.conjugates = bank.has_conjugates() ? 1 : 0;
+
+    const std::string filename = kernel_filename(key, w_value);
+    const std::string tmp_filename = filename + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(bank.data()), std::streamsize(bank.num_elems() * sizeof(cx_real_t)));
+        file.flush();
+        if (!file.good()) {
+            STPLIB_DEBUG("stplib", "Kernel store: unable to write kernel file {}", filename);
+            file.close();
+            std::remove(tmp_filename.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp_filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+}
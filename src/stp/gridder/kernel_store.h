@@ -0,0 +1,125 @@
+/** @file kernel_store.h
+ *  @brief Classes and function prototypes of the on-disk W-kernel store.
+ */
+
+#ifndef KERNEL_STORE_H
+#define KERNEL_STORE_H
+
+#include "../types.h"
+#include "kernel_bank.h"
+#include <cstdint>
+#include <string>
+
+// Version of the kernel files (files with a different version are ignored). Increase it when the kernel generation changes
+#ifndef KERNEL_STORE_VERSION
+#define KERNEL_STORE_VERSION 3
+#endif
+
+namespace stp {
+
+/**
+ * @brief The KernelStoreKey class
+ *
+ * Builds the key that identifies the imaging parameters of a set of W-kernels (64-bit FNV-1a hash of the parameter values).
+ */
+class KernelStoreKey {
+public:
+    /**
+     * @brief Add a buffer of bytes to the key
+     */
+    KernelStoreKey& add(const void* data, size_t num_bytes);
+
+    /**
+     * @brief Add a value to the key
+     */
+    template <typename T>
+    KernelStoreKey& add(const T& value)
+    {
+        return add(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Key value
+     */
+    uint64_t value() const
+    {
+        return hash;
+    }
+
+private:
+    uint64_t hash = 14695981039346656037ULL;
+};
+
+/**
+ * @brief The KernelStore class
+ *
+ * Stores kernel banks in a directory, one binary file per (key, w-value) pair. A file holds a 64-byte header followed by the
+ * kernel values with the padded layout of KernelBank, so a stored bank is loaded by memory-mapping the file: its pages are only
+ * read from disk when the gridder first touches them. Files are written to a temporary name and renamed, so that concurrent
+ * runs sharing the directory never see partially written files.
+ */
+class KernelStore {
+public:
+    /**
+     * @brief Default constructor (the store is disabled)
+     */
+    KernelStore() = default;
+
+    /**
+     * @brief KernelStore constructor
+     *
+     * @param[in] directory (string): Directory of the kernel files (created if it does not exist).
+     * @param[in] w_tolerance (double): W values are quantized to multiples of this tolerance. Set zero to disable quantization.
+     */
+    KernelStore(const std::string& directory, double w_tolerance = 0.0);
+
+    /**
+     * @brief Indicates whether the store is enabled
+     */
+    bool is_enabled() const
+    {
+        return !dir.empty();
+    }
+
+    /**
+     * @brief Quantize W value to the tolerance of the store
+     *
+     * @param[in] w_value (real_t): W value.
+     * @return (real_t): Nearest multiple of the tolerance (or the input value if quantization is disabled).
+     */
+    real_t quantize_w(real_t w_value) const;
+
+    /**
+     * @brief Load kernel bank of the given key and W value
+     *
+     * @param[in] key (uint64_t): Key of the imaging parameters.
+     * @param[in] w_value (real_t): (Quantized) W value.
+     * @param[out] bank (KernelBank): Memory-mapped kernel bank.
+     * @param[out] support (uint): Kernel support (after truncation).
+     * @return (bool): True if a valid kernel file was found. Outputs are not modified otherwise.
+     */
+    bool load(uint64_t key, real_t w_value, KernelBank& bank, uint& support) const;
+
+    /**
+     * @brief Store kernel bank of the given key and W value (failures are not fatal, the kernel is just not stored)
+     *
+     * @param[in] key (uint64_t): Key of the imaging parameters.
+     * @param[in] w_value (real_t): (Quantized) W value.
+     * @param[in] bank (KernelBank): Kernel bank.
+     * @param[in] support (uint): Kernel support (after truncation).
+     * @return (bool): True if the kernel file was written.
+     */
+    bool store(uint64_t key, real_t w_value, const KernelBank& bank, uint support) const;
+
+    /**
+     * @brief Path of the kernel file of the given key and W value
+     */
+    std::string kernel_filename(uint64_t key, real_t w_value) const;
+
+private:
+    std::string dir;
+    double w_tol = 0.0;
+};
+}
+
+#endif /* KERNEL_STORE_H */
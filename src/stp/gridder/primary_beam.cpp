@@ -0,0 +1,153 @@
+/**
+ * @file primary_beam.cpp
+ * @brief Implementation of the primary beam evaluator functions.
+ */
+
+#include "primary_beam.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <tbb/tbb.h>
+
+namespace stp {
+
+PrimaryBeam::PrimaryBeam(const std::vector<double>& pbeam_coefs, double fov, int workarea_size)
+    : degree(int((pbeam_coefs.size() - 1) / 2))
+    , workarea_centre(workarea_size / 2)
+{
+    assert((pbeam_coefs.size() % 2) == 1);
+    assert((workarea_size > 0) && ((workarea_size % 2) == 0));
+    if (pbeam_coefs.empty()) {
+        throw std::runtime_error("Primary beam coefficients are required for A-projection.");
+    }
+
+    const int l = degree;
+    cos_coefs.resize(size_t(l + 1));
+    sin_coefs.resize(size_t(l + 1));
+    for (int m = 0; m <= l; m++) {
+        cos_coefs[size_t(m)] = real_t(std::abs(pbeam_coefs[size_t(l + m)]));
+        sin_coefs[size_t(m)] = real_t(std::abs(pbeam_coefs[size_t(l - m)]));
+    }
+    // The m = 0 term has no sin part
+    sin_coefs[0] = 0;
+
+    // Normalization of the real spherical harmonics: sqrt((2l + 1) / 4pi * (l - m)! / (l + m)!), times sqrt(2) if m > 0
+    std::vector<double> norm(size_t(l + 1));
+    for (int m = 0; m <= l; m++) {
+        double factorial_ratio = 1.0;
+        for (int k = l - m + 1; k <= l + m; k++) {
+            factorial_ratio /= double(k);
+        }
+        norm[size_t(m)] = std::sqrt((2.0 * l + 1.0) * factorial_ratio / (4.0 * M_PI)) * ((m > 0) ? std::sqrt(2.0) : 1.0);
+    }
+
+    // Radial factors of one octant of the work area
+    const size_t num_rows = size_t(l + 2);
+    const size_t max_offset = size_t(workarea_centre);
+    radial.set_size(num_rows, (max_offset + 1) * (max_offset + 2) / 2);
+    const double pixel_angle = fov / double(workarea_size);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, max_offset + 1), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t b = r.begin(); b < r.end(); ++b) {
+            for (size_t a = 0; a <= b; ++a) {
+                real_t* values = radial.colptr(b * (b + 1) / 2 + a);
+                const double radius = std::sqrt(double(a * a + b * b));
+                values[0] = (b > 0) ? real_t(1.0 / radius) : real_t(0.0);
+
+                // Associated Legendre polynomials P_l^m(x) of all m (computed as in the spherical harmonics library)
+                const double x = std::cos(radius * pixel_angle);
+                const double somx2 = std::sqrt((1.0 - x) * (1.0 + x));
+                double pmm = 1.0;
+                for (int m = 0; m <= l; m++) {
+                    if (m > 0) {
+                        pmm *= -double(2 * m - 1) * somx2;
+                    }
+                    double plm = pmm;
+                    if (l > m) {
+                        double p_prev = pmm;
+                        plm = x * double(2 * m + 1) * pmm;
+                        for (int n = m + 2; n <= l; n++) {
+                            const double p_next = (x * double(2 * n - 1) * plm - double(n + m - 1) * p_prev) / double(n - m);
+                            p_prev = plm;
+                            plm = p_next;
+                        }
+                    }
+                    values[m + 1] = real_t(std::abs(norm[size_t(m)] * plm));
+                }
+            }
+        }
+    });
+}
+
+arma::Mat<real_t> PrimaryBeam::a_kernel(double rot_angle) const
+{
+    assert(!is_empty());
+
+    const int c = workarea_centre;
+    const size_t workarea_size = size_t(2 * c);
+    const size_t num_rows = radial.n_rows;
+    const int l = degree;
+    const real_t cos_rot = real_t(std::cos(rot_angle));
+    const real_t sin_rot = real_t(std::sin(rot_angle));
+    const real_t* cos_coef = cos_coefs.data();
+    const real_t* sin_coef = sin_coefs.data();
+
+    // Inverse primary beam at pixel (i, j) (row j, column i, relative to the centre)
+    auto pixel = [&](int i, int j) -> real_t {
+        const size_t a = size_t(std::abs(i));
+        const size_t b = size_t(std::abs(j));
+        const size_t lo = std::min(a, b);
+        const size_t hi = std::max(a, b);
+        const real_t* values = radial.memptr() + (hi * (hi + 1) / 2 + lo) * num_rows;
+
+        // Azimuth phi = atan(i / j) (pi / 2 when j is zero), rotated
+        real_t cos_phi = 0;
+        real_t sin_phi = 1;
+        if (j != 0) {
+            cos_phi = real_t(b) * values[0];
+            sin_phi = real_t((j > 0) ? i : -i) * values[0];
+        }
+        const real_t cos_psi = cos_phi * cos_rot - sin_phi * sin_rot;
+        const real_t sin_psi = sin_phi * cos_rot + cos_phi * sin_rot;
+
+        real_t beam = cos_coef[0] * values[1];
+        real_t cos_m = 1;
+        real_t sin_m = 0;
+        for (int m = 1; m <= l; m++) {
+            const real_t next_cos = cos_m * cos_psi - sin_m * sin_psi;
+            sin_m = sin_m * cos_psi + cos_m * sin_psi;
+            cos_m = next_cos;
+            beam += values[m + 1] * (cos_coef[m] * std::abs(cos_m) + sin_coef[m] * std::abs(sin_m));
+        }
+        return real_t(1.0) / beam;
+    };
+
+    arma::Mat<real_t> Akernel(workarea_size, workarea_size);
+
+    // Columns i <= 0 are evaluated
+    tbb::parallel_for(tbb::blocked_range<int>(-c, 1), [&](const tbb::blocked_range<int>& r) {
+        for (int i = r.begin(); i < r.end(); ++i) {
+            real_t* column = Akernel.colptr(size_t(i + c));
+            for (int j = -c; j < c; ++j) {
+                column[j + c] = pixel(i, j);
+            }
+        }
+    });
+
+    // Columns i > 0 are copied from pixels (-i, -j), which have the same radius and azimuth (except the first row, which has
+    // no mirror pixel in the work area)
+    tbb::parallel_for(tbb::blocked_range<int>(1, c), [&](const tbb::blocked_range<int>& r) {
+        for (int i = r.begin(); i < r.end(); ++i) {
+            real_t* column = Akernel.colptr(size_t(i + c));
+            const real_t* mirror_column = Akernel.colptr(size_t(c - i));
+            column[0] = pixel(i, -c);
+            for (int j = -c + 1; j < c; ++j) {
+                column[j + c] = mirror_column[c - j];
+            }
+        }
+    });
+
+    return Akernel;
+}
+}
@@ -0,0 +1,69 @@
+/** @file primary_beam.h
+ *  @brief Classes and function prototypes of the primary beam evaluator.
+ */
+
+#ifndef PRIMARY_BEAM_H
+#define PRIMARY_BEAM_H
+
+#include "../types.h"
+#include <armadillo>
+#include <vector>
+
+namespace stp {
+
+/**
+ * @brief The PrimaryBeam class
+ *
+ * Evaluates the A-kernels of A-projection: the inverse of the primary beam given by the spherical harmonics coefficients of degree l,
+ * 1 / sum_m |c_m * Y_lm(phi + rot_angle, theta)|, on the pixels of the work area (theta is the distance of the pixel to the centre).
+ *
+ * Each term is the product of a radial factor |K_lm * P_l^|m|(cos(theta))| and an azimuthal factor |cos(m * phi)| or |sin(|m| * phi)|.
+ * The radial factors only depend on (|i|, |j|), hence they are tabulated once for one octant of the work area. The azimuthal factors
+ * of a rotation angle are computed with a cos/sin recurrence on m, and pixels (i, j) and (-i, -j), which have the same azimuth, share
+ * their value.
+ */
+class PrimaryBeam {
+public:
+    /**
+     * @brief Default constructor
+     */
+    PrimaryBeam() = default;
+
+    /**
+     * @brief PrimaryBeam constructor
+     *
+     * @param[in] pbeam_coefs (std::vector<double>): Spherical harmonics coefficients of the primary beam (2 * l + 1 values, m = -l...l).
+     * @param[in] fov (double): Field of view (in radians).
+     * @param[in] workarea_size (int): Size of the A-kernels (even).
+     */
+    PrimaryBeam(const std::vector<double>& pbeam_coefs, double fov, int workarea_size);
+
+    /**
+     * @brief A-kernel (inverse primary beam) rotated by the given angle
+     *
+     * @param[in] rot_angle (double): Rotation angle (in radians).
+     * @return (arma::Mat<real_t>): A-kernel matrix (workarea_size x workarea_size).
+     */
+    arma::Mat<real_t> a_kernel(double rot_angle = 0.0) const;
+
+    /**
+     * @brief Indicates whether the evaluator is initialized or not
+     */
+    bool is_empty() const
+    {
+        return radial.is_empty();
+    }
+
+private:
+    int degree = 0;
+    int workarea_centre = 0;
+    // Absolute values of the coefficients of the cos (m >= 0) and sin (m < 0) terms, by |m|
+    std::vector<real_t> cos_coefs;
+    std::vector<real_t> sin_coefs;
+    // Octant table (one column per pixel (a, b) with 0 <= a <= b <= workarea_centre, at column b * (b + 1) / 2 + a):
+    // inverse radius in pixels, followed by the radial factors of |m| = 0...l
+    arma::Mat<real_t> radial;
+};
+}
+
+#endif /* PRIMARY_BEAM_H */
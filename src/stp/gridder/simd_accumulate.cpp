@@ -0,0 +1,125 @@
+/** @file simd_accumulate.cpp
+ *  @brief Implementation of the SIMD complex multiply-accumulate routines used by the gridder.
+ *
+ *  The scalar routine and the runtime dispatch are compiled with the baseline flags. The routines of each
+ *  instruction set are compiled in their own translation unit (see simd_accumulate_kernels.h), so the library
+ *  does not require the instruction set at build time. The routine is selected at runtime according to the CPU.
+ */
+
+#include "simd_accumulate.h"
+#include "simd_accumulate_kernels.h"
+
+namespace stp {
+
+namespace {
+
+// Scalar column implementation
+template <typename T>
+inline void accumulate_column_scalar(std::complex<T>* grid_col, std::complex<T>* sampling_col, const std::complex<T>* kernel_col, int n,
+    std::complex<T> vis_val, T vis_weight, bool conjugate_kernel)
+{
+    const T vis_weight_imag = conjugate_kernel ? -vis_weight : vis_weight;
+    for (int i = 0; i < n; ++i) {
+        const std::complex<T> kernel_val(kernel_col[i].real() * vis_weight, kernel_col[i].imag() * vis_weight_imag);
+        grid_col[i] += vis_val * kernel_val;
+        if (sampling_col != nullptr) {
+            sampling_col[i] += kernel_val;
+        }
+    }
+}
+
+template <typename T>
+void accumulate_block_scalar(std::complex<T>* grid, size_t grid_ld, std::complex<T>* sampling, size_t sampling_ld, const std::complex<T>* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, std::complex<T> vis_val, T vis_weight, bool conjugate_kernel)
+{
+    for (int j = 0; j < n_cols; ++j) {
+        accumulate_column_scalar(grid + j * grid_ld, sampling ? sampling + j * sampling_ld : nullptr, kernel + j * kernel_ld, n_rows, vis_val, vis_weight, conjugate_kernel);
+    }
+}
+
+#ifdef STP_SIMD_X86
+// Adapts a per-instruction set routine (see simd_accumulate_kernels.h) to the AccumulateBlockFn signature
+template <typename T, void (*Routine)(T*, size_t, T*, size_t, const T*, size_t, int, int, T, T, T, bool)>
+void accumulate_block_simd(std::complex<T>* grid, size_t grid_ld, std::complex<T>* sampling, size_t sampling_ld, const std::complex<T>* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, std::complex<T> vis_val, T vis_weight, bool conjugate_kernel)
+{
+    Routine(reinterpret_cast<T*>(grid), grid_ld, reinterpret_cast<T*>(sampling), sampling_ld, reinterpret_cast<const T*>(kernel), kernel_ld,
+        n_rows, n_cols, vis_val.real(), vis_val.imag(), vis_weight, conjugate_kernel);
+}
+#endif
+
+SimdLevel detect_simd_level()
+{
+#ifdef STP_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse3")) {
+        return SimdLevel::SSE3;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+}
+
+SimdLevel simd_level()
+{
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+const char* simd_level_name(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE3:
+        return "SSE3";
+    default:
+        return "Scalar";
+    }
+}
+
+template <typename T>
+AccumulateBlockFn<T> accumulate_block_routine(SimdLevel level)
+{
+    if (int(level) > int(simd_level())) {
+        return nullptr;
+    }
+    switch (level) {
+#ifdef STP_SIMD_X86
+    case SimdLevel::AVX512:
+        return &accumulate_block_simd<T, &simd::accumulate_block_avx512>;
+    case SimdLevel::AVX2:
+        return &accumulate_block_simd<T, &simd::accumulate_block_avx2>;
+    case SimdLevel::SSE3:
+        return &accumulate_block_simd<T, &simd::accumulate_block_sse3>;
+#endif
+    default:
+        return &accumulate_block_scalar<T>;
+    }
+}
+
+template AccumulateBlockFn<float> accumulate_block_routine<float>(SimdLevel level);
+template AccumulateBlockFn<double> accumulate_block_routine<double>(SimdLevel level);
+
+void accumulate_block(std::complex<float>* grid, size_t grid_ld, std::complex<float>* sampling, size_t sampling_ld, const std::complex<float>* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, std::complex<float> vis_val, float vis_weight, bool conjugate_kernel)
+{
+    static const AccumulateBlockFn<float> routine = accumulate_block_routine<float>(simd_level());
+    routine(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_val, vis_weight, conjugate_kernel);
+}
+
+void accumulate_block(std::complex<double>* grid, size_t grid_ld, std::complex<double>* sampling, size_t sampling_ld, const std::complex<double>* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, std::complex<double> vis_val, double vis_weight, bool conjugate_kernel)
+{
+    static const AccumulateBlockFn<double> routine = accumulate_block_routine<double>(simd_level());
+    routine(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_val, vis_weight, conjugate_kernel);
+}
+}
@@ -0,0 +1,84 @@
+/** @file simd_accumulate.h
+ *  @brief Function prototypes of the SIMD complex multiply-accumulate routines used by the gridder.
+ */
+
+#ifndef SIMD_ACCUMULATE_H
+#define SIMD_ACCUMULATE_H
+
+#include "../types.h"
+#include <complex>
+#include <cstddef>
+
+namespace stp {
+
+/**
+ * @brief Enum of instruction sets supported by the block-accumulate routines
+ */
+enum struct SimdLevel {
+    Scalar,
+    SSE3,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief Block-accumulate routine type
+ *
+ * Accumulates (on a block of grid columns) a block of convolution kernel columns multiplied by a complex visibility:
+ * grid[i, j] += vis_val * kernel[i, j] * vis_weight, and sampling[i, j] += kernel[i, j] * vis_weight
+ * (if sampling is not null). The kernel values are conjugated if conjugate_kernel is true.
+ * Blocks are column-major, the distance between columns is given by the leading dimension (ld) parameters.
+ */
+template <typename T>
+using AccumulateBlockFn = void (*)(std::complex<T>* grid, size_t grid_ld, std::complex<T>* sampling, size_t sampling_ld, const std::complex<T>* kernel,
+    size_t kernel_ld, int n_rows, int n_cols, std::complex<T> vis_val, T vis_weight, bool conjugate_kernel);
+
+/**
+ * @brief Get the widest instruction set supported by the CPU (detected once at runtime).
+ *
+ * @return (SimdLevel): Instruction set used by accumulate_block.
+ */
+SimdLevel simd_level();
+
+/**
+ * @brief Get name of instruction set
+ *
+ * @param[in] level (SimdLevel): Instruction set.
+ * @return (const char*): Instruction set name.
+ */
+const char* simd_level_name(SimdLevel level);
+
+/**
+ * @brief Get block-accumulate routine implemented with the given instruction set.
+ *
+ * @param[in] level (SimdLevel): Instruction set.
+ * @return (AccumulateBlockFn<T>): Block-accumulate routine (nullptr if the CPU does not support the instruction set).
+ */
+template <typename T>
+AccumulateBlockFn<T> accumulate_block_routine(SimdLevel level);
+
+/**
+ * @brief Accumulate weighted kernel columns multiplied by a complex visibility on grid columns.
+ *
+ * Uses the widest instruction set supported by the CPU (runtime dispatch).
+ *
+ * @param[in,out] grid (std::complex<T>*): First element of the visibility grid block.
+ * @param[in] grid_ld (size_t): Leading dimension of the visibility grid.
+ * @param[in,out] sampling (std::complex<T>*): First element of the sampling grid block (ignored if null).
+ * @param[in] sampling_ld (size_t): Leading dimension of the sampling grid.
+ * @param[in] kernel (std::complex<T>*): First element of the convolution kernel block.
+ * @param[in] kernel_ld (size_t): Leading dimension of the convolution kernel.
+ * @param[in] n_rows (int): Number of rows of the block.
+ * @param[in] n_cols (int): Number of columns of the block.
+ * @param[in] vis_val (std::complex<T>): Visibility value.
+ * @param[in] vis_weight (T): Visibility weight.
+ * @param[in] conjugate_kernel (bool): Use conjugate kernel values.
+ */
+void accumulate_block(std::complex<float>* grid, size_t grid_ld, std::complex<float>* sampling, size_t sampling_ld, const std::complex<float>* kernel,
+    size_t kernel_ld, int n_rows, int n_cols, std::complex<float> vis_val, float vis_weight, bool conjugate_kernel);
+
+void accumulate_block(std::complex<double>* grid, size_t grid_ld, std::complex<double>* sampling, size_t sampling_ld, const std::complex<double>* kernel,
+    size_t kernel_ld, int n_rows, int n_cols, std::complex<double> vis_val, double vis_weight, bool conjugate_kernel);
+}
+
+#endif /* SIMD_ACCUMULATE_H */
@@ -0,0 +1,98 @@
+/** @file simd_accumulate_avx2.cpp
+ *  @brief Implementation of the AVX2 block-accumulate routines (compiled with -mavx2 -mfma).
+ */
+
+#include "simd_accumulate_kernels.h"
+
+#ifdef STP_SIMD_X86
+#include <immintrin.h>
+
+namespace stp {
+
+namespace simd {
+
+namespace {
+
+/*
+ * Same scheme as the SSE3 routines (see simd_accumulate_sse3.cpp), with the multiply and add-sub fused.
+ */
+
+// Remaining elements of a column
+template <typename T>
+inline void column_tail(T* grid, T* sampling, const T* kernel, int n, T vis_real, T vis_imag, T vis_weight, T vis_weight_imag)
+{
+    for (int i = 0; i < n; ++i) {
+        const T kr = kernel[2 * i] * vis_weight;
+        const T ki = kernel[2 * i + 1] * vis_weight_imag;
+        grid[2 * i] += vis_real * kr - vis_imag * ki;
+        grid[2 * i + 1] += vis_real * ki + vis_imag * kr;
+        if (sampling != nullptr) {
+            sampling[2 * i] += kr;
+            sampling[2 * i + 1] += ki;
+        }
+    }
+}
+
+inline void column(float* grid, float* sampling, const float* kernel, int n, float vis_real, float vis_imag, float vis_weight, float vis_weight_imag)
+{
+    const __m256 vr = _mm256_set1_ps(vis_real);
+    const __m256 vi = _mm256_set1_ps(vis_imag);
+    const __m256 w = _mm256_setr_ps(vis_weight, vis_weight_imag, vis_weight, vis_weight_imag, vis_weight, vis_weight_imag, vis_weight, vis_weight_imag);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256 k = _mm256_mul_ps(_mm256_loadu_ps(kernel + 2 * i), w);
+        const __m256 k_swap = _mm256_permute_ps(k, 0xB1);
+        const __m256 prod = _mm256_fmaddsub_ps(vr, k, _mm256_mul_ps(vi, k_swap));
+        _mm256_storeu_ps(grid + 2 * i, _mm256_add_ps(_mm256_loadu_ps(grid + 2 * i), prod));
+        if (sampling != nullptr) {
+            _mm256_storeu_ps(sampling + 2 * i, _mm256_add_ps(_mm256_loadu_ps(sampling + 2 * i), k));
+        }
+    }
+    column_tail(grid + 2 * i, sampling ? sampling + 2 * i : nullptr, kernel + 2 * i, n - i, vis_real, vis_imag, vis_weight, vis_weight_imag);
+}
+
+inline void column(double* grid, double* sampling, const double* kernel, int n, double vis_real, double vis_imag, double vis_weight, double vis_weight_imag)
+{
+    const __m256d vr = _mm256_set1_pd(vis_real);
+    const __m256d vi = _mm256_set1_pd(vis_imag);
+    const __m256d w = _mm256_setr_pd(vis_weight, vis_weight_imag, vis_weight, vis_weight_imag);
+
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m256d k = _mm256_mul_pd(_mm256_loadu_pd(kernel + 2 * i), w);
+        const __m256d k_swap = _mm256_permute_pd(k, 0x5);
+        const __m256d prod = _mm256_fmaddsub_pd(vr, k, _mm256_mul_pd(vi, k_swap));
+        _mm256_storeu_pd(grid + 2 * i, _mm256_add_pd(_mm256_loadu_pd(grid + 2 * i), prod));
+        if (sampling != nullptr) {
+            _mm256_storeu_pd(sampling + 2 * i, _mm256_add_pd(_mm256_loadu_pd(sampling + 2 * i), k));
+        }
+    }
+    column_tail(grid + 2 * i, sampling ? sampling + 2 * i : nullptr, kernel + 2 * i, n - i, vis_real, vis_imag, vis_weight, vis_weight_imag);
+}
+
+template <typename T>
+void block(T* grid, size_t grid_ld, T* sampling, size_t sampling_ld, const T* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, T vis_real, T vis_imag, T vis_weight, bool conjugate_kernel)
+{
+    const T vis_weight_imag = conjugate_kernel ? -vis_weight : vis_weight;
+    for (int j = 0; j < n_cols; ++j) {
+        column(grid + 2 * j * grid_ld, sampling ? sampling + 2 * j * sampling_ld : nullptr, kernel + 2 * j * kernel_ld, n_rows, vis_real, vis_imag, vis_weight, vis_weight_imag);
+    }
+}
+}
+
+void accumulate_block_avx2(float* grid, size_t grid_ld, float* sampling, size_t sampling_ld, const float* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, float vis_real, float vis_imag, float vis_weight, bool conjugate_kernel)
+{
+    block(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_real, vis_imag, vis_weight, conjugate_kernel);
+}
+
+void accumulate_block_avx2(double* grid, size_t grid_ld, double* sampling, size_t sampling_ld, const double* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, double vis_real, double vis_imag, double vis_weight, bool conjugate_kernel)
+{
+    block(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_real, vis_imag, vis_weight, conjugate_kernel);
+}
+}
+}
+#endif
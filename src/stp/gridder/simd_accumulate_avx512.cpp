@@ -0,0 +1,83 @@
+/** @file simd_accumulate_avx512.cpp
+ *  @brief Implementation of the AVX-512 block-accumulate routines (compiled with -mavx512f).
+ */
+
+#include "simd_accumulate_kernels.h"
+
+#ifdef STP_SIMD_X86
+#include <immintrin.h>
+
+namespace stp {
+
+namespace simd {
+
+namespace {
+
+/*
+ * Same scheme as the SSE3 routines (see simd_accumulate_sse3.cpp), with the multiply and add-sub fused.
+ * Masked loads and stores are used for the remaining elements.
+ */
+
+inline void column(float* grid, float* sampling, const float* kernel, int n, float vis_real, float vis_imag, float vis_weight, float vis_weight_imag)
+{
+    const __m512 vr = _mm512_set1_ps(vis_real);
+    const __m512 vi = _mm512_set1_ps(vis_imag);
+    const __m512 w = _mm512_setr4_ps(vis_weight, vis_weight_imag, vis_weight, vis_weight_imag);
+
+    for (int i = 0; i < n; i += 8) {
+        const int num_elems = (n - i < 8) ? (n - i) : 8;
+        const __mmask16 mask = __mmask16((1u << (2 * num_elems)) - 1u);
+        const __m512 k = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, kernel + 2 * i), w);
+        const __m512 k_swap = _mm512_shuffle_ps(k, k, 0xB1);
+        const __m512 prod = _mm512_fmaddsub_ps(vr, k, _mm512_mul_ps(vi, k_swap));
+        _mm512_mask_storeu_ps(grid + 2 * i, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, grid + 2 * i), prod));
+        if (sampling != nullptr) {
+            _mm512_mask_storeu_ps(sampling + 2 * i, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, sampling + 2 * i), k));
+        }
+    }
+}
+
+inline void column(double* grid, double* sampling, const double* kernel, int n, double vis_real, double vis_imag, double vis_weight, double vis_weight_imag)
+{
+    const __m512d vr = _mm512_set1_pd(vis_real);
+    const __m512d vi = _mm512_set1_pd(vis_imag);
+    const __m512d w = _mm512_setr4_pd(vis_weight, vis_weight_imag, vis_weight, vis_weight_imag);
+
+    for (int i = 0; i < n; i += 4) {
+        const int num_elems = (n - i < 4) ? (n - i) : 4;
+        const __mmask8 mask = __mmask8((1u << (2 * num_elems)) - 1u);
+        const __m512d k = _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, kernel + 2 * i), w);
+        const __m512d k_swap = _mm512_shuffle_pd(k, k, 0x55);
+        const __m512d prod = _mm512_fmaddsub_pd(vr, k, _mm512_mul_pd(vi, k_swap));
+        _mm512_mask_storeu_pd(grid + 2 * i, mask, _mm512_add_pd(_mm512_maskz_loadu_pd(mask, grid + 2 * i), prod));
+        if (sampling != nullptr) {
+            _mm512_mask_storeu_pd(sampling + 2 * i, mask, _mm512_add_pd(_mm512_maskz_loadu_pd(mask, sampling + 2 * i), k));
+        }
+    }
+}
+
+template <typename T>
+void block(T* grid, size_t grid_ld, T* sampling, size_t sampling_ld, const T* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, T vis_real, T vis_imag, T vis_weight, bool conjugate_kernel)
+{
+    const T vis_weight_imag = conjugate_kernel ? -vis_weight : vis_weight;
+    for (int j = 0; j < n_cols; ++j) {
+        column(grid + 2 * j * grid_ld, sampling ? sampling + 2 * j * sampling_ld : nullptr, kernel + 2 * j * kernel_ld, n_rows, vis_real, vis_imag, vis_weight, vis_weight_imag);
+    }
+}
+}
+
+void accumulate_block_avx512(float* grid, size_t grid_ld, float* sampling, size_t sampling_ld, const float* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, float vis_real, float vis_imag, float vis_weight, bool conjugate_kernel)
+{
+    block(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_real, vis_imag, vis_weight, conjugate_kernel);
+}
+
+void accumulate_block_avx512(double* grid, size_t grid_ld, double* sampling, size_t sampling_ld, const double* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, double vis_real, double vis_imag, double vis_weight, bool conjugate_kernel)
+{
+    block(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_real, vis_imag, vis_weight, conjugate_kernel);
+}
+}
+}
+#endif
@@ -0,0 +1,46 @@
+/** @file simd_accumulate_kernels.h
+ *  @brief Function prototypes of the per-instruction set block-accumulate routines.
+ *
+ *  Each instruction set is implemented in its own translation unit, which is the only code compiled with the
+ *  corresponding compiler flags (e.g. -mavx2). The routines operate on interleaved (re, im) arrays and the
+ *  translation units do not include other library headers, so no inline function is ever instantiated with
+ *  instructions the CPU may not support. The routines are selected at runtime in simd_accumulate.cpp.
+ */
+
+#ifndef SIMD_ACCUMULATE_KERNELS_H
+#define SIMD_ACCUMULATE_KERNELS_H
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STP_SIMD_X86
+#endif
+
+namespace stp {
+
+namespace simd {
+
+#ifdef STP_SIMD_X86
+/*
+ * Parameters follow AccumulateBlockFn (see simd_accumulate.h), with complex values given as interleaved (re, im)
+ * arrays and leading dimensions given in complex elements.
+ */
+void accumulate_block_sse3(float* grid, size_t grid_ld, float* sampling, size_t sampling_ld, const float* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, float vis_real, float vis_imag, float vis_weight, bool conjugate_kernel);
+void accumulate_block_sse3(double* grid, size_t grid_ld, double* sampling, size_t sampling_ld, const double* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, double vis_real, double vis_imag, double vis_weight, bool conjugate_kernel);
+
+void accumulate_block_avx2(float* grid, size_t grid_ld, float* sampling, size_t sampling_ld, const float* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, float vis_real, float vis_imag, float vis_weight, bool conjugate_kernel);
+void accumulate_block_avx2(double* grid, size_t grid_ld, double* sampling, size_t sampling_ld, const double* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, double vis_real, double vis_imag, double vis_weight, bool conjugate_kernel);
+
+void accumulate_block_avx512(float* grid, size_t grid_ld, float* sampling, size_t sampling_ld, const float* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, float vis_real, float vis_imag, float vis_weight, bool conjugate_kernel);
+void accumulate_block_avx512(double* grid, size_t grid_ld, double* sampling, size_t sampling_ld, const double* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, double vis_real, double vis_imag, double vis_weight, bool conjugate_kernel);
+#endif
+}
+}
+
+#endif /* SIMD_ACCUMULATE_KERNELS_H */
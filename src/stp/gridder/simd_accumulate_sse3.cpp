@@ -0,0 +1,97 @@
+/** @file simd_accumulate_sse3.cpp
+ *  @brief Implementation of the SSE3 block-accumulate routines (compiled with -msse3).
+ */
+
+#include "simd_accumulate_kernels.h"
+
+#ifdef STP_SIMD_X86
+#include <immintrin.h>
+
+namespace stp {
+
+namespace simd {
+
+namespace {
+
+/*
+ * Complex values are stored interleaved (re, im). The weighted kernel k = (kr * w, ki * +-w) is multiplied by the
+ * visibility v = (vr, vi) using a single add-sub: (vr * kr - vi * ki, vr * ki + vi * kr) = addsub(vr * k, vi * swap(k)).
+ * The weight vector (w, +-w) also conjugates the kernel, so the same loop serves both kernel signs.
+ */
+
+// Remaining elements of a column
+inline void column_tail(float* grid, float* sampling, const float* kernel, int n, float vis_real, float vis_imag, float vis_weight, float vis_weight_imag)
+{
+    for (int i = 0; i < n; ++i) {
+        const float kr = kernel[2 * i] * vis_weight;
+        const float ki = kernel[2 * i + 1] * vis_weight_imag;
+        grid[2 * i] += vis_real * kr - vis_imag * ki;
+        grid[2 * i + 1] += vis_real * ki + vis_imag * kr;
+        if (sampling != nullptr) {
+            sampling[2 * i] += kr;
+            sampling[2 * i + 1] += ki;
+        }
+    }
+}
+
+inline void column(float* grid, float* sampling, const float* kernel, int n, float vis_real, float vis_imag, float vis_weight, float vis_weight_imag)
+{
+    const __m128 vr = _mm_set1_ps(vis_real);
+    const __m128 vi = _mm_set1_ps(vis_imag);
+    const __m128 w = _mm_setr_ps(vis_weight, vis_weight_imag, vis_weight, vis_weight_imag);
+
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128 k = _mm_mul_ps(_mm_loadu_ps(kernel + 2 * i), w);
+        const __m128 k_swap = _mm_shuffle_ps(k, k, _MM_SHUFFLE(2, 3, 0, 1));
+        const __m128 prod = _mm_addsub_ps(_mm_mul_ps(vr, k), _mm_mul_ps(vi, k_swap));
+        _mm_storeu_ps(grid + 2 * i, _mm_add_ps(_mm_loadu_ps(grid + 2 * i), prod));
+        if (sampling != nullptr) {
+            _mm_storeu_ps(sampling + 2 * i, _mm_add_ps(_mm_loadu_ps(sampling + 2 * i), k));
+        }
+    }
+    column_tail(grid + 2 * i, sampling ? sampling + 2 * i : nullptr, kernel + 2 * i, n - i, vis_real, vis_imag, vis_weight, vis_weight_imag);
+}
+
+inline void column(double* grid, double* sampling, const double* kernel, int n, double vis_real, double vis_imag, double vis_weight, double vis_weight_imag)
+{
+    const __m128d vr = _mm_set1_pd(vis_real);
+    const __m128d vi = _mm_set1_pd(vis_imag);
+    const __m128d w = _mm_setr_pd(vis_weight, vis_weight_imag);
+
+    for (int i = 0; i < n; ++i) {
+        const __m128d k = _mm_mul_pd(_mm_loadu_pd(kernel + 2 * i), w);
+        const __m128d k_swap = _mm_shuffle_pd(k, k, 1);
+        const __m128d prod = _mm_addsub_pd(_mm_mul_pd(vr, k), _mm_mul_pd(vi, k_swap));
+        _mm_storeu_pd(grid + 2 * i, _mm_add_pd(_mm_loadu_pd(grid + 2 * i), prod));
+        if (sampling != nullptr) {
+            _mm_storeu_pd(sampling + 2 * i, _mm_add_pd(_mm_loadu_pd(sampling + 2 * i), k));
+        }
+    }
+}
+
+template <typename T>
+void block(T* grid, size_t grid_ld, T* sampling, size_t sampling_ld, const T* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, T vis_real, T vis_imag, T vis_weight, bool conjugate_kernel)
+{
+    const T vis_weight_imag = conjugate_kernel ? -vis_weight : vis_weight;
+    for (int j = 0; j < n_cols; ++j) {
+        column(grid + 2 * j * grid_ld, sampling ? sampling + 2 * j * sampling_ld : nullptr, kernel + 2 * j * kernel_ld, n_rows, vis_real, vis_imag, vis_weight, vis_weight_imag);
+    }
+}
+}
+
+void accumulate_block_sse3(float* grid, size_t grid_ld, float* sampling, size_t sampling_ld, const float* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, float vis_real, float vis_imag, float vis_weight, bool conjugate_kernel)
+{
+    block(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_real, vis_imag, vis_weight, conjugate_kernel);
+}
+
+void accumulate_block_sse3(double* grid, size_t grid_ld, double* sampling, size_t sampling_ld, const double* kernel, size_t kernel_ld,
+    int n_rows, int n_cols, double vis_real, double vis_imag, double vis_weight, bool conjugate_kernel)
+{
+    block(grid, grid_ld, sampling, sampling_ld, kernel, kernel_ld, n_rows, n_cols, vis_real, vis_imag, vis_weight, conjugate_kernel);
+}
+}
+}
+#endif
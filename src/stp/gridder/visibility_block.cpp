@@ -0,0 +1,257 @@
+/**
+ * @file visibility_block.cpp
+ * @brief Implementation of the visibility block functions.
+ */
+
+#include "visibility_block.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <tbb/tbb.h>
+#include <utility>
+#include <vector>
+
+namespace stp {
+
+VisibilityBlock::VisibilityBlock(size_t num_vis, bool kernel_exact, bool store_w, bool store_conj)
+{
+    source_idx.set_size(num_vis);
+    good_vis.set_size(num_vis);
+    kernel_centre_on_grid.set_size(num_vis, 2);
+    if (kernel_exact) {
+        uv_frac.set_size(num_vis, 2);
+    } else {
+        oversampled_offset.set_size(num_vis, 2);
+    }
+    if (store_w) {
+        w_lambda.set_size(num_vis);
+    }
+    if (store_conj) {
+        vis_conj.set_size(num_vis);
+    }
+    vis_weights.set_size(num_vis);
+}
+
+void VisibilityBlock::load_visibilities(const StridedView<std::complex<double>>& input_vis)
+{
+    const size_t num_vis = size();
+    const bool conj_vis = !vis_conj.is_empty();
+    vis.set_size(num_vis);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_vis), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i < r.end(); ++i) {
+            assert(source_idx[i] < input_vis.size());
+            const std::complex<double>& val = input_vis[source_idx[i]];
+            vis[i] = cx_real_t((conj_vis && vis_conj[i]) ? std::conj(val) : val);
+        }
+    });
+}
+
+namespace {
+
+// Number of bits required to store the values in [0, max_value]
+inline uint num_bits(uint64_t max_value)
+{
+    uint bits = 0;
+    while (max_value > 0) {
+        bits++;
+        max_value >>= 1;
+    }
+    return bits;
+}
+
+// Largest values of the fields of the group key (see VisibilityGroups::VisibilityGroups)
+struct GroupKeyMax {
+    int64_t timestep = 0;
+    int64_t kc_x = 0;
+    int64_t kc_y = 0;
+    int64_t offset_x = 0;
+    int64_t offset_y = 0;
+
+    void join(const GroupKeyMax& other)
+    {
+        timestep = std::max(timestep, other.timestep);
+        kc_x = std::max(kc_x, other.kc_x);
+        kc_y = std::max(kc_y, other.kc_y);
+        offset_x = std::max(offset_x, other.offset_x);
+        offset_y = std::max(offset_y, other.offset_y);
+    }
+};
+}
+
+VisibilityGroups::VisibilityGroups(const VisibilityBlock& vis_block, const arma::uvec& _plane_firstidx, const arma::ivec& _vis_timesteps)
+{
+    const arma::uword num_vis = vis_block.size();
+    assert(vis_block.oversampled_offset.n_rows == num_vis);
+    assert(_vis_timesteps.is_empty() || (_vis_timesteps.n_elem == num_vis));
+    const bool use_timesteps = !_vis_timesteps.is_empty();
+    const bool use_w = !vis_block.w_lambda.is_empty();
+
+    // W-plane ranges of the visibility block (a single plane if not given)
+    arma::uvec plane_begin = _plane_firstidx;
+    if (plane_begin.is_empty()) {
+        plane_begin.zeros(1);
+    }
+    const size_t num_planes = plane_begin.n_elem;
+
+    // Visibilities are processed in fixed-size chunks (as in GridAccumulator::prepare)
+    const arma::uword chunk_size = VISIBILITY_BLOCK_CHUNK_SIZE;
+    const size_t num_chunks = size_t((num_vis + chunk_size - 1) / chunk_size);
+
+    // Bit widths of the key fields, from the largest values of the fields (all of them are non-negative)
+    const GroupKeyMax key_max = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, num_vis), GroupKeyMax(),
+        [&](const tbb::blocked_range<size_t>& r, GroupKeyMax key_max) {
+            for (size_t vi = r.begin(); vi < r.end(); ++vi) {
+                assert(!use_timesteps || (_vis_timesteps[vi] >= 0));
+                assert((vis_block.kernel_centre_on_grid.at(vi, 0) >= 0) && (vis_block.kernel_centre_on_grid.at(vi, 1) >= 0));
+                assert((vis_block.oversampled_offset.at(vi, 0) >= 0) && (vis_block.oversampled_offset.at(vi, 1) >= 0));
+                assert(vis_block.good_vis[vi] < 4);
+                GroupKeyMax vis_max;
+                vis_max.timestep = use_timesteps ? int64_t(_vis_timesteps[vi]) : 0;
+                vis_max.kc_x = vis_block.kernel_centre_on_grid.at(vi, 0);
+                vis_max.kc_y = vis_block.kernel_centre_on_grid.at(vi, 1);
+                vis_max.offset_x = vis_block.oversampled_offset.at(vi, 0);
+                vis_max.offset_y = vis_block.oversampled_offset.at(vi, 1);
+                key_max.join(vis_max);
+            }
+            return key_max;
+        },
+        [](GroupKeyMax a, const GroupKeyMax& b) {
+            a.join(b);
+            return a;
+        });
+    const uint offset_y_bits = num_bits(uint64_t(key_max.offset_y));
+    const uint offset_x_bits = num_bits(uint64_t(key_max.offset_x));
+    const uint kc_y_bits = num_bits(uint64_t(key_max.kc_y));
+    const uint kc_x_bits = num_bits(uint64_t(key_max.kc_x));
+    const uint w_sign_bits = 1;
+    const uint good_vis_bits = 2;
+    const uint timestep_bits = num_bits(uint64_t(key_max.timestep));
+    const uint plane_bits = num_bits(uint64_t(num_planes - 1));
+    if ((plane_bits + timestep_bits + good_vis_bits + w_sign_bits + kc_x_bits + kc_y_bits + offset_x_bits + offset_y_bits) > 64) {
+        throw std::runtime_error("Coalesced gridder: the visibility group key does not fit in 64 bits");
+    }
+
+    // Visibilities with the same key receive an identical convolution kernel. The key packs (from the most significant
+    // bits) the W-plane, the A-projection timestep, the number of gridded copies, the sign of w, the kernel centre and
+    // the oversampled kernel offsets, so that sorting by key sorts the visibilities by W-plane first.
+    std::vector<std::pair<uint64_t, arma::uword>> sorted_keys(num_vis);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_vis), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t vi = r.begin(); vi < r.end(); ++vi) {
+            const uint64_t plane = uint64_t(std::upper_bound(plane_begin.begin(), plane_begin.end(), arma::uword(vi)) - plane_begin.begin() - 1);
+            uint64_t key = plane;
+            key = (key << timestep_bits) | (use_timesteps ? uint64_t(_vis_timesteps[vi]) : 0);
+            key = (key << good_vis_bits) | uint64_t(vis_block.good_vis[vi]);
+            key = (key << w_sign_bits) | ((use_w && (vis_block.w_lambda[vi] < 0.0)) ? 1 : 0);
+            key = (key << kc_x_bits) | uint64_t(vis_block.kernel_centre_on_grid.at(vi, 0));
+            key = (key << kc_y_bits) | uint64_t(vis_block.kernel_centre_on_grid.at(vi, 1));
+            key = (key << offset_x_bits) | uint64_t(vis_block.oversampled_offset.at(vi, 0));
+            key = (key << offset_y_bits) | uint64_t(vis_block.oversampled_offset.at(vi, 1));
+            sorted_keys[vi] = std::make_pair(key, arma::uword(vi));
+        }
+    });
+
+    // Sort the visibilities by group key (ties are kept in visibility order)
+    tbb::parallel_sort(sorted_keys.begin(), sorted_keys.end());
+
+    // A group starts at every change of key
+    auto group_start = [&](arma::uword i) {
+        return (i == 0) || (sorted_keys[i - 1].first != sorted_keys[i].first);
+    };
+
+    // Count the groups starting in each chunk, then compute the index of the first group of each chunk
+    std::vector<arma::uword> chunk_groups(num_chunks + 1, 0);
+    members.set_size(num_vis);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_chunks), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t c = r.begin(); c < r.end(); ++c) {
+            const arma::uword i_end = std::min(num_vis, arma::uword(c + 1) * chunk_size);
+            arma::uword count = 0;
+            for (arma::uword i = c * chunk_size; i < i_end; ++i) {
+                members[i] = sorted_keys[i].second;
+                if (group_start(i))
+                    count++;
+            }
+            chunk_groups[c + 1] = count;
+        }
+    });
+    for (size_t c = 0; c < num_chunks; ++c) {
+        chunk_groups[c + 1] += chunk_groups[c];
+    }
+    const arma::uword num_groups = chunk_groups[num_chunks];
+
+    block = VisibilityBlock(num_groups, false, use_w, false);
+    member_offsets.set_size(num_groups + 1);
+    member_offsets[num_groups] = num_vis;
+    if (use_timesteps) {
+        vis_timesteps.set_size(num_groups);
+    }
+
+    // Fill the coalesced block: the placement of a group is that of its first member
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_chunks), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t c = r.begin(); c < r.end(); ++c) {
+            const arma::uword i_end = std::min(num_vis, arma::uword(c + 1) * chunk_size);
+            arma::uword g = chunk_groups[c];
+            for (arma::uword i = c * chunk_size; i < i_end; ++i) {
+                if (!group_start(i))
+                    continue;
+                const arma::uword vi = members[i];
+                member_offsets[g] = i;
+                block.source_idx[g] = vis_block.source_idx[vi];
+                block.good_vis[g] = vis_block.good_vis[vi];
+                block.kernel_centre_on_grid.at(g, 0) = vis_block.kernel_centre_on_grid.at(vi, 0);
+                block.kernel_centre_on_grid.at(g, 1) = vis_block.kernel_centre_on_grid.at(vi, 1);
+                block.oversampled_offset.at(g, 0) = vis_block.oversampled_offset.at(vi, 0);
+                block.oversampled_offset.at(g, 1) = vis_block.oversampled_offset.at(vi, 1);
+                if (use_w) {
+                    block.w_lambda[g] = vis_block.w_lambda[vi];
+                }
+                if (use_timesteps) {
+                    vis_timesteps[g] = _vis_timesteps[vi];
+                }
+                g++;
+            }
+            assert(g == chunk_groups[c + 1]);
+        }
+    });
+
+    // The weight of a group is the sum of the (non-negative) weights of its members
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_groups), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t g = r.begin(); g < r.end(); ++g) {
+            double weights_sum = 0.0;
+            for (arma::uword i = member_offsets[g]; i < member_offsets[g + 1]; i++) {
+                assert(vis_block.vis_weights[members[i]] >= 0.0);
+                weights_sum += vis_block.vis_weights[members[i]];
+            }
+            block.vis_weights[g] = weights_sum;
+        }
+    });
+
+    // Index of the first group of each W-plane (W-planes start a new group, since the plane is part of the key)
+    plane_firstidx.set_size(num_planes);
+    for (size_t pi = 0; pi < num_planes; pi++) {
+        plane_firstidx[pi] = arma::uword(std::lower_bound(member_offsets.begin(), member_offsets.end(), plane_begin[pi]) - member_offsets.begin());
+    }
+}
+
+void VisibilityGroups::load_visibilities(const VisibilityBlock& vis_block)
+{
+    assert(vis_block.vis.n_elem == members.n_elem);
+    const arma::uword num_groups = block.size();
+    block.vis.set_size(num_groups);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_groups), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t g = r.begin(); g < r.end(); ++g) {
+            std::complex<double> weighted_sum(0.0, 0.0);
+            for (arma::uword i = member_offsets[g]; i < member_offsets[g + 1]; i++) {
+                const arma::uword vi = members[i];
+                weighted_sum += std::complex<double>(vis_block.vis[vi]) * vis_block.vis_weights[vi];
+            }
+            // Weighted mean of the visibilities (the weight of the group is the sum of the weights). Weights must be
+            // non-negative (asserted when the groups are built), so a group of zero weight only holds zero-weight visibilities
+            const double weights_sum = block.vis_weights[g];
+            block.vis[g] = cx_real_t((weights_sum > 0.0) ? (weighted_sum / weights_sum) : std::complex<double>(0.0, 0.0));
+        }
+    });
+}
+}
@@ -0,0 +1,163 @@
+/** @file visibility_block.h
+ *  @brief Classes and function prototypes of the visibility block.
+ */
+
+#ifndef VISIBILITY_BLOCK_H
+#define VISIBILITY_BLOCK_H
+
+#include "../common/strided_view.h"
+#include "../types.h"
+#include <armadillo>
+
+// Number of visibilities processed by each task when the visibility block is filled
+#ifndef VISIBILITY_BLOCK_CHUNK_SIZE
+#define VISIBILITY_BLOCK_CHUNK_SIZE 4096
+#endif
+
+namespace stp {
+
+/**
+ * @brief The VisibilityBlock class
+ *
+ * Structure-of-arrays storage of the visibilities to be gridded, in gridding order (sorted by the module of w when
+ * W-projection is used). Visibilities that fall outside the grid are compacted away when the block is filled
+ * (see GridAccumulator::prepare), so every entry is gridded. Each array stores one field of all visibilities
+ * contiguously; the 2-column matrices store the x and y components in consecutive columns.
+ */
+class VisibilityBlock {
+public:
+    /**
+     * @brief Default constructor (empty block)
+     */
+    VisibilityBlock() = default;
+
+    /**
+     * @brief VisibilityBlock constructor. Allocates the arrays (values are not initialized).
+     *
+     * @param[in] num_vis (size_t): Number of visibilities.
+     * @param[in] kernel_exact (bool): Store sub-pixel offsets (exact gridder) instead of oversampled kernel offsets.
+     * @param[in] store_w (bool): Store the W-coordinates (W-projection or W-stacking).
+     * @param[in] store_conj (bool): Store the conjugation flags (halfplane gridding or W-stacking).
+     */
+    VisibilityBlock(size_t num_vis, bool kernel_exact, bool store_w, bool store_conj);
+
+    /**
+     * @brief Number of visibilities
+     */
+    size_t size() const
+    {
+        return good_vis.n_elem;
+    }
+
+    /**
+     * @brief Gather the complex visibilities in gridding order (conjugating those moved to a symmetric position, see vis_conj).
+     *
+     * @param[in] input_vis (StridedView<std::complex<double>>): Complex visibilities, in input order.
+     */
+    void load_visibilities(const StridedView<std::complex<double>>& input_vis);
+
+    /**
+     * Index of each visibility in the input data
+     */
+    arma::uvec source_idx;
+    /**
+     * Identifies visibilities moved to the bottom half-plane (or to positive w, when W-stacking is used), which are conjugated.
+     * Empty if neither halfplane gridding nor W-stacking are used.
+     */
+    arma::Col<uint> vis_conj;
+    /**
+     * Number of times each visibility is gridded (1 - grid, 2 - grid also conjugate)
+     */
+    arma::Col<uint> good_vis;
+    /**
+     * Kernel centre positions on the grid
+     */
+    arma::Mat<int> kernel_centre_on_grid;
+    /**
+     * Sub-pixel offsets of the visibilities (exact gridder only)
+     */
+    arma::mat uv_frac;
+    /**
+     * Oversampled kernel indexes (oversampled gridder only)
+     */
+    arma::Mat<int> oversampled_offset;
+    /**
+     * W-coordinates of the visibilities (W-projection or W-stacking only)
+     */
+    arma::vec w_lambda;
+    /**
+     * Visibility weights
+     */
+    arma::vec vis_weights;
+    /**
+     * Complex visibilities (see load_visibilities)
+     */
+    arma::Col<cx_real_t> vis;
+};
+
+/**
+ * @brief The VisibilityGroups class
+ *
+ * Coalesced visibilities (oversampled gridder only). Visibilities of the same W-plane (and A-projection timestep)
+ * that share the kernel centre, the oversampled kernel offsets, the number of gridded copies and the sign of w
+ * receive an identical convolution kernel, so they are summed into a single entry of the coalesced block before
+ * gridding. Each entry stores the sum of the weights and the weighted mean of the visibilities of its group, hence
+ * gridding the coalesced block is equivalent (up to floating-point reassociation) to gridding all visibilities.
+ * Visibility weights must be non-negative (the visibilities of a group of zero weight are gridded as zero).
+ */
+class VisibilityGroups {
+public:
+    /**
+     * @brief Default constructor (no coalescing)
+     */
+    VisibilityGroups() = default;
+
+    /**
+     * @brief VisibilityGroups constructor. Groups the visibilities of a visibility block (visibility values are not used).
+     *
+     * The visibilities are sorted by a packed integer key (W-plane, timestep, number of gridded copies, sign of w,
+     * kernel centre and oversampled offsets) using a parallel sort. Throws std::runtime_error if the key does not fit in 64 bits.
+     *
+     * @param[in] vis_block (VisibilityBlock): Visibilities to be gridded (oversampled gridder).
+     * @param[in] plane_firstidx (arma::uvec): Index of the first visibility of each W-plane (may be empty if there is a single plane).
+     * @param[in] vis_timesteps (arma::ivec): A-projection timestep of each visibility (may be empty).
+     */
+    VisibilityGroups(const VisibilityBlock& vis_block, const arma::uvec& plane_firstidx, const arma::ivec& vis_timesteps);
+
+    /**
+     * @brief Indicates whether the visibilities are not coalesced
+     */
+    bool is_empty() const
+    {
+        return member_offsets.is_empty();
+    }
+
+    /**
+     * @brief Sum the visibilities of each group into the coalesced block.
+     *
+     * @param[in] vis_block (VisibilityBlock): Visibility block used to compute the groups, with loaded visibilities.
+     */
+    void load_visibilities(const VisibilityBlock& vis_block);
+
+    /**
+     * Coalesced visibilities (one entry per group)
+     */
+    VisibilityBlock block;
+    /**
+     * Index of the first group of each W-plane
+     */
+    arma::uvec plane_firstidx;
+    /**
+     * A-projection timestep of each group (empty if not used)
+     */
+    arma::ivec vis_timesteps;
+    /**
+     * Members of each group (indexes of the visibility block): members of group g are stored from position member_offsets[g]
+     * to position member_offsets[g + 1] (not included)
+     */
+    arma::uvec member_offsets;
+    arma::uvec members;
+};
+}
+
+#endif /* VISIBILITY_BLOCK_H */
@@ -10,6 +10,45 @@ namespace stp {
 std::vector<std::chrono::high_resolution_clock::time_point> times_iv;
 std::vector<std::chrono::duration<double>> times_gridder;
 
+void check_imager_pars(const ImagerPars& img_pars, const W_ProjectionPars& w_proj, const A_ProjectionPars& a_proj)
+{
+    assert(img_pars.padding_factor >= 1.0);
+    assert(img_pars.padded_image_size >= img_pars.image_size);
+    assert(img_pars.kernel_exact || (img_pars.oversampling >= 1)); // If kernel exact is false, then oversampling must be >= 1
+    assert(img_pars.padded_image_size > 0);
+    assert(ispowerof2(img_pars.padded_image_size)); // Image size must be power of two. Also parallel complex2real FFTW function only works with image sizes multiple of 4.
+    assert(img_pars.kernel_support > 0);
+    assert(img_pars.cell_size > 0.0);
+#ifdef WPROJECTION
+    if (w_proj.num_wplanes > 0) {
+        assert(w_proj.isEnabled());
+    }
+    // W-stacking applies the w-term in the image domain, hence it cannot be combined with A-projection
+    if (w_proj.isEnabled() && w_proj.w_stacking) {
+        assert(!a_proj.isEnabled());
+        if (a_proj.isEnabled())
+            throw std::runtime_error("A-projection cannot be used when W-stacking is enabled.");
+    }
+#else
+    assert(!w_proj.isEnabled());
+#endif
+#ifdef APROJECTION
+    // A-proj can be used only with W-proj enabled
+    if (a_proj.num_timesteps > 0) {
+        assert(a_proj.isEnabled());
+        assert(w_proj.isEnabled());
+        assert(!w_proj.hankel_opt);
+        if (!w_proj.isEnabled())
+            throw std::runtime_error("W-projection must be used when A-projection is enabled.");
+        if (w_proj.hankel_opt)
+            throw std::runtime_error("Hankel transform cannot be used when A-projection is enabled.");
+    }
+#else
+    assert(!a_proj.isEnabled());
+#endif
+    assert(!(img_pars.kernel_exact && (w_proj.isEnabled()))); // W-proj cannot be used when 'kernel_exact' is true.
+}
+
 ImageVisibilities::ImageVisibilities(
     const arma::cx_mat& vis,
     const arma::mat& vis_weights,
@@ -67,4 +106,38 @@ ImageVisibilities::ImageVisibilities(
     vis_grid = std::move(result.first);
     sampling_grid = std::move(result.second);
 }
+
+ImageVisibilities::ImageVisibilities(const arma::cx_mat& vis, ImagingPlan& plan)
+{
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = plan.image(vis);
+
+    vis_grid = std::move(result.first);
+    sampling_grid = std::move(result.second);
+}
+
+std::unique_ptr<ImagingPlan> ImageVisibilities::make_plan(
+    const arma::mat& vis_weights,
+    const arma::mat& uvw_lambda,
+    const ImagerPars& img_pars,
+    const W_ProjectionPars& w_proj,
+    const A_ProjectionPars& a_proj)
+{
+    switch (img_pars.kernel_function) {
+    case stp::KernelFunction::TopHat:
+        return std::make_unique<KernelImagingPlan<stp::TopHat>>(stp::TopHat(img_pars.kernel_support), vis_weights, uvw_lambda, img_pars, w_proj, a_proj);
+    case stp::KernelFunction::Triangle:
+        return std::make_unique<KernelImagingPlan<stp::Triangle>>(stp::Triangle(img_pars.kernel_support), vis_weights, uvw_lambda, img_pars, w_proj, a_proj);
+    case stp::KernelFunction::Sinc:
+        return std::make_unique<KernelImagingPlan<stp::Sinc>>(stp::Sinc(img_pars.kernel_support), vis_weights, uvw_lambda, img_pars, w_proj, a_proj);
+    case stp::KernelFunction::Gaussian:
+        return std::make_unique<KernelImagingPlan<stp::Gaussian>>(stp::Gaussian(img_pars.kernel_support), vis_weights, uvw_lambda, img_pars, w_proj, a_proj);
+    case stp::KernelFunction::GaussianSinc:
+        return std::make_unique<KernelImagingPlan<stp::GaussianSinc>>(stp::GaussianSinc(img_pars.kernel_support), vis_weights, uvw_lambda, img_pars, w_proj, a_proj);
+    case stp::KernelFunction::PSWF:
+        return std::make_unique<KernelImagingPlan<stp::PSWF>>(stp::PSWF(img_pars.kernel_support), vis_weights, uvw_lambda, img_pars, w_proj, a_proj);
+    default:
+        assert(0);
+        throw std::runtime_error("Unknown kernel function.");
+    }
+}
 }
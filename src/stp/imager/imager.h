@@ -12,13 +12,75 @@
 #include "../gridder/gridder.h"
 #include "../types.h"
 #include <fftw3.h>
+#include <memory>
 #include <thread>
 
 namespace stp {
 
+/**
+ * @brief Crops, normalises and applies the gridding correction to an (unshifted) FFT result in a single pass.
+ *
+ * The quadrants of the cropped image are on the corners of the padded image. The gridding correction is separable, hence it is
+ * applied as the product of the reciprocal correction factors of the row and column. The result may be written in place when
+ * the image is not cropped (same matrix and column stride).
+ *
+ * @param[in] fft_result (real_t*): FFT result (padded image), in column-major order.
+ * @param[in] col_stride (size_t): Distance between the columns of the FFT result.
+ * @param[out] norm_result (real_t*): Normalised image (image_size x image_size), in column-major order.
+ * @param[in] padded_image_size (size_t): Width of the padded image in pixels.
+ * @param[in] image_size (size_t): Width of the image in pixels.
+ * @param[in] normalization_factor (real_t): Normalization factor computed from sampling grid.
+ * @param[in] fft_1D_array (arma::Col): Image-domain kernel of the gridding correction (padded_image_size values).
+ */
+template <bool grid_correction>
+void crop_normalise_result(
+    const real_t* fft_result,
+    const size_t col_stride,
+    real_t* norm_result,
+    const size_t padded_image_size,
+    const size_t image_size,
+    const real_t normalization_factor,
+    const arma::Col<real_t>& fft_1D_array)
+{
+    const size_t half_padded_image_size = padded_image_size / 2;
+    const size_t half_image_size = image_size / 2;
+    // Cropped pixels [half_image_size, image_size) are read from the end of the padded image
+    const size_t crop_offset = padded_image_size - image_size;
+
+    // Reciprocal gridding correction of the cropped pixels
+    arma::Col<real_t> correction(image_size);
+    for (size_t x = 0; x < image_size; ++x) {
+        if (grid_correction) {
+            const size_t gcf_x = (x < half_image_size) ? (half_padded_image_size + x) : (half_padded_image_size + x - image_size);
+            correction[x] = real_t(1.0) / fft_1D_array[gcf_x];
+        } else {
+            correction[x] = real_t(1.0);
+        }
+    }
+    const real_t* row_correction = correction.memptr();
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, image_size), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t j = r.begin(); j < r.end(); ++j) {
+            const size_t orig_j = (j < half_image_size) ? j : (crop_offset + j);
+            const real_t* col = fft_result + orig_j * col_stride;
+            real_t* norm_col = norm_result + j * image_size;
+            const real_t col_factor = normalization_factor * row_correction[j];
+            for (size_t i = 0; i < half_image_size; ++i) {
+                norm_col[i] = col[i] * col_factor * row_correction[i];
+            }
+            for (size_t i = half_image_size; i < image_size; ++i) {
+                norm_col[i] = col[crop_offset + i] * col_factor * row_correction[i];
+            }
+        }
+    });
+}
+
 /**
  * @brief Normalizes the result image and beam.
  *
+ * Crop, normalisation and gridding correction are done in a single pass (see crop_normalise_result). When the image is not
+ * padded, the image and beam matrices are normalised in place and moved to the result matrices.
+ *
  * @param[in] image_mat (std::pair<arma::mat): Image matrix.
  * @param[in] beam_mat (std::pair<arma::mat): Beam model matrix.
  * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel.
@@ -42,8 +104,6 @@ void normalise_image_beam_result_1D(
     const bool generate_beam = false,
     FFTRoutine r_fft = FFTRoutine::FFTW_ESTIMATE_FFT)
 {
-    size_t half_padded_image_size = padded_image_size / 2;
-
     // generate ImgDomKernel
     arma::Col<real_t> fft_1D_array;
     if (grid_correction) {
@@ -52,6 +112,7 @@ void normalise_image_beam_result_1D(
 
     // normalisation
 #ifdef FFTSHIFT
+    size_t half_padded_image_size = padded_image_size / 2;
     norm_image.set_size(image_size, image_size);
     tbb::parallel_for(tbb::blocked_range<size_t>(0, image_size),
         [&](const tbb::blocked_range<size_t>& r) {
@@ -94,136 +155,370 @@ void normalise_image_beam_result_1D(
         beam_mat.reset();
     }
 #else
-    norm_image.set_size(image_size, image_size);
+    // A padded real matrix of the exact image size is normalised in place, otherwise the cropped image is copied while normalised
+    if ((image_size == padded_image_size) && (image_mat.n_rows == padded_image_size)) {
+        crop_normalise_result<grid_correction>(image_mat.memptr(), image_mat.n_rows, image_mat.memptr(), padded_image_size, image_size,
+            normalization_factor, fft_1D_array);
+        norm_image = std::move(image_mat);
+    } else {
+        norm_image.set_size(image_size, image_size);
+        crop_normalise_result<grid_correction>(image_mat.memptr(), image_mat.n_rows, norm_image.memptr(), padded_image_size, image_size,
+            normalization_factor, fft_1D_array);
+    }
+    image_mat.reset();
 
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, image_size / 2),
-        [&](const tbb::blocked_range<size_t>& r) {
-            size_t j_begin = r.begin(),
-                   j_end = r.end();
-            for (size_t j = j_begin; j < j_end; ++j) {
-                size_t jj = j + half_padded_image_size;
-                size_t ii = half_padded_image_size;
-                for (size_t i = 0; i < (image_size / 2); ++i, ++ii) {
-                    if (grid_correction) {
-                        norm_image.at(i, j) = image_mat(i, j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                    } else {
-                        norm_image.at(i, j) = image_mat(i, j) * normalization_factor;
-                    }
+    // Beam is optional
+    if (generate_beam) {
+        if ((image_size == padded_image_size) && (beam_mat.n_rows == padded_image_size)) {
+            crop_normalise_result<grid_correction>(beam_mat.memptr(), beam_mat.n_rows, beam_mat.memptr(), padded_image_size, image_size,
+                normalization_factor, fft_1D_array);
+            norm_beam = std::move(beam_mat);
+        } else {
+            norm_beam.set_size(image_size, image_size);
+            crop_normalise_result<grid_correction>(beam_mat.memptr(), beam_mat.n_rows, norm_beam.memptr(), padded_image_size, image_size,
+                normalization_factor, fft_1D_array);
+        }
+        beam_mat.reset();
+    }
+#endif
+}
+
+/**
+ * @brief Crops and normalizes the result of the pruned c2r FFT (see fft_fftw_c2r_pruned).
+ *
+ * The cropped image is read from the real values stored in the transformed columns of the matrix, hence crop, normalisation
+ * and gridding correction are done in a single pass (see crop_normalise_result).
+ *
+ * @param[in] fft_result (arma::Mat): Complex matrix transformed by the pruned c2r FFT.
+ * @param[out] norm_mat (arma::Mat): Normalised image matrix (image_size x image_size).
+ * @param[in] fft_1D_array (arma::Col): Image-domain kernel of the gridding correction (padded_image_size values).
+ * @param[in] image_size (int): Width of the image in pixels.
+ * @param[in] normalization_factor (real_t): Normalization factor computed from sampling grid.
+ */
+template <bool grid_correction>
+void normalise_pruned_result(
+    const arma::Mat<cx_real_t>& fft_result,
+    arma::Mat<real_t>& norm_mat,
+    const arma::Col<real_t>& fft_1D_array,
+    const size_t image_size,
+    const real_t normalization_factor)
+{
+    // The real values of each transformed column are stored from the start of the column
+    norm_mat.set_size(image_size, image_size);
+    crop_normalise_result<grid_correction>(reinterpret_cast<const real_t*>(fft_result.memptr()), 2 * fft_result.n_rows, norm_mat.memptr(),
+        fft_result.n_cols, image_size, normalization_factor, fft_1D_array);
+}
+
+/**
+ * @brief Checks the imager, W-projection and A-projection parameters.
+ *
+ * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+ * @param[in] w_proj (W_ProjectionPars): W-projection parameters (see W_ProjectionPars struct).
+ * @param[in] a_proj (A_ProjectionPars): A-projection parameters (see A_ProjectionPars struct).
+ */
+void check_imager_pars(const ImagerPars& img_pars, const W_ProjectionPars& w_proj, const A_ProjectionPars& a_proj);
+
+/**
+ * @brief Scale factor that converts UV-coordinates from multiples of wavelength to (fractional) pixels of the UV-grid.
+ *
+ * @param[in] cell_size (double): Angular-width of a synthesized pixel in the image (arcsecond).
+ * @param[in] padded_image_size (int): Width of the padded image in pixels.
+ *
+ * @return (double): UV-grid pixels per wavelength.
+ */
+inline double uv_lambda_to_pixel_scale(double cell_size, int padded_image_size)
+{
+    return arc_sec_to_rad(cell_size) * double(padded_image_size);
+}
+
+/**
+ * @brief Normalises the image and beam matrices given by the iFFT of the gridded visibilities and applies the gridding correction.
+ *
+ * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel (used for gridding correction).
+ * @param[in,out] fft_result_image (arma::mat): Image matrix (released).
+ * @param[in,out] fft_result_beam (arma::mat): Beam matrix (released).
+ * @param[in] sample_grid_total (double): Total sampling grid sum.
+ * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+ *
+ * @return (std::pair<arma::mat, arma::mat>): Two matrices representing the normalised image map and beam model (image, beam).
+ */
+template <typename T>
+std::pair<arma::Mat<real_t>, arma::Mat<real_t>> normalise_imaging_result(
+    const T& kernel_creator,
+    arma::Mat<real_t>& fft_result_image,
+    arma::Mat<real_t>& fft_result_beam,
+    double sample_grid_total,
+    const ImagerPars& img_pars)
+{
+    arma::Mat<real_t> norm_result_image;
+    arma::Mat<real_t> norm_result_beam;
+    if (sample_grid_total > 0.0) {
+        real_t normalization_factor = 1.0 / (sample_grid_total);
+        if (img_pars.gridding_correction == true) {
+            normalise_image_beam_result_1D<true>(fft_result_image, fft_result_beam, norm_result_image, norm_result_beam, kernel_creator, img_pars.padded_image_size,
+                img_pars.image_size, normalization_factor, img_pars.analytic_gcf, img_pars.generate_beam, img_pars.r_fft);
+        } else {
+            normalise_image_beam_result_1D<false>(fft_result_image, fft_result_beam, norm_result_image, norm_result_beam, kernel_creator, img_pars.padded_image_size,
+                img_pars.image_size, normalization_factor, img_pars.analytic_gcf, img_pars.generate_beam, img_pars.r_fft);
+        }
+    }
+
+    return std::make_pair(std::move(norm_result_image), std::move(norm_result_beam));
+}
+
+/**
+ * @brief Generates the cropped image and beam data from gridded visibilities of a padded grid, using the pruned c2r FFT.
+ *
+ * The iFFT only computes the columns of the padded image that are kept by the crop (see fft_fftw_c2r_pruned), in place.
+ * The cropped image and beam are then normalised from the transformed grids, without intermediate padded real matrices.
+ *
+ * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel (used for gridding correction).
+ * @param[in,out] gridded_data (GridderOutput): Gridded visibilities. Grids are released.
+ * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+ *
+ * @return (std::pair<arma::mat, arma::mat>): Two matrices representing the generated image map and beam model (image, beam).
+ */
+template <typename T>
+std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_gridded_visibilities_pruned(
+    const T& kernel_creator,
+    GridderOutput& gridded_data,
+    const ImagerPars& img_pars)
+{
+    const bool generate_beam = img_pars.generate_beam;
+    const FFTRoutine r_fft = img_pars.r_fft;
+
+    // Run pruned iFFT over convolved matrices
+    fft_fftw_c2r_pruned(gridded_data.vis_grid, img_pars.image_size, r_fft);
+    if (generate_beam) {
+        fft_fftw_c2r_pruned(gridded_data.sampling_grid, img_pars.image_size, r_fft);
+    }
+    TIMESTAMP_IMAGER
+
+    // Crop, normalisation and convolution kernel correction
+    arma::Mat<real_t> norm_result_image;
+    arma::Mat<real_t> norm_result_beam;
+    if (gridded_data.sample_grid_total > 0.0) {
+        real_t normalization_factor = 1.0 / (gridded_data.sample_grid_total);
+        arma::Col<real_t> fft_1D_array;
+        if (img_pars.gridding_correction) {
+            fft_1D_array = ImgDomKernel(kernel_creator, img_pars.padded_image_size, false, img_pars.analytic_gcf, r_fft);
+            normalise_pruned_result<true>(gridded_data.vis_grid, norm_result_image, fft_1D_array, img_pars.image_size, normalization_factor);
+        } else {
+            normalise_pruned_result<false>(gridded_data.vis_grid, norm_result_image, fft_1D_array, img_pars.image_size, normalization_factor);
+        }
+        gridded_data.vis_grid.reset();
+
+        // Beam is optional
+        if (generate_beam) {
+            if (img_pars.gridding_correction) {
+                normalise_pruned_result<true>(gridded_data.sampling_grid, norm_result_beam, fft_1D_array, img_pars.image_size, normalization_factor);
+            } else {
+                normalise_pruned_result<false>(gridded_data.sampling_grid, norm_result_beam, fft_1D_array, img_pars.image_size, normalization_factor);
+            }
+        }
+    }
+    gridded_data.vis_grid.reset();
+    gridded_data.sampling_grid.reset();
+
+    TIMESTAMP_IMAGER
+
+    return std::make_pair(std::move(norm_result_image), std::move(norm_result_beam));
+}
+
+/**
+ * @brief Generates image and beam data from gridded visibilities.
+ *
+ * Applies ifft to the visibility and sampling grids and normalises the results. This is the stage that follows the
+ * gridding of all visibilities, e.g. when these are accumulated in chunks using the GridAccumulator class.
+ * FFTW threads must be initialised beforehand (see init_fftw).
+ *
+ * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel (used for gridding correction).
+ * @param[in,out] gridded_data (GridderOutput): Gridded visibilities. Grids are released (or reused by the in-place FFT).
+ * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+ *
+ * @return (std::pair<arma::mat, arma::mat>): Two matrices representing the generated image map and beam model (image, beam).
+ */
+template <typename T>
+std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_gridded_visibilities(
+    const T& kernel_creator,
+    GridderOutput& gridded_data,
+    const ImagerPars& img_pars = ImagerPars())
+{
+    bool generate_beam = img_pars.generate_beam;
+    FFTRoutine r_fft = img_pars.r_fft;
+
+#ifndef FFTSHIFT
+    // Padded image: only the columns of the cropped image are transformed (in the gridded data buffers)
+    if ((img_pars.padded_image_size > img_pars.image_size) && (r_fft != stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT)) {
+        return image_gridded_visibilities_pruned(kernel_creator, gridded_data, img_pars);
+    }
+#endif
+
+    arma::Mat<real_t> fft_result_image;
+    arma::Mat<real_t> fft_result_beam;
+
+    // Reuse gridded_data buffer if FFT is INPLACE
+    if (r_fft == stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
+        fft_result_image = std::move(arma::Mat<real_t>(reinterpret_cast<real_t*>(gridded_data.vis_grid.memptr()), (gridded_data.vis_grid.n_rows) * 2, gridded_data.vis_grid.n_cols, false, false));
+        fft_result_beam = std::move(arma::Mat<real_t>(reinterpret_cast<real_t*>(gridded_data.sampling_grid.memptr()), (gridded_data.sampling_grid.n_rows) * 2, gridded_data.sampling_grid.n_cols, false, false));
+    }
+
+    // Run iFFT over convolved matrices
+    // First: FFT of image matrix
+    fft_fftw_c2r(gridded_data.vis_grid, fft_result_image, r_fft);
+    // Delete gridded image matrix (only if FFT is not inplace)
+    if (r_fft != stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
+        gridded_data.vis_grid.reset();
+    }
+#ifdef FFTSHIFT
+    fftshift(fft_result_image);
+#endif
+
+    // Second: FFT of beam matrix (optional)
+    if (generate_beam) {
+        fft_fftw_c2r(gridded_data.sampling_grid, fft_result_beam, r_fft);
+        // Delete gridded beam matrix (only if FFT is not inplace)
+        if (r_fft != stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
+            gridded_data.sampling_grid.reset();
+        }
+#ifdef FFTSHIFT
+        fftshift(fft_result_beam);
+#endif
+    }
+    TIMESTAMP_IMAGER
+
+    // Normalisation and convolution kernel correction
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = normalise_imaging_result(kernel_creator, fft_result_image, fft_result_beam,
+        gridded_data.sample_grid_total, img_pars);
+
+    TIMESTAMP_IMAGER
+
+    return result;
+}
+
+/**
+ * @brief Generates image and beam data from views of the input visibilities, using W-stacking.
+ *
+ * Visibilities are divided into w-planes (those with negative w are moved to the symmetric position and conjugated).
+ * Each w-plane is gridded on the full grid with the AA-kernel and transformed by a c2c iFFT. The w-term of the plane
+ * is then applied in the image domain and the real part of the result is accumulated into the image. This avoids
+ * the generation of W-kernels and the wide kernel supports of W-projection, at the cost of one iFFT per w-plane.
+ * The beam is obtained from the sampling grid of all w-planes. FFTW threads must be initialised beforehand (see init_fftw).
+ *
+ * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel.
+ * @param[in] vis_data (VisibilityView): Views of the UVW-coordinates (multiples of wavelength), complex visibilities and weights.
+ * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+ * @param[in] w_proj (W_ProjectionPars): W-projection parameters, W-stacking must be enabled (see W_ProjectionPars struct).
+ *
+ * @return (std::pair<arma::mat, arma::mat>): Two matrices representing the generated image map and beam model (image, beam).
+ */
+template <bool generateBeam, typename T>
+std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_wstacked_visibilities(
+    const T& kernel_creator,
+    const VisibilityView& vis_data,
+    const ImagerPars& img_pars,
+    const W_ProjectionPars& w_proj)
+{
+    assert(w_proj.isEnabled() && w_proj.w_stacking);
+
+    const int padded_image_size = img_pars.padded_image_size;
+    const size_t n = size_t(padded_image_size);
+    const FFTRoutine r_fft = img_pars.r_fft;
+
+    // Grid the full plane of each w-plane (halfplane gridding is not used)
+    const bool shift_uv = true;
+    const bool halfplane_gridding = false;
+    GridAccumulator<T, generateBeam> accumulator(kernel_creator, img_pars.kernel_support, padded_image_size, img_pars.kernel_exact, img_pars.oversampling,
+        shift_uv, halfplane_gridding, w_proj, img_pars.cell_size, img_pars.analytic_gcf, r_fft);
+    GriddingGeometry geometry = accumulator.prepare(vis_data, uv_lambda_to_pixel_scale(img_pars.cell_size, padded_image_size));
+    accumulator.load_visibilities(geometry, vis_data.vis);
+
+    // Image-domain w-term factors of each pixel: (n - 1) and 1/n, where n = sqrt(1 - l^2 - m^2) (see WideFieldImaging)
+    // The image origin is on pixel (0, 0) because the uv-grid is shifted (shift_uv)
+    const real_t cell_size_rad = real_t(arc_sec_to_rad(img_pars.cell_size));
+    arma::Mat<real_t> n_minus_one(n, n);
+    arma::Mat<real_t> inv_n(n, n);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t j = r.begin(); j < r.end(); ++j) {
+            const real_t distance_x = real_t((j < n / 2) ? double(j) : double(j) - double(n)) * cell_size_rad;
+            for (size_t i = 0; i < n; ++i) {
+                const real_t distance_y = real_t((i < n / 2) ? double(i) : double(i) - double(n)) * cell_size_rad;
+                const real_t rsquared_radians = distance_x * distance_x + distance_y * distance_y;
+                if (rsquared_radians >= real_t(1.0)) {
+                    n_minus_one.at(i, j) = real_t(0.0);
+                    inv_n.at(i, j) = real_t(1.0);
+                } else {
+                    const real_t n_val = std::sqrt(real_t(1.0) - rsquared_radians);
+                    n_minus_one.at(i, j) = n_val - real_t(1.0);
+                    inv_n.at(i, j) = real_t(1.0) / n_val;
                 }
-                ii = half_padded_image_size - image_size / 2;
-                size_t orig_i = padded_image_size - (image_size / 2);
-                for (size_t i = (image_size / 2); i < image_size; ++i, ++ii, ++orig_i) {
-                    if (grid_correction) {
-                        norm_image.at(i, j) = image_mat(orig_i, j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                    } else {
-                        norm_image.at(i, j) = image_mat(orig_i, j) * normalization_factor;
-                    }
+            }
+        }
+    });
+
+    // Grid, transform and accumulate each w-plane
+    arma::Mat<real_t> fft_result_image(n, n, arma::fill::zeros);
+    for (uint pi = 0; pi < geometry.num_wplanes; pi++) {
+        if (accumulator.add_wplane(geometry, pi) == 0)
+            continue;
+
+        MatStp<cx_real_t>& plane_grid = accumulator.get_vis_grid();
+        fft_fftw_c2c(plane_grid, plane_grid, r_fft, false);
+
+        // The real image is twice the real part of the w-corrected plane image (as given by the c2r iFFT of the halfplane grid)
+        const real_t phase_factor = real_t(-2.0 * M_PI) * geometry.w_avg_values(pi);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t j = r.begin(); j < r.end(); ++j) {
+                for (size_t i = 0; i < n; ++i) {
+                    const cx_real_t w_term = std::polar(real_t(2.0) * inv_n.at(i, j), phase_factor * n_minus_one.at(i, j));
+                    fft_result_image.at(i, j) += std::real(plane_grid.at(i, j) * w_term);
                 }
             }
         });
+    }
+#ifdef FFTSHIFT
+    fftshift(fft_result_image);
+#endif
 
-    tbb::parallel_for(tbb::blocked_range<size_t>(image_size / 2, image_size),
-        [&](const tbb::blocked_range<size_t>& r) {
-            size_t j_begin = r.begin(),
-                   j_end = r.end();
-            size_t orig_j = padded_image_size + j_begin - image_size;
-            for (size_t j = j_begin; j < j_end; ++j, ++orig_j) {
-                size_t jj = half_padded_image_size + j - image_size;
-                size_t ii = half_padded_image_size;
-                for (size_t i = 0; i < (image_size / 2); ++i, ++ii) {
-                    if (grid_correction) {
-                        norm_image.at(i, j) = image_mat(i, orig_j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                    } else {
-                        norm_image.at(i, j) = image_mat(i, orig_j) * normalization_factor;
-                    }
-                }
-                ii = half_padded_image_size - image_size / 2;
-                size_t orig_i = padded_image_size - (image_size / 2);
-                for (size_t i = (image_size / 2); i < image_size; ++i, ++ii, ++orig_i) {
-                    if (grid_correction) {
-                        norm_image.at(i, j) = image_mat(orig_i, orig_j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                    } else {
-                        norm_image.at(i, j) = image_mat(orig_i, orig_j) * normalization_factor;
-                    }
+    // The beam is computed from the sampling grid of all w-planes
+    GridderOutput gridded_data = accumulator.finalize();
+    gridded_data.vis_grid.reset();
+    arma::Mat<real_t> fft_result_beam;
+    if (generateBeam) {
+        fft_fftw_c2c(gridded_data.sampling_grid, gridded_data.sampling_grid, r_fft, false);
+        fft_result_beam.set_size(n, n);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t j = r.begin(); j < r.end(); ++j) {
+                for (size_t i = 0; i < n; ++i) {
+                    fft_result_beam.at(i, j) = real_t(2.0) * std::real(gridded_data.sampling_grid.at(i, j));
                 }
             }
         });
+        gridded_data.sampling_grid.reset();
+#ifdef FFTSHIFT
+        fftshift(fft_result_beam);
+#endif
+    }
+    TIMESTAMP_IMAGER
 
-    image_mat.reset();
-
-    // Beam is optional
-    if (generate_beam) {
-        norm_beam.set_size(image_size, image_size);
-
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, image_size / 2),
-            [&](const tbb::blocked_range<size_t>& r) {
-                size_t j_begin = r.begin(),
-                       j_end = r.end();
-                for (size_t j = j_begin; j < j_end; ++j) {
-                    size_t jj = j + half_padded_image_size;
-                    size_t ii = half_padded_image_size;
-                    for (size_t i = 0; i < (image_size / 2); ++i, ++ii) {
-                        if (grid_correction) {
-                            norm_beam.at(i, j) = beam_mat(i, j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                        } else {
-                            norm_beam.at(i, j) = beam_mat(i, j) * normalization_factor;
-                        }
-                    }
-                    ii = half_padded_image_size - image_size / 2;
-                    size_t orig_i = padded_image_size - (image_size / 2);
-                    for (size_t i = (image_size / 2); i < image_size; ++i, ++ii, ++orig_i) {
-                        if (grid_correction) {
-                            norm_beam.at(i, j) = beam_mat(orig_i, j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                        } else {
-                            norm_beam.at(i, j) = beam_mat(orig_i, j) * normalization_factor;
-                        }
-                    }
-                }
-            });
+    // Normalisation and convolution kernel correction
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = normalise_imaging_result(kernel_creator, fft_result_image, fft_result_beam,
+        geometry.sample_grid_total, img_pars);
 
-        tbb::parallel_for(tbb::blocked_range<size_t>(image_size / 2, image_size),
-            [&](const tbb::blocked_range<size_t>& r) {
-                size_t j_begin = r.begin(),
-                       j_end = r.end();
-                size_t orig_j = padded_image_size + j_begin - image_size;
-                for (size_t j = j_begin; j < j_end; ++j, ++orig_j) {
-                    size_t jj = half_padded_image_size + j - image_size;
-                    size_t ii = half_padded_image_size;
-                    for (size_t i = 0; i < (image_size / 2); ++i, ++ii) {
-                        if (grid_correction) {
-                            norm_beam.at(i, j) = beam_mat(i, orig_j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                        } else {
-                            norm_beam.at(i, j) = beam_mat(i, orig_j) * normalization_factor;
-                        }
-                    }
-                    ii = half_padded_image_size - image_size / 2;
-                    size_t orig_i = padded_image_size - (image_size / 2);
-                    for (size_t i = (image_size / 2); i < image_size; ++i, ++ii, ++orig_i) {
-                        if (grid_correction) {
-                            norm_beam.at(i, j) = beam_mat(orig_i, orig_j) * normalization_factor / (fft_1D_array.at(ii) * fft_1D_array.at(jj));
-                        } else {
-                            norm_beam.at(i, j) = beam_mat(orig_i, orig_j) * normalization_factor;
-                        }
-                    }
-                }
-            });
+    TIMESTAMP_IMAGER
 
-        beam_mat.reset();
-    }
-#endif
+    return result;
 }
 
 /**
- * @brief Generates image and beam data from input visibilities.
+ * @brief Generates image and beam data from views of the input visibilities.
  *
  * Performs convolutional gridding of input visibilities and applies ifft.
  * Returns two arrays representing the image map and beam model.
+ * Visibility data is read in place through strided views (no copies of the input data are made).
  *
  * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel.
- * @param[in] vis (arma::cx_mat): Complex visibilities (1D array).
- * @param[in] vis_weights (arma::mat): Visibility weights (1D array).
- * @param[in] uvw_lambda (arma::mat): UVW-coordinates of complex visibilities. Units are multiples of wavelength.
- *                                    2D double array with 3 columns. Assumed ordering is u,v,w.
+ * @param[in] vis_data (VisibilityView): Views of the UVW-coordinates (multiples of wavelength), complex visibilities and weights.
  * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
  * @param[in] w_proj (W_ProjectionPars): W-projection parameters (see W_ProjectionPars struct).
  * @param[in] a_proj (A_ProjectionPars): A-projection parameters (see A_ProjectionPars struct).
@@ -233,9 +528,7 @@ void normalise_image_beam_result_1D(
 template <typename T>
 std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_visibilities(
     const T kernel_creator,
-    const arma::cx_mat& vis,
-    const arma::mat& vis_weights,
-    const arma::mat& uvw_lambda,
+    const VisibilityView& vis_data,
     const ImagerPars& img_pars = ImagerPars(),
     const W_ProjectionPars& w_proj = W_ProjectionPars(),
     const A_ProjectionPars& a_proj = A_ProjectionPars())
@@ -255,48 +548,26 @@ std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_visibilities(
     FFTRoutine r_fft = img_pars.r_fft;
 
     /* Some checks */
-    assert(img_pars.padding_factor >= 1.0);
-    assert(padded_image_size >= img_pars.image_size);
-    assert(kernel_exact || (oversampling >= 1)); // If kernel exact is false, then oversampling must be >= 1
-    assert(padded_image_size > 0);
-    assert(ispowerof2(padded_image_size)); // Image size must be power of two. Also parallel complex2real FFTW function only works with image sizes multiple of 4.
-    assert(kernel_support > 0);
-    assert(cell_size > 0.0);
-    assert(vis.n_elem == vis_weights.n_elem);
-#ifdef WPROJECTION
-    if (w_proj.num_wplanes > 0) {
-        assert(w_proj.isEnabled());
-    }
-#else
-    assert(!w_proj.isEnabled());
-#endif
-#ifdef APROJECTION
-    // A-proj can be used only with W-proj enabled
-    if (a_proj.num_timesteps > 0) {
-        assert(a_proj.isEnabled());
-        assert(w_proj.isEnabled());
-        assert(!w_proj.hankel_opt);
-        if (!w_proj.isEnabled())
-            throw std::runtime_error("W-projection must be used when A-projection is enabled.");
-        if (w_proj.hankel_opt)
-            throw std::runtime_error("Hankel transform cannot be used when A-projection is enabled.");
-    }
-#else
-    assert(!a_proj.isEnabled());
-#endif
-    assert(!(kernel_exact && (w_proj.isEnabled()))); // W-proj cannot be used when 'kernel_exact' is true.
+    assert(vis_data.vis.size() == vis_data.weights.size());
+    assert(vis_data.u.size() == vis_data.weights.size());
+    check_imager_pars(img_pars, w_proj, a_proj);
 
-    // Init FFTW threads
+    // Init FFTW threads (FFTW threads and plans are kept by the FFT context and reused by the next calls)
     init_fftw(r_fft, img_pars.fft_wisdom_filename);
 
-    // Size of a UV-grid pixel, in multiples of wavelength (lambda):
-    double inv_grid_pixel_width_lambda = arc_sec_to_rad(cell_size) * double(padded_image_size);
-    // convert u,v to pixel
-    arma::mat uv_lambda(uvw_lambda.n_rows, 2);
-    arma::vec w_lambda = uvw_lambda.col(2);
-    for (size_t idx = 0; idx < uvw_lambda.n_rows; ++idx) {
-        uv_lambda.at(idx, 0) = uvw_lambda.at(idx, 0) * inv_grid_pixel_width_lambda;
-        uv_lambda.at(idx, 1) = uvw_lambda.at(idx, 1) * inv_grid_pixel_width_lambda;
+    // u,v are converted to pixels by the gridder
+    double uv_scale = uv_lambda_to_pixel_scale(cell_size, padded_image_size);
+
+    // W-stacking: each w-plane is gridded and transformed separately
+    if (w_proj.isEnabled() && w_proj.w_stacking) {
+        std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result;
+        if (generate_beam) {
+            result = image_wstacked_visibilities<true>(kernel_creator, vis_data, img_pars, w_proj);
+        } else {
+            result = image_wstacked_visibilities<false>(kernel_creator, vis_data, img_pars, w_proj);
+        }
+
+        return result;
     }
 
     // Perform convolutional gridding of complex visibilities
@@ -306,74 +577,162 @@ std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_visibilities(
 
     if (generate_beam) {
         gridded_data = convolve_to_grid<true>(kernel_creator, kernel_support, padded_image_size,
-            uv_lambda, vis, vis_weights, kernel_exact, oversampling, shift_uv, halfplane_gridding,
-            w_proj, w_lambda, cell_size, img_pars.analytic_gcf, r_fft, a_proj);
+            vis_data, uv_scale, kernel_exact, oversampling, shift_uv, halfplane_gridding,
+            w_proj, cell_size, img_pars.analytic_gcf, r_fft, a_proj);
     } else {
         gridded_data = convolve_to_grid<false>(kernel_creator, kernel_support, padded_image_size,
-            uv_lambda, vis, vis_weights, kernel_exact, oversampling, shift_uv, halfplane_gridding,
-            w_proj, w_lambda, cell_size, img_pars.analytic_gcf, r_fft, a_proj);
+            vis_data, uv_scale, kernel_exact, oversampling, shift_uv, halfplane_gridding,
+            w_proj, cell_size, img_pars.analytic_gcf, r_fft, a_proj);
     }
 
     TIMESTAMP_IMAGER
 
-    arma::Mat<real_t> fft_result_image;
-    arma::Mat<real_t> fft_result_beam;
+    // Run iFFT over convolved matrices and normalise the results
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = image_gridded_visibilities(kernel_creator, gridded_data, img_pars);
 
-    // Reuse gridded_data buffer if FFT is INPLACE
-    if (r_fft == stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
-        fft_result_image = std::move(arma::Mat<real_t>(reinterpret_cast<real_t*>(gridded_data.vis_grid.memptr()), (gridded_data.vis_grid.n_rows) * 2, gridded_data.vis_grid.n_cols, false, false));
-        fft_result_beam = std::move(arma::Mat<real_t>(reinterpret_cast<real_t*>(gridded_data.sampling_grid.memptr()), (gridded_data.sampling_grid.n_rows) * 2, gridded_data.sampling_grid.n_cols, false, false));
-    }
+    return result;
+}
 
-    // Run iFFT over convolved matrices
-    // First: FFT of image matrix
-    fft_fftw_c2r(gridded_data.vis_grid, fft_result_image, r_fft);
-    // Delete gridded image matrix (only if FFT is not inplace)
-    if (r_fft != stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
-        gridded_data.vis_grid.reset();
-    }
-#ifdef FFTSHIFT
-    fftshift(fft_result_image);
-#endif
+/**
+ * @brief Generates image and beam data from input visibilities.
+ *
+ * Performs convolutional gridding of input visibilities and applies ifft.
+ * Returns two arrays representing the image map and beam model.
+ *
+ * @param[in] kernel_creator (typename T): Callable object that returns a convolution kernel.
+ * @param[in] vis (arma::cx_mat): Complex visibilities (1D array).
+ * @param[in] vis_weights (arma::mat): Visibility weights (1D array).
+ * @param[in] uvw_lambda (arma::mat): UVW-coordinates of complex visibilities. Units are multiples of wavelength.
+ *                                    2D double array with 3 columns. Assumed ordering is u,v,w.
+ * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+ * @param[in] w_proj (W_ProjectionPars): W-projection parameters (see W_ProjectionPars struct).
+ * @param[in] a_proj (A_ProjectionPars): A-projection parameters (see A_ProjectionPars struct).
+ *
+ * @return (std::pair<arma::mat, arma::mat>): Two matrices representing the generated image map and beam model (image, beam).
+ */
+template <typename T>
+std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image_visibilities(
+    const T kernel_creator,
+    const arma::cx_mat& vis,
+    const arma::mat& vis_weights,
+    const arma::mat& uvw_lambda,
+    const ImagerPars& img_pars = ImagerPars(),
+    const W_ProjectionPars& w_proj = W_ProjectionPars(),
+    const A_ProjectionPars& a_proj = A_ProjectionPars())
+{
+    assert(vis.n_elem == vis_weights.n_elem);
+    assert(uvw_lambda.n_rows == vis_weights.n_elem);
 
-    // Second: FFT of beam matrix (optional)
-    if (generate_beam) {
-        fft_fftw_c2r(gridded_data.sampling_grid, fft_result_beam, r_fft);
-        // Delete gridded beam matrix (only if FFT is not inplace)
-        if (r_fft != stp::FFTRoutine::FFTW_WISDOM_INPLACE_FFT) {
-            gridded_data.sampling_grid.reset();
+    return image_visibilities(kernel_creator, VisibilityView(uvw_lambda, vis, vis_weights), img_pars, w_proj, a_proj);
+}
+
+/**
+ * @brief ImagingPlan class. Images visibilities sharing the same UVW-coordinates and weights (see GriddingPlan).
+ *
+ * Plans are created by ImageVisibilities::make_plan, which selects the kernel function.
+ */
+class ImagingPlan {
+public:
+    /**
+     * @brief Default destructor
+     */
+    virtual ~ImagingPlan() = default;
+
+    /**
+     * @brief Generates image and beam data from input visibilities, using the plan.
+     *
+     * @param[in] vis (arma::cx_mat): Complex visibilities (1D array), in the order of the plan UVW-coordinates.
+     *
+     * @return (std::pair<arma::mat, arma::mat>): Two matrices representing the generated image map and beam model (image, beam).
+     */
+    virtual std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image(const arma::cx_mat& vis) = 0;
+
+    /**
+     * @brief Number of visibilities of the plan
+     */
+    virtual size_t num_vis() const = 0;
+};
+
+/**
+ * @brief KernelImagingPlan class. Imaging plan for a given kernel function.
+ */
+template <typename T>
+class KernelImagingPlan : public ImagingPlan {
+public:
+    /**
+     * @brief KernelImagingPlan constructor. Computes the gridding plan.
+     *
+     * See image_visibilities for the description of the parameters.
+     */
+    KernelImagingPlan(const T& _kernel_creator,
+        const arma::mat& vis_weights,
+        const arma::mat& uvw_lambda,
+        const ImagerPars& _img_pars = ImagerPars(),
+        const W_ProjectionPars& w_proj = W_ProjectionPars(),
+        const A_ProjectionPars& a_proj = A_ProjectionPars())
+        : kernel_creator(_kernel_creator)
+        , img_pars(_img_pars)
+    {
+        /* Some checks */
+        assert(uvw_lambda.n_rows == vis_weights.n_elem);
+        check_imager_pars(img_pars, w_proj, a_proj);
+        assert(!(w_proj.isEnabled() && w_proj.w_stacking));
+        if (w_proj.isEnabled() && w_proj.w_stacking)
+            throw std::runtime_error("W-stacking cannot be used by imaging plans.");
+
+        // Init FFTW threads (required for the generation of the image-domain kernels)
+        init_fftw(img_pars.r_fft, img_pars.fft_wisdom_filename);
+
+        // The plan reads the coordinates and weights in place (visibilities are passed to image())
+        VisibilityView vis_data(uvw_lambda, arma::cx_mat(), vis_weights);
+        double uv_scale = uv_lambda_to_pixel_scale(img_pars.cell_size, img_pars.padded_image_size);
+        bool shift_uv = true;
+        bool halfplane_gridding = true;
+
+        if (img_pars.generate_beam) {
+            beam_plan = std::make_unique<GriddingPlan<T, true>>(kernel_creator, img_pars.kernel_support, img_pars.padded_image_size,
+                vis_data, uv_scale, img_pars.kernel_exact, img_pars.oversampling, shift_uv, halfplane_gridding,
+                w_proj, img_pars.cell_size, img_pars.analytic_gcf, img_pars.r_fft, a_proj);
+        } else {
+            image_plan = std::make_unique<GriddingPlan<T, false>>(kernel_creator, img_pars.kernel_support, img_pars.padded_image_size,
+                vis_data, uv_scale, img_pars.kernel_exact, img_pars.oversampling, shift_uv, halfplane_gridding,
+                w_proj, img_pars.cell_size, img_pars.analytic_gcf, img_pars.r_fft, a_proj);
         }
-#ifdef FFTSHIFT
-        fftshift(fft_result_beam);
-#endif
     }
-    TIMESTAMP_IMAGER
 
-    // Normalisation and convolution kernel correction
-    arma::Mat<real_t> norm_result_image;
-    arma::Mat<real_t> norm_result_beam;
-    if (gridded_data.sample_grid_total > 0.0) {
-        real_t normalization_factor = 1.0 / (gridded_data.sample_grid_total);
-        if (img_pars.gridding_correction == true) {
-            normalise_image_beam_result_1D<true>(fft_result_image, fft_result_beam, norm_result_image, norm_result_beam, kernel_creator, padded_image_size,
-                img_pars.image_size, normalization_factor, img_pars.analytic_gcf, generate_beam, r_fft);
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> image(const arma::cx_mat& vis) override
+    {
+        assert(vis.n_elem == num_vis());
+
+        // Init FFTW threads
+        init_fftw(img_pars.r_fft, img_pars.fft_wisdom_filename);
+
+        // Perform convolutional gridding of complex visibilities
+        GridderOutput gridded_data;
+        if (img_pars.generate_beam) {
+            gridded_data = beam_plan->grid(vis);
         } else {
-            normalise_image_beam_result_1D<false>(fft_result_image, fft_result_beam, norm_result_image, norm_result_beam, kernel_creator, padded_image_size,
-                img_pars.image_size, normalization_factor, img_pars.analytic_gcf, generate_beam, r_fft);
+            gridded_data = image_plan->grid(vis);
         }
-    }
 
-    TIMESTAMP_IMAGER
+        // Run iFFT over convolved matrices and normalise the results
+        std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = image_gridded_visibilities(kernel_creator, gridded_data, img_pars);
 
-    // Destroy FFTW threads
-#ifdef USE_FLOAT
-    fftwf_cleanup_threads();
-#else
-    fftw_cleanup_threads();
-#endif
+        return result;
+    }
 
-    return std::make_pair(std::move(norm_result_image), std::move(norm_result_beam));
-}
+    size_t num_vis() const override
+    {
+        return img_pars.generate_beam ? beam_plan->num_vis() : image_plan->num_vis();
+    }
+
+private:
+    T kernel_creator;
+    ImagerPars img_pars;
+    // Gridding plan (with and without sampling grid)
+    std::unique_ptr<GriddingPlan<T, true>> beam_plan;
+    std::unique_ptr<GriddingPlan<T, false>> image_plan;
+};
 
 /**
  * @brief ImageVisibilities class. Runs imager.
@@ -405,6 +764,34 @@ public:
         const W_ProjectionPars& w_proj,
         const A_ProjectionPars& a_proj);
 
+    /**
+     * @brief ImageVisibilities constructor
+     *
+     * Images visibilities using a plan created by make_plan (the UVW-coordinates and weights are those of the plan).
+     *
+     * @param[in] vis (arma::cx_mat): Complex visibilities (1D array).
+     * @param[in] plan (ImagingPlan): Imaging plan.
+     */
+    ImageVisibilities(const arma::cx_mat& vis, ImagingPlan& plan);
+
+    /**
+     * @brief Creates an imaging plan for the given UVW-coordinates and weights, which can be used to image several sets of visibilities.
+     *
+     * @param[in] vis_weights (arma::mat): Visibility weights (1D array).
+     * @param[in] uvw_lambda (arma::mat): UVW-coordinates of complex visibilities. Units are multiples of wavelength.
+     *                                    2D double array with 3 columns. Assumed ordering is u,v,w.
+     * @param[in] img_pars (ImagerPars): Imager parameters (see ImagerPars struct).
+     * @param[in] w_proj (W_ProjectionPars): W-projection parameters (see W_ProjectionPars struct).
+     * @param[in] a_proj (A_ProjectionPars): A-projection parameters (see A_ProjectionPars struct).
+     *
+     * @return (std::unique_ptr<ImagingPlan>): Imaging plan.
+     */
+    static std::unique_ptr<ImagingPlan> make_plan(const arma::mat& vis_weights,
+        const arma::mat& uvw_lambda,
+        const ImagerPars& img_pars = ImagerPars(),
+        const W_ProjectionPars& w_proj = W_ProjectionPars(),
+        const A_ProjectionPars& a_proj = A_ProjectionPars());
+
     // Store gridded image and beam
     arma::Mat<real_t> vis_grid;
     arma::Mat<real_t> sampling_grid;
@@ -8,6 +8,7 @@
 
 #include <armadillo>
 #include <complex>
+#include <string>
 
 // Defines single- or double- precision floating point type for STP library
 #ifdef USE_FLOAT
@@ -58,6 +59,15 @@ enum struct InterpType {
     COSINE
 };
 
+/**
+ * @brief Enum of Hankel transform methods (used by W-projection with Hankel transform optimization)
+ */
+enum struct HankelMethod {
+    DHT, // Discrete Hankel transform matrix, one matrix-vector product per w-plane
+    DHT_BATCHED, // Discrete Hankel transform matrix, one matrix-matrix product (BLAS gemm) for the kernels of all w-planes
+    FHT // Fast Hankel transform: FFT-based correlation on a logarithmic grid
+};
+
 /**
  * @brief Enum of available median methods
  */
@@ -189,6 +199,11 @@ struct W_ProjectionPars {
         , hankel_proj_slice(false)
         , interp_type(stp::InterpType::LINEAR)
         , wplanes_median(false)
+        , w_stacking(false)
+        , kernel_cache_dir()
+        , kernel_cache_w_tolerance(0.0)
+        , wplanes_max_phase_error(0.0)
+        , hankel_method(stp::HankelMethod::DHT)
     {
     }
 
@@ -205,6 +220,19 @@ struct W_ProjectionPars {
      *                                The larger non-zero value increases HT accuracy, by using an extended W-kernel workarea size.
      * @param[in] _interp_type (InterpType): Select kernel interpolation type - required when using Hnakel transform approach.
      * @param[in] _wplanes_median (bool): Use median to compute w-planes, otherwise use mean.
+     * @param[in] _w_stacking (bool): Use W-stacking instead of W-projection: each w-plane is gridded with the AA-kernel and transformed
+     *                                separately, and the w-term is applied in the image domain.
+     * @param[in] _kernel_cache_dir (string): Directory of the on-disk W-kernel cache. Generated W-kernels are stored there and reused
+     *                                        by later runs with the same imaging parameters. Leave empty to disable the cache.
+     * @param[in] _kernel_cache_w_tolerance (double): W values of the cached W-kernels are quantized to multiples of this tolerance
+     *                                                (in wavelengths), so that nearby w-planes share a kernel. Set zero to disable quantization.
+     * @param[in] _wplanes_max_phase_error (double): Maximum phase error (in radians) of the w-term over the image. When non-zero, the w-planes are
+     *                                               placed according to the w distribution so that this bound is met with the fewest planes
+     *                                               (num_wplanes is then the maximum number of planes). The bound is a target, not a guarantee:
+     *                                               it is relaxed when more than num_wplanes planes would be needed (the achieved phase error is
+     *                                               logged). Set zero to use num_wplanes equal-size planes.
+     * @param[in] _hankel_method (HankelMethod): Hankel transform method used when Hankel transform optimization is enabled (without projection slice).
+     *                                           The fast Hankel transform (FHT) scales nearly linearly with the workarea size.
      */
     W_ProjectionPars(uint _num_wplanes,
         uint _max_wpconv_support,
@@ -213,7 +241,12 @@ struct W_ProjectionPars {
         bool _hankel_opt = false,
         bool _hankel_proj_slice = false,
         stp::InterpType _interp_type = stp::InterpType::LINEAR,
-        bool _wplanes_median = false)
+        bool _wplanes_median = false,
+        bool _w_stacking = false,
+        const std::string& _kernel_cache_dir = "",
+        double _kernel_cache_w_tolerance = 0.0,
+        double _wplanes_max_phase_error = 0.0,
+        stp::HankelMethod _hankel_method = stp::HankelMethod::DHT)
         : num_wplanes(_num_wplanes)
         , max_wpconv_support(_max_wpconv_support)
         , undersampling_opt(_undersampling_opt)
@@ -222,6 +255,11 @@ struct W_ProjectionPars {
         , hankel_proj_slice(_hankel_proj_slice)
         , interp_type(_interp_type)
         , wplanes_median(_wplanes_median)
+        , w_stacking(_w_stacking)
+        , kernel_cache_dir(_kernel_cache_dir)
+        , kernel_cache_w_tolerance(_kernel_cache_w_tolerance)
+        , wplanes_max_phase_error(_wplanes_max_phase_error)
+        , hankel_method(_hankel_method)
     {
     }
 
@@ -246,6 +284,11 @@ struct W_ProjectionPars {
     bool hankel_proj_slice;
     stp::InterpType interp_type;
     bool wplanes_median;
+    bool w_stacking;
+    std::string kernel_cache_dir;
+    double kernel_cache_w_tolerance;
+    double wplanes_max_phase_error;
+    stp::HankelMethod hankel_method;
 };
 
 /**
@@ -262,6 +305,8 @@ struct A_ProjectionPars {
         , obs_ra(0.0)
         , aproj_opt(false)
         , aproj_mask_perc(0.0)
+        , pangle_bin_size(0.0)
+        , cache_awkernels(false)
     {
     }
 
@@ -275,6 +320,11 @@ struct A_ProjectionPars {
      * @param[in] _aproj_mask_perc (double): Threshold value (in percentage) used to detect near zero regions of the primary beam.
      * @param[in] _lha (arma::mat): Local hour angle of visibilities. LHA=0 is transit, LHA=-6h is rising, LHA=+6h is setting.
      * @param[in] _pbeam_coefs (std::vector<double>): Primary beam given by spherical harmonics coefficients.
+     * @param[in] _pangle_bin_size (double): Width (in degrees) of the parallactic-angle bins. The A-kernel of each bin is generated once and
+     *                                       shared by all W-planes. Set zero to use the exact parallactic angles.
+     * @param[in] _cache_awkernels (bool): Keep the AW-kernels of each (W value, parallactic-angle bin) and reuse them in the next W-planes,
+     *                                     time steps and calls. Only used when the angles are binned (non-zero bin size) and
+     *                                     without the A-projection optimisation.
      */
     A_ProjectionPars(uint _num_timesteps,
         double _obs_dec = 0.0,
@@ -282,7 +332,9 @@ struct A_ProjectionPars {
         bool _aproj_opt = false,
         double _aproj_mask_perc = 0.0,
         const arma::mat& _lha = arma::mat(),
-        const std::vector<double>& _pbeam_coefs = std::vector<double>())
+        const std::vector<double>& _pbeam_coefs = std::vector<double>(),
+        double _pangle_bin_size = 0.0,
+        bool _cache_awkernels = false)
         : num_timesteps(_num_timesteps)
         , obs_dec(_obs_dec)
         , obs_ra(_obs_ra)
@@ -290,6 +342,8 @@ struct A_ProjectionPars {
         , aproj_mask_perc(_aproj_mask_perc)
         , lha(std::move(_lha))
         , pbeam_coefs(std::move(_pbeam_coefs))
+        , pangle_bin_size(_pangle_bin_size)
+        , cache_awkernels(_cache_awkernels)
     {
     }
 
@@ -313,6 +367,8 @@ struct A_ProjectionPars {
     double aproj_mask_perc;
     arma::mat lha;
     std::vector<double> pbeam_coefs;
+    double pangle_bin_size;
+    bool cache_awkernels;
 };
 
 } // stp namespace
@@ -17,4 +17,9 @@ TEST(ConvGaussianFunc, test_conv_funcs_test_gaussian)
     arma::Col<real_t> output = { 1.0, 1. / exp(1.), 0. };
 
     EXPECT_TRUE(arma::approx_equal(Gaussian(3.0, 1.0)(input), output, "absdiff", fptolerance));
+
+    // Single point evaluation (used by the exact gridder)
+    for (arma::uword i = 0; i < input.n_elem; i++) {
+        EXPECT_NEAR(Gaussian(3.0, 1.0).value(input[i]), output[i], fptolerance);
+    }
 }
@@ -38,4 +38,9 @@ TEST(ConvGaussianSincFunc, test_conv_funcs_test_gaussian_sinc)
     };
 
     EXPECT_TRUE(arma::approx_equal(GaussianSinc(trunc, width_normalization_gaussian, width_normalization_sinc)(input), output, "absdiff", fptolerance));
+
+    // Single point evaluation (used by the exact gridder)
+    for (arma::uword i = 0; i < input.n_elem; i++) {
+        EXPECT_NEAR(GaussianSinc(trunc, width_normalization_gaussian, width_normalization_sinc).value(input[i]), output[i], fptolerance);
+    }
 }
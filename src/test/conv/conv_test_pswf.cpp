@@ -37,4 +37,9 @@ TEST(ConvPswfFunc, conv_funcs_pswf)
     };
 
     EXPECT_TRUE(arma::approx_equal(PSWF(3.0)(input), output, "absdiff", fptolerance));
+
+    // Single point evaluation (used by the exact gridder)
+    for (arma::uword i = 0; i < input.n_elem; i++) {
+        EXPECT_NEAR(PSWF(3.0).value(input[i]), output[i], fptolerance);
+    }
 }
@@ -25,4 +25,9 @@ TEST(ConvSincFunc, conv_funcs_sinc)
     };
 
     EXPECT_TRUE(arma::approx_equal(Sinc(3.0, 1.0)(input), output, "absdiff", fptolerance));
+
+    // Single point evaluation (used by the exact gridder)
+    for (arma::uword i = 0; i < input.n_elem; i++) {
+        EXPECT_NEAR(Sinc(3.0, 1.0).value(input[i]), output[i], fptolerance);
+    }
 }
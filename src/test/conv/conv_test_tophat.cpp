@@ -17,4 +17,9 @@ TEST(ConvTopHatFunc, conv_funcs_tophat_func)
     arma::Col<real_t> output = { 1.0, 1.0, 1.0, 0.0, 0.0 };
 
     EXPECT_TRUE(arma::approx_equal(TopHat(3.0)(input), output, "absdiff", fptolerance));
+
+    // Single point evaluation (used by the exact gridder)
+    for (arma::uword i = 0; i < input.n_elem; i++) {
+        EXPECT_NEAR(TopHat(3.0).value(input[i]), output[i], fptolerance);
+    }
 }
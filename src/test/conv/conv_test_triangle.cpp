@@ -17,4 +17,9 @@ TEST(ConvTriangleFunc, conv_funcs_triangle_func)
     arma::Col<real_t> output = { 1.0, 0.5, 0.0, 0.0, 0.0, 0.95, 0.75 };
 
     EXPECT_TRUE(arma::approx_equal(Triangle(2.0)(input), output, "absdiff", fptolerance));
+
+    // Single point evaluation (used by the exact gridder)
+    for (arma::uword i = 0; i < input.n_elem; i++) {
+        EXPECT_NEAR(Triangle(2.0).value(input[i]), output[i], fptolerance);
+    }
 }
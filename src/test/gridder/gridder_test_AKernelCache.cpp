@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the A-kernel cache of A-projection: parallactic angles are quantized to bins, the A-kernel of each bin is generated once,
+ * and the cached AW-kernels produce the same images as the regenerated ones.
+ */
+
+#ifdef APROJECTION
+
+const int workarea_size = 64;
+const double fov = arc_sec_to_rad(10.0) * 64;
+const std::vector<double> pbeam_coefs = { 0.2, 1.0, 0.2 };
+
+TEST(GridderAKernelCache, quantize_angle)
+{
+    AKernelCache cache(A_ProjectionPars(1, 0.0, 0.0, false, 0.0, arma::mat(), pbeam_coefs, 2.0), fov, workarea_size);
+    EXPECT_NEAR(cache.quantize_angle(real_t(deg2rad(10.9))), real_t(deg2rad(10.0)), fptolerance);
+    EXPECT_NEAR(cache.quantize_angle(real_t(deg2rad(-11.2))), real_t(deg2rad(-12.0)), fptolerance);
+
+    AKernelCache exact_cache(A_ProjectionPars(1, 0.0, 0.0, false, 0.0, arma::mat(), pbeam_coefs), fov, workarea_size);
+    EXPECT_EQ(exact_cache.quantize_angle(real_t(0.123)), real_t(0.123));
+}
+
+TEST(GridderAKernelCache, binned_kernels)
+{
+    const A_ProjectionPars a_proj(1, 0.0, 0.0, false, 0.0, arma::mat(), pbeam_coefs, 2.0);
+    AKernelCache cache(a_proj, fov, workarea_size);
+
+    // Angles of the same bin share the A-kernel generated at the bin angle
+    const arma::Mat<real_t>& kernel = cache.a_kernel(real_t(deg2rad(29.5)));
+    const arma::Mat<real_t>& same_bin_kernel = cache.a_kernel(real_t(deg2rad(30.8)));
+    EXPECT_EQ(&kernel, &same_bin_kernel);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_TRUE(arma::approx_equal(kernel, generate_a_kernel(a_proj, fov, workarea_size, real_t(deg2rad(30.0))), "absdiff", fptolerance));
+
+    cache.a_kernel(real_t(deg2rad(45.0)));
+    EXPECT_EQ(cache.size(), 2u);
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(GridderAKernelCache, exact_kernels)
+{
+    const A_ProjectionPars a_proj(1, 0.0, 0.0, false, 0.0, arma::mat(), pbeam_coefs);
+    AKernelCache cache(a_proj, fov, workarea_size);
+
+    // Without bins, only the A-kernel of the last angle is kept
+    const arma::Mat<real_t>& kernel = cache.a_kernel(real_t(deg2rad(29.5)));
+    EXPECT_EQ(&kernel, &cache.a_kernel(real_t(deg2rad(29.5))));
+    cache.a_kernel(real_t(deg2rad(30.8)));
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_TRUE(arma::approx_equal(cache.a_kernel(real_t(deg2rad(45.0))), generate_a_kernel(a_proj, fov, workarea_size, real_t(deg2rad(45.0))), "absdiff", fptolerance));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+// Grid the same chunk of visibilities twice (the second chunk reuses the AW-kernels of the first one when they are cached)
+GridderOutput grid_chunks(const A_ProjectionPars& a_proj)
+{
+    const int num_vis = 500;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    arma::mat uv(num_vis, 2);
+    arma::vec w_lambda(num_vis);
+    arma::cx_mat vis(num_vis, 1);
+    arma::mat vis_weights(num_vis, 1);
+    arma::mat lha(num_vis, 1);
+    for (int i = 0; i < num_vis; i++) {
+        uv.at(i, 0) = dist(rng) * workarea_size / 2.0;
+        uv.at(i, 1) = dist(rng) * workarea_size / 2.0;
+        w_lambda[i] = dist(rng) * 2000.0;
+        vis.at(i, 0) = std::polar(1.0, M_PI * dist(rng));
+        vis_weights.at(i, 0) = 1.0;
+        lha.at(i, 0) = dist(rng) * M_PI / 4.0;
+    }
+
+    PSWF kernel_creator(3);
+    GridAccumulator<PSWF, true> accumulator(kernel_creator, 3, workarea_size, false, 4, true, true, W_ProjectionPars(2, 7, 1, 0.0), 10.0, true,
+        FFTRoutine::FFTW_ESTIMATE_FFT, a_proj);
+    for (int c = 0; c < 2; c++) {
+        accumulator.add(uv, vis, vis_weights, w_lambda, lha);
+    }
+    return accumulator.finalize();
+}
+
+TEST(GridderAKernelCache, cached_awkernels)
+{
+    // AW-kernels are only cached when the angles are binned
+    GridderOutput expected = grid_chunks(A_ProjectionPars(3, 45.0, 0.0, false, 0.0, arma::mat(), pbeam_coefs, 2.0));
+    GridderOutput result = grid_chunks(A_ProjectionPars(3, 45.0, 0.0, false, 0.0, arma::mat(), pbeam_coefs, 2.0, true));
+
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.vis_grid), static_cast<arma::Mat<cx_real_t>>(expected.vis_grid), "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.sampling_grid), static_cast<arma::Mat<cx_real_t>>(expected.sampling_grid), "absdiff", fptolerance));
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the streaming gridder (GridAccumulator class).
+ *
+ * Visibilities are gridded in several chunks and the accumulated grids are compared against the
+ * result of gridding all visibilities at once using the convolve_to_grid function.
+ * With W-projection, all chunks must use the W-plane layout fixed by the first prepare call.
+ */
+
+const int image_size = 32;
+const int support = 3;
+const int n_vis = 200;
+const int n_chunks = 4;
+
+void test_grid_accumulator(bool kernel_exact, int oversampling, bool halfplane_gridding)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-image_size / 2.0, image_size / 2.0);
+
+    arma::mat uv(n_vis, 2);
+    arma::cx_mat vis(n_vis, 1);
+    arma::mat vis_weights(n_vis, 1);
+    for (int i = 0; i < n_vis; i++) {
+        uv.at(i, 0) = dist(rng);
+        uv.at(i, 1) = dist(rng);
+        vis.at(i, 0) = arma::cx_double(dist(rng), dist(rng));
+        vis_weights.at(i, 0) = 1.0 + std::abs(dist(rng));
+    }
+
+    Triangle triangle(2.0);
+    GridderOutput expected = convolve_to_grid<true>(triangle, support, image_size, uv, vis, vis_weights, kernel_exact, oversampling, true, halfplane_gridding);
+
+    GridAccumulator<Triangle, true> accumulator(triangle, support, image_size, kernel_exact, oversampling, true, halfplane_gridding);
+    const int chunk_size = n_vis / n_chunks;
+    for (int c = 0; c < n_chunks; c++) {
+        const arma::uword first = c * chunk_size;
+        const arma::uword last = first + chunk_size - 1;
+        accumulator.add(uv.rows(first, last), vis.rows(first, last), vis_weights.rows(first, last));
+    }
+    EXPECT_NEAR(accumulator.get_sample_grid_total(), expected.sample_grid_total, fptolerance * expected.sample_grid_total);
+    GridderOutput result = accumulator.finalize();
+
+    EXPECT_NEAR(result.sample_grid_total, expected.sample_grid_total, fptolerance * expected.sample_grid_total);
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.vis_grid), static_cast<arma::Mat<cx_real_t>>(expected.vis_grid), "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.sampling_grid), static_cast<arma::Mat<cx_real_t>>(expected.sampling_grid), "absdiff", fptolerance));
+}
+
+TEST(GridderGridAccumulator, exact)
+{
+    test_grid_accumulator(true, 1, true);
+    test_grid_accumulator(true, 1, false);
+}
+
+TEST(GridderGridAccumulator, oversampled)
+{
+    test_grid_accumulator(false, 9, true);
+    test_grid_accumulator(false, 9, false);
+}
+
+#ifdef WPROJECTION
+void test_grid_accumulator_wprojection(const W_ProjectionPars& w_proj)
+{
+    const int wp_image_size = 64;
+    const double cell_size = 30.0;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    arma::mat uv(n_vis, 2);
+    arma::vec w_lambda(n_vis);
+    arma::cx_mat vis(n_vis, 1);
+    arma::mat vis_weights(n_vis, 1);
+    for (int i = 0; i < n_vis; i++) {
+        uv.at(i, 0) = dist(rng) * wp_image_size / 2;
+        uv.at(i, 1) = dist(rng) * wp_image_size / 2;
+        w_lambda.at(i) = dist(rng) * 200.0;
+        vis.at(i, 0) = arma::cx_double(dist(rng), dist(rng));
+        vis_weights.at(i, 0) = 1.5 + dist(rng);
+    }
+
+    PSWF kernel_creator(support);
+    GridderOutput expected = convolve_to_grid<true>(kernel_creator, support, wp_image_size, uv, vis, vis_weights, false, 8, true, true,
+        w_proj, w_lambda, cell_size);
+
+    GridAccumulator<PSWF, true> accumulator(kernel_creator, support, wp_image_size, false, 8, true, true, w_proj, cell_size);
+    // Fix the W-plane layout of all visibilities
+    const GriddingGeometry full_geometry = accumulator.prepare(uv, vis_weights, w_lambda);
+
+    const int chunk_size = n_vis / n_chunks;
+    for (int c = 0; c < n_chunks; c++) {
+        const arma::uword first = c * chunk_size;
+        const arma::uword last = first + chunk_size - 1;
+        // Every chunk uses the same W-planes
+        const GriddingGeometry geometry = accumulator.prepare(uv.rows(first, last), vis_weights.rows(first, last), w_lambda.rows(first, last));
+        ASSERT_EQ(geometry.num_wplanes, full_geometry.num_wplanes);
+        EXPECT_TRUE(arma::approx_equal(geometry.w_avg_values, full_geometry.w_avg_values, "absdiff", 0.0));
+
+        accumulator.add(uv.rows(first, last), vis.rows(first, last), vis_weights.rows(first, last), w_lambda.rows(first, last));
+    }
+    GridderOutput result = accumulator.finalize();
+
+    EXPECT_NEAR(result.sample_grid_total, expected.sample_grid_total, fptolerance * expected.sample_grid_total);
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.vis_grid), static_cast<arma::Mat<cx_real_t>>(expected.vis_grid), "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.sampling_grid), static_cast<arma::Mat<cx_real_t>>(expected.sampling_grid), "absdiff", fptolerance));
+}
+
+TEST(GridderGridAccumulator, wprojection)
+{
+    W_ProjectionPars w_proj(4, 7);
+    test_grid_accumulator_wprojection(w_proj);
+}
+#endif
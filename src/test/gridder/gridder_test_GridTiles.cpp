@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the bucketing of visibilities by grid tile used by the multi-threaded gridder.
+ *
+ * Every kernel point of every visibility (and conjugate visibility) must be visited exactly once
+ * when all tiles are processed, including the kernels that wrap around the grid margins.
+ */
+
+class GridderGridTiles : public ::testing::Test {
+public:
+    void SetUp()
+    {
+        kernel_centre_on_grid = {
+            { 8, 4 },
+            { 1, 3 },
+            { 15, 0 },
+            { 0, 7 },
+            { 6, 15 },
+            { 13, 8 },
+        };
+        good_vis = { 1, 2, 1, 2, 0, 1 };
+    }
+
+    // Reference count of grid positions touched by the kernel of a visibility (see oversampled gridder)
+    int count_kernel_points(int gc_x, int gc_y, bool wrap_negative_rows)
+    {
+        int count = 0;
+        for (int j = 0; j < kernel_size; j++) {
+            for (int i = 0; i < kernel_size; i++) {
+                int grid_row = gc_y - support + i;
+                if (grid_row < 0) {
+                    if (!wrap_negative_rows)
+                        continue;
+                    grid_row += image_size;
+                }
+                if (grid_row >= image_size)
+                    grid_row -= image_size;
+                if (grid_row < image_rows)
+                    count++;
+            }
+        }
+        return count;
+    }
+
+    void run(bool wrap_negative_rows)
+    {
+        GridTiles tiles(image_size, image_rows, tile_size, wrap_negative_rows);
+        tiles.bin(kernel_centre_on_grid, good_vis, 0, good_vis.n_elem, support);
+
+        arma::Mat<int> visited(good_vis.n_elem, 2, arma::fill::zeros);
+        for (size_t tile = 0; tile < tiles.num_tiles(); ++tile) {
+            int row_begin, row_end, col_begin, col_end;
+            tiles.tile_range(tile, row_begin, row_end, col_begin, col_end);
+
+            arma::uword last_vis = 0;
+            for (size_t e = tiles.tile_begin(tile); e < tiles.tile_end(tile); ++e) {
+                const arma::uword vi = GridTiles::entry_vis(tiles.entries[e]);
+                const bool conj = GridTiles::entry_conj(tiles.entries[e]);
+                // Entries of a tile must be sorted by visibility index
+                EXPECT_GE(vi, last_vis);
+                last_vis = vi;
+
+                int gc_x = kernel_centre_on_grid(vi, 0);
+                int gc_y = kernel_centre_on_grid(vi, 1);
+                if (conj) {
+                    gc_x = -gc_x + image_size;
+                    gc_y = -gc_y + image_size;
+                }
+                TileSpan col_spans[3];
+                TileSpan row_spans[3];
+                int num_col_spans = intersect_footprint(gc_x - support, kernel_size, col_begin, col_end, image_size, true, col_spans);
+                int num_row_spans = intersect_footprint(gc_y - support, kernel_size, row_begin, row_end, image_size, wrap_negative_rows, row_spans);
+                for (int cs = 0; cs < num_col_spans; ++cs) {
+                    for (int rs = 0; rs < num_row_spans; ++rs) {
+                        // Grid positions must fall inside the tile
+                        EXPECT_GE(col_spans[cs].kbegin + col_spans[cs].grid_offset, col_begin);
+                        EXPECT_LE(col_spans[cs].kend + col_spans[cs].grid_offset, col_end);
+                        EXPECT_GE(row_spans[rs].kbegin + row_spans[rs].grid_offset, row_begin);
+                        EXPECT_LE(row_spans[rs].kend + row_spans[rs].grid_offset, row_end);
+                        visited(vi, conj) += (col_spans[cs].kend - col_spans[cs].kbegin) * (row_spans[rs].kend - row_spans[rs].kbegin);
+                    }
+                }
+            }
+        }
+
+        for (arma::uword vi = 0; vi < good_vis.n_elem; ++vi) {
+            const int gc_x = kernel_centre_on_grid(vi, 0);
+            const int gc_y = kernel_centre_on_grid(vi, 1);
+            int expected = (good_vis[vi] > 0) ? count_kernel_points(gc_x, gc_y, wrap_negative_rows) : 0;
+            int expected_conj = (good_vis[vi] > 1) ? count_kernel_points(-gc_x + image_size, -gc_y + image_size, wrap_negative_rows) : 0;
+            EXPECT_EQ(visited(vi, 0), expected);
+            EXPECT_EQ(visited(vi, 1), expected_conj);
+        }
+    }
+
+    const int image_size = 16;
+    const int image_rows = 9;
+    const int tile_size = 4;
+    const int support = 2;
+    const int kernel_size = 5;
+    arma::Mat<int> kernel_centre_on_grid;
+    arma::Col<uint> good_vis;
+};
+
+TEST_F(GridderGridTiles, halfplane_coverage)
+{
+    run(false);
+}
+
+TEST_F(GridderGridTiles, wrapped_coverage)
+{
+    run(true);
+}
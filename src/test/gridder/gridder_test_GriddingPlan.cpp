@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the gridding plan (GriddingPlan class).
+ *
+ * The plan is created once for a set of UVW-coordinates and weights, and used to grid two different sets of
+ * visibility values. Both results are compared against the convolve_to_grid function.
+ */
+
+const int image_size = 64;
+const int support = 3;
+const int n_vis = 300;
+const double cell_size = 30.0;
+
+class GriddingPlanData {
+public:
+    GriddingPlanData()
+        : uv(n_vis, 2)
+        , w_lambda(n_vis)
+        , vis_weights(n_vis, 1)
+        , vis1(n_vis, 1)
+        , vis2(n_vis, 1)
+    {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        for (int i = 0; i < n_vis; i++) {
+            uv.at(i, 0) = dist(rng) * image_size / 2;
+            uv.at(i, 1) = dist(rng) * image_size / 2;
+            w_lambda.at(i) = dist(rng) * 200.0;
+            vis_weights.at(i, 0) = 1.5 + dist(rng);
+            vis1.at(i, 0) = arma::cx_double(dist(rng), dist(rng));
+            vis2.at(i, 0) = arma::cx_double(dist(rng), dist(rng));
+        }
+    }
+
+    arma::mat uv;
+    arma::vec w_lambda;
+    arma::mat vis_weights;
+    arma::cx_mat vis1;
+    arma::cx_mat vis2;
+};
+
+void expect_equal_output(GridderOutput& result, GridderOutput& expected)
+{
+    EXPECT_NEAR(result.sample_grid_total, expected.sample_grid_total, fptolerance * expected.sample_grid_total);
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.vis_grid), static_cast<arma::Mat<cx_real_t>>(expected.vis_grid), "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.sampling_grid), static_cast<arma::Mat<cx_real_t>>(expected.sampling_grid), "absdiff", fptolerance));
+}
+
+void test_gridding_plan(bool kernel_exact, int oversampling, const W_ProjectionPars& w_proj = W_ProjectionPars())
+{
+    GriddingPlanData data;
+    PSWF kernel_creator(support);
+    arma::vec w_lambda = w_proj.isEnabled() ? data.w_lambda : arma::vec();
+
+    GriddingPlan<PSWF, true> plan(kernel_creator, support, image_size, data.uv, data.vis_weights, kernel_exact, oversampling, true, true,
+        w_proj, w_lambda, cell_size);
+    EXPECT_EQ(plan.num_vis(), size_t(n_vis));
+
+    for (const arma::cx_mat& vis : { data.vis1, data.vis2 }) {
+        GridderOutput expected = convolve_to_grid<true>(kernel_creator, support, image_size, data.uv, vis, data.vis_weights, kernel_exact, oversampling, true, true,
+            w_proj, w_lambda, cell_size);
+        GridderOutput result = plan.grid(vis);
+        expect_equal_output(result, expected);
+    }
+}
+
+TEST(GridderGriddingPlan, exact)
+{
+    test_gridding_plan(true, 1);
+}
+
+TEST(GridderGriddingPlan, oversampled)
+{
+    test_gridding_plan(false, 8);
+}
+
+#ifdef WPROJECTION
+TEST(GridderGriddingPlan, wprojection)
+{
+    W_ProjectionPars w_proj(4, 7);
+    test_gridding_plan(false, 8, w_proj);
+}
+#endif
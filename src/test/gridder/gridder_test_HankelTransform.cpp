@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the Hankel transform methods of W-projection: the fast Hankel transform and the batched DHT produce the same W-kernels
+ * as the DHT matrix.
+ */
+
+#ifdef WPROJECTION
+
+const uint workarea_size = 512;
+const uint oversampling = 8;
+const double cell_size = 10.0;
+
+W_ProjectionPars hankel_w_proj(HankelMethod hankel_method)
+{
+    return W_ProjectionPars(1, 15, 1, 0.0, true, false, InterpType::CUBIC, false, false, "", 0.0, 0.0, hankel_method);
+}
+
+// W-kernels of the given W value
+KernelBank hankel_kernels(const W_ProjectionPars& w_proj, real_t w_value, bool batched = false)
+{
+    PSWF kernel_creator(3);
+    arma::Col<real_t> aa_kernel_img = ImgDomKernel(kernel_creator, workarea_size);
+    WideFieldImaging generator(workarea_size, arc_sec_to_rad(cell_size), oversampling, 1.0, w_proj);
+    if (batched) {
+        arma::Col<real_t> w_values = { real_t(100.0), w_value, real_t(-3000.0) };
+        generator.transform_hankel_batch(w_values, aa_kernel_img);
+    }
+    generator.generate_convolution_kernel_wproj(w_value, aa_kernel_img);
+    return generator.generate_kernel_cache();
+}
+
+real_t max_kernel_diff(const KernelBank& result, const KernelBank& expected)
+{
+    real_t max_diff = 0.0;
+    for (size_t cp_x = 0; cp_x < expected.num_offsets(); cp_x++) {
+        for (size_t cp_y = 0; cp_y < expected.num_offsets(); cp_y++) {
+            max_diff = std::max(max_diff, real_t(arma::abs(result.kernel_mat(cp_y, cp_x) - expected.kernel_mat(cp_y, cp_x)).max()));
+        }
+    }
+    return max_diff;
+}
+
+TEST(GridderHankelTransform, fht)
+{
+    for (real_t w_value : { real_t(0.0), real_t(1500.0), real_t(-8000.0) }) {
+        KernelBank expected = hankel_kernels(hankel_w_proj(HankelMethod::DHT), w_value);
+        KernelBank result = hankel_kernels(hankel_w_proj(HankelMethod::FHT), w_value);
+
+        ASSERT_EQ(result.kernel_size(), expected.kernel_size());
+        const real_t max_value = arma::abs(expected.kernel_mat(0, 0)).max();
+        EXPECT_LT(max_kernel_diff(result, expected), 1e-4 * max_value);
+    }
+}
+
+TEST(GridderHankelTransform, batched_dht)
+{
+    const real_t w_value = 1500.0;
+    KernelBank expected = hankel_kernels(hankel_w_proj(HankelMethod::DHT), w_value);
+    KernelBank result = hankel_kernels(hankel_w_proj(HankelMethod::DHT_BATCHED), w_value, true);
+
+    ASSERT_EQ(result.kernel_size(), expected.kernel_size());
+    EXPECT_LT(max_kernel_diff(result, expected), fptolerance);
+}
+
+TEST(GridderHankelTransform, batched_dht_imager)
+{
+    // Random visibilities with large w-terms
+    const int num_vis = 1000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    arma::mat uvw_lambda(num_vis, 3);
+    arma::cx_mat vis(num_vis, 1);
+    arma::mat vis_weights(num_vis, 1);
+    for (int i = 0; i < num_vis; i++) {
+        uvw_lambda.at(i, 0) = dist(rng) * 3000.0;
+        uvw_lambda.at(i, 1) = dist(rng) * 3000.0;
+        uvw_lambda.at(i, 2) = dist(rng) * 6000.0;
+        vis.at(i, 0) = std::polar(1.0, M_PI * dist(rng));
+        vis_weights.at(i, 0) = 1.0;
+    }
+    ImagerPars img_pars(256, 30.0, 1.0, KernelFunction::PSWF, 3, false, 8, true, true, true);
+    PSWF kernel_creator(img_pars.kernel_support);
+
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> expected = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars,
+        W_ProjectionPars(8, 15, 1, 0.0, true));
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars,
+        W_ProjectionPars(8, 15, 1, 0.0, true, false, InterpType::LINEAR, false, false, "", 0.0, 0.0, HankelMethod::DHT_BATCHED));
+
+    EXPECT_TRUE(arma::approx_equal(result.first, expected.first, "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(result.second, expected.second, "absdiff", fptolerance));
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the layout of the oversampled kernel bank: every kernel column is cache-line-aligned and padded with zeros,
+ * and kernels are indexed by their oversampled-pixel offsets.
+ */
+
+TEST(GridderKernelBank, layout)
+{
+    const size_t num_offsets = 5;
+    for (size_t kernel_size = 1; kernel_size <= 17; kernel_size += 2) {
+        KernelBank bank(num_offsets, kernel_size);
+
+        EXPECT_EQ(bank.num_offsets(), num_offsets);
+        EXPECT_EQ(bank.kernel_size(), kernel_size);
+        EXPECT_GE(bank.kernel_ld(), kernel_size);
+        EXPECT_EQ((bank.kernel_ld() * sizeof(cx_real_t)) % CACHE_LINE_SIZE, 0);
+
+        // Fill kernels with values that identify the offsets and the kernel position
+        for (size_t cp_x = 0; cp_x < num_offsets; cp_x++) {
+            for (size_t cp_y = 0; cp_y < num_offsets; cp_y++) {
+                cx_real_t* kernel = bank.kernel(cp_y, cp_x);
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(kernel) % CACHE_LINE_SIZE, 0);
+                for (size_t j = 0; j < kernel_size; j++) {
+                    for (size_t i = 0; i < kernel_size; i++) {
+                        kernel[j * bank.kernel_ld() + i] = cx_real_t(real_t(cp_y * num_offsets + cp_x), real_t(j * kernel_size + i));
+                    }
+                }
+            }
+        }
+
+        for (size_t cp_x = 0; cp_x < num_offsets; cp_x++) {
+            for (size_t cp_y = 0; cp_y < num_offsets; cp_y++) {
+                arma::Mat<cx_real_t> kernel = bank.kernel_mat(cp_y, cp_x);
+                ASSERT_EQ(kernel.n_rows, kernel_size);
+                ASSERT_EQ(kernel.n_cols, kernel_size);
+                for (size_t j = 0; j < kernel_size; j++) {
+                    for (size_t i = 0; i < kernel_size; i++) {
+                        EXPECT_EQ(kernel.at(i, j), cx_real_t(real_t(cp_y * num_offsets + cp_x), real_t(j * kernel_size + i)));
+                    }
+                    // Padding is left untouched (zeros)
+                    const cx_real_t* kernel_col = bank.kernel(cp_y, cp_x) + j * bank.kernel_ld();
+                    for (size_t i = kernel_size; i < bank.kernel_ld(); i++) {
+                        EXPECT_EQ(kernel_col[i], cx_real_t(0.0, 0.0));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(GridderKernelBank, conjugates)
+{
+    const size_t num_offsets = 3;
+    const size_t kernel_size = 5;
+    KernelBank bank(num_offsets, kernel_size, true);
+    EXPECT_TRUE(bank.has_conjugates());
+    EXPECT_FALSE(KernelBank(num_offsets, kernel_size).has_conjugates());
+
+    for (size_t cp_x = 0; cp_x < num_offsets; cp_x++) {
+        for (size_t cp_y = 0; cp_y < num_offsets; cp_y++) {
+            cx_real_t* kernel = bank.kernel(cp_y, cp_x);
+            for (size_t j = 0; j < kernel_size; j++) {
+                for (size_t i = 0; i < kernel_size; i++) {
+                    kernel[j * bank.kernel_ld() + i] = cx_real_t(real_t(cp_y * num_offsets + cp_x), real_t(j * kernel_size + i + 1));
+                }
+            }
+        }
+    }
+    bank.generate_conjugates();
+
+    // Conjugate kernels are aligned and hold the conjugate values of the regular kernels
+    for (size_t cp_x = 0; cp_x < num_offsets; cp_x++) {
+        for (size_t cp_y = 0; cp_y < num_offsets; cp_y++) {
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(bank.kernel(cp_y, cp_x, true)) % CACHE_LINE_SIZE, 0);
+            EXPECT_EQ(bank.kernel(cp_y, cp_x, false), bank.kernel(cp_y, cp_x));
+            arma::Mat<cx_real_t> kernel = bank.kernel_mat(cp_y, cp_x);
+            arma::Mat<cx_real_t> conj_kernel = bank.kernel_mat(cp_y, cp_x, true);
+            for (size_t j = 0; j < kernel_size; j++) {
+                for (size_t i = 0; i < kernel_size; i++) {
+                    EXPECT_EQ(conj_kernel.at(i, j), std::conj(kernel.at(i, j)));
+                }
+            }
+        }
+    }
+}
@@ -59,3 +59,21 @@ TEST(GridderKernelCaching, equal)
         }
     }
 }
+
+TEST(GridderKernelCaching, separable)
+{
+    Triangle triangle(half_base_width);
+    arma::field<arma::Mat<cx_real_t>> kernel_cache = populate_kernel_cache(triangle, support, oversampling);
+    arma::Mat<real_t> kernel1D_cache = populate_kernel_cache_1D(triangle, support, oversampling);
+
+    EXPECT_EQ(kernel1D_cache.n_rows, uint(2 * support + 1));
+    EXPECT_EQ(kernel1D_cache.n_cols, kernel_cache.n_cols);
+
+    // The 2D kernel at each pair of oversampled offsets is the outer product of the 1D kernels
+    for (arma::uword cp_x = 0; cp_x < kernel_cache.n_cols; ++cp_x) {
+        for (arma::uword cp_y = 0; cp_y < kernel_cache.n_rows; ++cp_y) {
+            arma::Mat<real_t> separable_kernel = kernel1D_cache.col(cp_y) * kernel1D_cache.col(cp_x).t();
+            EXPECT_TRUE(arma::approx_equal(arma::Mat<real_t>(arma::real(kernel_cache(cp_y, cp_x))), separable_kernel, "absdiff", fptolerance));
+        }
+    }
+}
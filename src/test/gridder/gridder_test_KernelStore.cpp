@@ -0,0 +1,148 @@
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <stp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace stp;
+
+/**
+ * Tests the on-disk W-kernel store: kernel banks are stored and memory-mapped back, and W-projection kernels loaded from disk
+ * match the generated ones.
+ */
+
+bool file_exists(const std::string& filename)
+{
+    struct stat file_stat;
+    return stat(filename.c_str(), &file_stat) == 0;
+}
+
+// Create a unique temporary directory for the kernel files of a test
+std::string make_store_dir()
+{
+    const char* tmp_dir = std::getenv("TMPDIR");
+    std::string dir_template = std::string((tmp_dir != nullptr) ? tmp_dir : "/tmp") + "/test_kernel_store.XXXXXX";
+    if (mkdtemp(&dir_template[0]) == nullptr) {
+        throw std::runtime_error("Unable to create temporary kernel store directory: " + dir_template);
+    }
+    return dir_template;
+}
+
+// Remove the kernel files and the directory of a test
+void remove_store_dir(const std::string& store_dir)
+{
+    DIR* dir = opendir(store_dir.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if ((name != ".") && (name != "..")) {
+            std::remove((store_dir + "/" + name).c_str());
+        }
+    }
+    closedir(dir);
+    rmdir(store_dir.c_str());
+}
+
+TEST(GridderKernelStore, store_load)
+{
+    const size_t num_offsets = 5;
+    const uint support = 4;
+    const uint64_t key = KernelStoreKey().add(42).value();
+    const real_t w_value = 1234.5;
+
+    KernelBank bank(num_offsets, 2 * support + 1);
+    for (size_t i = 0; i < bank.num_elems(); i++) {
+        bank.data()[i] = cx_real_t(real_t(i), -real_t(i % 7));
+    }
+
+    const std::string store_dir = make_store_dir();
+    KernelStore store(store_dir);
+    KernelBank loaded;
+    uint loaded_support = 0;
+    EXPECT_FALSE(store.load(key, w_value, loaded, loaded_support));
+
+    EXPECT_TRUE(store.store(key, w_value, bank, support));
+    EXPECT_TRUE(file_exists(store.kernel_filename(key, w_value)));
+    ASSERT_TRUE(store.load(key, w_value, loaded, loaded_support));
+
+    EXPECT_EQ(loaded_support, support);
+    EXPECT_EQ(loaded.num_offsets(), bank.num_offsets());
+    EXPECT_EQ(loaded.kernel_size(), bank.kernel_size());
+    EXPECT_EQ(loaded.kernel_ld(), bank.kernel_ld());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(loaded.data()) % CACHE_LINE_SIZE, 0);
+    for (size_t cp_x = 0; cp_x < num_offsets; cp_x++) {
+        for (size_t cp_y = 0; cp_y < num_offsets; cp_y++) {
+            EXPECT_TRUE(arma::all(arma::vectorise(loaded.kernel_mat(cp_y, cp_x) == bank.kernel_mat(cp_y, cp_x))));
+        }
+    }
+
+    // Other parameters or W values are not found
+    KernelBank other;
+    EXPECT_FALSE(store.load(key + 1, w_value, other, loaded_support));
+    EXPECT_FALSE(store.load(key, w_value + 1, other, loaded_support));
+    EXPECT_TRUE(other.is_empty());
+
+    remove_store_dir(store_dir);
+}
+
+TEST(GridderKernelStore, w_quantization)
+{
+    const std::string store_dir = make_store_dir();
+    KernelStore store(store_dir, 10.0);
+    EXPECT_EQ(store.quantize_w(1234.0), real_t(1230.0));
+    EXPECT_EQ(store.quantize_w(-1236.0), real_t(-1240.0));
+
+    KernelStore exact_store(store_dir);
+    EXPECT_EQ(exact_store.quantize_w(1234.0), real_t(1234.0));
+
+    remove_store_dir(store_dir);
+}
+
+#ifdef WPROJECTION
+TEST(GridderKernelStore, wproj_kernels)
+{
+    const uint workarea_size = 64;
+    const uint oversampling = 8;
+    const double cell_size = arc_sec_to_rad(10.0);
+    const real_t w_value = 8000.0;
+    PSWF kernel_creator(3);
+    arma::Col<real_t> aa_kernel_img = ImgDomKernel(kernel_creator, workarea_size);
+
+    W_ProjectionPars w_proj(1, 7, 1, 1.0);
+    WideFieldImaging generator(workarea_size, cell_size, oversampling, 1.0, w_proj);
+    generator.generate_convolution_kernel_wproj(w_value, aa_kernel_img);
+    KernelBank expected = generator.generate_kernel_cache();
+    const uint expected_support = generator.get_trunc_conv_support();
+
+    // The first run generates and stores the kernels, the second one loads them
+    const std::string store_dir = make_store_dir();
+    w_proj.kernel_cache_dir = store_dir;
+    for (int run = 0; run < 2; run++) {
+        WideFieldImaging cached_generator(workarea_size, cell_size, oversampling, 1.0, w_proj);
+        cached_generator.generate_convolution_kernel_wproj(w_value, aa_kernel_img);
+        KernelBank result = cached_generator.generate_kernel_cache();
+
+        EXPECT_EQ(cached_generator.get_trunc_conv_support(), expected_support);
+        ASSERT_EQ(result.kernel_size(), expected.kernel_size());
+        for (size_t cp_x = 0; cp_x < expected.num_offsets(); cp_x++) {
+            for (size_t cp_y = 0; cp_y < expected.num_offsets(); cp_y++) {
+                EXPECT_TRUE(arma::all(arma::vectorise(result.kernel_mat(cp_y, cp_x) == expected.kernel_mat(cp_y, cp_x))));
+            }
+        }
+    }
+
+    // A different AA-kernel does not use the stored kernels
+    PSWF other_kernel_creator(5);
+    arma::Col<real_t> other_aa_kernel_img = ImgDomKernel(other_kernel_creator, workarea_size);
+    WideFieldImaging other_generator(workarea_size, cell_size, oversampling, 1.0, w_proj);
+    other_generator.generate_convolution_kernel_wproj(w_value, other_aa_kernel_img);
+    KernelBank other = other_generator.generate_kernel_cache();
+    EXPECT_FALSE(arma::approx_equal(other.kernel_mat(0, 0), expected.kernel_mat(0, 0), "absdiff", fptolerance));
+
+    remove_store_dir(store_dir);
+}
+#endif
@@ -0,0 +1,69 @@
+#include <common/spharmonics.h>
+#include <gtest/gtest.h>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the primary beam evaluator: the tabulated A-kernels match the direct evaluation of the spherical harmonics at every pixel.
+ */
+
+const int workarea_size = 64;
+// Wide field of view, so that the azimuthal terms are significant
+const double fov = 1.0;
+
+// The A-kernels are stored with real_t type, so the float case presents larger error
+#ifdef USE_FLOAT
+const double pbeam_tolerance(1.0e-5);
+#else
+const double pbeam_tolerance(1.0e-12);
+#endif
+
+// A-kernel evaluated pixel by pixel with the spherical harmonics library
+arma::Mat<real_t> reference_a_kernel(const std::vector<double>& pbeam_coefs, double rot_angle)
+{
+    const int degree = int((pbeam_coefs.size() - 1) / 2);
+    const int workarea_centre = workarea_size / 2;
+    arma::Mat<real_t> Akernel(workarea_size, workarea_size);
+    for (int j = -workarea_centre; j < workarea_centre; ++j) {
+        for (int i = -workarea_centre; i < workarea_centre; ++i) {
+            const double j_rad = double(j) * fov / double(workarea_size);
+            const double i_rad = double(i) * fov / double(workarea_size);
+            const double theta = std::sqrt(j_rad * j_rad + i_rad * i_rad);
+            const double phi = (j != 0) ? std::atan(i_rad / j_rad) : M_PI / 2.0;
+            double beam = 0.0;
+            for (int m = -degree; m <= degree; m++) {
+                beam += std::abs(sh::EvalSH(degree, m, phi + rot_angle, theta) * pbeam_coefs[degree + m]);
+            }
+            Akernel(size_t(j + workarea_centre), size_t(i + workarea_centre)) = real_t(1.0 / beam);
+        }
+    }
+    return Akernel;
+}
+
+void test_primary_beam(const std::vector<double>& pbeam_coefs)
+{
+    PrimaryBeam beam(pbeam_coefs, fov, workarea_size);
+    for (double rot_angle : { 0.0, 0.7, -2.5 }) {
+        arma::Mat<real_t> expected = reference_a_kernel(pbeam_coefs, rot_angle);
+        arma::Mat<real_t> result = beam.a_kernel(rot_angle);
+
+        ASSERT_EQ(result.n_rows, expected.n_rows);
+        ASSERT_EQ(result.n_cols, expected.n_cols);
+        real_t max_rel_diff = 0.0;
+        for (size_t i = 0; i < expected.n_elem; i++) {
+            max_rel_diff = std::max(max_rel_diff, std::abs(result[i] - expected[i]) / std::abs(expected[i]));
+        }
+        EXPECT_LT(max_rel_diff, pbeam_tolerance);
+    }
+}
+
+TEST(GridderPrimaryBeam, degree1)
+{
+    test_primary_beam({ 0.2, 1.0, 0.2 });
+}
+
+TEST(GridderPrimaryBeam, degree6)
+{
+    test_primary_beam({ 0.05, -0.1, 0.02, 0.3, -0.2, 0.1, 1.0, 0.1, 0.25, -0.05, 0.3, 0.0, 0.1 });
+}
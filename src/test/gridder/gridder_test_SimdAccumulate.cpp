@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the SIMD block-accumulate routines used by the gridder.
+ *
+ * Every routine supported by the CPU is compared against a reference std::complex implementation, for both
+ * single and double precision, several block sizes (including remaining elements), and both kernel signs.
+ */
+
+template <typename T>
+void test_accumulate_block(SimdLevel level, double tolerance)
+{
+    AccumulateBlockFn<T> routine = accumulate_block_routine<T>(level);
+    if (routine == nullptr) {
+        return; // Instruction set not supported by this CPU
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<T> dist(-1.0, 1.0);
+
+    const int n_cols = 3;
+    const int grid_ld = 40;
+    for (int n_rows = 1; n_rows <= 33; n_rows++) {
+        for (int conj = 0; conj < 2; conj++) {
+            // Kernel block is n_rows x n_cols, grid blocks are taken from grid_ld x n_cols matrices
+            const int n = grid_ld * n_cols;
+            std::vector<std::complex<T>> kernel(n_rows * n_cols), grid(n), sampling(n);
+            for (size_t i = 0; i < kernel.size(); i++) {
+                kernel[i] = std::complex<T>(dist(rng), dist(rng));
+            }
+            for (int i = 0; i < n; i++) {
+                grid[i] = std::complex<T>(dist(rng), dist(rng));
+                sampling[i] = std::complex<T>(dist(rng), dist(rng));
+            }
+            const std::complex<T> vis_val(dist(rng), dist(rng));
+            const T vis_weight = dist(rng);
+
+            std::vector<std::complex<T>> expected_grid(grid), expected_sampling(sampling), kernel_vals(n);
+            for (int j = 0; j < n_cols; j++) {
+                for (int i = 0; i < n_rows; i++) {
+                    const std::complex<T> k = kernel[j * n_rows + i];
+                    kernel_vals[j * grid_ld + i] = (conj ? std::conj(k) : k) * vis_weight;
+                    expected_grid[j * grid_ld + i] += vis_val * kernel_vals[j * grid_ld + i];
+                    expected_sampling[j * grid_ld + i] += kernel_vals[j * grid_ld + i];
+                }
+            }
+
+            routine(grid.data(), grid_ld, sampling.data(), grid_ld, kernel.data(), n_rows, n_rows, n_cols, vis_val, vis_weight, conj != 0);
+            for (int i = 0; i < n; i++) {
+                EXPECT_NEAR(grid[i].real(), expected_grid[i].real(), tolerance);
+                EXPECT_NEAR(grid[i].imag(), expected_grid[i].imag(), tolerance);
+                EXPECT_NEAR(sampling[i].real(), expected_sampling[i].real(), tolerance);
+                EXPECT_NEAR(sampling[i].imag(), expected_sampling[i].imag(), tolerance);
+            }
+
+            // Without sampling grid
+            std::vector<std::complex<T>> grid_nosampl(expected_grid);
+            routine(grid_nosampl.data(), grid_ld, nullptr, 0, kernel.data(), n_rows, n_rows, n_cols, vis_val, vis_weight, conj != 0);
+            for (int i = 0; i < n; i++) {
+                EXPECT_NEAR(grid_nosampl[i].real(), (expected_grid[i] + vis_val * kernel_vals[i]).real(), tolerance);
+                EXPECT_NEAR(grid_nosampl[i].imag(), (expected_grid[i] + vis_val * kernel_vals[i]).imag(), tolerance);
+            }
+        }
+    }
+}
+
+TEST(GridderSimdAccumulate, single_precision)
+{
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE3, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        test_accumulate_block<float>(level, 1.0e-5);
+    }
+}
+
+TEST(GridderSimdAccumulate, double_precision)
+{
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE3, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        test_accumulate_block<double>(level, 1.0e-12);
+    }
+}
+
+TEST(GridderSimdAccumulate, dispatch)
+{
+    // The widest instruction set is always available, and the scalar routine is available on every CPU
+    EXPECT_NE(accumulate_block_routine<real_t>(simd_level()), nullptr);
+    EXPECT_NE(accumulate_block_routine<real_t>(SimdLevel::Scalar), nullptr);
+}
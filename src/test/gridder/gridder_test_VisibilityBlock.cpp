@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the visibility block (VisibilityBlock class) filled by GridAccumulator::prepare.
+ *
+ * Visibilities that fall outside the grid must be compacted away, and the remaining ones must keep their order.
+ * Visibilities that receive an identical kernel must be coalesced into a single entry (VisibilityGroups class),
+ * and gridding the coalesced visibilities must give the same grids as gridding each visibility (see COALESCED_GRIDDER).
+ */
+
+const int image_size = 16;
+const int support = 2;
+
+TEST(GridderVisibilityBlock, compaction)
+{
+    // Visibilities 1 and 3 fall outside the grid
+    arma::mat uv = { { 1.2, 2.3 }, { 7.0, 1.0 }, { -3.4, -0.2 }, { 0.0, -8.0 }, { -2.0, 4.6 } };
+    arma::mat vis_weights(uv.n_rows, 1);
+    arma::cx_mat vis(uv.n_rows, 1);
+    for (arma::uword i = 0; i < uv.n_rows; ++i) {
+        vis_weights.at(i, 0) = double(i + 1);
+        vis.at(i, 0) = arma::cx_double(double(i + 1), -double(i + 1));
+    }
+
+    Triangle triangle(1.5);
+    GridAccumulator<Triangle, true> accumulator(triangle, support, image_size, false, 5, true, true);
+    GriddingGeometry geometry = accumulator.prepare(uv, vis_weights);
+    VisibilityBlock& vis_block = geometry.vis_block;
+
+    const arma::uvec expected_idx = { 0, 2, 4 };
+    EXPECT_EQ(geometry.num_vis, uv.n_rows);
+    ASSERT_EQ(vis_block.size(), expected_idx.n_elem);
+    for (arma::uword i = 0; i < vis_block.size(); ++i) {
+        EXPECT_EQ(vis_block.source_idx[i], expected_idx[i]);
+        EXPECT_GT(vis_block.good_vis[i], 0u);
+        EXPECT_EQ(vis_block.vis_weights[i], vis_weights[expected_idx[i]]);
+    }
+    // Sum of the weights of the gridded visibilities (doubled because of halfplane gridding)
+    EXPECT_NEAR(geometry.sample_grid_total, 2.0 * (1.0 + 3.0 + 5.0), fptolerance);
+
+    // Visibilities moved to the bottom half-plane are conjugated
+    vis_block.load_visibilities(StridedView<std::complex<double>>(vis));
+    ASSERT_EQ(vis_block.vis.n_elem, expected_idx.n_elem);
+    for (arma::uword i = 0; i < vis_block.size(); ++i) {
+        const arma::cx_double val = vis[expected_idx[i]];
+        const arma::cx_double expected = (uv.at(expected_idx[i], 1) < 0.0) ? std::conj(val) : val;
+        EXPECT_EQ(vis_block.vis_conj[i], (uv.at(expected_idx[i], 1) < 0.0) ? 1u : 0u);
+        EXPECT_NEAR(vis_block.vis[i].real(), expected.real(), fptolerance);
+        EXPECT_NEAR(vis_block.vis[i].imag(), expected.imag(), fptolerance);
+    }
+}
+
+TEST(GridderVisibilityBlock, coalescing)
+{
+    // Visibilities 0, 2 and 3 share the grid cell and the oversampled kernel offsets, visibility 1 only shares the grid cell
+    arma::mat uv = { { 1.01, 2.02 }, { 1.3, 2.0 }, { 0.99, 1.98 }, { 1.0, 2.0 }, { -3.0, 4.0 } };
+    arma::mat vis_weights(uv.n_rows, 1);
+    arma::cx_mat vis(uv.n_rows, 1);
+    for (arma::uword i = 0; i < uv.n_rows; ++i) {
+        vis_weights.at(i, 0) = double(i + 1);
+        vis.at(i, 0) = arma::cx_double(double(i + 1), -double(i + 1));
+    }
+
+    Triangle triangle(1.5);
+    GridAccumulator<Triangle, true> accumulator(triangle, support, image_size, false, 5, true, true);
+    GriddingGeometry geometry = accumulator.prepare(uv, vis_weights);
+    geometry.vis_block.load_visibilities(StridedView<std::complex<double>>(vis));
+
+    VisibilityGroups vis_groups(geometry.vis_block, arma::uvec(), arma::ivec());
+    ASSERT_EQ(vis_groups.block.size(), 3u);
+    ASSERT_EQ(vis_groups.member_offsets.n_elem, 4u);
+    EXPECT_EQ(vis_groups.plane_firstidx[0], 0u);
+    arma::uword largest_group = 0;
+    for (arma::uword g = 0; g < vis_groups.block.size(); ++g) {
+        largest_group = std::max(largest_group, vis_groups.member_offsets[g + 1] - vis_groups.member_offsets[g]);
+    }
+    EXPECT_EQ(largest_group, 3u);
+
+    vis_groups.load_visibilities(geometry.vis_block);
+    double total_weight = 0.0;
+    for (arma::uword g = 0; g < vis_groups.block.size(); ++g) {
+        // The group is gridded with the summed weight and the weighted mean of its visibilities
+        double weights_sum = 0.0;
+        arma::cx_double weighted_sum(0.0, 0.0);
+        for (arma::uword i = vis_groups.member_offsets[g]; i < vis_groups.member_offsets[g + 1]; ++i) {
+            const arma::uword vi = vis_groups.members[i];
+            weights_sum += geometry.vis_block.vis_weights[vi];
+            weighted_sum += arma::cx_double(geometry.vis_block.vis[vi]) * geometry.vis_block.vis_weights[vi];
+            EXPECT_EQ(geometry.vis_block.kernel_centre_on_grid.at(vi, 0), vis_groups.block.kernel_centre_on_grid.at(g, 0));
+            EXPECT_EQ(geometry.vis_block.kernel_centre_on_grid.at(vi, 1), vis_groups.block.kernel_centre_on_grid.at(g, 1));
+            EXPECT_EQ(geometry.vis_block.oversampled_offset.at(vi, 0), vis_groups.block.oversampled_offset.at(g, 0));
+            EXPECT_EQ(geometry.vis_block.oversampled_offset.at(vi, 1), vis_groups.block.oversampled_offset.at(g, 1));
+        }
+        EXPECT_NEAR(vis_groups.block.vis_weights[g], weights_sum, fptolerance);
+        EXPECT_NEAR(vis_groups.block.vis[g].real(), (weighted_sum / weights_sum).real(), fptolerance);
+        EXPECT_NEAR(vis_groups.block.vis[g].imag(), (weighted_sum / weights_sum).imag(), fptolerance);
+        total_weight += weights_sum;
+    }
+    EXPECT_NEAR(total_weight, arma::accu(vis_weights), fptolerance);
+    EXPECT_EQ(vis_groups.member_offsets[3], uv.n_rows);
+    EXPECT_EQ(vis_groups.members.n_elem, uv.n_rows);
+}
+
+TEST(GridderVisibilityBlock, coalesced_gridding)
+{
+    // UV-coordinates are multiples of the oversampled cell size, so that many visibilities share the same kernel
+    const int oversampling = 5;
+    const int n_vis = 300;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> coord_dist(-(image_size / 2 - support - 1) * oversampling, (image_size / 2 - support - 1) * oversampling);
+    std::uniform_real_distribution<double> val_dist(-1.0, 1.0);
+
+    arma::mat uv(n_vis, 2);
+    arma::cx_mat vis(n_vis, 1);
+    arma::mat vis_weights(n_vis, 1);
+    for (int i = 0; i < n_vis; i++) {
+        uv.at(i, 0) = double(coord_dist(rng) / 8) / oversampling;
+        uv.at(i, 1) = double(coord_dist(rng) / 8) / oversampling;
+        vis.at(i, 0) = arma::cx_double(val_dist(rng), val_dist(rng));
+        vis_weights.at(i, 0) = 1.0 + std::abs(val_dist(rng));
+    }
+
+    Triangle triangle(1.5);
+    GridAccumulator<Triangle, true> accumulator(triangle, support, image_size, false, oversampling, true, true);
+    GridAccumulator<Triangle, true> coalesced_accumulator(triangle, support, image_size, false, oversampling, true, true);
+
+    // Visibilities gridded one by one
+    GriddingGeometry geometry = accumulator.prepare(uv, vis_weights);
+    geometry.vis_groups = VisibilityGroups();
+    accumulator.add(geometry, vis);
+
+    // Coalesced visibilities (as prepared by the gridder when compiled with COALESCED_GRIDDER)
+    GriddingGeometry coalesced_geometry = coalesced_accumulator.prepare(uv, vis_weights);
+    coalesced_geometry.vis_groups = VisibilityGroups(coalesced_geometry.vis_block, coalesced_geometry.w_planes_firstidx, arma::ivec());
+    ASSERT_LT(coalesced_geometry.vis_groups.block.size(), coalesced_geometry.vis_block.size());
+    coalesced_accumulator.add(coalesced_geometry, vis);
+
+    GridderOutput expected = accumulator.finalize();
+    GridderOutput result = coalesced_accumulator.finalize();
+    EXPECT_NEAR(result.sample_grid_total, expected.sample_grid_total, fptolerance * expected.sample_grid_total);
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.vis_grid), static_cast<arma::Mat<cx_real_t>>(expected.vis_grid), "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.sampling_grid), static_cast<arma::Mat<cx_real_t>>(expected.sampling_grid), "absdiff", fptolerance));
+}
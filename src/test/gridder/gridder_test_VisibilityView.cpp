@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests gridding from non-owning strided views of the visibility data (VisibilityView struct).
+ *
+ * The visibility data is stored interleaved (one record per visibility: u, v, w, weight), in wavelength units,
+ * and is gridded in place through strided views. The result is compared against the result of the convolve_to_grid
+ * function called with armadillo matrices of UV-coordinates in pixels.
+ */
+
+const int image_size = 32;
+const int support = 3;
+const int n_vis = 200;
+const int n_fields = 4;
+const double uv_scale = 0.5;
+
+void test_visibility_view(bool kernel_exact, int oversampling, bool halfplane_gridding)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-image_size / 2.0, image_size / 2.0);
+
+    // Interleaved records: each column stores (u, v, w, weight) of one visibility
+    arma::mat records(n_fields, n_vis);
+    arma::cx_mat vis(n_vis, 1);
+    for (int i = 0; i < n_vis; i++) {
+        records.at(0, i) = dist(rng) / uv_scale;
+        records.at(1, i) = dist(rng) / uv_scale;
+        records.at(2, i) = dist(rng);
+        records.at(3, i) = 1.0 + std::abs(dist(rng));
+        vis.at(i, 0) = arma::cx_double(dist(rng), dist(rng));
+    }
+
+    arma::mat uv(n_vis, 2);
+    arma::mat vis_weights(n_vis, 1);
+    for (int i = 0; i < n_vis; i++) {
+        uv.at(i, 0) = records.at(0, i) * uv_scale;
+        uv.at(i, 1) = records.at(1, i) * uv_scale;
+        vis_weights.at(i, 0) = records.at(3, i);
+    }
+
+    Triangle triangle(2.0);
+    GridderOutput expected = convolve_to_grid<true>(triangle, support, image_size, uv, vis, vis_weights, kernel_exact, oversampling, true, halfplane_gridding);
+
+    VisibilityView vis_data(StridedView<double>(records.memptr(), n_vis, n_fields), StridedView<double>(records.memptr() + 1, n_vis, n_fields),
+        StridedView<double>(records.memptr() + 2, n_vis, n_fields), StridedView<std::complex<double>>(vis), StridedView<double>(records.memptr() + 3, n_vis, n_fields));
+    GridderOutput result = convolve_to_grid<true>(triangle, support, image_size, vis_data, uv_scale, kernel_exact, oversampling, true, halfplane_gridding);
+
+    EXPECT_NEAR(result.sample_grid_total, expected.sample_grid_total, fptolerance * expected.sample_grid_total);
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.vis_grid), static_cast<arma::Mat<cx_real_t>>(expected.vis_grid), "absdiff", fptolerance));
+    EXPECT_TRUE(arma::approx_equal(static_cast<arma::Mat<cx_real_t>>(result.sampling_grid), static_cast<arma::Mat<cx_real_t>>(expected.sampling_grid), "absdiff", fptolerance));
+}
+
+TEST(GridderVisibilityView, strided_view)
+{
+    std::vector<double> data = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0 };
+    StridedView<double> view(data.data() + 1, 3, 2);
+
+    EXPECT_EQ(view.size(), 3u);
+    EXPECT_FALSE(view.is_empty());
+    EXPECT_EQ(view[0], 2.0);
+    EXPECT_EQ(view[1], 4.0);
+    EXPECT_EQ(view[2], 6.0);
+    EXPECT_TRUE(StridedView<double>().is_empty());
+}
+
+TEST(GridderVisibilityView, exact)
+{
+    test_visibility_view(true, 1, true);
+    test_visibility_view(true, 1, false);
+}
+
+TEST(GridderVisibilityView, oversampled)
+{
+    test_visibility_view(false, 9, true);
+    test_visibility_view(false, 9, false);
+}
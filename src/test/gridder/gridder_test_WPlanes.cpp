@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the error-driven placement of w-planes: every visibility is within the error bound of the W value of its plane,
+ * and planes are only created where there are visibilities.
+ */
+
+// Index of the plane of each visibility
+arma::uvec plane_of_visibilities(const arma::uvec& w_planes_firstidx, arma::uword num_vis)
+{
+    arma::uvec plane(num_vis);
+    arma::uword p = 0;
+    for (arma::uword k = 0; k < num_vis; k++) {
+        while ((p + 1 < w_planes_firstidx.n_elem) && (k >= w_planes_firstidx[p + 1])) {
+            p++;
+        }
+        plane[k] = p;
+    }
+    return plane;
+}
+
+// Sorted |w| of a mixed array: most visibilities have short baselines (small w), a few have long baselines
+arma::vec mixed_baseline_w(arma::uword num_vis)
+{
+    std::mt19937 rng(1);
+    std::exponential_distribution<double> short_w(1.0 / 200.0);
+    std::uniform_real_distribution<double> long_w(20000.0, 21000.0);
+    arma::vec w_lambda(num_vis);
+    for (arma::uword k = 0; k < num_vis; k++) {
+        w_lambda[k] = (k % 50 == 0) ? long_w(rng) : short_w(rng);
+    }
+    std::sort(w_lambda.begin(), w_lambda.end());
+    return w_lambda;
+}
+
+TEST(GridderWPlanes, error_bound)
+{
+    const arma::uword num_vis = 5000;
+    const double max_w_error = 50.0;
+    arma::vec w_lambda = mixed_baseline_w(num_vis);
+    arma::Col<uint> good_vis(num_vis);
+    good_vis.fill(1);
+    good_vis[10] = 0;
+    good_vis[num_vis - 1] = 0;
+
+    arma::Col<real_t> w_avg_values;
+    arma::uvec w_planes_firstidx;
+    double achieved_w_error = 0.0;
+    uint num_wplanes = adaptive_w_planes(w_lambda, good_vis, max_w_error, 100, w_avg_values, w_planes_firstidx, achieved_w_error);
+    EXPECT_LE(achieved_w_error, max_w_error);
+
+    ASSERT_EQ(w_avg_values.n_elem, num_wplanes);
+    ASSERT_EQ(w_planes_firstidx.n_elem, num_wplanes);
+    EXPECT_EQ(w_planes_firstidx[0], 0u);
+
+    // The gap between short and long baselines does not need planes: the long baselines fit in a few planes
+    const double w_range = w_lambda.max() - w_lambda.min();
+    EXPECT_LT(num_wplanes, uint(w_range / (2.0 * max_w_error)) / 4);
+
+    arma::uvec plane = plane_of_visibilities(w_planes_firstidx, num_vis);
+    for (arma::uword k = 0; k < num_vis; k++) {
+        if (good_vis[k] != 0) {
+            EXPECT_LE(std::abs(w_lambda[k] - double(w_avg_values[plane[k]])), achieved_w_error * (1.0 + 1e-6));
+        }
+    }
+}
+
+TEST(GridderWPlanes, max_num_wplanes)
+{
+    const arma::uword num_vis = 2000;
+    arma::vec w_lambda = mixed_baseline_w(num_vis);
+    arma::Col<uint> good_vis(num_vis);
+    good_vis.fill(1);
+
+    // The error bound is relaxed when the planes do not fit
+    arma::Col<real_t> w_avg_values;
+    arma::uvec w_planes_firstidx;
+    double achieved_w_error = 0.0;
+    uint num_wplanes = adaptive_w_planes(w_lambda, good_vis, 1.0, 8, w_avg_values, w_planes_firstidx, achieved_w_error);
+    EXPECT_GT(achieved_w_error, 1.0);
+    EXPECT_GE(num_wplanes, 1u);
+    EXPECT_LE(num_wplanes, 8u);
+    for (uint p = 1; p < num_wplanes; p++) {
+        EXPECT_GT(w_planes_firstidx[p], w_planes_firstidx[p - 1]);
+    }
+    // The relaxed error bound is the achieved error
+    arma::uvec plane = plane_of_visibilities(w_planes_firstidx, num_vis);
+    for (arma::uword k = 0; k < num_vis; k++) {
+        EXPECT_LE(std::abs(w_lambda[k] - double(w_avg_values[plane[k]])), achieved_w_error * (1.0 + 1e-6));
+    }
+
+    // Without valid visibilities a single plane is used
+    good_vis.zeros();
+    num_wplanes = adaptive_w_planes(w_lambda, good_vis, 1.0, 8, w_avg_values, w_planes_firstidx, achieved_w_error);
+    EXPECT_EQ(num_wplanes, 1u);
+    EXPECT_EQ(w_planes_firstidx[0], 0u);
+}
+
+TEST(GridderWPlanes, max_w_plane_error)
+{
+    const double max_phase_error = 0.1;
+    const double cell_size = 30.0;
+    const int image_size = 2048;
+    const double w_error = max_w_plane_error(max_phase_error, cell_size, image_size);
+
+    // Phase error of the w-term at the image corners
+    const double l = arc_sec_to_rad(cell_size) * double(image_size / 2);
+    const double n = std::sqrt(1.0 - 2.0 * l * l);
+    EXPECT_NEAR(2.0 * M_PI * w_error * (1.0 - n), max_phase_error, 1e-12);
+}
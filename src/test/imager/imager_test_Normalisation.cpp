@@ -0,0 +1,77 @@
+/** @file imager_test_Normalisation.cpp
+ *  @brief Test normalisation of the imager results
+ *
+ *  TestCase to test the fused crop, normalisation and gridding correction
+ *  of the FFT results against a pixel by pixel reference
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+#ifndef FFTSHIFT
+
+const double norm_tolerance = 1.0e-6;
+
+// Cropped and normalised image computed pixel by pixel (the quadrants of the cropped image are on the corners of the padded image)
+arma::Mat<real_t> reference_normalisation(const arma::Mat<real_t>& fft_result, const arma::Col<real_t>& gcf, size_t image_size,
+    real_t normalization_factor, bool grid_correction)
+{
+    const size_t padded_image_size = fft_result.n_cols;
+    arma::Mat<real_t> result(image_size, image_size);
+    for (size_t j = 0; j < image_size; j++) {
+        const size_t orig_j = (j < image_size / 2) ? j : (padded_image_size - image_size + j);
+        const size_t gcf_j = (j < image_size / 2) ? (padded_image_size / 2 + j) : (padded_image_size / 2 + j - image_size);
+        for (size_t i = 0; i < image_size; i++) {
+            const size_t orig_i = (i < image_size / 2) ? i : (padded_image_size - image_size + i);
+            const size_t gcf_i = (i < image_size / 2) ? (padded_image_size / 2 + i) : (padded_image_size / 2 + i - image_size);
+            result.at(i, j) = fft_result.at(orig_i, orig_j) * normalization_factor;
+            if (grid_correction) {
+                result.at(i, j) /= (gcf[gcf_i] * gcf[gcf_j]);
+            }
+        }
+    }
+    return result;
+}
+
+TEST(ImagerNormalisation, CropNormalise)
+{
+    const size_t image_size = 64;
+    const double sample_grid_total = 250.0;
+    for (double padding_factor : { 1.0, 2.0 }) {
+        for (bool gridding_correction : { false, true }) {
+            ImagerPars img_pars(image_size, 10.0, padding_factor, KernelFunction::PSWF, 3, false, 8, true, gridding_correction, true);
+            PSWF kernel_creator(img_pars.kernel_support);
+            const size_t n = img_pars.padded_image_size;
+
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<double> dist(-1.0, 1.0);
+            arma::Mat<real_t> fft_result_image(n, n);
+            arma::Mat<real_t> fft_result_beam(n, n);
+            for (size_t i = 0; i < n * n; i++) {
+                fft_result_image[i] = real_t(dist(rng));
+                fft_result_beam[i] = real_t(dist(rng));
+            }
+
+            arma::Col<real_t> gcf = ImgDomKernel(kernel_creator, n, false, img_pars.analytic_gcf);
+            const real_t normalization_factor = real_t(1.0 / sample_grid_total);
+            arma::Mat<real_t> expected_image = reference_normalisation(fft_result_image, gcf, image_size, normalization_factor, gridding_correction);
+            arma::Mat<real_t> expected_beam = reference_normalisation(fft_result_beam, gcf, image_size, normalization_factor, gridding_correction);
+
+            std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = normalise_imaging_result(kernel_creator, fft_result_image, fft_result_beam,
+                sample_grid_total, img_pars);
+
+            ASSERT_EQ(result.first.n_rows, image_size);
+            ASSERT_EQ(result.first.n_cols, image_size);
+            EXPECT_TRUE(arma::approx_equal(result.first, expected_image, "reldiff", norm_tolerance));
+            EXPECT_TRUE(arma::approx_equal(result.second, expected_beam, "reldiff", norm_tolerance));
+            // FFT results are released
+            EXPECT_EQ(fft_result_image.n_elem, 0u);
+            EXPECT_EQ(fft_result_beam.n_elem, 0u);
+        }
+    }
+}
+
+#endif
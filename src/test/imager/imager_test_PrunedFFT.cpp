@@ -0,0 +1,82 @@
+/** @file imager_test_PrunedFFT.cpp
+ *  @brief Test imager with padded images
+ *
+ *  TestCase to test the pruned c2r FFT of padded images
+ *  against the full c2r FFT followed by the crop
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+const double fft_tolerance = 1.0e-4;
+
+// Random halfplane grid of the given padded size (rows of u values beyond max_u are zero)
+GridderOutput random_gridded_data(size_t padded_image_size, size_t max_u)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    GridderOutput gridded_data;
+    gridded_data.vis_grid.zeros(padded_image_size / 2 + 1, padded_image_size);
+    gridded_data.sampling_grid.zeros(padded_image_size / 2 + 1, padded_image_size);
+    for (size_t j = 0; j < padded_image_size; j++) {
+        for (size_t i = 0; i <= max_u; i++) {
+            gridded_data.vis_grid.at(i, j) = cx_real_t(real_t(dist(rng)), real_t(dist(rng)));
+            gridded_data.sampling_grid.at(i, j) = cx_real_t(real_t(std::abs(dist(rng))), real_t(0.0));
+        }
+    }
+    gridded_data.sample_grid_total = 100.0;
+    return gridded_data;
+}
+
+TEST(ImagerPrunedFFT, PrunedFFT)
+{
+    const size_t padded_image_size = 128;
+    for (size_t image_size : { 64, 96, 128 }) {
+        GridderOutput gridded_data = random_gridded_data(padded_image_size, 40);
+        arma::Mat<cx_real_t> input = gridded_data.vis_grid;
+        arma::Mat<real_t> expected;
+        fft_fftw_c2r(input, expected);
+
+        fft_fftw_c2r_pruned(gridded_data.vis_grid, image_size, FFTRoutine::FFTW_ESTIMATE_FFT);
+        for (size_t j = 0; j < padded_image_size; j++) {
+            if ((j >= image_size / 2) && (j < padded_image_size - image_size / 2)) {
+                continue;
+            }
+            const real_t* col = reinterpret_cast<const real_t*>(gridded_data.vis_grid.colptr(j));
+            for (size_t i = 0; i < padded_image_size; i++) {
+                EXPECT_NEAR(col[i], expected.at(i, j), fft_tolerance);
+            }
+        }
+    }
+}
+
+TEST(ImagerPrunedFFT, PaddedImage)
+{
+    const size_t image_size = 128;
+    for (double padding_factor : { 2.0, 4.0 }) {
+        for (bool gridding_correction : { false, true }) {
+            ImagerPars img_pars(image_size, 10.0, padding_factor, KernelFunction::PSWF, 3, false, 8, true, gridding_correction, true);
+            PSWF kernel_creator(img_pars.kernel_support);
+
+            // Full c2r FFT followed by the crop
+            GridderOutput expected_data = random_gridded_data(img_pars.padded_image_size, img_pars.padded_image_size / 4);
+            arma::Mat<real_t> fft_result_image;
+            arma::Mat<real_t> fft_result_beam;
+            fft_fftw_c2r(expected_data.vis_grid, fft_result_image);
+            fft_fftw_c2r(expected_data.sampling_grid, fft_result_beam);
+            std::pair<arma::Mat<real_t>, arma::Mat<real_t>> expected = normalise_imaging_result(kernel_creator, fft_result_image, fft_result_beam,
+                expected_data.sample_grid_total, img_pars);
+
+            GridderOutput gridded_data = random_gridded_data(img_pars.padded_image_size, img_pars.padded_image_size / 4);
+            std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = image_gridded_visibilities(kernel_creator, gridded_data, img_pars);
+
+            ASSERT_EQ(result.first.n_rows, image_size);
+            ASSERT_EQ(result.first.n_cols, image_size);
+            EXPECT_TRUE(arma::approx_equal(result.first, expected.first, "absdiff", fft_tolerance));
+            EXPECT_TRUE(arma::approx_equal(result.second, expected.second, "absdiff", fft_tolerance));
+        }
+    }
+}
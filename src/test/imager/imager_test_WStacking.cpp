@@ -0,0 +1,100 @@
+/** @file imager_test_WStacking.cpp
+ *  @brief Test imager with W-stacking
+ *
+ *  TestCase to test the W-stacking imaging mode
+ *  against the standard and W-projection imagers
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+#ifdef WPROJECTION
+
+const int image_size = 256;
+const double cell_size = 30.0;
+const int num_vis = 2000;
+
+// Random UVW-coordinates (w is zero if max_w is zero)
+arma::mat random_uvw(double max_uv, double max_w)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    arma::mat uvw_lambda(num_vis, 3);
+    for (int i = 0; i < num_vis; i++) {
+        uvw_lambda.at(i, 0) = dist(rng) * max_uv;
+        uvw_lambda.at(i, 1) = dist(rng) * max_uv;
+        uvw_lambda.at(i, 2) = dist(rng) * max_w;
+    }
+    return uvw_lambda;
+}
+
+// Visibilities of a point source of unit amplitude at pixel offsets (l_pix, m_pix) from the image centre, including the w-term
+// (with the sign convention of the W-kernels)
+arma::cx_mat point_source_vis(const arma::mat& uvw_lambda, double l_pix, double m_pix)
+{
+    const double l = l_pix * arc_sec_to_rad(cell_size);
+    const double m = m_pix * arc_sec_to_rad(cell_size);
+    const double n = std::sqrt(1.0 - l * l - m * m);
+    arma::cx_mat vis(num_vis, 1);
+    for (int i = 0; i < num_vis; i++) {
+        const double phase = -2.0 * M_PI * (uvw_lambda.at(i, 0) * l + uvw_lambda.at(i, 1) * m - uvw_lambda.at(i, 2) * (n - 1.0));
+        vis.at(i, 0) = std::polar(1.0, phase);
+    }
+    return vis;
+}
+
+ImagerPars wstacking_imager_pars(bool generate_beam)
+{
+    ImagerPars img_pars(image_size, cell_size, 1.0, KernelFunction::PSWF, 3, false, 8, generate_beam, true, true);
+    img_pars.padded_image_size = image_size;
+    return img_pars;
+}
+
+TEST(ImagerWStacking, zero_w)
+{
+    // Without w-terms, W-stacking is equivalent to the standard imager (up to the 1/n factor of the w-term, as in W-projection)
+    arma::mat uvw_lambda = random_uvw(3000.0, 0.0);
+    arma::cx_mat vis = point_source_vis(uvw_lambda, 20.0, -35.0);
+    arma::mat vis_weights(num_vis, 1);
+    for (int i = 0; i < num_vis; i++) {
+        vis_weights.at(i, 0) = 1.0 + 0.5 * std::sin(double(i));
+    }
+    ImagerPars img_pars = wstacking_imager_pars(true);
+    PSWF kernel_creator(img_pars.kernel_support);
+
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> expected = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars);
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> result = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars,
+        W_ProjectionPars(4, 7, 1, 0.0, false, false, InterpType::LINEAR, false, true));
+
+    EXPECT_TRUE(arma::approx_equal(result.first, expected.first, "absdiff", 1.0e-3 * arma::abs(expected.first).max()));
+    EXPECT_TRUE(arma::approx_equal(result.second, expected.second, "absdiff", fptolerance));
+}
+
+TEST(ImagerWStacking, point_source)
+{
+    // Off-centre point source with large w-terms: the w-term is corrected as in W-projection
+    arma::mat uvw_lambda = random_uvw(3000.0, 6000.0);
+    arma::cx_mat vis = point_source_vis(uvw_lambda, 100.0, -80.0);
+    arma::mat vis_weights(num_vis, 1);
+    vis_weights.fill(1.0);
+    ImagerPars img_pars = wstacking_imager_pars(false);
+    PSWF kernel_creator(img_pars.kernel_support);
+
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> uncorrected = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars);
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> wproj = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars,
+        W_ProjectionPars(16, 15, 1));
+    std::pair<arma::Mat<real_t>, arma::Mat<real_t>> wstack = image_visibilities(kernel_creator, vis, vis_weights, uvw_lambda, img_pars,
+        W_ProjectionPars(16, 15, 1, 0.0, false, false, InterpType::LINEAR, false, true));
+
+    // The source peak is recovered (it is smeared by the w-terms when they are not corrected)
+    const real_t wstack_peak = wstack.first.max();
+    EXPECT_EQ(wstack.first.index_max(), wproj.first.index_max());
+    EXPECT_GT(wstack_peak, 0.95);
+    EXPECT_LT(uncorrected.first.max(), 0.5 * wstack_peak);
+    EXPECT_NEAR(wstack_peak, wproj.first.max(), 0.02);
+}
+
+#endif
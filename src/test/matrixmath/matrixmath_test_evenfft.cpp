@@ -0,0 +1,55 @@
+#include <common/fft.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+const double fft_tolerance = 1.0e-4;
+
+// Test FFT of matrices that are even along both axes (computed from the first quadrant)
+TEST(MatrixMathEvenFFTTest, EvenFFTCorrectness)
+{
+    for (size_t size : { 4, 16, 64, 96 }) {
+        std::mt19937 rng(size);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        const size_t quadrant_size = size / 2 + 1;
+
+        // Random even matrix and its first quadrant
+        arma::Mat<cx_real_t> quadrant(quadrant_size, quadrant_size);
+        for (size_t j = 0; j < quadrant_size; j++) {
+            for (size_t i = 0; i < quadrant_size; i++) {
+                quadrant.at(i, j) = cx_real_t(real_t(dist(rng)), real_t(dist(rng)));
+            }
+        }
+        arma::Mat<cx_real_t> full(size, size);
+        for (size_t j = 0; j < size; j++) {
+            for (size_t i = 0; i < size; i++) {
+                full.at(i, j) = quadrant.at(std::min(i, size - i), std::min(j, size - j));
+            }
+        }
+
+        arma::Mat<cx_real_t> full_fft;
+        fft_fftw_c2c(full, full_fft, FFTRoutine::FFTW_ESTIMATE_FFT);
+        arma::Mat<cx_real_t> quadrant_fft;
+        fft_fftw_c2c_even(quadrant, quadrant_fft, FFTRoutine::FFTW_ESTIMATE_FFT);
+
+        ASSERT_EQ(quadrant_fft.n_rows, quadrant_size);
+        ASSERT_EQ(quadrant_fft.n_cols, quadrant_size);
+        const double tolerance = fft_tolerance * double(size * size);
+        for (size_t j = 0; j < quadrant_size; j++) {
+            for (size_t i = 0; i < quadrant_size; i++) {
+                EXPECT_NEAR(std::real(quadrant_fft.at(i, j)), std::real(full_fft.at(i, j)), tolerance);
+                EXPECT_NEAR(std::imag(quadrant_fft.at(i, j)), std::imag(full_fft.at(i, j)), tolerance);
+            }
+        }
+
+        // In-place transform
+        fft_fftw_c2c_even(quadrant, quadrant, FFTRoutine::FFTW_ESTIMATE_FFT);
+        for (size_t j = 0; j < quadrant_size; j++) {
+            for (size_t i = 0; i < quadrant_size; i++) {
+                EXPECT_EQ(quadrant.at(i, j), quadrant_fft.at(i, j));
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include <common/fft.h>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <stp.h>
+
+using namespace stp;
+
+/**
+ * Tests the FFTW plan cache of the FFT context: plans are created once per shape and reused by later transforms, and plans
+ * missing from the wisdom are measured and saved.
+ */
+
+arma::Mat<cx_real_t> random_matrix(size_t n_rows, size_t n_cols, int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    arma::Mat<cx_real_t> m(n_rows, n_cols);
+    for (size_t i = 0; i < m.n_elem; i++) {
+        m[i] = cx_real_t(real_t(dist(rng)), real_t(dist(rng)));
+    }
+    return m;
+}
+
+TEST(MatrixMathFFTPlanCache, ReusedPlans)
+{
+    FFTContext& context = FFTContext::instance();
+    context.init(FFTRoutine::FFTW_ESTIMATE_FFT, "");
+    context.clear_plans();
+
+    arma::Mat<cx_real_t> input = random_matrix(64, 64, 1);
+    arma::Mat<cx_real_t> expected;
+    fft_fftw_c2c(input, expected, FFTRoutine::FFTW_ESTIMATE_FFT);
+    EXPECT_EQ(context.num_plans(), 1u);
+
+    // Same shape: the plan is reused
+    for (int i = 0; i < 3; i++) {
+        arma::Mat<cx_real_t> result;
+        fft_fftw_c2c(input, result, FFTRoutine::FFTW_ESTIMATE_FFT);
+        EXPECT_TRUE(arma::approx_equal(result, expected, "absdiff", fptolerance));
+    }
+    EXPECT_EQ(context.num_plans(), 1u);
+
+    // Different direction and shape: new plans
+    arma::Mat<cx_real_t> backward;
+    fft_fftw_c2c(expected, backward, FFTRoutine::FFTW_ESTIMATE_FFT, false);
+    EXPECT_TRUE(arma::approx_equal(backward / real_t(input.n_elem), input, "absdiff", 1e-4));
+    EXPECT_EQ(context.num_plans(), 2u);
+
+    arma::Mat<cx_real_t> small_input = random_matrix(16, 16, 2);
+    arma::Mat<cx_real_t> small_result;
+    fft_fftw_c2c(small_input, small_result, FFTRoutine::FFTW_ESTIMATE_FFT);
+    EXPECT_EQ(context.num_plans(), 3u);
+
+    context.clear_plans();
+    EXPECT_EQ(context.num_plans(), 0u);
+}
+
+TEST(MatrixMathFFTPlanCache, MeasuredPlans)
+{
+    FFTContext& context = FFTContext::instance();
+    context.init(FFTRoutine::FFTW_MEASURE_FFT, "");
+
+    arma::Mat<cx_real_t> input = random_matrix(32, 32, 3);
+    const arma::Mat<cx_real_t> input_copy = input;
+    arma::Mat<cx_real_t> expected;
+    fft_fftw_c2c(input, expected, FFTRoutine::FFTW_ESTIMATE_FFT);
+
+    // The planner overwrites the arrays, but the input is preserved
+    arma::Mat<cx_real_t> result;
+    fft_fftw_c2c(input, result, FFTRoutine::FFTW_MEASURE_FFT);
+    EXPECT_TRUE(arma::approx_equal(input, input_copy, "absdiff", 0.0));
+    EXPECT_TRUE(arma::approx_equal(result, expected, "absdiff", 1e-4));
+
+    const size_t num_plans = context.num_plans();
+    fft_fftw_c2c(input, result, FFTRoutine::FFTW_MEASURE_FFT);
+    EXPECT_EQ(context.num_plans(), num_plans);
+    EXPECT_TRUE(arma::approx_equal(result, expected, "absdiff", 1e-4));
+
+    // In-place transform
+    fft_fftw_c2c(input, input, FFTRoutine::FFTW_MEASURE_FFT);
+    EXPECT_TRUE(arma::approx_equal(input, expected, "absdiff", 1e-4));
+
+    context.cleanup();
+    EXPECT_EQ(context.num_plans(), 0u);
+}
+
+TEST(MatrixMathFFTPlanCache, MissingWisdom)
+{
+    FFTContext& context = FFTContext::instance();
+    const std::string wisdom_filename = "test_fftplancache_wisdom.fftw";
+    std::remove(wisdom_filename.c_str());
+    context.init(FFTRoutine::FFTW_WISDOM_FFT, wisdom_filename);
+    context.clear_plans();
+
+    arma::Mat<cx_real_t> input = random_matrix(48, 48, 4);
+    arma::Mat<cx_real_t> expected;
+    fft_fftw_c2c(input, expected, FFTRoutine::FFTW_ESTIMATE_FFT);
+
+    // The wisdom file does not exist: the plan falls back to FFTW_ESTIMATE and is recorded
+    arma::Mat<cx_real_t> result;
+    fft_fftw_c2c(input, result, FFTRoutine::FFTW_WISDOM_FFT);
+    EXPECT_TRUE(arma::approx_equal(result, expected, "absdiff", 1e-4));
+    ASSERT_EQ(context.missing_wisdom().size(), 1u);
+    EXPECT_EQ(context.missing_wisdom()[0].n0, 48);
+
+    // The measured plan replaces the cached plan
+    EXPECT_EQ(context.tune_missing_plans_async().get(), 1u);
+    EXPECT_EQ(context.missing_wisdom().size(), 0u);
+    fft_fftw_c2c(input, result, FFTRoutine::FFTW_WISDOM_FFT);
+    EXPECT_TRUE(arma::approx_equal(result, expected, "absdiff", 1e-4));
+
+    // The shape is now covered by the wisdom
+    context.clear_plans();
+    fft_fftw_c2c(input, result, FFTRoutine::FFTW_WISDOM_FFT);
+    EXPECT_EQ(context.missing_wisdom().size(), 0u);
+    EXPECT_TRUE(arma::approx_equal(result, expected, "absdiff", 1e-4));
+
+    context.save_wisdom(wisdom_filename);
+    EXPECT_TRUE(std::ifstream(wisdom_filename).good());
+    std::remove(wisdom_filename.c_str());
+
+    const std::string host_filename = FFTContext::host_wisdom_filename("wisdomfiles");
+    EXPECT_EQ(host_filename.find("wisdomfiles/WisdomFile_STP_"), 0u);
+
+    context.cleanup();
+}